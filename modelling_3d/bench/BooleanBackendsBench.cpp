@@ -0,0 +1,488 @@
+// Boolean backend benchmark on real buildings (FCB + OGR underpasses, as in
+// add_underpass) and synthetic stress cases. Prints CSV to stdout:
+// case,source,backend,underpasses,input_faces,output_faces,extrude_ms,
+// conversion_ms,boolean_ms,polygonal_ms,ok
+// Each phase is the best of the repetitions that succeeded; the time columns
+// are empty when none did and ok is 1 only if all did. polygonal_ms is empty
+// for backends whose result add_underpass writes as triangles (geogram).
+//
+// Usage: boolean_backends_bench <model.fcb> <ogr_source> <height_attr>
+//            [id_attr] [backends] [repetitions] [--cost-model-out table.csv]
+// backends is a comma-separated subset of manifold,pmp,nef[,geogram].
+// --cost-model-out fits the add_underpass `auto` cost table to the
+// measurements (best boolean time and success per case and backend).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <manifold/manifold.h>
+
+#include "BackendCostModel.h"
+#include "BooleanOps.h"
+#include "BooleanOpsManifold.h"
+#include "MeshConversion.h"
+#include "ModelLoaders.h"
+#include "OGRVectorReader.h"
+#include "PolygonExtruder.h"
+#include "PolygonalOutput.h"
+#include "zfcb.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Millis = std::chrono::duration<double, std::milli>;
+
+constexpr double kNullUnderpassHeightAboveGround = 2.5;
+
+struct BenchUnderpass {
+    // World coordinates, like the OGR features add_underpass reads.
+    ogr::LinearRing polygon;
+    double roof_z_local = 0.0;
+};
+
+struct BenchCase {
+    std::string name;
+    const char* source = "";
+    LoadedSolidMesh house;
+    double offset_x = 0.0;
+    double offset_y = 0.0;
+    double offset_z = 0.0;
+    std::vector<BenchUnderpass> underpasses;
+    std::string b3_val3dity_lod22;
+};
+
+struct PhaseTimes {
+    double extrude_ms = 0.0;
+    double conversion_ms = 0.0;
+    double boolean_ms = 0.0;
+    double polygonal_ms = 0.0;
+    size_t output_faces = 0;
+    bool has_polygonal = false;
+    bool ok = false;
+    BooleanFeatureTraits traits;
+};
+
+struct Backend {
+    const char* name;
+    BooleanMethod method;
+};
+
+std::vector<Backend> available_backends() {
+    return {
+        {"manifold", BooleanMethod::Manifold},
+        {"pmp", BooleanMethod::CgalPMP},
+        {"nef", BooleanMethod::CgalNef},
+#ifdef ENABLE_GEOGRAM
+        {"geogram", BooleanMethod::Geogram},
+#endif
+    };
+}
+
+bool select_backends(std::string_view list, std::vector<Backend>& selected) {
+    const auto available = available_backends();
+    while (!list.empty()) {
+        const size_t comma = list.find(',');
+        const std::string_view name = list.substr(0, comma);
+        const auto it = std::find_if(available.begin(), available.end(), [&](const Backend& backend) {
+            return name == backend.name;
+        });
+        if (it == available.end()) {
+            std::fprintf(stderr, "Unknown or unavailable backend: %.*s\n", static_cast<int>(name.size()), name.data());
+            return false;
+        }
+        selected.push_back(*it);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+    }
+    return !selected.empty();
+}
+
+ogr::LinearRing rectangle(double x0, double y0, double x1, double y1) {
+    return ogr::LinearRing{{x0, y0, 0.0}, {x1, y0, 0.0}, {x1, y1, 0.0}, {x0, y1, 0.0}};
+}
+
+ogr::LinearRing circle(double cx, double cy, double radius, size_t vertex_count) {
+    ogr::LinearRing ring;
+    ring.reserve(vertex_count);
+    for (size_t i = 0; i < vertex_count; ++i) {
+        const double angle = 2.0 * std::numbers::pi * static_cast<double>(i) / static_cast<double>(vertex_count);
+        ring.push_back({cx + radius * std::cos(angle), cy + radius * std::sin(angle), 0.0});
+    }
+    return ring;
+}
+
+BenchCase synthetic_case(std::string name, const ogr::LinearRing& footprint, std::vector<ogr::LinearRing> underpasses) {
+    BenchCase bench_case;
+    bench_case.name = std::move(name);
+    bench_case.source = "synthetic";
+    // No semantic surfaces: polygonal output infers every semantic from the
+    // face orientation, as for models without LoD 2.2 semantics.
+    bench_case.house.mesh = extrusion::extrude_polygon(footprint, 0.0, 10.0);
+    for (auto& polygon : underpasses) {
+        bench_case.underpasses.push_back(BenchUnderpass{std::move(polygon), 3.0});
+    }
+    return bench_case;
+}
+
+std::vector<BenchCase> synthetic_cases() {
+    std::vector<BenchCase> cases;
+
+    // Many underpasses carved out of one block.
+    for (size_t per_side : {4, 8}) {
+        std::vector<ogr::LinearRing> underpasses;
+        const double pitch = 60.0 / static_cast<double>(per_side);
+        for (size_t j = 0; j < per_side; ++j) {
+            for (size_t i = 0; i < per_side; ++i) {
+                const double x = static_cast<double>(i) * pitch + 0.25 * pitch;
+                const double y = static_cast<double>(j) * pitch + 0.25 * pitch;
+                underpasses.push_back(rectangle(x, y, x + 0.5 * pitch, y + 0.5 * pitch));
+            }
+        }
+        cases.push_back(synthetic_case(
+            "many_underpasses_" + std::to_string(per_side * per_side), rectangle(0.0, 0.0, 60.0, 60.0),
+            std::move(underpasses)));
+    }
+
+    // High-vertex footprints: round house with a round passage through its
+    // side, so both inputs contribute many wall faces to the result.
+    for (size_t vertex_count : {256, 2048}) {
+        std::vector<ogr::LinearRing> underpasses;
+        underpasses.push_back(circle(18.0, 0.0, 8.0, vertex_count / 2));
+        cases.push_back(synthetic_case(
+            "high_vertex_" + std::to_string(vertex_count), circle(0.0, 0.0, 20.0, vertex_count),
+            std::move(underpasses)));
+    }
+
+    // Coplanar ceilings: a row of passages sharing edges, plus one that
+    // overlaps two of them, all at the same roof height.
+    {
+        std::vector<ogr::LinearRing> underpasses;
+        for (int i = 0; i < 4; ++i) {
+            underpasses.push_back(rectangle(5.0 + 5.0 * i, -1.0, 10.0 + 5.0 * i, 6.0));
+        }
+        underpasses.push_back(rectangle(12.5, 2.0, 17.5, 8.0));
+        cases.push_back(synthetic_case("coplanar_ceilings", rectangle(0.0, 0.0, 30.0, 12.0), std::move(underpasses)));
+    }
+    return cases;
+}
+
+// Streams the model like add_underpass and keeps every building that has
+// underpass polygons. The first matched building sets the shared offset.
+bool real_cases(
+    const char* model_path,
+    const char* ogr_source,
+    const std::string& height_attribute,
+    const std::string& id_attribute,
+    std::vector<BenchCase>& cases) {
+    std::vector<ogr::VectorReader::PolygonFeature> features;
+    try {
+        ogr::VectorReader reader;
+        reader.open(ogr_source);
+        features = reader.read_polygon_features(id_attribute, height_attribute);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Failed to read %s: %s\n", ogr_source, e.what());
+        return false;
+    }
+    std::unordered_map<std::string_view, std::vector<size_t>> features_by_id;
+    for (size_t i = 0; i < features.size(); ++i) {
+        if (!features[i].id.empty()) {
+            features_by_id[features[i].id].push_back(i);
+        }
+    }
+
+    ZfcbReaderHandle fcb = zfcb_reader_open(model_path);
+    if (fcb == nullptr) {
+        std::fprintf(stderr, "Failed to open FlatCityBuf stream: %s\n", model_path);
+        return false;
+    }
+    bool offset_set = false;
+    double offset_x = 0.0;
+    double offset_y = 0.0;
+    double offset_z = 0.0;
+    bool ok = true;
+    while (true) {
+        const char* id_ptr = nullptr;
+        size_t id_len = 0;
+        const int peek_result = zfcb_peek_next_id(fcb, &id_ptr, &id_len);
+        if (peek_result <= 0) {
+            ok = peek_result == 0;
+            break;
+        }
+        const std::string id(id_ptr, id_len);
+        const auto matched = features_by_id.find(id);
+        if (matched == features_by_id.end()) {
+            if (zfcb_skip_next(fcb) < 0) {
+                ok = false;
+                break;
+            }
+            continue;
+        }
+        if (fcb_next_for_mesh_loading(fcb) <= 0) {
+            ok = false;
+            break;
+        }
+        if (!offset_set) {
+            const double* vertices = zfcb_current_vertices(fcb);
+            if (vertices == nullptr || zfcb_current_vertex_count(fcb) == 0) {
+                continue;
+            }
+            offset_x = vertices[0];
+            offset_y = vertices[1];
+            offset_z = vertices[2];
+            offset_set = true;
+        }
+
+        BenchCase bench_case;
+        bench_case.name = id;
+        bench_case.source = "real";
+        bench_case.offset_x = offset_x;
+        bench_case.offset_y = offset_y;
+        bench_case.offset_z = offset_z;
+        bool loaded = false;
+        try {
+            loaded = load_fcb_feature_mesh(
+                fcb, id, bench_case.house, offset_x, offset_y, offset_z, &bench_case.b3_val3dity_lod22);
+        } catch (const std::exception&) {
+            loaded = false;
+        }
+        if (!loaded) {
+            continue;
+        }
+        const double house_min_z = mesh_min_z(bench_case.house.mesh);
+        if (!std::isfinite(house_min_z)) {
+            continue;
+        }
+        for (size_t feature_idx : matched->second) {
+            const auto& feature = features[feature_idx];
+            const double roof_z = (feature.has_absolute_elevation && std::isfinite(feature.absolute_elevation))
+                ? feature.absolute_elevation - offset_z
+                : house_min_z + kNullUnderpassHeightAboveGround;
+            bench_case.underpasses.push_back(BenchUnderpass{feature.polygon, roof_z});
+        }
+        cases.push_back(std::move(bench_case));
+    }
+    zfcb_reader_destroy(fcb);
+    return ok;
+}
+
+// One carve of `bench_case` with `method`, timed per phase like the
+// add_underpass timing profile. `times` keeps the phases finished before a
+// backend throws.
+void run_once(const BenchCase& bench_case, BooleanMethod method, PhaseTimes& times) {
+    const double house_min_z = mesh_min_z(bench_case.house.mesh);
+
+    auto t_extrude_start = Clock::now();
+    std::vector<Surface_mesh> underpass_meshes;
+    std::vector<UnderpassSurfaceSource> sources;
+    double underpass_z = 0.0;
+    for (size_t i = 0; i < bench_case.underpasses.size(); ++i) {
+        const auto& underpass = bench_case.underpasses[i];
+        auto local_polygon = make_offset_polygon(
+            underpass.polygon, bench_case.offset_x, bench_case.offset_y, bench_case.offset_z);
+        Surface_mesh mesh = extrusion::extrude_polygon(local_polygon, house_min_z - 0.1, underpass.roof_z_local);
+        if (mesh.number_of_faces() == 0) {
+            continue;
+        }
+        underpass_meshes.push_back(std::move(mesh));
+        underpass_z = underpass.roof_z_local;
+        sources.push_back(UnderpassSurfaceSource{
+            .polygon_feature_index = i,
+            .polygon = &underpass.polygon,
+            .prepared_polygon = std::make_shared<const pip::PreparedPolygon>(
+                underpass.polygon, underpass.polygon.interior_rings()),
+            .roof_z_local = underpass.roof_z_local,
+        });
+    }
+    times.extrude_ms = Millis(Clock::now() - t_extrude_start).count();
+    if (underpass_meshes.empty()) {
+        return;
+    }
+    std::vector<double> ceiling_z;
+    for (const auto& source : sources) {
+        ceiling_z.push_back(source.roof_z_local);
+    }
+    times.traits = boolean_feature_traits(
+        bench_case.house.mesh, underpass_meshes, ceiling_z, bench_case.b3_val3dity_lod22);
+
+    BooleanOpTiming timing;
+    Surface_mesh house_sm = bench_case.house.mesh;
+    manifold::MeshGL result_meshgl;
+    Surface_mesh result_sm;
+    bool polygonal_from_cgal = false;
+    bool success = true;
+    if (method == BooleanMethod::Manifold) {
+        success = manifold_boolean_difference(house_sm, underpass_meshes, result_meshgl, &timing);
+        times.output_faces = result_meshgl.NumTri();
+    } else if (method == BooleanMethod::CgalNef) {
+        result_sm = nef_boolean_difference(house_sm, underpass_meshes, &timing);
+        times.output_faces = result_sm.number_of_faces();
+        polygonal_from_cgal = true;
+#ifdef ENABLE_GEOGRAM
+    } else if (method == BooleanMethod::Geogram) {
+        result_sm = geogram_boolean_difference(house_sm, underpass_meshes, &timing);
+        auto t_conversion_start = Clock::now();
+        result_meshgl = surface_mesh_to_meshgl(result_sm, false);
+        timing.conversion_ms += Clock::now() - t_conversion_start;
+        times.output_faces = result_meshgl.NumTri();
+#endif
+    } else {
+        result_sm = corefine_boolean_difference(house_sm, underpass_meshes, &timing);
+        times.output_faces = result_sm.number_of_faces();
+        polygonal_from_cgal = true;
+    }
+    times.conversion_ms = timing.conversion_ms.count();
+    times.boolean_ms = timing.boolean_ms.count();
+    if (!success || times.output_faces == 0) {
+        return;
+    }
+
+    PolygonalOutput polygonal_output;
+    auto t_polygonal_start = Clock::now();
+    if (method == BooleanMethod::Manifold) {
+        times.has_polygonal = true;
+        times.ok = build_polygonal_output_from_manifold_meshgl(
+            result_meshgl, bench_case.house, house_min_z, underpass_z, sources,
+            bench_case.offset_x, bench_case.offset_y, bench_case.offset_z, polygonal_output);
+    } else if (polygonal_from_cgal) {
+        times.has_polygonal = true;
+        times.ok = build_polygonal_output_from_cgal_mesh(
+            result_sm, bench_case.house, house_min_z, underpass_z, sources,
+            bench_case.offset_x, bench_case.offset_y, bench_case.offset_z, polygonal_output);
+    } else {
+        times.ok = true;
+    }
+    times.polygonal_ms = Millis(Clock::now() - t_polygonal_start).count();
+}
+
+void report_case(
+    const BenchCase& bench_case,
+    const Backend& backend,
+    int repetitions,
+    BackendCostModel* cost_model) {
+    PhaseTimes best;
+    best.extrude_ms = best.conversion_ms = best.boolean_ms = best.polygonal_ms =
+        std::numeric_limits<double>::infinity();
+    int succeeded = 0;
+    bool boolean_ok = true;
+    // Longest time a failed repetition spent past extrusion, so a backend
+    // that only fails is still charged for the time it took.
+    double failed_boolean_ms = 0.0;
+    for (int rep = 0; rep < repetitions; ++rep) {
+        PhaseTimes times;
+        bool threw = false;
+        const auto t_start = Clock::now();
+        try {
+            run_once(bench_case, backend.method, times);
+        } catch (const std::exception&) {
+            times.ok = false;
+            threw = true;
+        }
+        const double wall_ms = Millis(Clock::now() - t_start).count();
+        boolean_ok = boolean_ok && !threw && times.output_faces > 0;
+        if (times.traits.underpass_count > 0) {
+            best.traits = times.traits;
+        }
+        best.has_polygonal = times.has_polygonal;
+        if (!times.ok || times.output_faces == 0) {
+            failed_boolean_ms = std::max(failed_boolean_ms, wall_ms - times.extrude_ms - times.polygonal_ms);
+            continue;
+        }
+        ++succeeded;
+        best.extrude_ms = std::min(best.extrude_ms, times.extrude_ms);
+        best.conversion_ms = std::min(best.conversion_ms, times.conversion_ms);
+        best.boolean_ms = std::min(best.boolean_ms, times.boolean_ms);
+        best.polygonal_ms = std::min(best.polygonal_ms, times.polygonal_ms);
+        best.output_faces = times.output_faces;
+    }
+
+    const auto format_ms = [succeeded](char (&buffer)[32], double ms, bool present = true) {
+        buffer[0] = '\0';
+        if (present && succeeded > 0) {
+            std::snprintf(buffer, sizeof(buffer), "%.3f", ms);
+        }
+        return buffer;
+    };
+    char extrude[32];
+    char conversion[32];
+    char boolean[32];
+    char polygonal[32];
+    const size_t input_faces = bench_case.house.mesh.number_of_faces();
+    std::printf("%s,%s,%s,%zu,%zu,%zu,%s,%s,%s,%s,%d\n",
+                bench_case.name.c_str(), bench_case.source, backend.name, bench_case.underpasses.size(),
+                input_faces, best.output_faces, format_ms(extrude, best.extrude_ms),
+                format_ms(conversion, best.conversion_ms), format_ms(boolean, best.boolean_ms),
+                format_ms(polygonal, best.polygonal_ms, best.has_polygonal), succeeded == repetitions ? 1 : 0);
+    std::fflush(stdout);
+    if (cost_model != nullptr && best.traits.underpass_count > 0) {
+        const double boolean_ms = succeeded > 0 ? best.boolean_ms : failed_boolean_ms;
+        cost_model->record(backend.method, best.traits, boolean_ms, boolean_ok);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string cost_model_out_path;
+    std::vector<char*> positional_args{argv[0]};
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--cost-model-out" && i + 1 < argc) {
+            cost_model_out_path = argv[++i];
+        } else if (arg.starts_with("--cost-model-out=")) {
+            cost_model_out_path = std::string(arg.substr(std::string_view("--cost-model-out=").size()));
+        } else {
+            positional_args.push_back(argv[i]);
+        }
+    }
+    argc = static_cast<int>(positional_args.size());
+    argv = positional_args.data();
+
+    if (argc < 4) {
+        std::fprintf(stderr,
+                     "Usage: %s <model.fcb> <ogr_source> <height_attr> [id_attr] [backends] [repetitions]"
+                     " [--cost-model-out table.csv]\n",
+                     argv[0]);
+        return 1;
+    }
+    const std::string id_attribute = argc > 4 ? argv[4] : "identificatie";
+    std::vector<Backend> backends;
+    if (argc > 5) {
+        if (!select_backends(argv[5], backends)) {
+            return 1;
+        }
+    } else {
+        backends = available_backends();
+    }
+    const int repetitions = argc > 6 ? std::max(1, std::atoi(argv[6])) : 3;
+
+    std::vector<BenchCase> cases = synthetic_cases();
+    if (!real_cases(argv[1], argv[2], argv[3], id_attribute, cases)) {
+        return 1;
+    }
+
+    std::printf("case,source,backend,underpasses,input_faces,output_faces,"
+                "extrude_ms,conversion_ms,boolean_ms,polygonal_ms,ok\n");
+    // Calibrated from scratch, so the table reflects this machine only.
+    BackendCostModel cost_model = BackendCostModel::empty();
+    BackendCostModel* cost_model_ptr = cost_model_out_path.empty() ? nullptr : &cost_model;
+    for (const auto& bench_case : cases) {
+        for (const auto& backend : backends) {
+            report_case(bench_case, backend, repetitions, cost_model_ptr);
+        }
+    }
+    if (cost_model_ptr != nullptr && !cost_model.write_csv(cost_model_out_path)) {
+        std::fprintf(stderr, "Failed to write cost model: %s\n", cost_model_out_path.c_str());
+        return 1;
+    }
+    return 0;
+}
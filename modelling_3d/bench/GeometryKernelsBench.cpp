@@ -0,0 +1,117 @@
+// Microbenchmarks for GeometryKernels against the scalar loops they replaced.
+// Prints CSV to stdout: kernel,elements,reference_ns,kernel_ns,speedup
+// (ns per element, best of several repetitions).
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "GeometryKernels.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kRepetitions = 15;
+
+// Interleaved float mesh like manifold::MeshGL with numProp = 3.
+struct BenchMesh {
+    std::vector<float> props;
+    size_t vertex_count = 0;
+};
+
+BenchMesh make_mesh(size_t grid) {
+    BenchMesh mesh;
+    std::mt19937 rng(0xdeadbeef);
+    std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+    mesh.vertex_count = grid * grid;
+    mesh.props.reserve(mesh.vertex_count * 3);
+    for (size_t j = 0; j < grid; ++j) {
+        for (size_t i = 0; i < grid; ++i) {
+            mesh.props.push_back(static_cast<float>(i) + jitter(rng));
+            mesh.props.push_back(static_cast<float>(j) + jitter(rng));
+            mesh.props.push_back(5.0f + 3.0f * jitter(rng));
+        }
+    }
+    return mesh;
+}
+
+template <typename Fn>
+double best_ns(size_t elements, Fn&& fn) {
+    double best = std::numeric_limits<double>::infinity();
+    for (int rep = 0; rep < kRepetitions; ++rep) {
+        const auto start = Clock::now();
+        fn();
+        const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        best = std::min(best, elapsed.count() / static_cast<double>(elements));
+    }
+    return best;
+}
+
+void report(const char* kernel, size_t elements, double reference_ns, double kernel_ns) {
+    std::printf("%s,%zu,%.3f,%.3f,%.2f\n", kernel, elements, reference_ns, kernel_ns, reference_ns / kernel_ns);
+}
+
+volatile double g_sink = 0.0;
+volatile size_t g_stride = 3;
+
+// Scalar reference loops, as they were before GeometryKernels. Kept out of
+// line with a runtime stride so they compile like the originals.
+[[gnu::noinline]] void reference_offset(std::vector<float>& props, size_t stride, double dx, double dy, double dz) {
+    for (size_t i = 0; i + 2 < props.size(); i += stride) {
+        props[i] += static_cast<float>(dx);
+        props[i + 1] += static_cast<float>(dy);
+        props[i + 2] += static_cast<float>(dz);
+    }
+}
+
+[[gnu::noinline]] double reference_min_z(const std::vector<double>& xyz) {
+    double min_z = std::numeric_limits<double>::infinity();
+    for (size_t i = 2; i < xyz.size(); i += 3) {
+        const double z = xyz[i];
+        if (z < min_z) {
+            min_z = z;
+        }
+    }
+    return min_z;
+}
+
+void bench_mesh(size_t grid) {
+    BenchMesh mesh = make_mesh(grid);
+    // Runtime stride, as for MeshGL::numProp; a constant would let the
+    // compiler specialize the reference loops.
+    const size_t stride = g_stride;
+
+    const double offset_ref = best_ns(mesh.vertex_count, [&] {
+        reference_offset(mesh.props, stride, 0.5, -0.5, 0.0);
+        g_sink = mesh.props[mesh.props.size() / 2];
+    });
+    const double offset_kernel = best_ns(mesh.vertex_count, [&] {
+        kernels::offset_positions(mesh.props.data(), mesh.vertex_count, stride, -0.5f, 0.5f, 0.0f);
+        g_sink = mesh.props[mesh.props.size() / 2];
+    });
+    report("meshgl_offset", mesh.vertex_count, offset_ref, offset_kernel);
+
+    std::vector<double> world(mesh.vertex_count * 3);
+    kernels::to_world_xyz(mesh.props.data(), mesh.vertex_count, stride, 0.0, 0.0, 0.0, world.data());
+    const double min_ref = best_ns(mesh.vertex_count, [&] {
+        g_sink = reference_min_z(world);
+    });
+    const double min_kernel = best_ns(mesh.vertex_count, [&] {
+        g_sink = kernels::min_strided(world.data() + 2, mesh.vertex_count, 3);
+    });
+    report("mesh_min_z", mesh.vertex_count, min_ref, min_kernel);
+}
+
+} // namespace
+
+int main() {
+    std::printf("kernel,elements,reference_ns,kernel_ns,speedup\n");
+    for (size_t grid : {32, 256, 1024}) {
+        bench_mesh(grid);
+    }
+    return 0;
+}
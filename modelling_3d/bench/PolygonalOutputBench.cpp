@@ -0,0 +1,254 @@
+// Microbenchmark for the boundary-cycle extraction of the polygonal output
+// against the hash-map version it replaced. Prints CSV to stdout:
+// stage,faces,boundary_edges,reference_ns,dense_ns,speedup
+// (ns per group face, best of several repetitions).
+//
+// Groups are triangulated square roofs with every fifth interior cell cut out,
+// held in a plain halfedge table instead of a Surface_mesh so the bench needs
+// no CGAL. Face and vertex ids are scattered like descriptors of a mesh that
+// also holds the rest of the building.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "BoundaryCycles.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using boundary_cycles::BoundaryEdge;
+
+constexpr int kRepetitions = 15;
+constexpr uint32_t kNoFace = std::numeric_limits<uint32_t>::max();
+
+struct HalfEdge {
+    uint32_t source = 0;
+    uint32_t target = 0;
+    uint32_t opposite_face = kNoFace;
+};
+
+struct GroupMesh {
+    size_t face_capacity = 0;
+    size_t vertex_capacity = 0;
+    // Three halfedges per face id.
+    std::vector<HalfEdge> halfedges;
+    std::vector<uint32_t> group_faces;
+    // Dense per-id tables, as after the rewrite.
+    std::vector<uint32_t> face_group;
+    std::vector<uint32_t> vertex_to_dense;
+    // The same tables as hash maps, as before it.
+    std::unordered_map<size_t, size_t> face_group_map;
+    std::unordered_map<size_t, uint32_t> vertex_to_dense_map;
+};
+
+GroupMesh make_group(size_t grid) {
+    GroupMesh mesh;
+    const size_t cells = grid * grid;
+    // Ids spread over a mesh four times the size of the group.
+    mesh.face_capacity = cells * 2 * 4;
+    mesh.vertex_capacity = (grid + 1) * (grid + 1) * 4;
+    std::mt19937 rng(0xc0ffee);
+    std::vector<uint32_t> face_ids(mesh.face_capacity);
+    std::vector<uint32_t> vertex_ids(mesh.vertex_capacity);
+    for (size_t i = 0; i < face_ids.size(); ++i) face_ids[i] = static_cast<uint32_t>(i);
+    for (size_t i = 0; i < vertex_ids.size(); ++i) vertex_ids[i] = static_cast<uint32_t>(i);
+    std::shuffle(face_ids.begin(), face_ids.end(), rng);
+    std::shuffle(vertex_ids.begin(), vertex_ids.end(), rng);
+
+    mesh.halfedges.resize(mesh.face_capacity * 3);
+    mesh.face_group.assign(mesh.face_capacity, 1);
+    mesh.vertex_to_dense.assign(mesh.vertex_capacity, std::numeric_limits<uint32_t>::max());
+    for (size_t v = 0; v < mesh.vertex_capacity; ++v) {
+        mesh.vertex_to_dense[v] = static_cast<uint32_t>(v);
+        mesh.vertex_to_dense_map[v] = static_cast<uint32_t>(v);
+    }
+
+    const auto vertex = [&](size_t i, size_t j) { return vertex_ids[j * (grid + 1) + i]; };
+    const auto cut = [&](size_t i, size_t j) {
+        return i > 0 && j > 0 && i + 1 < grid && j + 1 < grid && (j * grid + i) % 5 == 0;
+    };
+    // Cell (i, j) is split into a lower triangle 2c and an upper one 2c + 1.
+    const auto face = [&](size_t i, size_t j, size_t half) { return face_ids[(j * grid + i) * 2 + half]; };
+    const auto neighbour = [&](ptrdiff_t i, ptrdiff_t j, size_t half) -> uint32_t {
+        if (i < 0 || j < 0 || i >= static_cast<ptrdiff_t>(grid) || j >= static_cast<ptrdiff_t>(grid)) {
+            return kNoFace;
+        }
+        return face(static_cast<size_t>(i), static_cast<size_t>(j), half);
+    };
+    for (size_t j = 0; j < grid; ++j) {
+        for (size_t i = 0; i < grid; ++i) {
+            const auto ii = static_cast<ptrdiff_t>(i);
+            const auto jj = static_cast<ptrdiff_t>(j);
+            const uint32_t lower = face(i, j, 0);
+            const uint32_t upper = face(i, j, 1);
+            // Lower: (i,j) -> (i+1,j) -> (i,j+1); upper: (i+1,j) -> (i+1,j+1) -> (i,j+1).
+            mesh.halfedges[lower * 3 + 0] = {vertex(i, j), vertex(i + 1, j), neighbour(ii, jj - 1, 1)};
+            mesh.halfedges[lower * 3 + 1] = {vertex(i + 1, j), vertex(i, j + 1), upper};
+            mesh.halfedges[lower * 3 + 2] = {vertex(i, j + 1), vertex(i, j), neighbour(ii - 1, jj, 1)};
+            mesh.halfedges[upper * 3 + 0] = {vertex(i + 1, j), vertex(i + 1, j + 1), neighbour(ii + 1, jj, 0)};
+            mesh.halfedges[upper * 3 + 1] = {vertex(i + 1, j + 1), vertex(i, j + 1), neighbour(ii, jj + 1, 0)};
+            mesh.halfedges[upper * 3 + 2] = {vertex(i, j + 1), vertex(i + 1, j), lower};
+            const uint32_t group = cut(i, j) ? 1 : 0;
+            for (const uint32_t f : {lower, upper}) {
+                mesh.face_group[f] = group;
+                mesh.face_group_map[f] = group;
+                if (group == 0) {
+                    mesh.group_faces.push_back(f);
+                }
+            }
+        }
+    }
+    return mesh;
+}
+
+// extract_group_cycles before the dense rewrite.
+[[gnu::noinline]] std::vector<std::vector<uint32_t>> reference_cycles(const GroupMesh& mesh, size_t group_id) {
+    std::vector<BoundaryEdge> boundary_edges;
+    for (const uint32_t face : mesh.group_faces) {
+        for (size_t k = 0; k < 3; ++k) {
+            const HalfEdge& h = mesh.halfedges[face * 3 + k];
+            const bool boundary = h.opposite_face == kNoFace ||
+                mesh.face_group_map.find(h.opposite_face) == mesh.face_group_map.end() ||
+                mesh.face_group_map.at(h.opposite_face) != group_id;
+            if (!boundary) {
+                continue;
+            }
+            const auto from_it = mesh.vertex_to_dense_map.find(h.source);
+            const auto to_it = mesh.vertex_to_dense_map.find(h.target);
+            if (from_it == mesh.vertex_to_dense_map.end() || to_it == mesh.vertex_to_dense_map.end()) {
+                continue;
+            }
+            boundary_edges.push_back(BoundaryEdge{.from = from_it->second, .to = to_it->second});
+        }
+    }
+
+    std::unordered_map<uint32_t, std::vector<size_t>> outgoing;
+    for (size_t edge_idx = 0; edge_idx < boundary_edges.size(); ++edge_idx) {
+        outgoing[boundary_edges[edge_idx].from].push_back(edge_idx);
+    }
+
+    std::vector<bool> visited(boundary_edges.size(), false);
+    std::vector<std::vector<uint32_t>> cycles;
+    for (size_t edge_idx = 0; edge_idx < boundary_edges.size(); ++edge_idx) {
+        if (visited[edge_idx]) {
+            continue;
+        }
+        std::vector<uint32_t> ring;
+        const uint32_t start_vertex = boundary_edges[edge_idx].from;
+        size_t current_edge = edge_idx;
+        for (size_t step = 0; step <= boundary_edges.size(); ++step) {
+            if (visited[current_edge]) {
+                break;
+            }
+            visited[current_edge] = true;
+            if (ring.empty()) {
+                ring.push_back(boundary_edges[current_edge].from);
+            }
+            ring.push_back(boundary_edges[current_edge].to);
+            const uint32_t current_vertex = boundary_edges[current_edge].to;
+            if (current_vertex == start_vertex) {
+                ring.pop_back();
+                break;
+            }
+            auto next_it = outgoing.find(current_vertex);
+            if (next_it == outgoing.end()) {
+                ring.clear();
+                break;
+            }
+            bool found_next = false;
+            for (size_t candidate_edge : next_it->second) {
+                if (!visited[candidate_edge]) {
+                    current_edge = candidate_edge;
+                    found_next = true;
+                    break;
+                }
+            }
+            if (!found_next) {
+                ring.clear();
+                break;
+            }
+        }
+        if (ring.size() >= 3) {
+            cycles.push_back(std::move(ring));
+        }
+    }
+    return cycles;
+}
+
+// extract_group_cycles as it is now: dense lookups, then the CSR walk.
+[[gnu::noinline]] std::vector<std::vector<uint32_t>> dense_cycles(
+    const GroupMesh& mesh,
+    uint32_t group_id,
+    std::vector<BoundaryEdge>& boundary_edges,
+    boundary_cycles::WalkScratch& scratch) {
+    boundary_edges.clear();
+    for (const uint32_t face : mesh.group_faces) {
+        for (size_t k = 0; k < 3; ++k) {
+            const HalfEdge& h = mesh.halfedges[face * 3 + k];
+            const bool boundary = h.opposite_face == kNoFace || mesh.face_group[h.opposite_face] != group_id;
+            if (!boundary) {
+                continue;
+            }
+            const uint32_t from = mesh.vertex_to_dense[h.source];
+            const uint32_t to = mesh.vertex_to_dense[h.target];
+            if (from == boundary_cycles::kNoSlot || to == boundary_cycles::kNoSlot) {
+                continue;
+            }
+            boundary_edges.push_back(BoundaryEdge{.from = from, .to = to});
+        }
+    }
+    return boundary_cycles::walk_boundary_cycles(boundary_edges, scratch);
+}
+
+template <typename Fn>
+double best_ns(size_t elements, Fn&& fn) {
+    double best = std::numeric_limits<double>::infinity();
+    for (int rep = 0; rep < kRepetitions; ++rep) {
+        const auto start = Clock::now();
+        fn();
+        const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        best = std::min(best, elapsed.count() / static_cast<double>(elements));
+    }
+    return best;
+}
+
+volatile size_t g_sink = 0;
+
+bool bench_group(size_t grid) {
+    const GroupMesh mesh = make_group(grid);
+    std::vector<BoundaryEdge> boundary_edges;
+    boundary_cycles::WalkScratch scratch;
+    scratch.local_slot.assign(mesh.vertex_capacity, boundary_cycles::kNoSlot);
+
+    const auto expected = reference_cycles(mesh, 0);
+    if (dense_cycles(mesh, 0, boundary_edges, scratch) != expected) {
+        std::fprintf(stderr, "group_cycles grid %zu: dense walk differs from the reference\n", grid);
+        return false;
+    }
+
+    const size_t faces = mesh.group_faces.size();
+    const double reference = best_ns(faces, [&] { g_sink = reference_cycles(mesh, 0).size(); });
+    const double dense = best_ns(faces, [&] { g_sink = dense_cycles(mesh, 0, boundary_edges, scratch).size(); });
+    std::printf("group_cycles,%zu,%zu,%.3f,%.3f,%.2f\n", faces, boundary_edges.size(), reference, dense,
+                reference / dense);
+    return true;
+}
+
+} // namespace
+
+int main() {
+    std::printf("stage,faces,boundary_edges,reference_ns,dense_ns,speedup\n");
+    for (const size_t grid : {4, 16, 64, 256}) {
+        if (!bench_group(grid)) {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
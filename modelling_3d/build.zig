@@ -75,6 +75,9 @@ pub fn build(b: *std.Build) void {
         }),
     });
     zityjson_lib.bundle_compiler_rt = true;
+    // Compressed CityJSONSeq (.jsonl.zst/.jsonl.gz) I/O.
+    zityjson_lib.root_module.linkSystemLibrary("zstd", .{});
+    zityjson_lib.root_module.linkSystemLibrary("z", .{});
 
     // C++ flags
     var cpp_flags_list: std.ArrayListUnmanaged([]const u8) = .empty;
@@ -82,6 +85,9 @@ pub fn build(b: *std.Build) void {
     if (enable_rerun) cpp_flags_list.append(b.allocator, "-DENABLE_RERUN=1") catch @panic("OOM");
     if (enable_geogram) cpp_flags_list.append(b.allocator, "-DENABLE_GEOGRAM=1") catch @panic("OOM");
     const cpp_flags = cpp_flags_list.items;
+    // The per-triangle normals call sqrt; without errno it is a single
+    // instruction instead of a call on the error path.
+    const kernel_flags = std.mem.concat(b.allocator, []const u8, &.{ cpp_flags, &.{"-fno-math-errno"} }) catch @panic("OOM");
 
     // Create the main executable module
     const exe_mod = b.createModule(.{
@@ -132,7 +138,31 @@ pub fn build(b: *std.Build) void {
         .flags = cpp_flags,
     });
     exe.root_module.addCSourceFile(.{
-        .file = b.path("src/BooleanObjWriter.cpp"),
+        .file = b.path("src/BooleanMeshWriter.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/BooleanAttempt.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/BooleanWorker.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/BackendCostModel.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/CarveServer.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/Checkpoint.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/MemoryBudget.cpp"),
         .flags = cpp_flags,
     });
     exe.root_module.addCSourceFile(.{
@@ -147,6 +177,42 @@ pub fn build(b: *std.Build) void {
         .file = b.path("src/PolygonalOutput.cpp"),
         .flags = cpp_flags,
     });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/BoundaryCycles.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/CycleNesting.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/PreparedPolygon.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/GeometryKernels.cpp"),
+        .flags = kernel_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/JsonWriter.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/ProcessMemory.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/RunMetrics.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/Trace.cpp"),
+        .flags = cpp_flags,
+    });
+    exe.root_module.addCSourceFile(.{
+        .file = b.path("src/VertexWelding.cpp"),
+        .flags = cpp_flags,
+    });
 
     // 2. Linking System Libraries
     // Note: Zig automatically picks up NIX_CFLAGS_COMPILE and NIX_LDFLAGS from the environment
@@ -160,6 +226,10 @@ pub fn build(b: *std.Build) void {
     // GDAL
     exe.root_module.linkSystemLibrary("gdal", .{});
 
+    // zityjson compressed CityJSONSeq streams
+    exe.root_module.linkSystemLibrary("zstd", .{});
+    exe.root_module.linkSystemLibrary("z", .{});
+
     // 3. Rerun dependencies (optional)
     if (enable_rerun) {
         const resolved_target = target.result;
@@ -203,6 +273,17 @@ pub fn build(b: *std.Build) void {
     // 5. Installation
     b.installArtifact(exe);
 
+    // fcb_merge combines the outputs of --shard runs
+    const fcb_merge = b.addExecutable(.{
+        .name = "fcb_merge",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("zityjson/src/fcb_merge.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+    b.installArtifact(fcb_merge);
+
     // Optionally install zfcb/zityjson libraries and headers
     const install_lib = b.step("lib", "Build and install zfcb/zityjson libraries");
     install_lib.dependOn(&b.addInstallArtifact(zfcb_lib, .{}).step);
@@ -218,4 +299,241 @@ pub fn build(b: *std.Build) void {
         "zityjson.h",
     ).step);
 
+    // Geometry kernel microbenchmarks (CSV on stdout)
+    const kernels_bench = b.addExecutable(.{
+        .name = "geometry_kernels_bench",
+        .root_module = b.createModule(.{
+            .target = target,
+            .optimize = optimize,
+            .link_libcpp = true,
+        }),
+    });
+    kernels_bench.root_module.addCSourceFile(.{
+        .file = b.path("bench/GeometryKernelsBench.cpp"),
+        .flags = cpp_flags,
+    });
+    kernels_bench.root_module.addCSourceFile(.{
+        .file = b.path("src/GeometryKernels.cpp"),
+        .flags = kernel_flags,
+    });
+    kernels_bench.root_module.addIncludePath(b.path("src"));
+    const run_kernels_bench = b.addRunArtifact(kernels_bench);
+    const bench_kernels_step = b.step("bench-kernels", "Run geometry kernel microbenchmarks");
+    bench_kernels_step.dependOn(&run_kernels_bench.step);
+
+    // Boundary-cycle extraction of the polygonal output against the hash-map
+    // version it replaced (CSV on stdout)
+    const polygonal_bench = b.addExecutable(.{
+        .name = "polygonal_output_bench",
+        .root_module = b.createModule(.{
+            .target = target,
+            .optimize = optimize,
+            .link_libcpp = true,
+        }),
+    });
+    polygonal_bench.root_module.addCSourceFile(.{
+        .file = b.path("bench/PolygonalOutputBench.cpp"),
+        .flags = cpp_flags,
+    });
+    polygonal_bench.root_module.addCSourceFile(.{
+        .file = b.path("src/BoundaryCycles.cpp"),
+        .flags = cpp_flags,
+    });
+    polygonal_bench.root_module.addIncludePath(b.path("src"));
+    const run_polygonal_bench = b.addRunArtifact(polygonal_bench);
+    const bench_polygonal_step = b.step("bench-polygonal", "Benchmark boundary-cycle extraction against the map-based version");
+    bench_polygonal_step.dependOn(&run_polygonal_bench.step);
+
+    // Boolean backend benchmark on the sample tile and synthetic buildings
+    // (CSV on stdout). Built without Rerun so it links like a plain tool.
+    var bench_flags_list: std.ArrayListUnmanaged([]const u8) = .empty;
+    bench_flags_list.append(b.allocator, "-std=c++20") catch @panic("OOM");
+    if (enable_geogram) bench_flags_list.append(b.allocator, "-DENABLE_GEOGRAM=1") catch @panic("OOM");
+    const bench_flags = bench_flags_list.items;
+    const boolean_bench = b.addExecutable(.{
+        .name = "boolean_backends_bench",
+        .root_module = b.createModule(.{
+            .target = target,
+            .optimize = optimize,
+            .link_libcpp = true,
+        }),
+    });
+    if (enable_geogram) addGeogramIncludePathFromNixFlags(b, boolean_bench.root_module);
+    const boolean_bench_sources = [_][]const u8{
+        "bench/BooleanBackendsBench.cpp",
+        "src/BackendCostModel.cpp",
+        "src/OGRVectorReader.cpp",
+        "src/PolygonExtruder.cpp",
+        "src/BooleanOpsNef.cpp",
+        "src/BooleanOpsPMP.cpp",
+        "src/BooleanOpsManifold.cpp",
+        "src/MeshConversion.cpp",
+        "src/ModelLoaders.cpp",
+        "src/PolygonalOutput.cpp",
+        "src/BoundaryCycles.cpp",
+        "src/CycleNesting.cpp",
+        "src/PreparedPolygon.cpp",
+    };
+    for (boolean_bench_sources) |source| {
+        boolean_bench.root_module.addCSourceFile(.{
+            .file = b.path(source),
+            .flags = bench_flags,
+        });
+    }
+    if (enable_geogram) {
+        boolean_bench.root_module.addCSourceFile(.{
+            .file = b.path("src/BooleanOpsGeogram.cpp"),
+            .flags = bench_flags,
+        });
+    }
+    boolean_bench.root_module.addCSourceFile(.{
+        .file = b.path("src/GeometryKernels.cpp"),
+        .flags = std.mem.concat(b.allocator, []const u8, &.{ bench_flags, &.{"-fno-math-errno"} }) catch @panic("OOM"),
+    });
+    boolean_bench.root_module.addIncludePath(b.path("src"));
+    boolean_bench.root_module.addIncludePath(b.path("zityjson/include"));
+    boolean_bench.root_module.linkSystemLibrary("manifold", .{});
+    if (enable_geogram) boolean_bench.root_module.linkSystemLibrary("geogram", .{});
+    boolean_bench.root_module.linkSystemLibrary("gmp", .{});
+    boolean_bench.root_module.linkSystemLibrary("mpfr", .{});
+    boolean_bench.root_module.linkSystemLibrary("gdal", .{});
+    boolean_bench.root_module.linkSystemLibrary("zstd", .{});
+    boolean_bench.root_module.linkSystemLibrary("z", .{});
+    boolean_bench.root_module.linkLibrary(zfcb_lib);
+    boolean_bench.root_module.linkLibrary(zityjson_lib);
+    // Extra arguments after `--` select backends and repetitions, e.g.
+    // `zig build bench -Doptimize=ReleaseFast -- manifold,pmp 5`; add
+    // `--cost-model-out cost_model.csv` to calibrate the auto method.
+    const run_boolean_bench = b.addRunArtifact(boolean_bench);
+    run_boolean_bench.addFileArg(b.path("sample_data/9-444-728_sm.fcb"));
+    run_boolean_bench.addFileArg(b.path("sample_data/amsterdam_beemsterstraat_42.gpkg"));
+    run_boolean_bench.addArgs(&.{ "hoogte", "identificatie" });
+    if (b.args) |args| run_boolean_bench.addArgs(args);
+    const bench_step = b.step("bench", "Benchmark the boolean backends (CSV on stdout)");
+    bench_step.dependOn(&run_boolean_bench.step);
+
+    // C++ unit tests, one standalone executable each that exits non-zero on
+    // failure: `zig build test`.
+    // Sources in `kernel_sources` get the same kernel_flags as in the executable.
+    const unit_tests = [_]struct {
+        name: []const u8,
+        sources: []const []const u8,
+        kernel_sources: []const []const u8 = &.{},
+        libraries: []const []const u8 = &.{},
+    }{
+        .{ .name = "prepared_polygon_test", .sources = &.{ "tests/PreparedPolygonTest.cpp", "src/PreparedPolygon.cpp" } },
+        .{ .name = "cycle_nesting_test", .sources = &.{ "tests/CycleNestingTest.cpp", "src/CycleNesting.cpp", "src/PreparedPolygon.cpp" } },
+        .{
+            .name = "backend_cost_model_test",
+            .sources = &.{ "tests/BackendCostModelTest.cpp", "src/BackendCostModel.cpp", "src/MeshConversion.cpp" },
+            .kernel_sources = &.{"src/GeometryKernels.cpp"},
+            .libraries = &.{ "manifold", "gmp", "mpfr" },
+        },
+    };
+    const test_step = b.step("test", "Run the C++ unit tests");
+    for (unit_tests) |unit_test| {
+        const test_exe = b.addExecutable(.{
+            .name = unit_test.name,
+            .root_module = b.createModule(.{
+                .target = target,
+                .optimize = optimize,
+                .link_libcpp = true,
+            }),
+        });
+        for (unit_test.sources) |source| {
+            test_exe.root_module.addCSourceFile(.{
+                .file = b.path(source),
+                .flags = cpp_flags,
+            });
+        }
+        for (unit_test.kernel_sources) |source| {
+            test_exe.root_module.addCSourceFile(.{
+                .file = b.path(source),
+                .flags = kernel_flags,
+            });
+        }
+        test_exe.root_module.addIncludePath(b.path("src"));
+        for (unit_test.libraries) |library| {
+            test_exe.root_module.linkSystemLibrary(library, .{});
+        }
+        test_step.dependOn(&b.addRunArtifact(test_exe).step);
+    }
+
+    // libadd_underpass: the carve behind a C ABI (include/add_underpass.h),
+    // for embedding in other pipelines. Built without Rerun, like the bench.
+    const underpass_linkage = b.option(std.builtin.LinkMode, "underpass-linkage", "Linkage of libadd_underpass (static or dynamic)") orelse .static;
+    const underpass_lib = b.addLibrary(.{
+        .name = "add_underpass",
+        .linkage = underpass_linkage,
+        .root_module = b.createModule(.{
+            .target = target,
+            .optimize = optimize,
+            .link_libcpp = true,
+        }),
+    });
+    if (enable_geogram) addGeogramIncludePathFromNixFlags(b, underpass_lib.root_module);
+    const underpass_lib_sources = [_][]const u8{
+        "src/AddUnderpassApi.cpp",
+        "src/BackendCostModel.cpp",
+        "src/BooleanAttempt.cpp",
+        "src/PolygonExtruder.cpp",
+        "src/BooleanOpsNef.cpp",
+        "src/BooleanOpsPMP.cpp",
+        "src/BooleanOpsManifold.cpp",
+        "src/MeshConversion.cpp",
+        "src/ModelLoaders.cpp",
+        "src/PolygonalOutput.cpp",
+        "src/BoundaryCycles.cpp",
+        "src/CycleNesting.cpp",
+        "src/PreparedPolygon.cpp",
+    };
+    for (underpass_lib_sources) |source| {
+        underpass_lib.root_module.addCSourceFile(.{
+            .file = b.path(source),
+            .flags = bench_flags,
+        });
+    }
+    if (enable_geogram) {
+        underpass_lib.root_module.addCSourceFile(.{
+            .file = b.path("src/BooleanOpsGeogram.cpp"),
+            .flags = bench_flags,
+        });
+    }
+    underpass_lib.root_module.addCSourceFile(.{
+        .file = b.path("src/GeometryKernels.cpp"),
+        .flags = std.mem.concat(b.allocator, []const u8, &.{ bench_flags, &.{"-fno-math-errno"} }) catch @panic("OOM"),
+    });
+    underpass_lib.root_module.addIncludePath(b.path("include"));
+    underpass_lib.root_module.addIncludePath(b.path("src"));
+    underpass_lib.root_module.addIncludePath(b.path("zityjson/include"));
+    underpass_lib.root_module.linkSystemLibrary("manifold", .{});
+    if (enable_geogram) underpass_lib.root_module.linkSystemLibrary("geogram", .{});
+    underpass_lib.root_module.linkSystemLibrary("gmp", .{});
+    underpass_lib.root_module.linkSystemLibrary("mpfr", .{});
+    // ModelLoaders.cpp also carries the FCB/CityJSON loaders.
+    underpass_lib.root_module.linkLibrary(zfcb_lib);
+    underpass_lib.root_module.linkLibrary(zityjson_lib);
+    // Concurrent add_underpass_carve calls, linked like an embedding pipeline.
+    const underpass_api_test = b.addExecutable(.{
+        .name = "add_underpass_api_test",
+        .root_module = b.createModule(.{
+            .target = target,
+            .optimize = optimize,
+            .link_libcpp = true,
+        }),
+    });
+    underpass_api_test.root_module.addCSourceFile(.{
+        .file = b.path("tests/AddUnderpassApiTest.cpp"),
+        .flags = cpp_flags,
+    });
+    underpass_api_test.root_module.addIncludePath(b.path("include"));
+    underpass_api_test.root_module.linkLibrary(underpass_lib);
+    test_step.dependOn(&b.addRunArtifact(underpass_api_test).step);
+    const install_underpass_lib = b.step("lib-underpass", "Build and install libadd_underpass and add_underpass.h");
+    install_underpass_lib.dependOn(&b.addInstallArtifact(underpass_lib, .{}).step);
+    install_underpass_lib.dependOn(&b.addInstallFileWithDir(
+        b.path("include/add_underpass.h"),
+        .header,
+        "add_underpass.h",
+    ).step);
 }
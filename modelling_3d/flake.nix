@@ -46,6 +46,7 @@
           eigen
 
           zlib
+          zstd
 
           # GDAL with features
           gdal
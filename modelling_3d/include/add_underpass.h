@@ -0,0 +1,105 @@
+#ifndef ADD_UNDERPASS_H
+#define ADD_UNDERPASS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Boolean backends, in the order of a fallback chain.
+#define ADD_UNDERPASS_METHOD_MANIFOLD 0
+#define ADD_UNDERPASS_METHOD_NEF      1
+#define ADD_UNDERPASS_METHOD_PMP      2
+#define ADD_UNDERPASS_METHOD_GEOGRAM  3 // only when built with -Dgeogram=true
+// Ranks every backend per building with the built-in cost model. The model is
+// not updated, so calls stay independent of each other.
+#define ADD_UNDERPASS_METHOD_AUTO     255
+
+// Status codes returned by add_underpass_carve.
+#define ADD_UNDERPASS_OK                    0
+// Every backend failed or produced an empty mesh; the building is unchanged.
+#define ADD_UNDERPASS_NOT_CARVED            1
+#define ADD_UNDERPASS_ERROR_INVALID_ARGUMENT -1
+// No surface of the building could be triangulated.
+#define ADD_UNDERPASS_ERROR_INVALID_BUILDING -2
+// No underpass could be extruded.
+#define ADD_UNDERPASS_ERROR_INVALID_UNDERPASS -3
+// The boolean result could not be turned into polygonal surfaces.
+#define ADD_UNDERPASS_ERROR_POLYGONAL_OUTPUT -4
+#define ADD_UNDERPASS_ERROR_INTERNAL         -5
+
+// LoD 2.2 solid of one building in the FlatCityBuf layout, world coordinates.
+// Surfaces hold rings (the first is the exterior), rings hold vertex indices.
+typedef struct {
+    const double* vertices;              // xyz packed, length vertex_count * 3
+    size_t vertex_count;
+    const uint32_t* surfaces;            // ring count per surface
+    size_t surface_count;
+    const uint32_t* strings;             // vertex count per ring
+    size_t string_count;
+    const uint32_t* boundaries;          // ring vertex indices into vertices
+    size_t boundary_count;
+    const uint8_t* surface_semantic_types; // optional, FCB SemanticSurfaceType per surface, 255 => wall
+} AddUnderpassBuilding;
+
+// One underpass footprint, world coordinates.
+typedef struct {
+    const double* xy;                    // xy packed: exterior ring, then holes
+    const uint32_t* ring_vertex_counts;  // the first ring is the exterior
+    size_t ring_count;
+    // Absolute ceiling height; NaN => 2.5 m above the lowest building vertex.
+    double ceiling_z;
+} AddUnderpassFootprint;
+
+typedef struct {
+    // ADD_UNDERPASS_METHOD_* chain, tried in order. NULL/0 => pmp.
+    const uint8_t* methods;
+    size_t method_count;
+    // Wall-clock budget per backend attempt, 0 => none. Checked between
+    // boolean phases; one Nef or Manifold operation can run past it.
+    int64_t budget_ms;
+    // Extrude only the exterior ring of each footprint.
+    int ignore_holes;
+} AddUnderpassOptions;
+
+// Carved building as polygonal surfaces, world coordinates. Arrays are owned
+// by the result and released with add_underpass_result_free.
+typedef struct {
+    double* vertices;                    // xyz packed
+    size_t vertex_count;
+    uint32_t* surfaces;                  // ring count per surface
+    size_t surface_count;
+    uint32_t* strings;                   // vertex count per ring
+    size_t string_count;
+    uint32_t* boundaries;
+    size_t boundary_count;
+    uint8_t* surface_semantic_types;     // length surface_count
+    // Index of the footprint whose ceiling produced the surface, -1 otherwise.
+    int32_t* surface_underpass_indices;  // length surface_count
+    uint8_t method;                      // backend that produced the result
+    // Failure detail, truncated to fit. On success it lists the footprints
+    // that could not be extruded and were left out, else it is empty.
+    char message[256];
+} AddUnderpassResult;
+
+// Subtracts the extruded footprints from the building.
+// Reentrant: calls share no mutable state, so they may run concurrently from
+// any threads (Geogram attempts are serialized internally). options may be NULL.
+// On any status other than ADD_UNDERPASS_OK the result arrays are NULL.
+int add_underpass_carve(
+    const AddUnderpassBuilding* building,
+    const AddUnderpassFootprint* footprints,
+    size_t footprint_count,
+    const AddUnderpassOptions* options,
+    AddUnderpassResult* out_result);
+
+// Releases the arrays of a result and resets it; safe on a zeroed result.
+void add_underpass_result_free(AddUnderpassResult* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADD_UNDERPASS_H
@@ -0,0 +1,325 @@
+// C ABI of libadd_underpass: the add_underpass carve for one building, from
+// flat arrays to flat arrays, without files.
+
+#include "add_underpass.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BackendCostModel.h"
+#include "BooleanAttempt.h"
+#include "BooleanOps.h"
+#include "MeshConversion.h"
+#include "ModelLoaders.h"
+#include "PolygonExtruder.h"
+#include "PolygonalOutput.h"
+
+static_assert(ADD_UNDERPASS_METHOD_MANIFOLD == static_cast<int>(BooleanMethod::Manifold));
+static_assert(ADD_UNDERPASS_METHOD_NEF == static_cast<int>(BooleanMethod::CgalNef));
+static_assert(ADD_UNDERPASS_METHOD_PMP == static_cast<int>(BooleanMethod::CgalPMP));
+#ifdef ENABLE_GEOGRAM
+static_assert(ADD_UNDERPASS_METHOD_GEOGRAM == static_cast<int>(BooleanMethod::Geogram));
+#endif
+
+namespace {
+
+// Same fallback as add_underpass for footprints without an elevation.
+constexpr double kNullUnderpassHeightAboveGround = 2.5;
+
+#ifdef ENABLE_GEOGRAM
+// Geogram keeps process-wide state.
+std::mutex geogram_mutex;
+#endif
+
+void set_message(AddUnderpassResult* out, std::string_view message) {
+    std::snprintf(out->message, sizeof(out->message), "%.*s", static_cast<int>(message.size()), message.data());
+}
+
+int fail(AddUnderpassResult* out, int status, std::string_view message) {
+    set_message(out, message);
+    return status;
+}
+
+void append_detail(std::string& details, std::string_view detail) {
+    if (!details.empty()) {
+        details += "; ";
+    }
+    details += detail;
+}
+
+bool parse_methods(const AddUnderpassOptions* options, bool& auto_method, std::vector<BooleanMethod>& methods) {
+    auto_method = false;
+    if (options == nullptr || options->methods == nullptr || options->method_count == 0) {
+        methods.push_back(BooleanMethod::CgalPMP);
+        return true;
+    }
+    for (size_t i = 0; i < options->method_count; ++i) {
+        const uint8_t method = options->methods[i];
+        if (method == ADD_UNDERPASS_METHOD_AUTO) {
+            auto_method = true;
+        } else if (method < kAutoBooleanMethods.size()) {
+            methods.push_back(static_cast<BooleanMethod>(method));
+        } else {
+            return false;
+        }
+    }
+    // auto stands alone, as on the command line.
+    return !auto_method || methods.empty();
+}
+
+bool read_footprint(const AddUnderpassFootprint& footprint, ogr::LinearRing& ring) {
+    if (footprint.xy == nullptr || footprint.ring_vertex_counts == nullptr || footprint.ring_count == 0) {
+        return false;
+    }
+    const double* xy = footprint.xy;
+    for (size_t r = 0; r < footprint.ring_count; ++r) {
+        const uint32_t count = footprint.ring_vertex_counts[r];
+        if (count < 3) {
+            return false;
+        }
+        std::vector<std::array<double, 3>> points;
+        points.reserve(count);
+        for (uint32_t i = 0; i < count; ++i, xy += 2) {
+            points.push_back({xy[0], xy[1], 0.0});
+        }
+        if (r == 0) {
+            ring.assign(points.begin(), points.end());
+        } else {
+            ring.interior_rings().push_back(std::move(points));
+        }
+    }
+    return true;
+}
+
+// Geogram results arrive as MeshGL; the polygonal builder wants a Surface_mesh.
+Surface_mesh meshgl_to_surface_mesh(const manifold::MeshGL& meshgl) {
+    Surface_mesh mesh;
+    std::vector<Surface_mesh::Vertex_index> vertices;
+    vertices.reserve(meshgl.NumVert());
+    for (size_t v = 0; v < meshgl.NumVert(); ++v) {
+        const float* p = meshgl.vertProperties.data() + v * meshgl.numProp;
+        vertices.push_back(mesh.add_vertex(K::Point_3(p[0], p[1], p[2])));
+    }
+    for (size_t t = 0; t + 2 < meshgl.triVerts.size(); t += 3) {
+        mesh.add_face(vertices[meshgl.triVerts[t]], vertices[meshgl.triVerts[t + 1]], vertices[meshgl.triVerts[t + 2]]);
+    }
+    return mesh;
+}
+
+template <typename T>
+T* copy_array(const std::vector<T>& values) {
+    if (values.empty()) {
+        return nullptr;
+    }
+    auto* copy = static_cast<T*>(std::malloc(values.size() * sizeof(T)));
+    if (copy == nullptr) {
+        throw std::bad_alloc();
+    }
+    std::memcpy(copy, values.data(), values.size() * sizeof(T));
+    return copy;
+}
+
+void fill_result(const PolygonalOutput& polygonal, BooleanMethod method, AddUnderpassResult* out) {
+    out->vertices = copy_array(polygonal.vertices_xyz_world);
+    out->vertex_count = polygonal.vertices_xyz_world.size() / 3;
+    out->surfaces = copy_array(polygonal.surface_ring_counts);
+    out->surface_count = polygonal.surface_ring_counts.size();
+    out->strings = copy_array(polygonal.ring_vertex_counts);
+    out->string_count = polygonal.ring_vertex_counts.size();
+    out->boundaries = copy_array(polygonal.boundary_indices);
+    out->boundary_count = polygonal.boundary_indices.size();
+    out->surface_semantic_types = copy_array(polygonal.surface_semantic_types);
+    out->surface_underpass_indices = copy_array(polygonal.surface_underpass_indices);
+    out->method = static_cast<uint8_t>(method);
+}
+
+int carve(
+    const AddUnderpassBuilding* building,
+    const AddUnderpassFootprint* footprints,
+    size_t footprint_count,
+    const AddUnderpassOptions* options,
+    AddUnderpassResult* out) {
+    bool auto_method = false;
+    std::vector<BooleanMethod> methods;
+    if (!parse_methods(options, auto_method, methods)) {
+        return fail(out, ADD_UNDERPASS_ERROR_INVALID_ARGUMENT, "unknown method, or auto combined with other methods");
+    }
+    const std::chrono::milliseconds budget(options != nullptr && options->budget_ms > 0 ? options->budget_ms : 0);
+    const bool ignore_holes = options != nullptr && options->ignore_holes != 0;
+
+    // Local frame at the first vertex, as in add_underpass.
+    const double offset_x = building->vertices[0];
+    const double offset_y = building->vertices[1];
+    const double offset_z = building->vertices[2];
+    const RingedSolidSpans spans{
+        .vertices = building->vertices,
+        .vertex_count = building->vertex_count,
+        .surfaces = building->surfaces,
+        .surface_count = building->surface_count,
+        .strings = building->strings,
+        .string_count = building->string_count,
+        .boundaries = building->boundaries,
+        .boundary_count = building->boundary_count,
+        .surface_semantic_types = building->surface_semantic_types,
+    };
+    LoadedSolidMesh house;
+    if (!load_ringed_solid_mesh(spans, house, offset_x, offset_y, offset_z, "add_underpass_carve building")) {
+        return fail(out, ADD_UNDERPASS_ERROR_INVALID_BUILDING, "no building surface could be triangulated");
+    }
+    const double house_min_z = mesh_min_z(house.mesh);
+    if (!std::isfinite(house_min_z)) {
+        return fail(out, ADD_UNDERPASS_ERROR_INVALID_BUILDING, "could not determine building min z");
+    }
+
+    // UnderpassSurfaceSource points into `rings`, so it is sized up front.
+    std::vector<ogr::LinearRing> rings(footprint_count);
+    std::vector<Surface_mesh> underpass_meshes;
+    std::vector<UnderpassSurfaceSource> sources;
+    std::vector<double> ceiling_z;
+    double underpass_z = 0.0;
+    // Footprints left out, reported like add_underpass reports skipped features.
+    std::string skipped;
+    for (size_t i = 0; i < footprint_count; ++i) {
+        if (!read_footprint(footprints[i], rings[i])) {
+            return fail(out, ADD_UNDERPASS_ERROR_INVALID_ARGUMENT, "footprint " + std::to_string(i) + " is malformed");
+        }
+        const double roof_z = std::isfinite(footprints[i].ceiling_z)
+            ? footprints[i].ceiling_z - offset_z
+            : house_min_z + kNullUnderpassHeightAboveGround;
+        Surface_mesh mesh;
+        try {
+            mesh = extrusion::extrude_polygon(
+                make_offset_polygon(rings[i], offset_x, offset_y, offset_z), house_min_z - 0.1, roof_z, ignore_holes);
+        } catch (const std::exception& e) {
+            append_detail(skipped, "footprint " + std::to_string(i) + ": underpass extrusion failed (" + e.what() + ")");
+            continue;
+        } catch (...) {
+            append_detail(skipped, "footprint " + std::to_string(i) + ": underpass extrusion failed (unknown exception)");
+            continue;
+        }
+        if (mesh.number_of_faces() == 0) {
+            append_detail(skipped, "footprint " + std::to_string(i) + ": underpass extrusion produced empty mesh");
+            continue;
+        }
+        underpass_meshes.push_back(std::move(mesh));
+        underpass_z = roof_z;
+        ceiling_z.push_back(roof_z);
+        sources.push_back(UnderpassSurfaceSource{
+            .polygon_feature_index = i,
+            .polygon = &rings[i],
+            .prepared_polygon = std::make_shared<const pip::PreparedPolygon>(rings[i], rings[i].interior_rings()),
+            .roof_z_local = roof_z,
+        });
+    }
+    if (underpass_meshes.empty()) {
+        return fail(out, ADD_UNDERPASS_ERROR_INVALID_UNDERPASS, "no footprint could be extruded; " + skipped);
+    }
+
+    if (auto_method) {
+        methods = BackendCostModel().rank(boolean_feature_traits(house.mesh, underpass_meshes, ceiling_z, {}));
+    }
+    int status = ADD_UNDERPASS_NOT_CARVED;
+    std::string failures = skipped;
+    for (BooleanMethod method : methods) {
+        BooleanAttempt attempt;
+#ifdef ENABLE_GEOGRAM
+        if (method == BooleanMethod::Geogram) {
+            std::lock_guard<std::mutex> lock(geogram_mutex);
+            attempt = run_boolean_attempt(method, house.mesh, underpass_meshes, budget);
+        } else
+#endif
+        {
+            attempt = run_boolean_attempt(method, house.mesh, underpass_meshes, budget);
+        }
+        const size_t output_faces = attempt.has_polygonal_result
+            ? attempt.result_surface_mesh.number_of_faces()
+            : attempt.result_meshgl.NumTri();
+        if (!attempt.success || output_faces == 0) {
+            append_detail(
+                failures,
+                attempt.success ? std::string(boolean_method_name(method)) + " boolean produced empty mesh"
+                                : attempt.failure);
+            continue;
+        }
+
+        PolygonalOutput polygonal;
+        bool built = false;
+        if (method == BooleanMethod::Manifold) {
+            built = build_polygonal_output_from_manifold_meshgl(
+                attempt.result_meshgl, house, house_min_z, underpass_z, sources,
+                offset_x, offset_y, offset_z, polygonal);
+        } else {
+            const Surface_mesh result_mesh = attempt.has_polygonal_result
+                ? std::move(attempt.result_surface_mesh)
+                : meshgl_to_surface_mesh(attempt.result_meshgl);
+            built = build_polygonal_output_from_cgal_mesh(
+                result_mesh, house, house_min_z, underpass_z, sources,
+                offset_x, offset_y, offset_z, polygonal);
+        }
+        if (!built) {
+            status = ADD_UNDERPASS_ERROR_POLYGONAL_OUTPUT;
+            append_detail(failures, std::string(boolean_method_name(method)) + " result could not be converted to polygons");
+            continue;
+        }
+        fill_result(polygonal, method, out);
+        set_message(out, skipped);
+        return ADD_UNDERPASS_OK;
+    }
+    return fail(out, status, failures);
+}
+
+} // namespace
+
+extern "C" int add_underpass_carve(
+    const AddUnderpassBuilding* building,
+    const AddUnderpassFootprint* footprints,
+    size_t footprint_count,
+    const AddUnderpassOptions* options,
+    AddUnderpassResult* out_result) {
+    if (out_result == nullptr) {
+        return ADD_UNDERPASS_ERROR_INVALID_ARGUMENT;
+    }
+    *out_result = AddUnderpassResult{};
+    if (building == nullptr || building->vertices == nullptr || building->vertex_count == 0 ||
+        footprints == nullptr || footprint_count == 0) {
+        return fail(out_result, ADD_UNDERPASS_ERROR_INVALID_ARGUMENT, "missing building or footprints");
+    }
+    if ((building->surfaces == nullptr && building->surface_count != 0) ||
+        (building->strings == nullptr && building->string_count != 0) ||
+        (building->boundaries == nullptr && building->boundary_count != 0)) {
+        return fail(out_result, ADD_UNDERPASS_ERROR_INVALID_ARGUMENT, "building array is NULL but its count is not 0");
+    }
+    try {
+        return carve(building, footprints, footprint_count, options, out_result);
+    } catch (const std::exception& e) {
+        add_underpass_result_free(out_result);
+        return fail(out_result, ADD_UNDERPASS_ERROR_INTERNAL, e.what());
+    } catch (...) {
+        add_underpass_result_free(out_result);
+        return fail(out_result, ADD_UNDERPASS_ERROR_INTERNAL, "unknown exception");
+    }
+}
+
+extern "C" void add_underpass_result_free(AddUnderpassResult* result) {
+    if (result == nullptr) {
+        return;
+    }
+    std::free(result->vertices);
+    std::free(result->surfaces);
+    std::free(result->strings);
+    std::free(result->boundaries);
+    std::free(result->surface_semantic_types);
+    std::free(result->surface_underpass_indices);
+    *result = AddUnderpassResult{};
+}
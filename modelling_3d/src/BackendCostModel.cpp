@@ -0,0 +1,312 @@
+#include "BackendCostModel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+#include <manifold/manifold.h>
+
+#include "MeshConversion.h"
+
+namespace {
+
+// Height difference under which a ceiling counts as coplanar with a house face.
+constexpr double kCoplanarToleranceM = 0.01;
+// Weight of the built-in priors, in observations.
+constexpr double kPriorSamples = 8.0;
+
+constexpr std::string_view kCsvHeader =
+    "backend,samples,sum_kfaces,sum_ms,sum_kfaces_sq,sum_kfaces_ms,failures,"
+    "non_manifold_attempts,non_manifold_failures,val3dity_attempts,val3dity_failures,"
+    "coplanar_attempts,coplanar_failures";
+constexpr size_t kCsvColumnCount = 13;
+
+size_t method_index(BooleanMethod method) {
+    return static_cast<size_t>(method);
+}
+
+// Smoothed rate, so a backend with no observations is not trusted blindly.
+double failure_rate(double failures, double attempts) {
+    return (failures + 0.5) / (attempts + 1.0);
+}
+
+std::vector<std::string_view> split_csv_line(std::string_view line) {
+    std::vector<std::string_view> fields;
+    while (true) {
+        const size_t comma = line.find(',');
+        fields.push_back(line.substr(0, comma));
+        if (comma == std::string_view::npos) {
+            return fields;
+        }
+        line.remove_prefix(comma + 1);
+    }
+}
+
+bool parse_double(std::string_view field, double& value) {
+    const std::string text(field);
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtod(text.c_str(), &end);
+    return !text.empty() && end == text.c_str() + text.size() && errno == 0 && std::isfinite(value) && value >= 0.0;
+}
+
+} // namespace
+
+BooleanFeatureTraits boolean_feature_traits(
+    const Surface_mesh& house,
+    const std::vector<Surface_mesh>& underpasses,
+    const std::vector<double>& ceiling_z,
+    std::string_view b3_val3dity_lod22) {
+    BooleanFeatureTraits traits;
+    traits.input_triangles = house.number_of_faces();
+    for (const auto& underpass : underpasses) {
+        traits.input_triangles += underpass.number_of_faces();
+    }
+    traits.underpass_count = underpasses.size();
+    // Valid buildings carry "[]"; invalid ones list val3dity error codes.
+    traits.val3dity_errors = b3_val3dity_lod22.find_first_of("0123456789") != std::string_view::npos;
+
+    // surface_mesh_to_meshgl takes a mutable mesh.
+    Surface_mesh house_copy = house;
+    const manifold::MeshGL house_meshgl = surface_mesh_to_meshgl(house_copy, false);
+    traits.non_manifold_input = house_meshgl.NumTri() == 0 ||
+                                manifold::Manifold(house_meshgl).Status() != manifold::Manifold::Error::NoError;
+
+    for (auto f : house.faces()) {
+        double min_z = std::numeric_limits<double>::infinity();
+        double max_z = -std::numeric_limits<double>::infinity();
+        for (auto v : house.vertices_around_face(house.halfedge(f))) {
+            const double z = house.point(v).z();
+            min_z = std::min(min_z, z);
+            max_z = std::max(max_z, z);
+        }
+        if (max_z - min_z > kCoplanarToleranceM) {
+            continue;
+        }
+        for (double z : ceiling_z) {
+            if (std::abs(z - min_z) <= kCoplanarToleranceM) {
+                traits.coplanar_ceiling = true;
+                return traits;
+            }
+        }
+    }
+    return traits;
+}
+
+BackendCostModel::Entry BackendCostModel::prior(
+    double fixed_ms,
+    double ms_per_kface,
+    double failure_rate,
+    const std::array<double, kConditionCount>& condition_failure_rates) {
+    // Half of the weight at 1k and half at 10k input triangles reproduces the
+    // line through those points.
+    Entry entry;
+    for (const double kfaces : {1.0, 10.0}) {
+        const double weight = kPriorSamples / 2.0;
+        const double ms = fixed_ms + ms_per_kface * kfaces;
+        entry.samples += weight;
+        entry.sum_kfaces += weight * kfaces;
+        entry.sum_ms += weight * ms;
+        entry.sum_kfaces_sq += weight * kfaces * kfaces;
+        entry.sum_kfaces_ms += weight * kfaces * ms;
+    }
+    entry.failures = kPriorSamples * failure_rate;
+    for (size_t c = 0; c < kConditionCount; ++c) {
+        entry.condition_attempts[c] = kPriorSamples;
+        entry.condition_failures[c] = kPriorSamples * condition_failure_rates[c];
+    }
+    return entry;
+}
+
+BackendCostModel::BackendCostModel() {
+    // Rough orders of magnitude from the sample tile; calibrate with
+    // `zig build bench -- --cost-model-out` for real numbers.
+    // Condition order: non-manifold input, val3dity errors, coplanar ceiling.
+    entries_[method_index(BooleanMethod::Manifold)] = prior(1.0, 0.5, 0.05, {0.95, 0.3, 0.1});
+    entries_[method_index(BooleanMethod::CgalPMP)] = prior(5.0, 10.0, 0.05, {0.3, 0.2, 0.2});
+    entries_[method_index(BooleanMethod::CgalNef)] = prior(50.0, 80.0, 0.01, {0.05, 0.05, 0.02});
+#ifdef ENABLE_GEOGRAM
+    entries_[method_index(BooleanMethod::Geogram)] = prior(5.0, 5.0, 0.1, {0.3, 0.2, 0.3});
+#endif
+}
+
+BackendCostModel BackendCostModel::empty() {
+    BackendCostModel model;
+    model.entries_.fill(Entry{});
+    return model;
+}
+
+bool BackendCostModel::load_csv(const std::string& path, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        error = "cannot open file";
+        return false;
+    }
+    std::string contents;
+    char buffer[4096];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, read);
+    }
+    std::fclose(file);
+
+    auto entries = entries_;
+    std::string_view remaining(contents);
+    size_t line_number = 0;
+    while (!remaining.empty()) {
+        const size_t newline = remaining.find('\n');
+        std::string_view line = remaining.substr(0, newline);
+        remaining = newline == std::string_view::npos ? std::string_view{} : remaining.substr(newline + 1);
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line_number == 1) {
+            if (line != kCsvHeader) {
+                error = "unexpected header";
+                return false;
+            }
+            continue;
+        }
+        if (line.empty()) {
+            continue;
+        }
+        const auto fields = split_csv_line(line);
+        std::array<double, kCsvColumnCount - 1> values{};
+        bool valid = fields.size() == kCsvColumnCount;
+        for (size_t i = 1; valid && i < kCsvColumnCount; ++i) {
+            valid = parse_double(fields[i], values[i - 1]);
+        }
+        if (!valid) {
+            error = "invalid row on line " + std::to_string(line_number);
+            return false;
+        }
+        // Rows for backends this build lacks are ignored.
+        const auto method = std::find_if(kAutoBooleanMethods.begin(), kAutoBooleanMethods.end(), [&](BooleanMethod m) {
+            return fields[0] == boolean_method_name(m);
+        });
+        if (method == kAutoBooleanMethods.end()) {
+            continue;
+        }
+        Entry& entry = entries[method_index(*method)];
+        entry.samples = values[0];
+        entry.sum_kfaces = values[1];
+        entry.sum_ms = values[2];
+        entry.sum_kfaces_sq = values[3];
+        entry.sum_kfaces_ms = values[4];
+        entry.failures = values[5];
+        for (size_t c = 0; c < kConditionCount; ++c) {
+            entry.condition_attempts[c] = values[6 + 2 * c];
+            entry.condition_failures[c] = values[7 + 2 * c];
+        }
+    }
+    if (line_number == 0) {
+        error = "empty file";
+        return false;
+    }
+    entries_ = entries;
+    return true;
+}
+
+bool BackendCostModel::write_csv(const std::string& path) const {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = std::fprintf(file, "%.*s\n", static_cast<int>(kCsvHeader.size()), kCsvHeader.data()) > 0;
+    for (BooleanMethod method : kAutoBooleanMethods) {
+        const Entry& entry = entries_[method_index(method)];
+        // Unmeasured backends keep their priors when the table is loaded.
+        if (entry.samples <= 0.0) {
+            continue;
+        }
+        written = written &&
+            std::fprintf(file, "%s,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g\n",
+                         boolean_method_name(method), entry.samples, entry.sum_kfaces, entry.sum_ms,
+                         entry.sum_kfaces_sq, entry.sum_kfaces_ms, entry.failures,
+                         entry.condition_attempts[NonManifold], entry.condition_failures[NonManifold],
+                         entry.condition_attempts[Val3dityErrors], entry.condition_failures[Val3dityErrors],
+                         entry.condition_attempts[CoplanarCeiling], entry.condition_failures[CoplanarCeiling]) > 0;
+    }
+    return (std::fclose(file) == 0) && written;
+}
+
+void BackendCostModel::record(
+    BooleanMethod method,
+    const BooleanFeatureTraits& traits,
+    double boolean_ms,
+    bool succeeded) {
+    Entry& entry = entries_[method_index(method)];
+    const double kfaces = static_cast<double>(traits.input_triangles) / 1000.0;
+    entry.samples += 1.0;
+    entry.sum_kfaces += kfaces;
+    entry.sum_ms += boolean_ms;
+    entry.sum_kfaces_sq += kfaces * kfaces;
+    entry.sum_kfaces_ms += kfaces * boolean_ms;
+    const double failed = succeeded ? 0.0 : 1.0;
+    entry.failures += failed;
+    const std::array<bool, kConditionCount> active{
+        traits.non_manifold_input, traits.val3dity_errors, traits.coplanar_ceiling};
+    for (size_t c = 0; c < kConditionCount; ++c) {
+        if (active[c]) {
+            entry.condition_attempts[c] += 1.0;
+            entry.condition_failures[c] += failed;
+        }
+    }
+}
+
+double charged_boolean_ms(double boolean_ms, double wall_ms, bool succeeded) {
+    return succeeded ? boolean_ms : std::max(boolean_ms, wall_ms);
+}
+
+double BackendCostModel::predicted_ms(BooleanMethod method, const BooleanFeatureTraits& traits) const {
+    const Entry& entry = entries_[method_index(method)];
+    if (entry.samples <= 0.0) {
+        return 0.0;
+    }
+    const double kfaces = static_cast<double>(traits.input_triangles) / 1000.0;
+    const double mean_kfaces = entry.sum_kfaces / entry.samples;
+    const double mean_ms = entry.sum_ms / entry.samples;
+    const double variance = entry.sum_kfaces_sq / entry.samples - mean_kfaces * mean_kfaces;
+    if (variance <= 1e-12) {
+        return mean_ms;
+    }
+    const double slope = (entry.sum_kfaces_ms / entry.samples - mean_kfaces * mean_ms) / variance;
+    return std::max(0.0, mean_ms + slope * (kfaces - mean_kfaces));
+}
+
+double BackendCostModel::failure_probability(BooleanMethod method, const BooleanFeatureTraits& traits) const {
+    const Entry& entry = entries_[method_index(method)];
+    double probability = failure_rate(entry.failures, entry.samples);
+    const std::array<bool, kConditionCount> active{
+        traits.non_manifold_input, traits.val3dity_errors, traits.coplanar_ceiling};
+    for (size_t c = 0; c < kConditionCount; ++c) {
+        if (active[c]) {
+            probability = std::max(probability, failure_rate(entry.condition_failures[c], entry.condition_attempts[c]));
+        }
+    }
+    return probability;
+}
+
+std::vector<BooleanMethod> BackendCostModel::rank(const BooleanFeatureTraits& traits) const {
+    std::array<double, kAutoBooleanMethods.size()> predicted{};
+    double fallback_ms = 0.0;
+    for (BooleanMethod method : kAutoBooleanMethods) {
+        predicted[method_index(method)] = predicted_ms(method, traits);
+        fallback_ms = std::max(fallback_ms, predicted[method_index(method)]);
+    }
+    std::vector<std::pair<double, BooleanMethod>> scored;
+    for (BooleanMethod method : kAutoBooleanMethods) {
+        scored.emplace_back(
+            predicted[method_index(method)] + failure_probability(method, traits) * fallback_ms, method);
+    }
+    std::stable_sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<BooleanMethod> ranked;
+    for (const auto& [score, method] : scored) {
+        ranked.push_back(method);
+    }
+    return ranked;
+}
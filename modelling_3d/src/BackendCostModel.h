@@ -0,0 +1,101 @@
+#ifndef BACKEND_COST_MODEL_H
+#define BACKEND_COST_MODEL_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BooleanOps.h"
+
+// Backends the auto method chooses from, in enum order.
+inline constexpr std::array kAutoBooleanMethods{
+    BooleanMethod::Manifold,
+    BooleanMethod::CgalNef,
+    BooleanMethod::CgalPMP,
+#ifdef ENABLE_GEOGRAM
+    BooleanMethod::Geogram,
+#endif
+};
+
+// Cheap per-building inputs of the cost model, known before any boolean.
+struct BooleanFeatureTraits {
+    // House plus underpass triangles.
+    size_t input_triangles = 0;
+    size_t underpass_count = 0;
+    // b3_val3dity_lod22 lists error codes.
+    bool val3dity_errors = false;
+    // Manifold rejects the house mesh (Manifold::Status() != NoError).
+    bool non_manifold_input = false;
+    // An underpass ceiling lies in the plane of a horizontal house face.
+    bool coplanar_ceiling = false;
+};
+
+BooleanFeatureTraits boolean_feature_traits(
+    const Surface_mesh& house,
+    const std::vector<Surface_mesh>& underpasses,
+    const std::vector<double>& ceiling_z,
+    std::string_view b3_val3dity_lod22);
+
+// Time a boolean attempt is charged in the cost model. Failed attempts,
+// including ones killed at the budget, lost to a worker crash or stopped by
+// the in-process deadline, come back without complete phase timings, so they
+// are charged at least the wall time `wall_ms` they ran.
+double charged_boolean_ms(double boolean_ms, double wall_ms, bool succeeded);
+
+// Per-backend run time and failure model behind the `auto` method.
+//
+// Time is a least-squares line over thousands of input triangles; failure
+// rates are kept overall and for each risky trait. Both are stored as running
+// sums, so observations from the benchmark or from earlier runs (see
+// --cost-model) merge exactly with the built-in priors or a loaded table.
+class BackendCostModel {
+public:
+    // Built-in priors, weighted like a handful of observations each.
+    BackendCostModel();
+
+    // A model without observations, for calibration from scratch.
+    static BackendCostModel empty();
+
+    // Replaces the rows of the backends listed in a table written by
+    // write_csv(); backends not in the table keep their current rows.
+    bool load_csv(const std::string& path, std::string& error);
+    bool write_csv(const std::string& path) const;
+
+    void record(BooleanMethod method, const BooleanFeatureTraits& traits, double boolean_ms, bool succeeded);
+
+    double predicted_ms(BooleanMethod method, const BooleanFeatureTraits& traits) const;
+    double failure_probability(BooleanMethod method, const BooleanFeatureTraits& traits) const;
+
+    // All backends, cheapest expected cost first: predicted time plus the
+    // failure probability times the slowest backend's time, which is what a
+    // failed attempt costs in the fallback chain.
+    std::vector<BooleanMethod> rank(const BooleanFeatureTraits& traits) const;
+
+private:
+    enum Condition {
+        NonManifold,
+        Val3dityErrors,
+        CoplanarCeiling,
+        kConditionCount,
+    };
+
+    struct Entry {
+        double samples = 0.0;
+        double sum_kfaces = 0.0;
+        double sum_ms = 0.0;
+        double sum_kfaces_sq = 0.0;
+        double sum_kfaces_ms = 0.0;
+        double failures = 0.0;
+        std::array<double, kConditionCount> condition_attempts{};
+        std::array<double, kConditionCount> condition_failures{};
+    };
+
+    static Entry prior(double fixed_ms, double ms_per_kface, double failure_rate,
+                       const std::array<double, kConditionCount>& condition_failure_rates);
+
+    std::array<Entry, kAutoBooleanMethods.size()> entries_{};
+};
+
+#endif // BACKEND_COST_MODEL_H
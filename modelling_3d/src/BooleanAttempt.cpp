@@ -0,0 +1,54 @@
+#include "BooleanAttempt.h"
+
+#include <exception>
+#include <format>
+
+#include "BooleanOpsManifold.h"
+#include "MeshConversion.h"
+
+using Clock = std::chrono::steady_clock;
+
+BooleanAttempt run_boolean_attempt(
+    BooleanMethod method,
+    const Surface_mesh& house,
+    std::vector<Surface_mesh>& underpasses,
+    std::chrono::milliseconds budget) {
+    BooleanAttempt attempt;
+    attempt.success = true;
+    const char* method_name = boolean_method_name(method);
+    const BooleanDeadline deadline = budget.count() > 0 ? BooleanDeadline(Clock::now() + budget) : BooleanDeadline{};
+    Surface_mesh house_sm = house;
+    try {
+        if (method == BooleanMethod::Manifold) {
+            ManifoldBooleanError error = ManifoldBooleanError::None;
+            attempt.success = manifold_boolean_difference(
+                house_sm, underpasses, attempt.result_meshgl, &attempt.timing, &error, deadline);
+            if (!attempt.success) {
+                attempt.failure = error == ManifoldBooleanError::EmptyInputMesh ? "empty mesh for manifold boolean"
+                    : error == ManifoldBooleanError::InvalidInput               ? "invalid manifold input"
+                                                                                : "manifold boolean failed";
+            }
+        } else if (method == BooleanMethod::CgalNef) {
+            attempt.result_surface_mesh = nef_boolean_difference(house_sm, underpasses, &attempt.timing, deadline);
+            attempt.has_polygonal_result = true;
+#ifdef ENABLE_GEOGRAM
+        } else if (method == BooleanMethod::Geogram) {
+            Surface_mesh result_sm = geogram_boolean_difference(house_sm, underpasses, &attempt.timing, deadline);
+            auto t_conversion_start = Clock::now();
+            attempt.result_meshgl = surface_mesh_to_meshgl(result_sm, false);
+            attempt.timing.conversion_ms += Clock::now() - t_conversion_start;
+#endif
+        } else {
+            attempt.result_surface_mesh = corefine_boolean_difference(house_sm, underpasses, &attempt.timing, deadline);
+            attempt.has_polygonal_result = true;
+        }
+    } catch (const BooleanDeadlineExceeded&) {
+        attempt.success = false;
+        attempt.budget_exceeded = true;
+        attempt.failure = std::format("{} boolean exceeded the {} ms budget", method_name, budget.count());
+    } catch (const std::exception& e) {
+        attempt.success = false;
+        attempt.failure = std::format("{} boolean failed ({})", method_name, e.what());
+    }
+    return attempt;
+}
@@ -0,0 +1,36 @@
+#ifndef BOOLEAN_ATTEMPT_H
+#define BOOLEAN_ATTEMPT_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <manifold/manifold.h>
+
+#include "BooleanOps.h"
+
+// Outcome of one boolean difference with one backend.
+struct BooleanAttempt {
+    // The backend returned without error; the result may still be empty.
+    bool success = false;
+    bool budget_exceeded = false;
+    std::string failure;
+    manifold::MeshGL result_meshgl;
+    Surface_mesh result_surface_mesh;
+    bool has_polygonal_result = false;
+    BooleanOpTiming timing;
+    // Peak memory the attempt added to its worker process's resident set;
+    // 0 when it ran in-process or the worker could not measure it.
+    size_t peak_bytes = 0;
+};
+
+// Runs `method` in this process. Backend exceptions, including CGAL
+// assertions, become a failed attempt; crashes do not.
+BooleanAttempt run_boolean_attempt(
+    BooleanMethod method,
+    const Surface_mesh& house,
+    std::vector<Surface_mesh>& underpasses,
+    std::chrono::milliseconds budget);
+
+#endif // BOOLEAN_ATTEMPT_H
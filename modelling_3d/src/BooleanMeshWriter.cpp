@@ -0,0 +1,546 @@
+#include "BooleanMeshWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <format>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+class BooleanMeshWriter::Encoder {
+public:
+    virtual ~Encoder() = default;
+    virtual bool write(const FeatureMesh& mesh) = 0;
+    // Completes and closes the file.
+    virtual bool finish() = 0;
+};
+
+namespace {
+
+using FeatureMesh = BooleanMeshWriter::FeatureMesh;
+
+// Meshes the pipeline may run ahead of the writer thread before append blocks.
+constexpr size_t kMaxQueuedMeshes = 64;
+constexpr size_t kWriteBufferBytes = size_t{4} << 20;
+
+std::string obj_safe_feature_id(std::string_view feature_id) {
+    std::string result;
+    result.reserve(feature_id.size());
+    for (const unsigned char c : feature_id) {
+        const bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                          (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.';
+        result.push_back(safe ? static_cast<char>(c) : '_');
+    }
+    return result.empty() ? "feature" : result;
+}
+
+bool ends_with_ignore_case(std::string_view text, std::string_view suffix) {
+    if (text.size() < suffix.size()) {
+        return false;
+    }
+    return std::equal(suffix.begin(), suffix.end(), text.end() - static_cast<std::ptrdiff_t>(suffix.size()),
+                      [](char a, char b) {
+                          const auto lower = [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; };
+                          return lower(a) == lower(b);
+                      });
+}
+
+// stdio file behind a large write buffer; every write after a failure is a
+// no-op and close() reports it.
+class BufferedFile {
+public:
+    explicit BufferedFile(std::FILE* file) : file_(file), ok_(file != nullptr) {
+        buffer_.reserve(kWriteBufferBytes);
+    }
+    ~BufferedFile() {
+        if (file_ != nullptr) {
+            std::fclose(file_);
+        }
+    }
+    BufferedFile(const BufferedFile&) = delete;
+    BufferedFile& operator=(const BufferedFile&) = delete;
+
+    bool is_open() const { return file_ != nullptr; }
+    bool ok() const { return ok_; }
+    uint64_t bytes_written() const { return bytes_written_; }
+
+    void write(const void* data, size_t size) {
+        if (!ok_) {
+            return;
+        }
+        bytes_written_ += size;
+        if (buffer_.size() + size > kWriteBufferBytes) {
+            flush();
+            if (size >= kWriteBufferBytes) {
+                ok_ = ok_ && std::fwrite(data, 1, size, file_) == size;
+                return;
+            }
+        }
+        const char* bytes = static_cast<const char*>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+    void write(std::string_view text) { write(text.data(), text.size()); }
+
+    template <typename T>
+    void write_le(T value) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8);
+        using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+        const Bits bits = std::bit_cast<Bits>(value);
+        if constexpr (std::endian::native == std::endian::little) {
+            write(&bits, sizeof(bits));
+        } else {
+            std::array<unsigned char, sizeof(Bits)> bytes;
+            for (size_t i = 0; i < bytes.size(); ++i) {
+                bytes[i] = static_cast<unsigned char>(bits >> (8 * i));
+            }
+            write(bytes.data(), bytes.size());
+        }
+    }
+
+    void flush() {
+        if (ok_ && !buffer_.empty()) {
+            ok_ = std::fwrite(buffer_.data(), 1, buffer_.size(), file_) == buffer_.size();
+        }
+        buffer_.clear();
+    }
+
+    // Appends everything written to `source` so far.
+    void append_contents_of(BufferedFile& source) {
+        source.flush();
+        if (!source.ok_ || std::fseek(source.file_, 0, SEEK_SET) != 0) {
+            ok_ = false;
+            return;
+        }
+        flush();
+        std::vector<char> chunk(kWriteBufferBytes);
+        size_t read = 0;
+        while (ok_ && (read = std::fread(chunk.data(), 1, chunk.size(), source.file_)) > 0) {
+            ok_ = std::fwrite(chunk.data(), 1, read, file_) == read;
+        }
+        ok_ = ok_ && !std::ferror(source.file_);
+    }
+
+    bool close() {
+        if (file_ == nullptr) {
+            return false;
+        }
+        flush();
+        ok_ = (std::fclose(file_) == 0) && ok_;
+        file_ = nullptr;
+        return ok_;
+    }
+
+private:
+    std::FILE* file_ = nullptr;
+    std::vector<char> buffer_;
+    uint64_t bytes_written_ = 0;
+    bool ok_ = false;
+};
+
+template <typename T>
+char* format_number(char* cursor, char* end, T value) {
+    return std::to_chars(cursor, end, value).ptr;
+}
+
+class ObjEncoder final : public BooleanMeshWriter::Encoder {
+public:
+    explicit ObjEncoder(std::FILE* file) : out_(file) {
+        out_.write("# Boolean results from add_underpass\n");
+    }
+
+    bool write(const FeatureMesh& mesh) override {
+        out_.write("\no ");
+        out_.write(mesh.name);
+        out_.write("\n");
+
+        // Shortest round-trip representation of each coordinate.
+        std::array<char, 128> line;
+        const size_t vertex_count = mesh.positions.size() / 3;
+        for (size_t v = 0; v < vertex_count; ++v) {
+            char* cursor = line.data();
+            char* const end = line.data() + line.size();
+            *cursor++ = 'v';
+            for (size_t axis = 0; axis < 3; ++axis) {
+                *cursor++ = ' ';
+                const double value = mesh.positions[v * 3 + axis];
+                cursor = mesh.single_precision
+                    ? format_number(cursor, end, static_cast<float>(value))
+                    : format_number(cursor, end, value);
+            }
+            *cursor++ = '\n';
+            out_.write(line.data(), static_cast<size_t>(cursor - line.data()));
+        }
+
+        const size_t face_count = mesh.face_offsets.empty() ? 0 : mesh.face_offsets.size() - 1;
+        std::array<char, 24> number;
+        for (size_t f = 0; f < face_count; ++f) {
+            out_.write("f");
+            for (uint32_t i = mesh.face_offsets[f]; i < mesh.face_offsets[f + 1]; ++i) {
+                number[0] = ' ';
+                char* cursor = format_number(
+                    number.data() + 1, number.data() + number.size(), next_vertex_index_ + mesh.face_vertices[i]);
+                out_.write(number.data(), static_cast<size_t>(cursor - number.data()));
+            }
+            out_.write("\n");
+        }
+        next_vertex_index_ += vertex_count;
+        return out_.ok();
+    }
+
+    bool finish() override { return out_.close(); }
+
+private:
+    BufferedFile out_;
+    uint64_t next_vertex_index_ = 1;
+};
+
+// The PLY header holds the element counts, so vertex and face records go to
+// anonymous temporary files and are appended behind the header on finish.
+class PlyEncoder final : public BooleanMeshWriter::Encoder {
+public:
+    explicit PlyEncoder(std::FILE* file)
+        : out_(file), vertices_(std::tmpfile()), faces_(std::tmpfile()) {}
+
+    bool write(const FeatureMesh& mesh) override {
+        if (!vertices_.is_open() || !faces_.is_open()) {
+            return false;
+        }
+        const size_t vertex_count = mesh.positions.size() / 3;
+        if (vertex_count_ + vertex_count > std::numeric_limits<uint32_t>::max()) {
+            return false;
+        }
+        for (double coordinate : mesh.positions) {
+            vertices_.write_le(coordinate);
+        }
+        const auto feature_index = static_cast<uint32_t>(names_.size());
+        const size_t face_count = mesh.face_offsets.empty() ? 0 : mesh.face_offsets.size() - 1;
+        for (size_t f = 0; f < face_count; ++f) {
+            faces_.write_le(mesh.face_offsets[f + 1] - mesh.face_offsets[f]);
+            for (uint32_t i = mesh.face_offsets[f]; i < mesh.face_offsets[f + 1]; ++i) {
+                faces_.write_le(static_cast<uint32_t>(vertex_count_ + mesh.face_vertices[i]));
+            }
+            faces_.write_le(feature_index);
+        }
+        vertex_count_ += vertex_count;
+        face_count_ += face_count;
+        names_.push_back(mesh.name);
+        return vertices_.ok() && faces_.ok();
+    }
+
+    bool finish() override {
+        std::string header = "ply\nformat binary_little_endian 1.0\ncomment Boolean results from add_underpass\n";
+        for (size_t i = 0; i < names_.size(); ++i) {
+            header += std::format("comment feature {} {}\n", i, names_[i]);
+        }
+        header += std::format(
+            "element vertex {}\nproperty double x\nproperty double y\nproperty double z\n"
+            "element face {}\nproperty list uint uint vertex_indices\nproperty uint feature\nend_header\n",
+            vertex_count_, face_count_);
+        out_.write(header);
+        out_.append_contents_of(vertices_);
+        out_.append_contents_of(faces_);
+        return out_.close();
+    }
+
+private:
+    BufferedFile out_;
+    BufferedFile vertices_;
+    BufferedFile faces_;
+    std::vector<std::string> names_;
+    size_t vertex_count_ = 0;
+    size_t face_count_ = 0;
+};
+
+// One glTF node and mesh per feature. glTF is Y-up, so local (x, y, z) is
+// stored as (x, z, -y); polygonal faces are fan-triangulated. The binary chunk
+// is staged in a temporary file because the JSON chunk precedes it.
+class GlbEncoder final : public BooleanMeshWriter::Encoder {
+public:
+    explicit GlbEncoder(std::FILE* file) : out_(file), body_(std::tmpfile()) {}
+
+    bool write(const FeatureMesh& mesh) override {
+        if (!body_.is_open()) {
+            return false;
+        }
+        const size_t vertex_count = mesh.positions.size() / 3;
+        const size_t face_count = mesh.face_offsets.empty() ? 0 : mesh.face_offsets.size() - 1;
+        size_t index_count = 0;
+        for (size_t f = 0; f < face_count; ++f) {
+            const uint32_t size = mesh.face_offsets[f + 1] - mesh.face_offsets[f];
+            index_count += size >= 3 ? (size - 2) * 3 : 0;
+        }
+        if (vertex_count == 0 || index_count == 0) {
+            // glTF accessors cannot be empty.
+            return true;
+        }
+
+        GlbMesh record;
+        record.name = mesh.name;
+        record.vertex_count = vertex_count;
+        record.index_count = index_count;
+        record.positions_offset = body_.bytes_written();
+        record.min.fill(std::numeric_limits<float>::infinity());
+        record.max.fill(-std::numeric_limits<float>::infinity());
+        for (size_t v = 0; v < vertex_count; ++v) {
+            const std::array<float, 3> p = {
+                static_cast<float>(mesh.positions[v * 3 + 0]),
+                static_cast<float>(mesh.positions[v * 3 + 2]),
+                static_cast<float>(-mesh.positions[v * 3 + 1]),
+            };
+            for (size_t axis = 0; axis < 3; ++axis) {
+                body_.write_le(p[axis]);
+                record.min[axis] = std::min(record.min[axis], p[axis]);
+                record.max[axis] = std::max(record.max[axis], p[axis]);
+            }
+        }
+        record.indices_offset = body_.bytes_written();
+        for (size_t f = 0; f < face_count; ++f) {
+            const uint32_t first = mesh.face_offsets[f];
+            for (uint32_t i = first + 1; i + 1 < mesh.face_offsets[f + 1]; ++i) {
+                body_.write_le(mesh.face_vertices[first]);
+                body_.write_le(mesh.face_vertices[i]);
+                body_.write_le(mesh.face_vertices[i + 1]);
+            }
+        }
+        meshes_.push_back(std::move(record));
+        return body_.ok();
+    }
+
+    bool finish() override {
+        const uint64_t body_bytes = body_.bytes_written();
+        std::string json = R"({"asset":{"version":"2.0","generator":"add_underpass"},"scene":0,"scenes":[{"nodes":[)";
+        for (size_t i = 0; i < meshes_.size(); ++i) {
+            json += std::format("{}{}", i == 0 ? "" : ",", i);
+        }
+        json += "]}],\"nodes\":[";
+        for (size_t i = 0; i < meshes_.size(); ++i) {
+            json += std::format("{}{{\"name\":\"{}\",\"mesh\":{}}}", i == 0 ? "" : ",", meshes_[i].name, i);
+        }
+        json += "],\"meshes\":[";
+        for (size_t i = 0; i < meshes_.size(); ++i) {
+            json += std::format(
+                "{}{{\"name\":\"{}\",\"primitives\":[{{\"attributes\":{{\"POSITION\":{}}},\"indices\":{},\"mode\":4}}]}}",
+                i == 0 ? "" : ",", meshes_[i].name, i * 2, i * 2 + 1);
+        }
+        json += "],\"accessors\":[";
+        for (size_t i = 0; i < meshes_.size(); ++i) {
+            const GlbMesh& mesh = meshes_[i];
+            json += std::format(
+                "{}{{\"bufferView\":{},\"componentType\":5126,\"count\":{},\"type\":\"VEC3\","
+                "\"min\":[{},{},{}],\"max\":[{},{},{}]}},"
+                "{{\"bufferView\":{},\"componentType\":5125,\"count\":{},\"type\":\"SCALAR\"}}",
+                i == 0 ? "" : ",", i * 2, mesh.vertex_count,
+                mesh.min[0], mesh.min[1], mesh.min[2], mesh.max[0], mesh.max[1], mesh.max[2],
+                i * 2 + 1, mesh.index_count);
+        }
+        json += "],\"bufferViews\":[";
+        for (size_t i = 0; i < meshes_.size(); ++i) {
+            const GlbMesh& mesh = meshes_[i];
+            json += std::format(
+                "{}{{\"buffer\":0,\"byteOffset\":{},\"byteLength\":{},\"target\":34962}},"
+                "{{\"buffer\":0,\"byteOffset\":{},\"byteLength\":{},\"target\":34963}}",
+                i == 0 ? "" : ",",
+                mesh.positions_offset, mesh.vertex_count * 12,
+                mesh.indices_offset, mesh.index_count * 4);
+        }
+        json += "]";
+        if (body_bytes > 0) {
+            json += std::format(",\"buffers\":[{{\"byteLength\":{}}}]", body_bytes);
+        }
+        json += "}";
+        json.append((4 - json.size() % 4) % 4, ' ');
+
+        // Every record is a multiple of 4 bytes, so the binary chunk is aligned.
+        const uint64_t total = 12 + 8 + json.size() + (body_bytes > 0 ? 8 + body_bytes : 0);
+        if (total > std::numeric_limits<uint32_t>::max()) {
+            return false;
+        }
+        out_.write_le(uint32_t{0x46546C67}); // "glTF"
+        out_.write_le(uint32_t{2});
+        out_.write_le(static_cast<uint32_t>(total));
+        out_.write_le(static_cast<uint32_t>(json.size()));
+        out_.write_le(uint32_t{0x4E4F534A}); // "JSON"
+        out_.write(json);
+        if (body_bytes > 0) {
+            out_.write_le(static_cast<uint32_t>(body_bytes));
+            out_.write_le(uint32_t{0x004E4942}); // "BIN\0"
+            out_.append_contents_of(body_);
+        }
+        return out_.close();
+    }
+
+private:
+    struct GlbMesh {
+        std::string name;
+        size_t vertex_count = 0;
+        size_t index_count = 0;
+        uint64_t positions_offset = 0;
+        uint64_t indices_offset = 0;
+        std::array<float, 3> min{};
+        std::array<float, 3> max{};
+    };
+
+    BufferedFile out_;
+    BufferedFile body_;
+    std::vector<GlbMesh> meshes_;
+};
+
+} // namespace
+
+BooleanMeshWriter::Format BooleanMeshWriter::format_for_path(std::string_view path) {
+    if (ends_with_ignore_case(path, ".ply")) {
+        return Format::Ply;
+    }
+    if (ends_with_ignore_case(path, ".glb")) {
+        return Format::Glb;
+    }
+    return Format::Obj;
+}
+
+BooleanMeshWriter::BooleanMeshWriter() = default;
+
+BooleanMeshWriter::~BooleanMeshWriter() {
+    close();
+}
+
+bool BooleanMeshWriter::open(const std::string& path) {
+    if (encoder_) {
+        return false;
+    }
+    const Format format = format_for_path(path);
+    std::FILE* file = std::fopen(path.c_str(), format == Format::Obj ? "w" : "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    switch (format) {
+        case Format::Obj:
+            encoder_ = std::make_unique<ObjEncoder>(file);
+            break;
+        case Format::Ply:
+            encoder_ = std::make_unique<PlyEncoder>(file);
+            break;
+        case Format::Glb:
+            encoder_ = std::make_unique<GlbEncoder>(file);
+            break;
+    }
+    closing_ = false;
+    failed_ = false;
+    worker_ = std::thread([this] { run(); });
+    return true;
+}
+
+bool BooleanMeshWriter::append(std::string_view feature_id, const manifold::MeshGL& mesh) {
+    if (!encoder_) {
+        return true;
+    }
+    if (mesh.numProp < 3 || mesh.triVerts.size() % 3 != 0) {
+        return false;
+    }
+
+    FeatureMesh feature;
+    feature.name = obj_safe_feature_id(feature_id);
+    feature.single_precision = true;
+    const size_t vertex_count = mesh.NumVert();
+    feature.positions.resize(vertex_count * 3);
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            feature.positions[vertex * 3 + axis] = mesh.vertProperties[vertex * mesh.numProp + axis];
+        }
+    }
+    for (uint32_t vertex : mesh.triVerts) {
+        if (vertex >= vertex_count) {
+            return false;
+        }
+    }
+    feature.face_vertices = mesh.triVerts;
+    feature.face_offsets.resize(mesh.NumTri() + 1);
+    for (size_t triangle = 0; triangle < feature.face_offsets.size(); ++triangle) {
+        feature.face_offsets[triangle] = static_cast<uint32_t>(triangle * 3);
+    }
+    return enqueue(std::move(feature));
+}
+
+bool BooleanMeshWriter::append(std::string_view feature_id, const Surface_mesh& mesh) {
+    if (!encoder_) {
+        return true;
+    }
+
+    FeatureMesh feature;
+    feature.name = obj_safe_feature_id(feature_id);
+    // Dense map from (possibly sparse) vertex index to position in the output.
+    std::vector<uint32_t> local_index(mesh.number_of_vertices() + mesh.number_of_removed_vertices());
+    feature.positions.reserve(mesh.number_of_vertices() * 3);
+    for (auto vertex : mesh.vertices()) {
+        const auto& point = mesh.point(vertex);
+        local_index[static_cast<size_t>(vertex)] = static_cast<uint32_t>(feature.positions.size() / 3);
+        feature.positions.insert(feature.positions.end(), {point.x(), point.y(), point.z()});
+    }
+    feature.face_offsets.reserve(mesh.number_of_faces() + 1);
+    feature.face_vertices.reserve(mesh.number_of_faces() * 3);
+    feature.face_offsets.push_back(0);
+    for (auto face : mesh.faces()) {
+        for (auto vertex : mesh.vertices_around_face(mesh.halfedge(face))) {
+            feature.face_vertices.push_back(local_index[static_cast<size_t>(vertex)]);
+        }
+        feature.face_offsets.push_back(static_cast<uint32_t>(feature.face_vertices.size()));
+    }
+    return enqueue(std::move(feature));
+}
+
+bool BooleanMeshWriter::enqueue(FeatureMesh&& mesh) {
+    std::unique_lock lock(mutex_);
+    queue_changed_.wait(lock, [&] { return failed_ || queue_.size() < kMaxQueuedMeshes; });
+    if (failed_) {
+        return false;
+    }
+    queue_.push_back(std::move(mesh));
+    lock.unlock();
+    queue_changed_.notify_all();
+    return true;
+}
+
+void BooleanMeshWriter::run() {
+    while (true) {
+        FeatureMesh mesh;
+        bool failed = false;
+        {
+            std::unique_lock lock(mutex_);
+            queue_changed_.wait(lock, [&] { return closing_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            mesh = std::move(queue_.front());
+            queue_.pop_front();
+            failed = failed_;
+        }
+        queue_changed_.notify_all();
+        if (failed || encoder_->write(mesh)) {
+            continue;
+        }
+        {
+            std::lock_guard lock(mutex_);
+            failed_ = true;
+        }
+        queue_changed_.notify_all();
+    }
+}
+
+bool BooleanMeshWriter::close() {
+    if (!encoder_) {
+        return true;
+    }
+    {
+        std::lock_guard lock(mutex_);
+        closing_ = true;
+    }
+    queue_changed_.notify_all();
+    worker_.join();
+    const bool ok = !failed_ && encoder_->finish();
+    encoder_.reset();
+    return ok;
+}
@@ -0,0 +1,72 @@
+#ifndef BOOLEAN_MESH_WRITER_H
+#define BOOLEAN_MESH_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <manifold/manifold.h>
+
+#include "BooleanOps.h"
+
+// Debug output of every feature mesh directly after the boolean operation,
+// in local coordinates, one named object per feature. The format follows the
+// path extension: .ply (binary PLY), .glb (binary glTF) or OBJ otherwise.
+// append() only copies the mesh; encoding and buffered writing happen on a
+// background thread so enabling the output barely changes the pipeline
+// timings.
+class BooleanMeshWriter {
+public:
+    enum class Format {
+        Obj,
+        Ply,
+        Glb,
+    };
+
+    static Format format_for_path(std::string_view path);
+
+    BooleanMeshWriter();
+    ~BooleanMeshWriter();
+    BooleanMeshWriter(const BooleanMeshWriter&) = delete;
+    BooleanMeshWriter& operator=(const BooleanMeshWriter&) = delete;
+
+    bool open(const std::string& path);
+    // Both return true without doing anything when no file is open.
+    bool append(std::string_view feature_id, const manifold::MeshGL& mesh);
+    bool append(std::string_view feature_id, const Surface_mesh& mesh);
+    // Writes the queued meshes, completes the file and closes it.
+    bool close();
+
+    class Encoder;
+
+    struct FeatureMesh {
+        std::string name;
+        std::vector<double> positions;
+        // Face f uses face_vertices[face_offsets[f] .. face_offsets[f + 1]).
+        std::vector<uint32_t> face_offsets;
+        std::vector<uint32_t> face_vertices;
+        // Positions came from float data (MeshGL) and are printed as floats.
+        bool single_precision = false;
+    };
+
+private:
+    bool enqueue(FeatureMesh&& mesh);
+    void run();
+
+    std::unique_ptr<Encoder> encoder_;
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable queue_changed_;
+    std::deque<FeatureMesh> queue_;
+    bool closing_ = false;
+    bool failed_ = false;
+};
+
+#endif // BOOLEAN_MESH_WRITER_H
@@ -2,6 +2,7 @@
 #define BOOLEAN_OPS_H
 
 #include <chrono>
+#include <stdexcept>
 #include <vector>
 
 #include <CGAL/Simple_cartesian.h>
@@ -20,29 +21,77 @@ enum class BooleanMethod {
 #endif
 };
 
+// Name used on the command line and in the add_underpass_method attribute.
+inline const char* boolean_method_name(BooleanMethod method) {
+    switch (method) {
+        case BooleanMethod::Manifold:
+            return "manifold";
+        case BooleanMethod::CgalNef:
+            return "nef";
+        case BooleanMethod::CgalPMP:
+            return "pmp";
+#ifdef ENABLE_GEOGRAM
+        case BooleanMethod::Geogram:
+            return "geogram";
+#endif
+    }
+    return "unknown";
+}
+
 struct BooleanOpTiming {
     std::chrono::duration<double, std::milli> conversion_ms{0.0};
     std::chrono::duration<double, std::milli> boolean_ms{0.0};
 };
 
+class BooleanDeadlineExceeded : public std::runtime_error {
+public:
+    BooleanDeadlineExceeded() : std::runtime_error("boolean time budget exceeded") {}
+};
+
+// Wall-clock limit for one boolean attempt. Backends poll it between phases
+// (operand construction, each operation, result conversion; PMP also during
+// corefinement) and throw BooleanDeadlineExceeded once it has passed; a
+// default-constructed deadline never expires. A single Nef or Manifold
+// operation cannot be interrupted, so in-process the budget can be overrun
+// by one such operation; only a --isolate-booleans worker is a hard bound.
+class BooleanDeadline {
+public:
+    BooleanDeadline() = default;
+    explicit BooleanDeadline(std::chrono::steady_clock::time_point at) : at_(at), limited_(true) {}
+
+    bool expired() const { return limited_ && std::chrono::steady_clock::now() >= at_; }
+    void check() const {
+        if (expired()) {
+            throw BooleanDeadlineExceeded();
+        }
+    }
+
+private:
+    std::chrono::steady_clock::time_point at_{};
+    bool limited_ = false;
+};
+
 // Nef polyhedra boolean difference
 Surface_mesh nef_boolean_difference(
     const Surface_mesh& mesh_a,
     const std::vector<Surface_mesh>& meshes_b,
-    BooleanOpTiming* timing = nullptr);
+    BooleanOpTiming* timing = nullptr,
+    const BooleanDeadline& deadline = {});
 
 // PMP corefinement boolean difference
 Surface_mesh corefine_boolean_difference(
     const Surface_mesh& mesh_a,
     const std::vector<Surface_mesh>& meshes_b,
-    BooleanOpTiming* timing = nullptr);
+    BooleanOpTiming* timing = nullptr,
+    const BooleanDeadline& deadline = {});
 
 #ifdef ENABLE_GEOGRAM
 // Geogram mesh boolean difference
 Surface_mesh geogram_boolean_difference(
     const Surface_mesh& mesh_a,
     const std::vector<Surface_mesh>& meshes_b,
-    BooleanOpTiming* timing = nullptr);
+    BooleanOpTiming* timing = nullptr,
+    const BooleanDeadline& deadline = {});
 #endif
 
 #endif // BOOLEAN_OPS_H
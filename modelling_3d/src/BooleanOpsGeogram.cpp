@@ -91,7 +91,8 @@ Surface_mesh geogram_mesh_to_surface_mesh(const GEO::Mesh& geo_mesh) {
 Surface_mesh geogram_boolean_difference(
     const Surface_mesh& mesh_a,
     const std::vector<Surface_mesh>& meshes_b,
-    BooleanOpTiming* timing) {
+    BooleanOpTiming* timing,
+    const BooleanDeadline& deadline) {
     ensure_geogram_initialized();
 
     GEO::Mesh geo_current;
@@ -102,6 +103,7 @@ Surface_mesh geogram_boolean_difference(
         timing->conversion_ms += t_conversion_end - t_conversion_start;
     }
     for (const auto& mesh_b : meshes_b) {
+        deadline.check();
         GEO::Mesh geo_b;
         t_conversion_start = Clock::now();
         surface_mesh_to_geogram_mesh(mesh_b, geo_b);
@@ -12,7 +12,8 @@ bool manifold_boolean_difference(
     std::vector<Surface_mesh>& underpass_sms,
     manifold::MeshGL& result_meshgl,
     BooleanOpTiming* timing,
-    ManifoldBooleanError* error) {
+    ManifoldBooleanError* error,
+    const BooleanDeadline& deadline) {
     if (error != nullptr) {
         *error = ManifoldBooleanError::None;
     }
@@ -29,6 +30,7 @@ bool manifold_boolean_difference(
         }
         return false;
     }
+    deadline.check();
     manifold::Manifold house(house_meshgl);
     if (house.Status() != manifold::Manifold::Error::NoError) {
         if (error != nullptr) {
@@ -40,6 +42,7 @@ bool manifold_boolean_difference(
     std::vector<manifold::Manifold> underpasses;
     underpasses.reserve(underpass_sms.size());
     for (auto& underpass_sm : underpass_sms) {
+        deadline.check();
         auto underpass_meshgl = surface_mesh_to_meshgl(underpass_sm, false);
         if (underpass_meshgl.NumTri() == 0) {
             continue;
@@ -68,6 +71,7 @@ bool manifold_boolean_difference(
     auto t_boolean_start = Clock::now();
     manifold::Manifold merged_underpass = std::move(underpasses.front());
     for (size_t i = 1; i < underpasses.size(); ++i) {
+        deadline.check();
         merged_underpass = merged_underpass + underpasses[i];
         if (merged_underpass.Status() != manifold::Manifold::Error::NoError) {
             if (timing != nullptr) {
@@ -79,6 +83,7 @@ bool manifold_boolean_difference(
             return false;
         }
     }
+    deadline.check();
     auto result = house - merged_underpass;
     auto t_boolean_end = Clock::now();
     if (timing != nullptr) {
@@ -91,6 +96,7 @@ bool manifold_boolean_difference(
         return false;
     }
 
+    deadline.check();
     t_conversion_start = Clock::now();
     result = result.AsOriginal().Simplify(mesh_processing::kCleanupTolerance);
     if (result.Status() != manifold::Manifold::Error::NoError) {
@@ -17,6 +17,7 @@ bool manifold_boolean_difference(
     std::vector<Surface_mesh>& underpass_sms,
     manifold::MeshGL& result_meshgl,
     BooleanOpTiming* timing = nullptr,
-    ManifoldBooleanError* error = nullptr);
+    ManifoldBooleanError* error = nullptr,
+    const BooleanDeadline& deadline = {});
 
 #endif // BOOLEAN_OPS_MANIFOLD_H
@@ -12,9 +12,11 @@ using Clock = std::chrono::steady_clock;
 Surface_mesh nef_boolean_difference(
     const Surface_mesh& mesh_a,
     const std::vector<Surface_mesh>& meshes_b,
-    BooleanOpTiming* timing) {
+    BooleanOpTiming* timing,
+    const BooleanDeadline& deadline) {
     auto t_conversion_start = Clock::now();
     auto exact_a = surface_mesh_to_exact(mesh_a);
+    deadline.check();
     Nef_polyhedron nef_result(exact_a);
     auto t_conversion_end = Clock::now();
     if (timing != nullptr) {
@@ -22,6 +24,7 @@ Surface_mesh nef_boolean_difference(
     }
 
     for (const auto& mesh_b : meshes_b) {
+        deadline.check();
         t_conversion_start = Clock::now();
         auto exact_b = surface_mesh_to_exact(mesh_b);
         Nef_polyhedron nef_b(exact_b);
@@ -29,6 +32,8 @@ Surface_mesh nef_boolean_difference(
         if (timing != nullptr) {
             timing->conversion_ms += t_conversion_end - t_conversion_start;
         }
+        // Building the operand can take as long as the difference itself.
+        deadline.check();
 
         auto t_boolean_start = Clock::now();
         nef_result = nef_result - nef_b;
@@ -38,6 +43,7 @@ Surface_mesh nef_boolean_difference(
         }
     }
 
+    deadline.check();
     t_conversion_start = Clock::now();
     Exact_surface_mesh exact_result;
     CGAL::convert_nef_polyhedron_to_polygon_mesh(nef_result, exact_result);
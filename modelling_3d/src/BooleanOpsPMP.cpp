@@ -8,10 +8,30 @@
 
 using Clock = std::chrono::steady_clock;
 
+namespace {
+
+namespace PMP = CGAL::Polygon_mesh_processing;
+
+// Polls the deadline at every corefinement progress step, so a single slow
+// operand cannot run far past the budget.
+struct DeadlineVisitor : PMP::Corefinement::Default_visitor<Exact_surface_mesh> {
+    const BooleanDeadline* deadline = nullptr;
+
+    void progress_filtering_intersections(double) const { deadline->check(); }
+    void triangulating_faces_step() const { deadline->check(); }
+    void intersection_of_coplanar_faces_step() const { deadline->check(); }
+    void edge_face_intersections_step() const { deadline->check(); }
+};
+
+} // namespace
+
 Surface_mesh corefine_boolean_difference(
     const Surface_mesh& mesh_a,
     const std::vector<Surface_mesh>& meshes_b,
-    BooleanOpTiming* timing) {
+    BooleanOpTiming* timing,
+    const BooleanDeadline& deadline) {
+    DeadlineVisitor visitor;
+    visitor.deadline = &deadline;
     auto t_conversion_start = Clock::now();
     auto exact_a = surface_mesh_to_exact(mesh_a);
     auto t_conversion_end = Clock::now();
@@ -20,6 +40,7 @@ Surface_mesh corefine_boolean_difference(
     }
 
     for (const auto& mesh_b : meshes_b) {
+        deadline.check();
         t_conversion_start = Clock::now();
         auto exact_b = surface_mesh_to_exact(mesh_b);
         t_conversion_end = Clock::now();
@@ -29,8 +50,8 @@ Surface_mesh corefine_boolean_difference(
 
         Exact_surface_mesh exact_result;
         auto t_boolean_start = Clock::now();
-        bool success = CGAL::Polygon_mesh_processing::corefine_and_compute_difference(
-            exact_a, exact_b, exact_result);
+        bool success = PMP::corefine_and_compute_difference(
+            exact_a, exact_b, exact_result, CGAL::parameters::visitor(visitor));
         auto t_boolean_end = Clock::now();
         if (timing != nullptr) {
             timing->boolean_ms += t_boolean_end - t_boolean_start;
@@ -0,0 +1,626 @@
+#include "BooleanWorker.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <format>
+#include <mutex>
+#include <stdexcept>
+
+#include "ProcessMemory.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+#ifndef _WIN32
+
+namespace {
+
+constexpr size_t kInitialRegionBytes = size_t{4} << 20;
+// Time a worker gets past the budget to notice the deadline itself before it
+// is killed.
+constexpr int kKillGraceMs = 1000;
+
+} // namespace
+
+// File-backed memory shared by the parent and its worker. Either side may
+// grow the file; the other remaps it before reading past its mapping.
+class BooleanWorker::SharedRegion {
+public:
+    SharedRegion() = default;
+    ~SharedRegion() {
+        unmap();
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+    SharedRegion(const SharedRegion&) = delete;
+    SharedRegion& operator=(const SharedRegion&) = delete;
+
+    bool create() {
+#ifdef __linux__
+        fd_ = memfd_create("add_underpass_booleans", 0);
+#else
+        // macOS shared memory objects cannot be resized, an unlinked file can.
+        const char* tmpdir = std::getenv("TMPDIR");
+        std::string path = std::string(tmpdir != nullptr && *tmpdir != '\0' ? tmpdir : "/tmp") +
+                           "/add_underpass_booleans.XXXXXX";
+        fd_ = mkstemp(path.data());
+        if (fd_ >= 0) {
+            unlink(path.c_str());
+        }
+#endif
+        return fd_ >= 0 && reserve(kInitialRegionBytes);
+    }
+
+    bool attach(int fd) {
+        fd_ = fd;
+        return remap();
+    }
+
+    // Grows the file to hold at least `size` bytes.
+    bool reserve(size_t size) {
+        if (size <= mapped_) {
+            return true;
+        }
+        const size_t capacity = std::max({size, mapped_ * 2, kInitialRegionBytes});
+        if (ftruncate(fd_, static_cast<off_t>(capacity)) != 0) {
+            return false;
+        }
+        return remap();
+    }
+
+    // Maps the whole file, after the other process may have grown it.
+    bool remap() {
+        struct stat info;
+        if (fstat(fd_, &info) != 0) {
+            return false;
+        }
+        const auto size = static_cast<size_t>(info.st_size);
+        if (size == mapped_) {
+            return true;
+        }
+        unmap();
+        if (size == 0) {
+            return true;
+        }
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+        data_ = static_cast<std::byte*>(data);
+        mapped_ = size;
+        return true;
+    }
+
+    std::byte* data() const { return data_; }
+    size_t size() const { return mapped_; }
+    int fd() const { return fd_; }
+
+private:
+    void unmap() {
+        if (data_ != nullptr) {
+            munmap(data_, mapped_);
+            data_ = nullptr;
+            mapped_ = 0;
+        }
+    }
+
+    int fd_ = -1;
+    std::byte* data_ = nullptr;
+    size_t mapped_ = 0;
+};
+
+namespace {
+
+class ByteWriter {
+public:
+    explicit ByteWriter(BooleanWorker::SharedRegion& region) : region_(region) {}
+
+    template <typename T>
+    void put(const T& value) {
+        put_bytes(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void put_vector(const std::vector<T>& values) {
+        put<uint64_t>(values.size());
+        put_bytes(values.data(), values.size() * sizeof(T));
+    }
+
+    void put_string(std::string_view value) {
+        put<uint64_t>(value.size());
+        put_bytes(value.data(), value.size());
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    void put_bytes(const void* bytes, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (!region_.reserve(size_ + count)) {
+            throw std::runtime_error("cannot grow shared memory");
+        }
+        std::memcpy(region_.data() + size_, bytes, count);
+        size_ += count;
+    }
+
+    BooleanWorker::SharedRegion& region_;
+    size_t size_ = 0;
+};
+
+class ByteReader {
+public:
+    ByteReader(const std::byte* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    T get() {
+        T value;
+        get_bytes(&value, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void get_vector(std::vector<T>& values) {
+        const auto count = get<uint64_t>();
+        if (count > (size_ - position_) / sizeof(T)) {
+            throw std::runtime_error("truncated message");
+        }
+        values.resize(count);
+        get_bytes(values.data(), count * sizeof(T));
+    }
+
+    std::string get_string() {
+        std::vector<char> chars;
+        get_vector(chars);
+        return std::string(chars.begin(), chars.end());
+    }
+
+private:
+    void get_bytes(void* bytes, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (count > size_ - position_) {
+            throw std::runtime_error("truncated message");
+        }
+        std::memcpy(bytes, data_ + position_, count);
+        position_ += count;
+    }
+
+    const std::byte* data_;
+    size_t size_;
+    size_t position_ = 0;
+};
+
+// Vertices in iteration order, then faces as vertex index lists.
+void put_surface_mesh(ByteWriter& writer, const Surface_mesh& mesh) {
+    std::vector<uint32_t> index(mesh.num_vertices(), 0);
+    writer.put<uint64_t>(mesh.number_of_vertices());
+    uint32_t next_index = 0;
+    for (auto v : mesh.vertices()) {
+        index[v.idx()] = next_index++;
+        const auto& point = mesh.point(v);
+        writer.put<double>(point.x());
+        writer.put<double>(point.y());
+        writer.put<double>(point.z());
+    }
+    writer.put<uint64_t>(mesh.number_of_faces());
+    for (auto f : mesh.faces()) {
+        writer.put<uint32_t>(static_cast<uint32_t>(mesh.degree(f)));
+        for (auto v : mesh.vertices_around_face(mesh.halfedge(f))) {
+            writer.put<uint32_t>(index[v.idx()]);
+        }
+    }
+}
+
+void get_surface_mesh(ByteReader& reader, Surface_mesh& mesh) {
+    mesh.clear();
+    const auto vertex_count = reader.get<uint64_t>();
+    for (uint64_t i = 0; i < vertex_count; ++i) {
+        const double x = reader.get<double>();
+        const double y = reader.get<double>();
+        const double z = reader.get<double>();
+        mesh.add_vertex(K::Point_3(x, y, z));
+    }
+    const auto face_count = reader.get<uint64_t>();
+    std::vector<Surface_mesh::Vertex_index> face;
+    for (uint64_t f = 0; f < face_count; ++f) {
+        const auto degree = reader.get<uint32_t>();
+        face.clear();
+        for (uint32_t i = 0; i < degree; ++i) {
+            const auto index = reader.get<uint32_t>();
+            if (index >= vertex_count) {
+                throw std::runtime_error("face index out of range");
+            }
+            face.push_back(Surface_mesh::Vertex_index(index));
+        }
+        if (mesh.add_face(face) == Surface_mesh::null_face()) {
+            throw std::runtime_error("non-manifold face in mesh");
+        }
+    }
+}
+
+void put_meshgl(ByteWriter& writer, const manifold::MeshGL& mesh) {
+    writer.put(mesh.numProp);
+    writer.put_vector(mesh.vertProperties);
+    writer.put_vector(mesh.triVerts);
+    writer.put_vector(mesh.mergeFromVert);
+    writer.put_vector(mesh.mergeToVert);
+    writer.put_vector(mesh.runIndex);
+    writer.put_vector(mesh.runOriginalID);
+    writer.put_vector(mesh.runTransform);
+    writer.put_vector(mesh.faceID);
+    writer.put_vector(mesh.halfedgeTangent);
+    writer.put(mesh.tolerance);
+}
+
+void get_meshgl(ByteReader& reader, manifold::MeshGL& mesh) {
+    mesh.numProp = reader.get<decltype(mesh.numProp)>();
+    reader.get_vector(mesh.vertProperties);
+    reader.get_vector(mesh.triVerts);
+    reader.get_vector(mesh.mergeFromVert);
+    reader.get_vector(mesh.mergeToVert);
+    reader.get_vector(mesh.runIndex);
+    reader.get_vector(mesh.runOriginalID);
+    reader.get_vector(mesh.runTransform);
+    reader.get_vector(mesh.faceID);
+    reader.get_vector(mesh.halfedgeTangent);
+    mesh.tolerance = reader.get<decltype(mesh.tolerance)>();
+}
+
+void put_attempt(ByteWriter& writer, const BooleanAttempt& attempt) {
+    writer.put<uint8_t>(attempt.success ? 1 : 0);
+    writer.put<uint8_t>(attempt.budget_exceeded ? 1 : 0);
+    writer.put_string(attempt.failure);
+    writer.put<double>(attempt.timing.conversion_ms.count());
+    writer.put<double>(attempt.timing.boolean_ms.count());
+    writer.put<uint64_t>(attempt.peak_bytes);
+    writer.put<uint8_t>(attempt.has_polygonal_result ? 1 : 0);
+    if (attempt.has_polygonal_result) {
+        put_surface_mesh(writer, attempt.result_surface_mesh);
+    } else {
+        put_meshgl(writer, attempt.result_meshgl);
+    }
+}
+
+void get_attempt(ByteReader& reader, BooleanAttempt& attempt) {
+    attempt.success = reader.get<uint8_t>() != 0;
+    attempt.budget_exceeded = reader.get<uint8_t>() != 0;
+    attempt.failure = reader.get_string();
+    attempt.timing.conversion_ms = std::chrono::duration<double, std::milli>(reader.get<double>());
+    attempt.timing.boolean_ms = std::chrono::duration<double, std::milli>(reader.get<double>());
+    attempt.peak_bytes = reader.get<uint64_t>();
+    attempt.has_polygonal_result = reader.get<uint8_t>() != 0;
+    if (attempt.has_polygonal_result) {
+        get_surface_mesh(reader, attempt.result_surface_mesh);
+    } else {
+        get_meshgl(reader, attempt.result_meshgl);
+    }
+}
+
+bool send_all(int fd, const void* bytes, size_t count) {
+#ifdef MSG_NOSIGNAL
+    constexpr int kFlags = MSG_NOSIGNAL;
+#else
+    constexpr int kFlags = 0;
+#endif
+    const auto* cursor = static_cast<const char*>(bytes);
+    while (count > 0) {
+        const ssize_t sent = send(fd, cursor, count, kFlags);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        cursor += sent;
+        count -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool receive_all(int fd, void* bytes, size_t count) {
+    auto* cursor = static_cast<char*>(bytes);
+    while (count > 0) {
+        const ssize_t received = recv(fd, cursor, count, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        cursor += received;
+        count -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+} // namespace
+
+int run_boolean_worker(int argc, char* argv[]) {
+    if (argc < 4) {
+        return 2;
+    }
+    const int socket_fd = std::atoi(argv[2]);
+    BooleanWorker::SharedRegion region;
+    if (!region.attach(std::atoi(argv[3]))) {
+        return 2;
+    }
+    while (true) {
+        uint64_t request_size = 0;
+        if (!receive_all(socket_fd, &request_size, sizeof(request_size))) {
+            // The parent closed the socket.
+            return 0;
+        }
+        if (!region.remap() || request_size > region.size()) {
+            return 2;
+        }
+        BooleanAttempt attempt;
+        try {
+            ByteReader reader(region.data(), request_size);
+            const auto method = static_cast<BooleanMethod>(reader.get<uint32_t>());
+            const auto budget = std::chrono::milliseconds(reader.get<int64_t>());
+            Surface_mesh house;
+            get_surface_mesh(reader, house);
+            std::vector<Surface_mesh> underpasses(reader.get<uint64_t>());
+            for (auto& underpass : underpasses) {
+                get_surface_mesh(reader, underpass);
+            }
+            // The worker runs one attempt at a time, so its own high-water
+            // mark is this attempt's footprint, free of other jobs' memory.
+            const bool measured = reset_peak_rss_window();
+            const size_t rss_before = current_rss_bytes();
+            attempt = run_boolean_attempt(method, house, underpasses, budget);
+            const size_t peak = measured ? peak_rss_window_bytes() : 0;
+            attempt.peak_bytes = peak > rss_before ? peak - rss_before : 0;
+        } catch (const std::exception& e) {
+            attempt = BooleanAttempt{};
+            attempt.failure = std::format("invalid boolean worker request ({})", e.what());
+        }
+        uint64_t response_size = 0;
+        try {
+            ByteWriter writer(region);
+            put_attempt(writer, attempt);
+            response_size = writer.size();
+        } catch (const std::exception&) {
+            return 2;
+        }
+        if (!send_all(socket_fd, &response_size, sizeof(response_size))) {
+            return 0;
+        }
+    }
+}
+
+BooleanWorker::BooleanWorker(std::string executable_path)
+    : executable_path_(std::move(executable_path)) {}
+
+BooleanWorker::~BooleanWorker() {
+    stop(false);
+}
+
+bool BooleanWorker::spawn() {
+    if (executable_path_.empty()) {
+        return false;
+    }
+    if (region_ == nullptr) {
+        auto region = std::make_unique<SharedRegion>();
+        if (!region->create()) {
+            return false;
+        }
+        region_ = std::move(region);
+    }
+    // Jobs under --serve spawn workers from several threads; holding this
+    // until the parent closes the child's end keeps that end out of the
+    // other workers, whose socket would otherwise never report this one dead.
+    static std::mutex spawn_mutex;
+    std::lock_guard<std::mutex> spawn_lock(spawn_mutex);
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        return false;
+    }
+    // Later workers must not inherit the parent's end.
+    fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+    const int enabled = 1;
+    setsockopt(sockets[0], SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+
+    std::string flag(kBooleanWorkerFlag);
+    std::string socket_arg = std::to_string(sockets[1]);
+    std::string region_arg = std::to_string(region_->fd());
+    std::array<char*, 5> args{
+        executable_path_.data(), flag.data(), socket_arg.data(), region_arg.data(), nullptr};
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(sockets[0]);
+        close(sockets[1]);
+        return false;
+    }
+    if (pid == 0) {
+        // stdout may carry the output stream; backend chatter goes to stderr.
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+        execvp(args[0], args.data());
+        _exit(127);
+    }
+    close(sockets[1]);
+    socket_ = sockets[0];
+    pid_ = pid;
+    if (starts_++ > 0) {
+        ++restarts_;
+    }
+    return true;
+}
+
+std::string BooleanWorker::stop(bool kill_worker) {
+    if (pid_ < 0) {
+        return {};
+    }
+    if (kill_worker) {
+        kill(pid_, SIGKILL);
+    }
+    // A live worker sees the closed socket and exits.
+    close(socket_);
+    socket_ = -1;
+    int status = 0;
+    while (waitpid(pid_, &status, 0) < 0 && errno == EINTR) {
+    }
+    pid_ = -1;
+    if (WIFSIGNALED(status)) {
+        return std::format("signal {}: {}", WTERMSIG(status), strsignal(WTERMSIG(status)));
+    }
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+        // exec failed; retrying would fail the same way for every feature.
+        executable_path_.clear();
+    }
+    return std::format("exit code {}", WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+}
+
+BooleanWorker::Status BooleanWorker::run(
+    BooleanMethod method,
+    const Surface_mesh& house,
+    const std::vector<Surface_mesh>& underpasses,
+    std::chrono::milliseconds budget,
+    BooleanAttempt& out,
+    std::string& detail) {
+    out = BooleanAttempt{};
+    if (pid_ < 0 && !spawn()) {
+        detail = "could not start boolean worker";
+        return Status::Unavailable;
+    }
+
+    auto t_encode_start = Clock::now();
+    uint64_t request_size = 0;
+    try {
+        ByteWriter writer(*region_);
+        writer.put<uint32_t>(static_cast<uint32_t>(method));
+        writer.put<int64_t>(budget.count());
+        put_surface_mesh(writer, house);
+        writer.put<uint64_t>(underpasses.size());
+        for (const auto& underpass : underpasses) {
+            put_surface_mesh(writer, underpass);
+        }
+        request_size = writer.size();
+    } catch (const std::exception& e) {
+        detail = e.what();
+        return Status::Unavailable;
+    }
+    const auto encode_time = Clock::now() - t_encode_start;
+
+    // A worker that could not even exec is no crash of this feature's boolean.
+    const auto worker_died = [&] {
+        detail = stop(false);
+        return executable_path_.empty() ? Status::Unavailable : Status::Crashed;
+    };
+    if (!send_all(socket_, &request_size, sizeof(request_size))) {
+        return worker_died();
+    }
+    const int timeout_ms = budget.count() > 0
+        ? static_cast<int>(std::min<int64_t>(budget.count() + kKillGraceMs, INT32_MAX))
+        : -1;
+    pollfd response{socket_, POLLIN, 0};
+    int ready = 0;
+    do {
+        ready = poll(&response, 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    if (ready == 0) {
+        stop(true);
+        detail = std::format("no result within {} ms", timeout_ms);
+        return Status::Killed;
+    }
+    uint64_t response_size = 0;
+    if (ready < 0 || !receive_all(socket_, &response_size, sizeof(response_size))) {
+        return worker_died();
+    }
+
+    auto t_decode_start = Clock::now();
+    try {
+        if (!region_->remap() || response_size > region_->size()) {
+            throw std::runtime_error("truncated message");
+        }
+        ByteReader reader(region_->data(), response_size);
+        get_attempt(reader, out);
+    } catch (const std::exception& e) {
+        out = BooleanAttempt{};
+        out.failure = std::format("invalid boolean worker response ({})", e.what());
+    }
+    out.timing.conversion_ms += encode_time + (Clock::now() - t_decode_start);
+    return Status::Completed;
+}
+
+std::string current_executable_path(const char* argv0) {
+#ifdef __APPLE__
+    uint32_t size = 0;
+    _NSGetExecutablePath(nullptr, &size);
+    std::string path(size, '\0');
+    if (_NSGetExecutablePath(path.data(), &size) == 0) {
+        path.resize(std::strlen(path.c_str()));
+        return path;
+    }
+#elif defined(__linux__)
+    std::array<char, 4096> path{};
+    const ssize_t length = readlink("/proc/self/exe", path.data(), path.size() - 1);
+    if (length > 0) {
+        return std::string(path.data(), static_cast<size_t>(length));
+    }
+#endif
+    return argv0 != nullptr ? argv0 : "";
+}
+
+#else // _WIN32
+
+class BooleanWorker::SharedRegion {};
+
+int run_boolean_worker(int, char*[]) {
+    return 2;
+}
+
+BooleanWorker::BooleanWorker(std::string executable_path)
+    : executable_path_(std::move(executable_path)) {}
+
+BooleanWorker::~BooleanWorker() = default;
+
+bool BooleanWorker::spawn() {
+    return false;
+}
+
+std::string BooleanWorker::stop(bool) {
+    return {};
+}
+
+BooleanWorker::Status BooleanWorker::run(
+    BooleanMethod,
+    const Surface_mesh&,
+    const std::vector<Surface_mesh>&,
+    std::chrono::milliseconds,
+    BooleanAttempt& out,
+    std::string& detail) {
+    out = BooleanAttempt{};
+    detail = "boolean workers need POSIX fork/exec";
+    return Status::Unavailable;
+}
+
+std::string current_executable_path(const char* argv0) {
+    return argv0 != nullptr ? argv0 : "";
+}
+
+#endif // _WIN32
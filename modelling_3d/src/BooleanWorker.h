@@ -0,0 +1,69 @@
+#ifndef BOOLEAN_WORKER_H
+#define BOOLEAN_WORKER_H
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BooleanAttempt.h"
+
+// Command-line flag that turns add_underpass into a boolean worker.
+inline constexpr std::string_view kBooleanWorkerFlag = "--boolean-worker";
+
+// Entry point of a worker process started by BooleanWorker.
+int run_boolean_worker(int argc, char* argv[]);
+
+// Runs boolean attempts in a child process, so a segfault or abort inside a
+// backend costs one feature instead of the whole run. Meshes are exchanged
+// through a shared memory region; a socket pair only carries payload sizes.
+// The child is a fresh exec of this executable (fork alone is unsafe once the
+// writer threads run). It is started on first use and again after it died.
+class BooleanWorker {
+public:
+    enum class Status {
+        Completed,
+        // The worker died; `detail` names the signal or exit code.
+        Crashed,
+        // The worker overran the budget plus a grace period and was killed.
+        Killed,
+        // No worker could be started.
+        Unavailable,
+    };
+
+    explicit BooleanWorker(std::string executable_path);
+    ~BooleanWorker();
+    BooleanWorker(const BooleanWorker&) = delete;
+    BooleanWorker& operator=(const BooleanWorker&) = delete;
+
+    Status run(
+        BooleanMethod method,
+        const Surface_mesh& house,
+        const std::vector<Surface_mesh>& underpasses,
+        std::chrono::milliseconds budget,
+        BooleanAttempt& out,
+        std::string& detail);
+
+    // Workers started after the first one.
+    size_t restarts() const { return restarts_; }
+
+    class SharedRegion;
+
+private:
+    bool spawn();
+    std::string stop(bool kill_worker);
+
+    std::string executable_path_;
+    std::unique_ptr<SharedRegion> region_;
+    int socket_ = -1;
+    int pid_ = -1;
+    size_t starts_ = 0;
+    size_t restarts_ = 0;
+};
+
+// Path to the running executable, for starting workers. Falls back to argv0.
+std::string current_executable_path(const char* argv0);
+
+#endif // BOOLEAN_WORKER_H
@@ -0,0 +1,97 @@
+#include "BoundaryCycles.h"
+
+#include <utility>
+
+namespace boundary_cycles {
+
+std::vector<std::vector<uint32_t>> walk_boundary_cycles(
+    const std::vector<BoundaryEdge>& boundary_edges,
+    WalkScratch& scratch) {
+    // Outgoing boundary edges per source vertex as CSR. A stable counting sort
+    // keeps each row in boundary-edge order, so the walk picks the same next
+    // edge as a per-vertex list would.
+    auto& local_slot = scratch.local_slot;
+    auto& slot_vertices = scratch.slot_vertices;
+    auto& offsets = scratch.outgoing_offsets;
+    slot_vertices.clear();
+    offsets.assign(1, 0);
+    for (const auto& edge : boundary_edges) {
+        if (local_slot[edge.from] == kNoSlot) {
+            local_slot[edge.from] = static_cast<uint32_t>(slot_vertices.size());
+            slot_vertices.push_back(edge.from);
+            offsets.push_back(0);
+        }
+        offsets[local_slot[edge.from] + 1] += 1;
+    }
+    for (size_t slot = 1; slot < offsets.size(); ++slot) {
+        offsets[slot] += offsets[slot - 1];
+    }
+    auto& cursor = scratch.outgoing_cursor;
+    cursor.assign(offsets.begin(), offsets.end() - 1);
+    auto& outgoing = scratch.outgoing_edges;
+    outgoing.resize(boundary_edges.size());
+    for (size_t edge_idx = 0; edge_idx < boundary_edges.size(); ++edge_idx) {
+        outgoing[cursor[local_slot[boundary_edges[edge_idx].from]]++] = static_cast<uint32_t>(edge_idx);
+    }
+    // Reused as the first possibly-unvisited edge of each row; visited only
+    // grows, so skipping past visited entries never changes the pick.
+    cursor.assign(offsets.begin(), offsets.end() - 1);
+
+    auto& visited = scratch.visited;
+    visited.assign(boundary_edges.size(), 0);
+    std::vector<std::vector<uint32_t>> cycles;
+
+    for (size_t edge_idx = 0; edge_idx < boundary_edges.size(); ++edge_idx) {
+        if (visited[edge_idx]) {
+            continue;
+        }
+
+        std::vector<uint32_t> ring;
+        const uint32_t start_vertex = boundary_edges[edge_idx].from;
+        uint32_t current_vertex = start_vertex;
+        size_t current_edge = edge_idx;
+
+        for (size_t step = 0; step <= boundary_edges.size(); ++step) {
+            if (visited[current_edge]) {
+                break;
+            }
+            visited[current_edge] = 1;
+            if (ring.empty()) {
+                ring.push_back(boundary_edges[current_edge].from);
+            }
+            ring.push_back(boundary_edges[current_edge].to);
+            current_vertex = boundary_edges[current_edge].to;
+            if (current_vertex == start_vertex) {
+                ring.pop_back();
+                break;
+            }
+
+            const uint32_t slot = local_slot[current_vertex];
+            if (slot == kNoSlot) {
+                ring.clear();
+                break;
+            }
+
+            uint32_t& next = cursor[slot];
+            while (next < offsets[slot + 1] && visited[outgoing[next]]) {
+                ++next;
+            }
+            if (next == offsets[slot + 1]) {
+                ring.clear();
+                break;
+            }
+            current_edge = outgoing[next];
+        }
+
+        if (ring.size() >= 3) {
+            cycles.push_back(std::move(ring));
+        }
+    }
+
+    for (uint32_t vertex : slot_vertices) {
+        local_slot[vertex] = kNoSlot;
+    }
+    return cycles;
+}
+
+} // namespace boundary_cycles
@@ -0,0 +1,45 @@
+#ifndef BOUNDARY_CYCLES_H
+#define BOUNDARY_CYCLES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Closed boundary cycles of a face group, walked over a CSR of outgoing
+// boundary edges per vertex. Vertices are dense indices; kept free of CGAL so
+// the walk can be benchmarked on its own (bench/PolygonalOutputBench.cpp).
+
+namespace boundary_cycles {
+
+constexpr uint32_t kNoSlot = std::numeric_limits<uint32_t>::max();
+
+struct BoundaryEdge {
+    uint32_t from = 0;
+    uint32_t to = 0;
+};
+
+// Buffers reused across the groups of one mesh. local_slot maps a dense
+// vertex to its row in the outgoing-edge CSR; size it to the vertex count,
+// filled with kNoSlot, before the first walk. Each walk resets the entries it
+// touched.
+struct WalkScratch {
+    std::vector<uint32_t> local_slot;
+    std::vector<uint32_t> slot_vertices;
+    std::vector<uint32_t> outgoing_offsets;
+    std::vector<uint32_t> outgoing_edges;
+    std::vector<uint32_t> outgoing_cursor;
+    std::vector<uint8_t> visited;
+};
+
+// Follows the edges into cycles in boundary-edge order: each cycle starts at
+// the first unvisited edge and continues with the first unvisited outgoing
+// edge of the vertex reached, as a per-vertex edge list would. Open chains
+// and cycles under three vertices are dropped.
+std::vector<std::vector<uint32_t>> walk_boundary_cycles(
+    const std::vector<BoundaryEdge>& boundary_edges,
+    WalkScratch& scratch);
+
+} // namespace boundary_cycles
+
+#endif // BOUNDARY_CYCLES_H
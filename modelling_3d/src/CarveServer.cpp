@@ -0,0 +1,275 @@
+#include "CarveServer.h"
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+
+namespace {
+
+constexpr size_t kMaxRequestBytes = 4096;
+// Time a client has to send its whole request line; it only competes for a
+// job slot once the line is in.
+constexpr std::chrono::seconds kRequestTimeout{10};
+// Connections still sending their request line, beyond which new clients get
+// BUSY right away, so idle connections cannot pile up threads either.
+constexpr size_t kMaxPendingRequests = 64;
+// How often the accept loop looks at the stop flag.
+constexpr int kAcceptPollMs = 200;
+constexpr int kListenBacklog = 64;
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+volatile sig_atomic_t g_stop_requested = 0;
+
+void request_stop(int) {
+    g_stop_requested = 1;
+}
+
+// Boolean workers forked by jobs must not inherit the listener or another
+// job's connection, or clients would not see their stream end.
+void set_cloexec(int fd) {
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+    const int enabled = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+}
+
+int open_listener(const std::string& path, std::string& error) {
+    sockaddr_un address{};
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = std::format("socket path must be 1 to {} bytes", sizeof(address.sun_path) - 1);
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    const auto* socket_address = reinterpret_cast<const sockaddr*>(&address);
+
+    // A socket left behind by a stopped server is replaced; a live one or any
+    // other file at the path is not.
+    struct stat status {};
+    if (lstat(path.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+            error = "path exists and is not a socket";
+            return -1;
+        }
+        const int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        const bool live = probe >= 0 && connect(probe, socket_address, sizeof(address)) == 0;
+        if (probe >= 0) {
+            close(probe);
+        }
+        if (live) {
+            error = "another server is listening on it";
+            return -1;
+        }
+        unlink(path.c_str());
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return -1;
+    }
+    set_cloexec(fd);
+    if (bind(fd, socket_address, sizeof(address)) != 0 || listen(fd, kListenBacklog) != 0) {
+        error = std::strerror(errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One deadline for the whole line, so a client trickling bytes cannot hold
+// the connection open any longer than one that sends nothing.
+bool read_request_line(int fd, std::string& request) {
+    const auto deadline = std::chrono::steady_clock::now() + kRequestTimeout;
+    request.clear();
+    char buffer[512];
+    while (request.size() < kMaxRequestBytes) {
+        const auto remaining =
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            return false;
+        }
+        pollfd client_poll{.fd = fd, .events = POLLIN, .revents = 0};
+        const int ready = poll(&client_poll, 1, static_cast<int>(remaining.count()));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            return false;
+        }
+        const ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+        const size_t newline = request.find('\n');
+        if (newline != std::string::npos) {
+            request.resize(newline);
+            if (!request.empty() && request.back() == '\r') {
+                request.pop_back();
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t sent = send(fd, data.data(), data.size(), kSendFlags);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+bool run_carve_server(const CarveServerOptions& options, const CarveJobHandler& handler, std::ostream& log_out) {
+    std::string error;
+    const int listener = open_listener(options.socket_path, error);
+    if (listener < 0) {
+        log_out << std::format("Failed to listen on {}: {}", options.socket_path, error) << std::endl;
+        return false;
+    }
+
+    // Without SA_RESTART, poll() returns as soon as a stop signal arrives.
+    struct sigaction stop_action {};
+    stop_action.sa_handler = request_stop;
+    sigemptyset(&stop_action.sa_mask);
+    sigaction(SIGINT, &stop_action, nullptr);
+    sigaction(SIGTERM, &stop_action, nullptr);
+    // A client that disconnects mid-stream fails that job's writes, nothing more.
+    signal(SIGPIPE, SIG_IGN);
+
+    log_out << std::format("Serving carve jobs on {} (at most {} in flight)", options.socket_path, options.max_jobs)
+            << std::endl;
+
+    std::mutex mutex;
+    std::condition_variable job_finished;
+    // Connection threads alive, including jobs in flight.
+    size_t connections = 0;
+    size_t in_flight = 0;
+    size_t admitted = 0;
+    size_t rejected = 0;
+    while (g_stop_requested == 0) {
+        pollfd listener_poll{.fd = listener, .events = POLLIN, .revents = 0};
+        const int ready = poll(&listener_poll, 1, kAcceptPollMs);
+        if (ready <= 0) {
+            continue;
+        }
+        const int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        set_cloexec(client);
+
+        bool accept_request = false;
+        size_t busy_with = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            accept_request = connections - in_flight < kMaxPendingRequests;
+            busy_with = in_flight;
+            if (accept_request) {
+                ++connections;
+            } else {
+                ++rejected;
+            }
+        }
+        if (!accept_request) {
+            write_all(client, std::format("BUSY {}\n", busy_with));
+            close(client);
+            continue;
+        }
+
+        // The request line is read before admission, so a client that
+        // connects and sends nothing never holds a job slot.
+        std::thread([&, client] {
+            std::string request;
+            const bool received = read_request_line(client, request);
+            bool admit = false;
+            size_t jobs_running = 0;
+            if (received) {
+                std::lock_guard<std::mutex> lock(mutex);
+                admit = in_flight < options.max_jobs;
+                jobs_running = in_flight;
+                if (admit) {
+                    ++in_flight;
+                    ++admitted;
+                } else {
+                    ++rejected;
+                }
+            }
+            if (admit) {
+                handler(client, request);
+            } else if (received) {
+                write_all(client, std::format("BUSY {}\n", jobs_running));
+            } else {
+                write_all(client, "ERROR no request line\n");
+            }
+            close(client);
+            // Notified under the lock: once connections reaches zero the
+            // server may return and destroy these locals.
+            std::lock_guard<std::mutex> lock(mutex);
+            if (admit) {
+                --in_flight;
+            }
+            --connections;
+            job_finished.notify_all();
+        }).detach();
+    }
+
+    close(listener);
+    unlink(options.socket_path.c_str());
+    std::unique_lock<std::mutex> lock(mutex);
+    if (connections > 0) {
+        log_out << std::format("Stopping: waiting for {} job(s) in flight and {} pending request(s)", in_flight,
+                               connections - in_flight) << std::endl;
+    }
+    job_finished.wait(lock, [&] { return connections == 0; });
+    log_out << std::format("Served {} job(s), rejected {} as busy", admitted, rejected) << std::endl;
+    return true;
+}
+
+#else // _WIN32
+
+bool write_all(int, std::string_view) {
+    return false;
+}
+
+bool run_carve_server(const CarveServerOptions&, const CarveJobHandler&, std::ostream& log_out) {
+    log_out << "--serve needs Unix domain sockets" << std::endl;
+    return false;
+}
+
+#endif // _WIN32
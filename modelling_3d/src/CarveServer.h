@@ -0,0 +1,36 @@
+#ifndef CARVE_SERVER_H
+#define CARVE_SERVER_H
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Local job server behind --serve. Clients connect to a Unix socket and send
+// one request line; each admitted job runs on its own thread with the
+// connection as its response stream, so the caller's warm state (OGR
+// features, id index, boolean workers) outlives every job.
+//
+// Admission control: a connection competes for a job slot once its request
+// line is in (within 10 s, or it is closed with an ERROR line).
+// While `max_jobs` jobs are in flight, it is answered with
+// "BUSY <in flight>\n" and closed instead of queueing.
+struct CarveServerOptions {
+    std::string socket_path;
+    size_t max_jobs = 1;
+};
+
+// Runs one admitted job. `request` is the request line without its newline;
+// the handler writes the whole response to `fd`, which the server closes
+// afterwards.
+using CarveJobHandler = std::function<void(int fd, const std::string& request)>;
+
+// Serves until SIGINT or SIGTERM, then waits for the jobs in flight and
+// removes the socket. Returns false when the socket could not be set up.
+bool run_carve_server(const CarveServerOptions& options, const CarveJobHandler& handler, std::ostream& log_out);
+
+// Writes all of `data`; false once the client has gone away.
+bool write_all(int fd, std::string_view data);
+
+#endif // CARVE_SERVER_H
@@ -0,0 +1,208 @@
+#include "Checkpoint.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string_view>
+#include <utility>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace {
+
+// One "key value..." pair per line; the bitmap is hex, four features per digit.
+constexpr std::string_view kFormatLine = "add_underpass checkpoint 1";
+
+bool parse_size(std::string_view text, size_t& value) {
+    const auto parsed = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && parsed.ec == std::errc{} && parsed.ptr == text.data() + text.size();
+}
+
+bool parse_u64(std::string_view text, uint64_t& value) {
+    const auto parsed = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && parsed.ec == std::errc{} && parsed.ptr == text.data() + text.size();
+}
+
+bool parse_double(std::string_view text, double& value) {
+    const std::string owned(text);
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtod(owned.c_str(), &end);
+    return !owned.empty() && end == owned.c_str() + owned.size() && errno == 0 && std::isfinite(value);
+}
+
+// Splits off the text up to the first space.
+std::string_view next_word(std::string_view& text) {
+    const size_t space = text.find(' ');
+    const std::string_view word = text.substr(0, space);
+    text = space == std::string_view::npos ? std::string_view{} : text.substr(space + 1);
+    return word;
+}
+
+std::string encode_bitmap(const std::vector<bool>& bits) {
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    std::string hex((bits.size() + 3) / 4, '0');
+    for (size_t digit = 0; digit < hex.size(); ++digit) {
+        unsigned nibble = 0;
+        for (size_t bit = 0; bit < 4 && digit * 4 + bit < bits.size(); ++bit) {
+            if (bits[digit * 4 + bit]) {
+                nibble |= 1u << bit;
+            }
+        }
+        hex[digit] = kHexDigits[nibble];
+    }
+    return hex;
+}
+
+bool decode_bitmap(std::string_view hex, size_t count, std::vector<bool>& bits) {
+    if (hex.size() != (count + 3) / 4) {
+        return false;
+    }
+    bits.assign(count, false);
+    for (size_t i = 0; i < count; ++i) {
+        const char c = hex[i / 4];
+        int digit = 0;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        bits[i] = (digit >> (i % 4)) & 1;
+    }
+    return true;
+}
+
+} // namespace
+
+bool write_checkpoint(const std::string& path, const RunCheckpoint& checkpoint) {
+    const std::string temp_path = path + ".tmp";
+    std::FILE* file = std::fopen(temp_path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = std::fprintf(file, "%.*s\n", static_cast<int>(kFormatLine.size()), kFormatLine.data()) > 0 &&
+        std::fprintf(file, "model_path %s\n", checkpoint.model_path.c_str()) > 0 &&
+        std::fprintf(file, "output_path %s\n", checkpoint.output_path.c_str()) > 0 &&
+        std::fprintf(file, "input_offset %llu\n", static_cast<unsigned long long>(checkpoint.input_offset)) > 0 &&
+        std::fprintf(file, "output_offset %llu\n", static_cast<unsigned long long>(checkpoint.output_offset)) > 0 &&
+        std::fprintf(file, "processed %zu\n", checkpoint.processed_count) > 0 &&
+        std::fprintf(file, "skipped %zu\n", checkpoint.skipped_count) > 0;
+    for (size_t i = 0; written && i < kSkipReasonCount; ++i) {
+        if (checkpoint.skipped.by_reason[i] > 0) {
+            written = std::fprintf(file, "skip %s %zu\n", skip_reason_name(static_cast<SkipReason>(i)),
+                                   checkpoint.skipped.by_reason[i]) > 0;
+        }
+    }
+    if (written && checkpoint.global_offset_set) {
+        written = std::fprintf(file, "global_offset %.17g %.17g %.17g\n", checkpoint.global_offset_x,
+                               checkpoint.global_offset_y, checkpoint.global_offset_z) > 0;
+    }
+    written = written && std::fprintf(file, "seen_feature %zu %s\n", checkpoint.seen_feature.size(),
+                                      encode_bitmap(checkpoint.seen_feature).c_str()) > 0;
+    written = written && std::fflush(file) == 0;
+#ifndef _WIN32
+    written = written && fsync(fileno(file)) == 0;
+#endif
+    if (std::fclose(file) != 0 || !written) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    return !error;
+}
+
+bool read_checkpoint(const std::string& path, RunCheckpoint& checkpoint, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        error = "cannot open file";
+        return false;
+    }
+    std::string contents;
+    char buffer[4096];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, read);
+    }
+    std::fclose(file);
+
+    RunCheckpoint parsed;
+    bool has_input_offset = false;
+    bool has_output_offset = false;
+    bool has_bitmap = false;
+    std::string_view remaining(contents);
+    size_t line_number = 0;
+    while (!remaining.empty()) {
+        const size_t newline = remaining.find('\n');
+        std::string_view line = remaining.substr(0, newline);
+        remaining = newline == std::string_view::npos ? std::string_view{} : remaining.substr(newline + 1);
+        ++line_number;
+        if (line_number == 1) {
+            if (line != kFormatLine) {
+                error = "not a checkpoint file";
+                return false;
+            }
+            continue;
+        }
+        if (line.empty()) {
+            continue;
+        }
+        std::string_view value = line;
+        const std::string_view key = next_word(value);
+        bool valid = true;
+        if (key == "model_path") {
+            parsed.model_path = value;
+        } else if (key == "output_path") {
+            parsed.output_path = value;
+        } else if (key == "input_offset") {
+            valid = parse_u64(value, parsed.input_offset);
+            has_input_offset = valid;
+        } else if (key == "output_offset") {
+            valid = parse_u64(value, parsed.output_offset);
+            has_output_offset = valid;
+        } else if (key == "processed") {
+            valid = parse_size(value, parsed.processed_count);
+        } else if (key == "skipped") {
+            valid = parse_size(value, parsed.skipped_count);
+        } else if (key == "skip") {
+            const std::string_view name = next_word(value);
+            size_t reason = 0;
+            while (reason < kSkipReasonCount && name != skip_reason_name(static_cast<SkipReason>(reason))) {
+                ++reason;
+            }
+            valid = reason < kSkipReasonCount && parse_size(value, parsed.skipped.by_reason[reason]);
+        } else if (key == "global_offset") {
+            valid = parse_double(next_word(value), parsed.global_offset_x) &&
+                parse_double(next_word(value), parsed.global_offset_y) &&
+                parse_double(value, parsed.global_offset_z);
+            parsed.global_offset_set = valid;
+        } else if (key == "seen_feature") {
+            size_t count = 0;
+            valid = parse_size(next_word(value), count) && decode_bitmap(value, count, parsed.seen_feature);
+            has_bitmap = valid;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            error = "invalid line " + std::to_string(line_number);
+            return false;
+        }
+    }
+    if (line_number == 0) {
+        error = "empty file";
+        return false;
+    }
+    if (!has_input_offset || !has_output_offset || !has_bitmap) {
+        error = "incomplete checkpoint";
+        return false;
+    }
+    checkpoint = std::move(parsed);
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "RunMetrics.h"
+
+// State of an FCB run at a feature boundary, written every
+// --checkpoint-every model features. The output is fsynced first, so its
+// first `output_offset` bytes are a valid partial FlatCityBuf; --resume
+// truncates the output there, seeks the input to `input_offset` and restores
+// the counters, so the resumed run continues the same output.
+struct RunCheckpoint {
+    std::string model_path;
+    std::string output_path;
+    uint64_t input_offset = 0;
+    uint64_t output_offset = 0;
+    size_t processed_count = 0;
+    size_t skipped_count = 0;
+    SkipCounts skipped;
+    // Replacement geometry is written relative to the first feature's offset,
+    // so a resumed run must keep using it.
+    bool global_offset_set = false;
+    double global_offset_x = 0.0;
+    double global_offset_y = 0.0;
+    double global_offset_z = 0.0;
+    // One bit per OGR feature; its size identifies the OGR input.
+    std::vector<bool> seen_feature;
+};
+
+// Writes next to `path` and renames over it, so a crash leaves either the old
+// or the new checkpoint.
+bool write_checkpoint(const std::string& path, const RunCheckpoint& checkpoint);
+bool read_checkpoint(const std::string& path, RunCheckpoint& checkpoint, std::string& error);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,129 @@
+#include "CycleNesting.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace cycle_nesting {
+
+namespace {
+
+constexpr uint32_t kNoSlot = std::numeric_limits<uint32_t>::max();
+
+// Crossing-number test; boundary points land on either side.
+bool point_in_ring(const pip::Point2& p, const std::vector<pip::Point2>& ring) {
+    if (ring.size() < 3) {
+        return false;
+    }
+
+    bool inside = false;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        const auto& a = ring[i];
+        const auto& b = ring[j];
+        const bool intersects = ((a.y > p.y) != (b.y > p.y)) &&
+            (p.x < (b.x - a.x) * (p.y - a.y) / ((b.y - a.y) == 0.0 ? 1e-18 : (b.y - a.y)) + a.x);
+        if (intersects) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+} // namespace
+
+void compute_bounds(NestingCycle& cycle) {
+    cycle.bbox_min = cycle.ring.front();
+    cycle.bbox_max = cycle.ring.front();
+    for (const auto& v : cycle.ring) {
+        cycle.bbox_min.x = std::min(cycle.bbox_min.x, v.x);
+        cycle.bbox_min.y = std::min(cycle.bbox_min.y, v.y);
+        cycle.bbox_max.x = std::max(cycle.bbox_max.x, v.x);
+        cycle.bbox_max.y = std::max(cycle.bbox_max.y, v.y);
+    }
+}
+
+void resolve_cycle_nesting(std::vector<NestingCycle>& cycles) {
+    enum : uint8_t { kOpen = 0, kQuery = 1, kClose = 2 };
+    struct SweepEvent {
+        double x = 0.0;
+        uint8_t kind = kOpen;
+        uint32_t index = 0;
+    };
+
+    std::vector<SweepEvent> events;
+    events.reserve(cycles.size() * 3);
+    for (uint32_t i = 0; i < cycles.size(); ++i) {
+        events.push_back(SweepEvent{cycles[i].bbox_min.x, kOpen, i});
+        events.push_back(SweepEvent{cycles[i].ring.front().x, kQuery, i});
+        events.push_back(SweepEvent{cycles[i].bbox_max.x, kClose, i});
+    }
+    std::sort(events.begin(), events.end(), [](const SweepEvent& a, const SweepEvent& b) {
+        if (a.x != b.x) {
+            return a.x < b.x;
+        }
+        if (a.kind != b.kind) {
+            return a.kind < b.kind;
+        }
+        return a.index < b.index;
+    });
+
+    std::vector<pip::PreparedRing> prepared(cycles.size());
+    std::vector<uint8_t> prepared_ready(cycles.size(), 0);
+    const auto ring_contains = [&](size_t j, const pip::Point2& p) {
+        // Rings too small for a grid are scanned in place rather than copied.
+        const auto& ring = cycles[j].ring;
+        if (ring.size() < pip::PreparedRing::kMinGridVertices) {
+            return point_in_ring(p, ring);
+        }
+        if (!prepared_ready[j]) {
+            prepared[j] = pip::PreparedRing(ring);
+            prepared_ready[j] = 1;
+        }
+        return prepared[j].contains(p.x, p.y);
+    };
+
+    std::vector<uint32_t> active;
+    std::vector<uint32_t> active_slot(cycles.size(), kNoSlot);
+    for (const auto& event : events) {
+        const uint32_t i = event.index;
+        if (event.kind == kOpen) {
+            active_slot[i] = static_cast<uint32_t>(active.size());
+            active.push_back(i);
+            continue;
+        }
+        if (event.kind == kClose) {
+            const uint32_t last = active.back();
+            active[active_slot[i]] = last;
+            active_slot[last] = active_slot[i];
+            active.pop_back();
+            active_slot[i] = kNoSlot;
+            continue;
+        }
+
+        const auto& test_point = cycles[i].ring.front();
+        double best_parent_area = std::numeric_limits<double>::max();
+        for (uint32_t j : active) {
+            if (i == j) {
+                continue;
+            }
+            if (cycles[j].abs_area <= cycles[i].abs_area) {
+                continue;
+            }
+            if (test_point.y < cycles[j].bbox_min.y || test_point.y > cycles[j].bbox_max.y) {
+                continue;
+            }
+            if (!ring_contains(j, test_point)) {
+                continue;
+            }
+            cycles[i].nesting_depth += 1;
+            // Ties go to the lowest index, as in a scan over all cycles.
+            if (cycles[j].abs_area < best_parent_area ||
+                (cycles[j].abs_area == best_parent_area && j < cycles[i].parent_index)) {
+                best_parent_area = cycles[j].abs_area;
+                cycles[i].parent_index = j;
+            }
+        }
+    }
+}
+
+} // namespace cycle_nesting
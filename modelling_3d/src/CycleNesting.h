@@ -0,0 +1,41 @@
+#ifndef CYCLE_NESTING_H
+#define CYCLE_NESTING_H
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "PreparedPolygon.h"
+
+// Nesting of the projected boundary cycles of one polygonal surface group.
+// Kept free of CGAL so it can be checked against the pairwise loop it
+// replaced (tests/CycleNestingTest.cpp).
+
+namespace cycle_nesting {
+
+constexpr size_t kNoParent = std::numeric_limits<size_t>::max();
+
+struct NestingCycle {
+    std::vector<pip::Point2> ring;
+    double abs_area = 0.0;
+    // Closed bounds of ring.
+    pip::Point2 bbox_min;
+    pip::Point2 bbox_max;
+    // Outputs of resolve_cycle_nesting.
+    size_t nesting_depth = 0;
+    size_t parent_index = kNoParent;
+};
+
+// Sets bbox_min / bbox_max from the ring's vertices.
+void compute_bounds(NestingCycle& cycle);
+
+// For every cycle, counts the larger cycles containing its first vertex and
+// records the smallest of them as parent. Bounding boxes are swept along x so
+// a query only tests rings whose box spans the point; the crossing test is
+// false outside a ring's closed box, so this matches testing every pair.
+// Parent ties go to the lowest index. Rings must not be empty.
+void resolve_cycle_nesting(std::vector<NestingCycle>& cycles);
+
+} // namespace cycle_nesting
+
+#endif // CYCLE_NESTING_H
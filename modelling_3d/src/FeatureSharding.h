@@ -0,0 +1,48 @@
+#ifndef FEATURE_SHARDING_H
+#define FEATURE_SHARDING_H
+
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+// --shard i/n: a feature belongs to shard FNV-1a-64(feature id) mod n. The
+// hash only depends on the id, so every node of a cluster run agrees on the
+// split without coordination, and fcb_merge (zityjson/src/fcb_merge.zig)
+// recomputes it to pick each feature from its owner's output.
+struct ShardSpec {
+    uint64_t index = 0;
+    uint64_t count = 1;
+
+    bool active() const { return count > 1; }
+
+    bool owns(std::string_view feature_id) const {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (unsigned char c : feature_id) {
+            hash ^= c;
+            hash *= 0x100000001b3ull;
+        }
+        return hash % count == index;
+    }
+};
+
+// Parses "i/n" with 0 <= i < n.
+inline bool parse_shard_spec(std::string_view text, ShardSpec& out) {
+    const size_t slash = text.find('/');
+    if (slash == std::string_view::npos) {
+        return false;
+    }
+    ShardSpec spec;
+    const char* index_end = text.data() + slash;
+    const char* count_end = text.data() + text.size();
+    const auto index_parsed = std::from_chars(text.data(), index_end, spec.index);
+    const auto count_parsed = std::from_chars(index_end + 1, count_end, spec.count);
+    if (index_parsed.ec != std::errc{} || index_parsed.ptr != index_end ||
+        count_parsed.ec != std::errc{} || count_parsed.ptr != count_end ||
+        spec.count == 0 || spec.index >= spec.count) {
+        return false;
+    }
+    out = spec;
+    return true;
+}
+
+#endif // FEATURE_SHARDING_H
@@ -0,0 +1,152 @@
+#include "GeometryKernels.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace kernels {
+
+void to_world_xyz(
+    const float* props,
+    size_t vertex_count,
+    size_t stride,
+    double offset_x,
+    double offset_y,
+    double offset_z,
+    double* out_xyz) {
+    for (size_t v = 0; v < vertex_count; ++v) {
+        const float* p = props + v * stride;
+        double* out = out_xyz + v * 3;
+        out[0] = static_cast<double>(p[0]) + offset_x;
+        out[1] = static_cast<double>(p[1]) + offset_y;
+        out[2] = static_cast<double>(p[2]) + offset_z;
+    }
+}
+
+void offset_positions(float* props, size_t vertex_count, size_t stride, float dx, float dy, float dz) {
+    for (size_t v = 0; v < vertex_count; ++v) {
+        float* p = props + v * stride;
+        p[0] += dx;
+        p[1] += dy;
+        p[2] += dz;
+    }
+}
+
+double min_strided(const double* values, size_t count, size_t stride) {
+    // Four independent accumulators break the dependency chain; min is exact,
+    // so the split does not change the result.
+    constexpr double kInf = std::numeric_limits<double>::infinity();
+    double m0 = kInf;
+    double m1 = kInf;
+    double m2 = kInf;
+    double m3 = kInf;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const double v0 = values[(i + 0) * stride];
+        const double v1 = values[(i + 1) * stride];
+        const double v2 = values[(i + 2) * stride];
+        const double v3 = values[(i + 3) * stride];
+        m0 = v0 < m0 ? v0 : m0;
+        m1 = v1 < m1 ? v1 : m1;
+        m2 = v2 < m2 ? v2 : m2;
+        m3 = v3 < m3 ? v3 : m3;
+    }
+    for (; i < count; ++i) {
+        const double v = values[i * stride];
+        m0 = v < m0 ? v : m0;
+    }
+    return std::min(std::min(m0, m1), std::min(m2, m3));
+}
+
+void classify_triangles(
+    const float* props,
+    size_t vertex_count,
+    size_t stride,
+    const uint32_t* tri_verts,
+    size_t tri_count,
+    const TriangleClassifier& classifier,
+    uint8_t* out) {
+    if (vertex_count == 0) {
+        std::fill(out, out + tri_count, classifier.wall);
+        return;
+    }
+
+    const auto vertex = [&](uint32_t index) {
+        return props + static_cast<size_t>(index < vertex_count ? index : 0) * stride;
+    };
+    for (size_t t = 0; t < tri_count; ++t) {
+        const float* p0 = vertex(tri_verts[t * 3 + 0]);
+        const float* p1 = vertex(tri_verts[t * 3 + 1]);
+        const float* p2 = vertex(tri_verts[t * 3 + 2]);
+
+        // Cross product of edges e1 = v1-v0, e2 = v2-v0.
+        const float ex1 = p1[0] - p0[0], ey1 = p1[1] - p0[1], ez1 = p1[2] - p0[2];
+        const float ex2 = p2[0] - p0[0], ey2 = p2[1] - p0[1], ez2 = p2[2] - p0[2];
+        const float nx = ey1 * ez2 - ez1 * ey2;
+        const float ny = ez1 * ex2 - ex1 * ez2;
+        float nz = ex1 * ey2 - ey1 * ex2;
+
+        const float len = std::sqrt(nx * nx + ny * ny + nz * nz);
+        if (len > 0.0f) nz /= len;
+
+        if (std::abs(nz) < classifier.nz_threshold) {
+            out[t] = classifier.wall;
+        } else if (nz > 0.0f) {
+            out[t] = classifier.roof;
+        } else if (std::abs(static_cast<double>(p0[2]) - classifier.ground_z) < classifier.z_tolerance) {
+            // Downward-facing: distinguish ground from outer ceiling by first vertex Z.
+            out[t] = classifier.ground;
+        } else {
+            out[t] = classifier.outer_ceiling;
+        }
+    }
+}
+
+void triangle_frames(
+    const float* props,
+    size_t vertex_count,
+    size_t stride,
+    const uint32_t* tri_verts,
+    size_t tri_count,
+    double min_normal_length_sq,
+    TriangleFramesSoA& out) {
+    out.nx.assign(tri_count, 0.0);
+    out.ny.assign(tri_count, 0.0);
+    out.nz.assign(tri_count, 0.0);
+    out.cx.assign(tri_count, 0.0);
+    out.cy.assign(tri_count, 0.0);
+    out.cz.assign(tri_count, 0.0);
+    if (vertex_count == 0) {
+        return;
+    }
+
+    const auto point = [&](uint32_t index) {
+        const float* p = props + static_cast<size_t>(index < vertex_count ? index : 0) * stride;
+        return std::array<double, 3>{p[0], p[1], p[2]};
+    };
+    for (size_t t = 0; t < tri_count; ++t) {
+        const auto p0 = point(tri_verts[t * 3 + 0]);
+        const auto p1 = point(tri_verts[t * 3 + 1]);
+        const auto p2 = point(tri_verts[t * 3 + 2]);
+        out.cx[t] = (p0[0] + p1[0] + p2[0]) / 3.0;
+        out.cy[t] = (p0[1] + p1[1] + p2[1]) / 3.0;
+        out.cz[t] = (p0[2] + p1[2] + p2[2]) / 3.0;
+
+        const double ux = p1[0] - p0[0], uy = p1[1] - p0[1], uz = p1[2] - p0[2];
+        const double vx = p2[0] - p0[0], vy = p2[1] - p0[1], vz = p2[2] - p0[2];
+        const double nx = uy * vz - uz * vy;
+        const double ny = uz * vx - ux * vz;
+        const double nz = ux * vy - uy * vx;
+        const double len_sq = nx * nx + ny * ny + nz * nz;
+        if (!std::isfinite(len_sq) || len_sq <= min_normal_length_sq) {
+            continue;
+        }
+        const double inv_len = 1.0 / std::sqrt(len_sq);
+        out.nx[t] = nx * inv_len;
+        out.ny[t] = ny * inv_len;
+        out.nz[t] = nz * inv_len;
+    }
+}
+
+} // namespace kernels
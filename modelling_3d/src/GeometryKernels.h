@@ -0,0 +1,81 @@
+#ifndef GEOMETRY_KERNELS_H
+#define GEOMETRY_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-vertex and per-triangle loops over result meshes. Inputs are the
+// interleaved float properties of manifold::MeshGL (stride floats per vertex,
+// xyz first). The triangle loops are the plain per-triangle loops; only
+// min_strided and offset_positions measured faster than the loops they
+// replaced (bench/GeometryKernelsBench).
+
+namespace kernels {
+
+// Per-triangle unit normals and centroids.
+struct TriangleFramesSoA {
+    std::vector<double> nx;
+    std::vector<double> ny;
+    std::vector<double> nz;
+    std::vector<double> cx;
+    std::vector<double> cy;
+    std::vector<double> cz;
+
+    size_t size() const { return nx.size(); }
+};
+
+// Orientation/height classification of triangles into caller-defined codes:
+// |nz| < nz_threshold is a wall, nz > 0 a roof, otherwise ground when the
+// first vertex is within z_tolerance of ground_z and outer ceiling if not.
+struct TriangleClassifier {
+    double ground_z = 0.0;
+    double nz_threshold = 0.3;
+    double z_tolerance = 0.5;
+    uint8_t wall = 0;
+    uint8_t roof = 0;
+    uint8_t ground = 0;
+    uint8_t outer_ceiling = 0;
+};
+
+// Interleaved world-space xyz doubles (3 per vertex) from local positions.
+void to_world_xyz(
+    const float* props,
+    size_t vertex_count,
+    size_t stride,
+    double offset_x,
+    double offset_y,
+    double offset_z,
+    double* out_xyz);
+
+// Adds an offset to the xyz of every vertex in place.
+void offset_positions(float* props, size_t vertex_count, size_t stride, float dx, float dy, float dz);
+
+// Smallest of count values spaced stride doubles apart; +inf when empty.
+double min_strided(const double* values, size_t count, size_t stride);
+
+// One code per triangle, computed in float like the original per-triangle
+// loop. Triangles referencing out-of-range vertices read vertex 0.
+void classify_triangles(
+    const float* props,
+    size_t vertex_count,
+    size_t stride,
+    const uint32_t* tri_verts,
+    size_t tri_count,
+    const TriangleClassifier& classifier,
+    uint8_t* out);
+
+// Unit normals and centroids in double. Normals whose squared length is not
+// above min_normal_length_sq (or is not finite) are zero.
+void triangle_frames(
+    const float* props,
+    size_t vertex_count,
+    size_t stride,
+    const uint32_t* tri_verts,
+    size_t tri_count,
+    double min_normal_length_sq,
+    TriangleFramesSoA& out);
+
+} // namespace kernels
+
+#endif // GEOMETRY_KERNELS_H
@@ -0,0 +1,18 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <string>
+#include <string_view>
+
+// Append-only JSON scalars shared by the --metrics and --trace writers, which
+// build their documents by hand into one string.
+namespace json {
+
+// Quoted and escaped; control characters become \uXXXX.
+void append_string(std::string& out, std::string_view value);
+// Shortest round-trip form; NaN and infinities become null.
+void append_double(std::string& out, double value);
+
+} // namespace json
+
+#endif // JSON_WRITER_H
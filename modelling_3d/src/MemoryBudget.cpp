@@ -0,0 +1,237 @@
+#include "MemoryBudget.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <utility>
+
+#include "ProcessMemory.h"
+
+namespace {
+
+constexpr double kKiB = 1024.0;
+constexpr double kMiB = 1024.0 * kKiB;
+// Weight of each measurement in the per-backend scale, so one coincident
+// spike fades after a few attempts instead of pinning the scale.
+constexpr double kCalibrationWeight = 0.25;
+
+// Peak memory of one attempt: fixed + per input triangle + per underpass.
+// Rough priors; calibration raises them where they fall short.
+struct MemoryPrior {
+    double fixed_bytes;
+    double bytes_per_triangle;
+    double bytes_per_underpass;
+};
+
+MemoryPrior memory_prior(BooleanMethod method) {
+    switch (method) {
+        case BooleanMethod::Manifold:
+            return {16.0 * kMiB, 1.0 * kKiB, 256.0 * kKiB};
+        case BooleanMethod::CgalNef:
+            // Every operand becomes a Nef polyhedron with exact coordinates.
+            return {32.0 * kMiB, 48.0 * kKiB, 8.0 * kMiB};
+        case BooleanMethod::CgalPMP:
+            // Exact_surface_mesh copies plus corefinement visitors.
+            return {32.0 * kMiB, 6.0 * kKiB, 2.0 * kMiB};
+#ifdef ENABLE_GEOGRAM
+        case BooleanMethod::Geogram:
+            return {16.0 * kMiB, 2.0 * kKiB, 512.0 * kKiB};
+#endif
+    }
+    return {32.0 * kMiB, 48.0 * kKiB, 8.0 * kMiB};
+}
+
+size_t method_index(BooleanMethod method) {
+    return static_cast<size_t>(method);
+}
+
+} // namespace
+
+MemoryBudget::Reservation::Reservation(Reservation&& other) noexcept {
+    *this = std::move(other);
+}
+
+MemoryBudget::Reservation& MemoryBudget::Reservation::operator=(Reservation&& other) noexcept {
+    if (this != &other) {
+        release();
+        budget_ = std::exchange(other.budget_, nullptr);
+        bytes_ = other.bytes_;
+        exclusive_ = other.exclusive_;
+        method_ = other.method_;
+        input_triangles_ = other.input_triangles_;
+        underpass_count_ = other.underpass_count_;
+        grant_ = other.grant_;
+        alone_ = other.alone_;
+        window_reset_ = other.window_reset_;
+        rss_before_ = other.rss_before_;
+        peak_rss_before_ = other.peak_rss_before_;
+    }
+    return *this;
+}
+
+MemoryBudget::Reservation::~Reservation() {
+    release();
+}
+
+void MemoryBudget::Reservation::release() {
+    if (budget_ != nullptr) {
+        budget_->release(bytes_, exclusive_);
+        budget_ = nullptr;
+    }
+}
+
+void MemoryBudget::Reservation::observe_in_process_peak() {
+    // The resident set is shared, so an attempt that overlapped another would
+    // be charged for both.
+    if (budget_ == nullptr || rss_before_ == 0 || !budget_->ran_alone(*this)) {
+        return;
+    }
+    if (window_reset_) {
+        const size_t peak = peak_rss_window_bytes();
+        if (peak > rss_before_) {
+            budget_->observe(method_, input_triangles_, underpass_count_, peak - rss_before_);
+        }
+        return;
+    }
+    // Without a resettable high-water mark, only attempts that raised the
+    // process peak say how much they needed.
+    const size_t peak_after = peak_rss_bytes();
+    if (peak_after > peak_rss_before_ && peak_after > rss_before_) {
+        budget_->observe(method_, input_triangles_, underpass_count_, peak_after - rss_before_);
+    }
+}
+
+void MemoryBudget::Reservation::observe_worker_peak(size_t peak_bytes) {
+    if (budget_ != nullptr && peak_bytes > 0) {
+        budget_->observe(method_, input_triangles_, underpass_count_, peak_bytes);
+    }
+}
+
+MemoryBudget::MemoryBudget(size_t budget_bytes) : budget_bytes_(budget_bytes) {
+    scale_.fill(1.0);
+}
+
+double MemoryBudget::raw_estimate_bytes(BooleanMethod method, size_t input_triangles, size_t underpass_count) const {
+    const MemoryPrior prior = memory_prior(method);
+    return prior.fixed_bytes + prior.bytes_per_triangle * static_cast<double>(input_triangles) +
+        prior.bytes_per_underpass * static_cast<double>(underpass_count);
+}
+
+size_t MemoryBudget::estimate_bytes(BooleanMethod method, size_t input_triangles, size_t underpass_count) const {
+    double scale = 1.0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scale = scale_[method_index(method)];
+    }
+    const double estimate = raw_estimate_bytes(method, input_triangles, underpass_count) * scale;
+    return estimate >= static_cast<double>(std::numeric_limits<size_t>::max())
+        ? std::numeric_limits<size_t>::max()
+        : static_cast<size_t>(estimate);
+}
+
+MemoryBudget::Reservation MemoryBudget::reserve(BooleanMethod method, size_t input_triangles, size_t underpass_count) {
+    Reservation reservation;
+    reservation.bytes_ = estimate_bytes(method, input_triangles, underpass_count);
+    reservation.method_ = method;
+    reservation.input_triangles_ = input_triangles;
+    reservation.underpass_count_ = underpass_count;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (reservation.bytes_ >= budget_bytes_) {
+        ++serialized_waiting_;
+        released_.wait(lock, [&] { return reserved_bytes_ == 0 && !exclusive_running_; });
+        --serialized_waiting_;
+        exclusive_running_ = true;
+        reservation.exclusive_ = true;
+        ++serialized_count_;
+    } else {
+        // Attempts queue behind a waiting serialized one, so it cannot starve.
+        released_.wait(lock, [&] {
+            return !exclusive_running_ && serialized_waiting_ == 0 &&
+                reserved_bytes_ + reservation.bytes_ <= budget_bytes_;
+        });
+    }
+    reservation.alone_ = reserved_bytes_ == 0;
+    reservation.grant_ = ++grants_;
+    reserved_bytes_ += reservation.bytes_;
+    peak_reserved_bytes_ = std::max(peak_reserved_bytes_, reserved_bytes_);
+    // Only an attempt that starts alone restarts the high-water mark, so a
+    // reset never cuts into the window of one already running.
+    if (reservation.alone_) {
+        reservation.window_reset_ = reset_peak_rss_window();
+    }
+    lock.unlock();
+
+    reservation.budget_ = this;
+    reservation.rss_before_ = current_rss_bytes();
+    reservation.peak_rss_before_ = peak_rss_bytes();
+    return reservation;
+}
+
+void MemoryBudget::release(size_t bytes, bool exclusive) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reserved_bytes_ -= bytes;
+    if (exclusive) {
+        exclusive_running_ = false;
+    }
+    released_.notify_all();
+}
+
+bool MemoryBudget::ran_alone(const Reservation& reservation) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reservation.alone_ && grants_ == reservation.grant_;
+}
+
+void MemoryBudget::observe(BooleanMethod method, size_t input_triangles, size_t underpass_count, size_t measured_bytes) {
+    const double raw = raw_estimate_bytes(method, input_triangles, underpass_count);
+    std::lock_guard<std::mutex> lock(mutex_);
+    double& scale = scale_[method_index(method)];
+    scale += kCalibrationWeight * (static_cast<double>(measured_bytes) / raw - scale);
+}
+
+size_t MemoryBudget::serialized_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return serialized_count_;
+}
+
+size_t MemoryBudget::peak_reserved_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_reserved_bytes_;
+}
+
+bool parse_memory_size(std::string_view text, size_t& bytes) {
+    size_t multiplier = 1;
+    if (!text.empty()) {
+        switch (text.back()) {
+            case 'K':
+            case 'k':
+                multiplier = size_t{1} << 10;
+                break;
+            case 'M':
+            case 'm':
+                multiplier = size_t{1} << 20;
+                break;
+            case 'G':
+            case 'g':
+                multiplier = size_t{1} << 30;
+                break;
+            case 'T':
+            case 't':
+                multiplier = size_t{1} << 40;
+                break;
+            default:
+                break;
+        }
+        if (multiplier != 1) {
+            text.remove_suffix(1);
+        }
+    }
+    size_t value = 0;
+    const auto parsed = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || parsed.ec != std::errc{} || parsed.ptr != text.data() + text.size() || value == 0 ||
+        value > std::numeric_limits<size_t>::max() / multiplier) {
+        return false;
+    }
+    bytes = value * multiplier;
+    return true;
+}
@@ -0,0 +1,99 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+
+#include "BackendCostModel.h"
+#include "BooleanOps.h"
+
+// --max-memory: admission control for the booleans of concurrent --serve
+// jobs or of the --jobs threads carving a .city.json tile. Each attempt
+// reserves its estimated peak memory before it runs and waits while the
+// reservations in flight would exceed the budget. An attempt estimated above
+// the whole budget is serialized: it waits until nothing else runs, and new
+// attempts wait behind it.
+//
+// The estimate is linear in input triangles and underpass count with
+// per-backend priors (exact-kernel Nef and PMP grow fastest). Measured peaks
+// calibrate a per-backend scale as a moving average: attempts in a
+// --isolate-booleans worker report their own peak, and in-process attempts
+// count only when no other boolean attempt ran next to them.
+class MemoryBudget {
+public:
+    class Reservation {
+    public:
+        Reservation() = default;
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+        Reservation(Reservation&& other) noexcept;
+        Reservation& operator=(Reservation&& other) noexcept;
+        ~Reservation();
+
+        // Calibrates the estimate with the peak RSS this attempt reached in
+        // this process, if no other reservation overlapped it.
+        void observe_in_process_peak();
+        // Calibrates the estimate with the peak a boolean worker measured for
+        // this attempt (BooleanAttempt::peak_bytes); 0 means unknown.
+        void observe_worker_peak(size_t peak_bytes);
+
+    private:
+        friend class MemoryBudget;
+        void release();
+
+        MemoryBudget* budget_ = nullptr;
+        size_t bytes_ = 0;
+        bool exclusive_ = false;
+        BooleanMethod method_ = BooleanMethod::Manifold;
+        size_t input_triangles_ = 0;
+        size_t underpass_count_ = 0;
+        // Number of this grant; a later one means another attempt overlapped.
+        size_t grant_ = 0;
+        // Nothing else was reserved when this was granted.
+        bool alone_ = false;
+        // The high-water mark was restarted at the grant.
+        bool window_reset_ = false;
+        size_t rss_before_ = 0;
+        size_t peak_rss_before_ = 0;
+    };
+
+    explicit MemoryBudget(size_t budget_bytes);
+
+    size_t estimate_bytes(BooleanMethod method, size_t input_triangles, size_t underpass_count) const;
+
+    // Blocks until the estimate for this attempt fits next to the
+    // reservations in flight.
+    Reservation reserve(BooleanMethod method, size_t input_triangles, size_t underpass_count);
+
+    size_t budget_bytes() const { return budget_bytes_; }
+    // Attempts that ran alone because their estimate exceeded the budget.
+    size_t serialized_count() const;
+    // Highest total of simultaneous reservations.
+    size_t peak_reserved_bytes() const;
+
+private:
+    void release(size_t bytes, bool exclusive);
+    bool ran_alone(const Reservation& reservation) const;
+    void observe(BooleanMethod method, size_t input_triangles, size_t underpass_count, size_t measured_bytes);
+    double raw_estimate_bytes(BooleanMethod method, size_t input_triangles, size_t underpass_count) const;
+
+    const size_t budget_bytes_;
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+    std::array<double, kAutoBooleanMethods.size()> scale_;
+    size_t reserved_bytes_ = 0;
+    size_t grants_ = 0;
+    size_t peak_reserved_bytes_ = 0;
+    size_t serialized_waiting_ = 0;
+    bool exclusive_running_ = false;
+    size_t serialized_count_ = 0;
+};
+
+// Parses a byte count with an optional K, M, G or T suffix (powers of 1024),
+// e.g. "512M" or "16G".
+bool parse_memory_size(std::string_view text, size_t& bytes);
+
+#endif // MEMORY_BUDGET_H
@@ -7,6 +7,8 @@
 #include <CGAL/Polygon_mesh_processing/triangulate_faces.h>
 #include <CGAL/Polygon_mesh_processing/compute_normal.h>
 
+#include "GeometryKernels.h"
+
 Exact_surface_mesh surface_mesh_to_exact(const Surface_mesh& sm) {
     Exact_surface_mesh esm;
 
@@ -156,14 +158,24 @@ void apply_meshgl_offset(manifold::MeshGL& mesh, double offset_x, double offset_
     if (mesh.numProp < 3) {
         return;
     }
-    for (size_t i = 0; i + 2 < mesh.vertProperties.size(); i += mesh.numProp) {
-        mesh.vertProperties[i] += static_cast<float>(offset_x);
-        mesh.vertProperties[i + 1] += static_cast<float>(offset_y);
-        mesh.vertProperties[i + 2] += static_cast<float>(offset_z);
-    }
+    kernels::offset_positions(
+        mesh.vertProperties.data(),
+        mesh.vertProperties.size() / mesh.numProp,
+        mesh.numProp,
+        static_cast<float>(offset_x),
+        static_cast<float>(offset_y),
+        static_cast<float>(offset_z));
 }
 
 double mesh_min_z(const Surface_mesh& sm) {
+    // Without garbage the vertex indices are 0..n-1 over one contiguous point
+    // array, so z can be scanned with a stride.
+    static_assert(sizeof(K::Point_3) == 3 * sizeof(double));
+    if (!sm.has_garbage() && sm.number_of_vertices() > 0) {
+        const double* first_z = &sm.point(*sm.vertices().begin()).z();
+        return kernels::min_strided(first_z, sm.number_of_vertices(), 3);
+    }
+
     double min_z = std::numeric_limits<double>::infinity();
     for (auto v : sm.vertices()) {
         const double z = sm.point(v).z();
@@ -22,6 +22,9 @@
 namespace {
 
 constexpr uint8_t kDefaultSemanticType = 2;
+constexpr std::string_view kLod22ObjectSuffix = "-0";
+constexpr std::string_view kLod22 = "2.2";
+constexpr std::string_view kB3Val3dityLod22 = "b3_val3dity_lod22";
 
 struct FaceInfo {
     int nesting_level = -1;
@@ -230,20 +233,42 @@ bool triangulate_surface_with_holes(
     }
 }
 
-template <typename T, typename SemanticGetter>
+// Adds the span vertices to sm, shifted by the local offset.
+template <typename Spans>
+std::vector<Surface_mesh::Vertex_index> add_offset_vertices(
+    const Spans& spans,
+    Surface_mesh& sm,
+    double offset_x,
+    double offset_y,
+    double offset_z) {
+    std::vector<Surface_mesh::Vertex_index> vertex_handles;
+    vertex_handles.reserve(spans.vertex_count);
+    const double* v = spans.vertices;
+    for (size_t i = 0; i < spans.vertex_count; ++i, v += 3) {
+        vertex_handles.push_back(sm.add_vertex(K::Point_3(
+            v[0] - offset_x,
+            v[1] - offset_y,
+            v[2] - offset_z)));
+    }
+    return vertex_handles;
+}
+
+// Spans is ZfcbGeometrySpans or CityJSONGeometrySpans; both expose the same
+// surfaces/strings/boundaries layout, only the index type differs.
+template <typename Spans>
 bool append_ringed_geometry_faces(
     const std::vector<Surface_mesh::Vertex_index>& vertex_handles,
-    size_t vertex_count,
-    const T* surfaces,
-    size_t surface_count,
-    const T* strings,
-    size_t string_count,
-    const T* boundaries,
-    size_t boundary_count,
+    const Spans& spans,
     Surface_mesh& sm,
     std::vector<SemanticSurface>* semantic_surfaces,
-    SemanticGetter&& get_surface_semantic_type,
     std::string_view mesh_context) {
+    const size_t vertex_count = spans.vertex_count;
+    const auto* surfaces = spans.surfaces;
+    const size_t surface_count = spans.surface_count;
+    const auto* strings = spans.strings;
+    const size_t string_count = spans.string_count;
+    const auto* boundaries = spans.boundaries;
+    const size_t boundary_count = spans.boundary_count;
     if (surfaces == nullptr || strings == nullptr || boundaries == nullptr) {
         std::cerr << "Skipping all surfaces for " << mesh_context
                   << ": missing surfaces/strings/boundaries arrays" << std::endl;
@@ -320,8 +345,12 @@ bool append_ringed_geometry_faces(
         if (triangulate_surface_with_holes(std::move(rings), vertex_handles, sm, &tri_failure)) {
             added_faces = true;
             if (semantic_surfaces != nullptr) {
-                uint8_t semantic_type = kDefaultSemanticType;
-                get_surface_semantic_type(s, semantic_type);
+                uint8_t semantic_type = spans.surface_semantic_types != nullptr
+                    ? spans.surface_semantic_types[s]
+                    : ZFCB_SEMANTIC_TYPE_NONE;
+                if (semantic_type == ZFCB_SEMANTIC_TYPE_NONE) {
+                    semantic_type = kDefaultSemanticType;
+                }
                 semantic_surfaces->push_back(SemanticSurface{
                     .rings = std::move(rings_copy),
                     .semantic_type = semantic_type,
@@ -336,21 +365,9 @@ bool append_ringed_geometry_faces(
     return added_faces;
 }
 
-ssize_t find_cityjson_lod22_solid_geometry(CityJSONHandle cj, size_t object_index) {
-    const size_t geometry_count = cityjson_get_geometry_count(cj, object_index);
-    for (size_t geometry_index = 0; geometry_index < geometry_count; ++geometry_index) {
-        if (cityjson_get_geometry_type(cj, object_index, geometry_index) != CITYJSON_SOLID) {
-            continue;
-        }
-
-        const char* lod_ptr = nullptr;
-        size_t lod_len = 0;
-        if (cityjson_get_geometry_lod(cj, object_index, geometry_index, &lod_ptr, &lod_len) == 1 &&
-            lod_ptr != nullptr && std::string_view(lod_ptr, lod_len) == "2.2") {
-            return static_cast<ssize_t>(geometry_index);
-        }
-    }
-    return -1;
+bool find_cityjson_solid(
+    CityJSONHandle cj, size_t object_index, std::string_view lod, CityJSONGeometrySpans& spans) {
+    return cityjson_get_solid_geometry(cj, object_index, lod.data(), lod.size(), &spans) == 1;
 }
 
 } // namespace
@@ -363,18 +380,23 @@ bool is_fcb_path(const std::string_view path) {
     return path.substr(path.size() - ext.size()) == ext;
 }
 
-bool is_cityjsonseq_path(const std::string_view path) {
-    constexpr std::string_view jsonl_ext = ".jsonl";
-    constexpr std::string_view cityjsonl_ext = ".city.jsonl";
-    if (path.size() >= cityjsonl_ext.size() &&
-        path.substr(path.size() - cityjsonl_ext.size()) == cityjsonl_ext) {
-        return true;
-    }
-    if (path.size() >= jsonl_ext.size() &&
-        path.substr(path.size() - jsonl_ext.size()) == jsonl_ext) {
-        return true;
+bool is_cityjsonseq_path(std::string_view path) {
+    // zityjson decodes/encodes zstd and gzip streams itself.
+    for (const std::string_view compressed_ext : {std::string_view(".zst"), std::string_view(".gz")}) {
+        if (path.size() >= compressed_ext.size() &&
+            path.substr(path.size() - compressed_ext.size()) == compressed_ext) {
+            path.remove_suffix(compressed_ext.size());
+            break;
+        }
     }
-    return false;
+    constexpr std::string_view jsonl_ext = ".jsonl";
+    return path.size() >= jsonl_ext.size() &&
+           path.substr(path.size() - jsonl_ext.size()) == jsonl_ext;
+}
+
+bool is_cityjson_path(const std::string_view path) {
+    constexpr std::string_view ext = ".city.json";
+    return path.size() >= ext.size() && path.substr(path.size() - ext.size()) == ext;
 }
 
 ssize_t resolve_cityjson_object_index(CityJSONHandle cj, std::string_view feature_id) {
@@ -400,18 +422,14 @@ bool cityjson_lod22_first_vertex(
     if (cj == nullptr) {
         return false;
     }
-    const ssize_t geometry_index = find_cityjson_lod22_solid_geometry(cj, object_index);
-    if (geometry_index < 0) {
+    CityJSONGeometrySpans spans{};
+    if (!find_cityjson_solid(cj, object_index, kLod22, spans) ||
+        spans.vertices == nullptr || spans.vertex_count == 0) {
         return false;
     }
-    const size_t geometry = static_cast<size_t>(geometry_index);
-    const double* vertices = cityjson_get_vertices(cj, object_index, geometry);
-    if (vertices == nullptr || cityjson_get_vertex_count(cj, object_index, geometry) == 0) {
-        return false;
-    }
-    x = vertices[0];
-    y = vertices[1];
-    z = vertices[2];
+    x = spans.vertices[0];
+    y = spans.vertices[1];
+    z = spans.vertices[2];
     return true;
 }
 
@@ -421,64 +439,26 @@ bool load_cityjson_object_mesh(
     LoadedSolidMesh& out,
     double offset_x,
     double offset_y,
-    double offset_z) {
+    double offset_z,
+    std::string_view lod) {
     out.mesh.clear();
     out.semantic_surfaces.clear();
     if (cj == nullptr) {
         return false;
     }
 
-    const ssize_t geometry_index = find_cityjson_lod22_solid_geometry(cj, object_index);
-    if (geometry_index < 0) {
-        return false;
-    }
-
-    const size_t geom_idx = static_cast<size_t>(geometry_index);
-    size_t vertex_count = cityjson_get_vertex_count(cj, object_index, geom_idx);
-    const double* vertices = cityjson_get_vertices(cj, object_index, geom_idx);
-    if (vertices == nullptr || vertex_count == 0) {
+    CityJSONGeometrySpans spans{};
+    if (!find_cityjson_solid(cj, object_index, lod, spans) ||
+        spans.vertices == nullptr || spans.vertex_count == 0) {
         return false;
     }
 
-    std::vector<Surface_mesh::Vertex_index> vertex_handles;
-    vertex_handles.reserve(vertex_count);
-    for (size_t v = 0; v < vertex_count; ++v) {
-        vertex_handles.push_back(out.mesh.add_vertex(K::Point_3(
-            vertices[v * 3] - offset_x,
-            vertices[v * 3 + 1] - offset_y,
-            vertices[v * 3 + 2] - offset_z)));
-    }
-
-    const size_t surface_count = cityjson_get_geometry_surface_count(cj, object_index, geom_idx);
-    const size_t string_count = cityjson_get_geometry_string_count(cj, object_index, geom_idx);
-    const size_t boundary_count = cityjson_get_geometry_boundary_count(cj, object_index, geom_idx);
-    const size_t* surfaces = cityjson_get_geometry_surfaces(cj, object_index, geom_idx);
-    const size_t* strings = cityjson_get_geometry_strings(cj, object_index, geom_idx);
-    const size_t* boundaries = cityjson_get_geometry_boundaries(cj, object_index, geom_idx);
-
+    const auto vertex_handles = add_offset_vertices(spans, out.mesh, offset_x, offset_y, offset_z);
     const std::string mesh_context =
         std::string("CityJSON object_index=") + std::to_string(object_index) +
-        " geometry_index=" + std::to_string(geom_idx);
-
-    auto semantic_getter = [&](size_t surface_index, uint8_t& semantic_type) {
-        semantic_type = kDefaultSemanticType;
-        (void)cityjson_get_geometry_surface_semantic_type(
-            cj, object_index, geom_idx, surface_index, &semantic_type);
-    };
-
+        " geometry_index=" + std::to_string(spans.geometry_index);
     return append_ringed_geometry_faces(
-        vertex_handles,
-        vertex_count,
-        surfaces,
-        surface_count,
-        strings,
-        string_count,
-        boundaries,
-        boundary_count,
-        out.mesh,
-        &out.semantic_surfaces,
-        semantic_getter,
-        mesh_context);
+        vertex_handles, spans, out.mesh, &out.semantic_surfaces, mesh_context);
 }
 
 bool load_cityjson_object_mesh(
@@ -496,6 +476,21 @@ bool load_cityjson_object_mesh(
     return true;
 }
 
+int fcb_next_for_mesh_loading(ZfcbReaderHandle fcb, std::string_view lod) {
+    const char* const attribute_names[] = {kB3Val3dityLod22.data()};
+    const size_t attribute_name_lens[] = {kB3Val3dityLod22.size()};
+    const ZfcbDecodeFilter filter{
+        .geometry_object_suffix = kLod22ObjectSuffix.data(),
+        .geometry_object_suffix_len = kLod22ObjectSuffix.size(),
+        .lod = lod.empty() ? nullptr : lod.data(),
+        .lod_len = lod.size(),
+        .attribute_names = attribute_names,
+        .attribute_name_lens = attribute_name_lens,
+        .attribute_name_count = 1,
+    };
+    return zfcb_next_selective(fcb, &filter);
+}
+
 bool load_fcb_feature_mesh(
     ZfcbReaderHandle fcb,
     std::string_view feature_id,
@@ -503,129 +498,43 @@ bool load_fcb_feature_mesh(
     double offset_x,
     double offset_y,
     double offset_z,
-    std::string* out_b3_val3dity_lod22) {
+    std::string* out_b3_val3dity_lod22,
+    std::string_view lod) {
     out.mesh.clear();
     out.semantic_surfaces.clear();
     if (out_b3_val3dity_lod22 != nullptr) {
         out_b3_val3dity_lod22->clear();
-    }
-
-    size_t vertex_count = zfcb_current_vertex_count(fcb);
-    const double* vertices = zfcb_current_vertices(fcb);
-    if (vertices == nullptr || vertex_count == 0) {
-        return false;
-    }
-
-    std::vector<Surface_mesh::Vertex_index> vertex_handles;
-    vertex_handles.reserve(vertex_count);
-    for (size_t v = 0; v < vertex_count; ++v) {
-        vertex_handles.push_back(out.mesh.add_vertex(K::Point_3(
-            vertices[v * 3] - offset_x,
-            vertices[v * 3 + 1] - offset_y,
-            vertices[v * 3 + 2] - offset_z)));
-    }
-
-    const std::string object_id = std::string(feature_id) + "-0";
-    ssize_t object_index = -1;
-    ssize_t feature_object_index = -1;
-    size_t object_count = zfcb_current_object_count(fcb);
-    for (size_t obj_idx = 0; obj_idx < object_count; ++obj_idx) {
-        const char* current_obj_id_ptr = nullptr;
-        size_t current_obj_id_len = 0;
-        if (zfcb_current_object_id(fcb, obj_idx, &current_obj_id_ptr, &current_obj_id_len) != 0) {
-            continue;
-        }
-        std::string_view current_obj_id(current_obj_id_ptr, current_obj_id_len);
-        if (current_obj_id == object_id) {
-            object_index = static_cast<ssize_t>(obj_idx);
-        }
-        if (current_obj_id == feature_id) {
-            feature_object_index = static_cast<ssize_t>(obj_idx);
-        }
-        if (object_index >= 0 &&
-            (out_b3_val3dity_lod22 == nullptr || feature_object_index >= 0)) {
-            break;
-        }
-    }
-
-    if (out_b3_val3dity_lod22 != nullptr && feature_object_index >= 0) {
-        constexpr std::string_view kB3Val3dityLod22 = "b3_val3dity_lod22";
+        size_t feature_object_index = 0;
         const char* attr_value_ptr = nullptr;
         size_t attr_value_len = 0;
-        int attr_result = zfcb_current_object_string_attribute(
-            fcb,
-            static_cast<size_t>(feature_object_index),
-            kB3Val3dityLod22.data(),
-            kB3Val3dityLod22.size(),
-            &attr_value_ptr,
-            &attr_value_len);
-        if (attr_result == 1 && attr_value_ptr != nullptr) {
+        if (zfcb_current_find_object(fcb, feature_id.data(), feature_id.size(), &feature_object_index) == 1 &&
+            zfcb_current_object_string_attribute(
+                fcb,
+                feature_object_index,
+                kB3Val3dityLod22.data(),
+                kB3Val3dityLod22.size(),
+                &attr_value_ptr,
+                &attr_value_len) == 1 &&
+            attr_value_ptr != nullptr) {
             *out_b3_val3dity_lod22 = std::string(attr_value_ptr, attr_value_len);
         }
     }
 
-    if (object_index < 0) {
+    const std::string object_id = std::string(feature_id) + std::string(kLod22ObjectSuffix);
+    ZfcbGeometrySpans spans{};
+    if (zfcb_current_solid_geometry(
+            fcb, object_id.data(), object_id.size(), lod.data(), lod.size(), &spans) != 1 ||
+        spans.vertices == nullptr || spans.vertex_count == 0) {
         return false;
     }
 
-    ssize_t geometry_index = -1;
-    size_t geom_count = zfcb_current_object_geometry_count(fcb, static_cast<size_t>(object_index));
-    for (size_t geom_idx = 0; geom_idx < geom_count; ++geom_idx) {
-        uint8_t geom_type = zfcb_current_geometry_type(fcb, static_cast<size_t>(object_index), geom_idx);
-        bool solid_like = geom_type == ZFCB_GEOMETRY_SOLID ||
-                          geom_type == ZFCB_GEOMETRY_MULTI_SOLID ||
-                          geom_type == ZFCB_GEOMETRY_COMPOSITE_SOLID;
-        if (!solid_like) {
-            continue;
-        }
-
-        const char* lod_ptr = nullptr;
-        size_t lod_len = 0;
-        if (zfcb_current_geometry_lod(fcb, static_cast<size_t>(object_index), geom_idx, &lod_ptr, &lod_len) != 0) {
-            continue;
-        }
-        std::string_view lod = (lod_ptr != nullptr) ? std::string_view(lod_ptr, lod_len) : std::string_view{};
-        if (lod == "2.2") {
-            geometry_index = static_cast<ssize_t>(geom_idx);
-            break;
-        }
-    }
-    if (geometry_index < 0) {
-        return false;
-    }
-
-    size_t geom_idx = static_cast<size_t>(geometry_index);
-    size_t surface_count = zfcb_current_geometry_surface_count(fcb, static_cast<size_t>(object_index), geom_idx);
-    size_t string_count = zfcb_current_geometry_string_count(fcb, static_cast<size_t>(object_index), geom_idx);
-    size_t boundary_count = zfcb_current_geometry_boundary_count(fcb, static_cast<size_t>(object_index), geom_idx);
-    const uint32_t* surfaces = zfcb_current_geometry_surfaces(fcb, static_cast<size_t>(object_index), geom_idx);
-    const uint32_t* strings = zfcb_current_geometry_strings(fcb, static_cast<size_t>(object_index), geom_idx);
-    const uint32_t* boundaries = zfcb_current_geometry_boundaries(fcb, static_cast<size_t>(object_index), geom_idx);
-
+    const auto vertex_handles = add_offset_vertices(spans, out.mesh, offset_x, offset_y, offset_z);
     const std::string mesh_context =
         std::string("FCB feature='") + std::string(feature_id) +
-        "' object_index=" + std::to_string(object_index) +
-        " geometry_index=" + std::to_string(geom_idx);
-
-    auto semantic_getter = [&](size_t surface_index, uint8_t& semantic_type) {
-        semantic_type = kDefaultSemanticType;
-        (void)zfcb_current_geometry_surface_semantic_type(
-            fcb, static_cast<size_t>(object_index), geom_idx, surface_index, &semantic_type);
-    };
-
+        "' object_index=" + std::to_string(spans.object_index) +
+        " geometry_index=" + std::to_string(spans.geometry_index);
     return append_ringed_geometry_faces(
-        vertex_handles,
-        vertex_count,
-        surfaces,
-        surface_count,
-        strings,
-        string_count,
-        boundaries,
-        boundary_count,
-        out.mesh,
-        &out.semantic_surfaces,
-        semantic_getter,
-        mesh_context);
+        vertex_handles, spans, out.mesh, &out.semantic_surfaces, mesh_context);
 }
 
 bool load_fcb_feature_mesh(
@@ -645,6 +554,22 @@ bool load_fcb_feature_mesh(
     return true;
 }
 
+bool load_ringed_solid_mesh(
+    const RingedSolidSpans& spans,
+    LoadedSolidMesh& out,
+    double offset_x,
+    double offset_y,
+    double offset_z,
+    std::string_view mesh_context) {
+    out.mesh.clear();
+    out.semantic_surfaces.clear();
+    if (spans.vertices == nullptr || spans.vertex_count == 0) {
+        return false;
+    }
+    const auto vertex_handles = add_offset_vertices(spans, out.mesh, offset_x, offset_y, offset_z);
+    return append_ringed_geometry_faces(vertex_handles, spans, out.mesh, &out.semantic_surfaces, mesh_context);
+}
+
 ogr::LinearRing make_offset_polygon(
     const ogr::LinearRing& polygon,
     double offset_x,
@@ -23,8 +23,28 @@ struct LoadedSolidMesh {
     std::vector<SemanticSurface> semantic_surfaces;
 };
 
+// Flat solid boundary in the FCB layout: ring counts per surface, vertex
+// counts per ring, then vertex indices. Field names match ZfcbGeometrySpans.
+struct RingedSolidSpans {
+    const double* vertices = nullptr; // xyz packed, world coordinates
+    size_t vertex_count = 0;
+    const uint32_t* surfaces = nullptr;
+    size_t surface_count = 0;
+    const uint32_t* strings = nullptr;
+    size_t string_count = 0;
+    const uint32_t* boundaries = nullptr;
+    size_t boundary_count = 0;
+    // Optional, length surface_count; 255 (unassigned) or NULL => WallSurface.
+    const uint8_t* surface_semantic_types = nullptr;
+};
+
+// Solid LoD carved unless --lods selects others.
+inline constexpr std::string_view kDefaultSolidLod = "2.2";
+
 bool is_fcb_path(std::string_view path);
 bool is_cityjsonseq_path(std::string_view path);
+// A whole CityJSON document, as 3DBAG distributes its tiles.
+bool is_cityjson_path(std::string_view path);
 
 ssize_t resolve_cityjson_object_index(CityJSONHandle cj, std::string_view feature_id);
 
@@ -41,7 +61,8 @@ bool load_cityjson_object_mesh(
     LoadedSolidMesh& out,
     double offset_x,
     double offset_y,
-    double offset_z);
+    double offset_z,
+    std::string_view lod = kDefaultSolidLod);
 
 bool load_cityjson_object_mesh(
     CityJSONHandle cj,
@@ -51,6 +72,12 @@ bool load_cityjson_object_mesh(
     double offset_y,
     double offset_z);
 
+// Advances the FCB reader like zfcb_next, but only decodes what
+// load_fcb_feature_mesh reads: the "<id>-0" geometry with LoD `lod` (every
+// LoD when empty) and the b3_val3dity_lod22 attribute. Returns 1/0/-1 like
+// zfcb_next.
+int fcb_next_for_mesh_loading(ZfcbReaderHandle fcb, std::string_view lod = kDefaultSolidLod);
+
 bool load_fcb_feature_mesh(
     ZfcbReaderHandle fcb,
     std::string_view feature_id,
@@ -58,7 +85,8 @@ bool load_fcb_feature_mesh(
     double offset_x,
     double offset_y,
     double offset_z,
-    std::string* out_b3_val3dity_lod22 = nullptr);
+    std::string* out_b3_val3dity_lod22 = nullptr,
+    std::string_view lod = kDefaultSolidLod);
 
 bool load_fcb_feature_mesh(
     ZfcbReaderHandle fcb,
@@ -69,6 +97,15 @@ bool load_fcb_feature_mesh(
     double offset_z,
     std::string* out_b3_val3dity_lod22 = nullptr);
 
+// Triangulates `spans` into `out` like the FCB and CityJSON loaders.
+bool load_ringed_solid_mesh(
+    const RingedSolidSpans& spans,
+    LoadedSolidMesh& out,
+    double offset_x,
+    double offset_y,
+    double offset_z,
+    std::string_view mesh_context);
+
 ogr::LinearRing make_offset_polygon(
     const ogr::LinearRing& polygon,
     double offset_x,
@@ -275,6 +275,8 @@ void VectorReader::read_polygon_feature(
   }
 
   PolygonFeature feature;
+  feature.prepared_polygon =
+      std::make_shared<const pip::PreparedPolygon>(polygon, polygon.interior_rings());
   feature.polygon = std::move(polygon);
   feature.id = id;
   feature.source_attributes = source_attributes;
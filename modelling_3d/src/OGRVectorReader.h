@@ -14,6 +14,8 @@
 #include <string>
 #include <vector>
 
+#include "PreparedPolygon.h"
+
 namespace ogr {
 
 // A linear ring representing a polygon exterior with optional interior rings
@@ -57,6 +59,9 @@ class VectorReader {
 
   struct PolygonFeature {
     LinearRing polygon;
+    // Grid-prepared `polygon` for point-in-polygon tests, built once on read
+    // and shared by every carve that matches the feature.
+    std::shared_ptr<const pip::PreparedPolygon> prepared_polygon;
     std::string id;
     std::vector<SourceAttribute> source_attributes;
     double absolute_elevation = 0.0;
@@ -6,14 +6,17 @@
 #include <cstddef>
 #include <cstdint>
 #include <limits>
-#include <queue>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <CGAL/Polygon_2.h>
 
+#include "BoundaryCycles.h"
+#include "CycleNesting.h"
+#include "GeometryKernels.h"
 #include "MeshProcessingConfig.h"
+#include "PreparedPolygon.h"
 
 namespace {
 
@@ -37,10 +40,10 @@ constexpr double kSemanticNzThreshold = 0.3;
 // Units are the same as the mesh coordinate system.
 constexpr double kGroundZTolerance = 0.5;
 constexpr double kUnderpassRoofZTolerance = 5e-2;
-struct Vec2 {
-    double x = 0.0;
-    double y = 0.0;
-};
+// Marks a missing face, group or surface index in the dense per-index arrays.
+constexpr uint32_t kNoIndex = std::numeric_limits<uint32_t>::max();
+// Projected 2D point; the same type as the nesting rings so they need no copy.
+using Vec2 = pip::Point2;
 
 struct FaceGeometry {
     std::vector<Surface_mesh::Vertex_index> vertices;
@@ -54,12 +57,41 @@ struct PreparedSourceSurface {
     K::Point_3 plane_point;
     K::Vector_3 unit_normal;
     int drop_axis = 2;
-    std::vector<std::vector<Vec2>> rings;
+    std::vector<pip::PreparedRing> rings;
+};
+
+struct PlaneCellKey {
+    int32_t nx = 0;
+    int32_t ny = 0;
+    int32_t nz = 0;
+
+    bool operator==(const PlaneCellKey& other) const = default;
+};
+
+struct PlaneCellKeyHash {
+    size_t operator()(const PlaneCellKey& key) const {
+        size_t h = static_cast<uint32_t>(key.nx);
+        h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.ny);
+        h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.nz);
+        return h;
+    }
 };
 
-struct BoundaryEdge {
-    uint32_t from = 0;
-    uint32_t to = 0;
+struct PlaneCellEntry {
+    double offset = 0.0;
+    uint32_t surface_index = 0;
+};
+
+// Source surfaces hashed by quantized normal, each bucket sorted by plane
+// offset. A lookup returns a superset of the surfaces that pass the
+// coplanarity tolerances in infer_face_semantic.
+struct SourceSurfaceIndex {
+    std::vector<PreparedSourceSurface> surfaces;
+    K::Point_3 center = K::Point_3(0.0, 0.0, 0.0);
+    double radius = 0.0;
+    double reach_radius = 0.0;
+    double offset_window = 0.0;
+    std::unordered_map<PlaneCellKey, std::vector<PlaneCellEntry>, PlaneCellKeyHash> cells;
 };
 
 struct TriangleGroupKey {
@@ -190,76 +222,12 @@ bool outer_ring_wants_positive_projected_area(const K::Vector_3& normal) {
     }
 }
 
-bool point_in_ring(const Vec2& p, const std::vector<Vec2>& ring) {
-    if (ring.size() < 3) {
-        return false;
-    }
-
-    bool inside = false;
-    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
-        const auto& a = ring[i];
-        const auto& b = ring[j];
-        const bool intersects = ((a.y > p.y) != (b.y > p.y)) &&
-            (p.x < (b.x - a.x) * (p.y - a.y) / ((b.y - a.y) == 0.0 ? 1e-18 : (b.y - a.y)) + a.x);
-        if (intersects) {
-            inside = !inside;
-        }
-    }
-    return inside;
-}
-
 bool point_in_surface(const Vec2& p, const PreparedSourceSurface& surface) {
-    if (surface.rings.empty() || !point_in_ring(p, surface.rings.front())) {
+    if (surface.rings.empty() || !surface.rings.front().contains(p.x, p.y)) {
         return false;
     }
     for (size_t i = 1; i < surface.rings.size(); ++i) {
-        if (point_in_ring(p, surface.rings[i])) {
-            return false;
-        }
-    }
-    return true;
-}
-
-bool point_on_segment(const Vec2& p, const Vec2& a, const Vec2& b) {
-    const double dx = b.x - a.x;
-    const double dy = b.y - a.y;
-    const double cross = (p.x - a.x) * dy - (p.y - a.y) * dx;
-    const double scale = std::max({1.0, std::abs(dx), std::abs(dy)});
-    if (std::abs(cross) > 1e-9 * scale) {
-        return false;
-    }
-    const double dot = (p.x - a.x) * dx + (p.y - a.y) * dy;
-    const double length_sq = dx * dx + dy * dy;
-    return dot >= -1e-9 && dot <= length_sq + 1e-9;
-}
-
-bool point_in_ogr_ring(const Vec2& p, const std::vector<std::array<double, 3>>& ring) {
-    if (ring.size() < 3) {
-        return false;
-    }
-    bool inside = false;
-    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
-        const Vec2 a{ring[j][0], ring[j][1]};
-        const Vec2 b{ring[i][0], ring[i][1]};
-        if (point_on_segment(p, a, b)) {
-            return true;
-        }
-        const bool intersects = ((a.y > p.y) != (b.y > p.y)) &&
-            (p.x < (b.x - a.x) * (p.y - a.y) /
-                    ((b.y - a.y) == 0.0 ? 1e-18 : (b.y - a.y)) + a.x);
-        if (intersects) {
-            inside = !inside;
-        }
-    }
-    return inside;
-}
-
-bool point_in_underpass_polygon(const Vec2& p, const ogr::LinearRing& polygon) {
-    if (!point_in_ogr_ring(p, polygon)) {
-        return false;
-    }
-    for (const auto& hole : polygon.interior_rings()) {
-        if (point_in_ogr_ring(p, hole)) {
+        if (surface.rings[i].contains(p.x, p.y)) {
             return false;
         }
     }
@@ -281,14 +249,14 @@ int32_t match_underpass_surface(
     double best_z_distance = std::numeric_limits<double>::infinity();
     for (size_t i = 0; i < underpasses.size(); ++i) {
         const auto& underpass = underpasses[i];
-        if (underpass.polygon == nullptr) {
+        if (underpass.prepared_polygon == nullptr) {
             continue;
         }
         const double z_distance = std::abs(geom.avg_z - underpass.roof_z_local);
         if (z_distance > kUnderpassRoofZTolerance || z_distance >= best_z_distance) {
             continue;
         }
-        if (!point_in_underpass_polygon(world_centroid, *underpass.polygon)) {
+        if (!underpass.prepared_polygon->contains_or_touches(world_centroid.x, world_centroid.y)) {
             continue;
         }
         best_match = static_cast<int32_t>(i);
@@ -345,8 +313,22 @@ FaceGeometry compute_face_geometry(const Surface_mesh& mesh, Surface_mesh::Face_
     return geom;
 }
 
-std::vector<PreparedSourceSurface> prepare_source_surfaces(const LoadedSolidMesh& source_mesh) {
-    std::vector<PreparedSourceSurface> prepared;
+// Normals within kNormalDotTolerance of each other differ by at most
+// sqrt(2 * kNormalDotTolerance) in every component, so a surface registered in
+// its own cell and all 26 neighbours is found from the query normal's cell.
+const double kNormalCellSize = 1.05 * std::sqrt(2.0 * kNormalDotTolerance);
+
+PlaneCellKey plane_cell_key(const K::Vector_3& unit_normal) {
+    return {
+        static_cast<int32_t>(std::floor(unit_normal.x() / kNormalCellSize)),
+        static_cast<int32_t>(std::floor(unit_normal.y() / kNormalCellSize)),
+        static_cast<int32_t>(std::floor(unit_normal.z() / kNormalCellSize)),
+    };
+}
+
+SourceSurfaceIndex prepare_source_surfaces(const LoadedSolidMesh& source_mesh) {
+    SourceSurfaceIndex index;
+    auto& prepared = index.surfaces;
     prepared.reserve(source_mesh.semantic_surfaces.size());
 
     for (const auto& surface : source_mesh.semantic_surfaces) {
@@ -375,13 +357,14 @@ std::vector<PreparedSourceSurface> prepare_source_surfaces(const LoadedSolidMesh
             if (ring_indices.size() < 3) {
                 continue;
             }
-            std::vector<Vec2> ring_2d;
+            std::vector<pip::Point2> ring_2d;
             ring_2d.reserve(ring_indices.size());
             for (size_t idx : ring_indices) {
-                ring_2d.push_back(project_point(source_mesh.mesh.point(Surface_mesh::Vertex_index(idx)),
-                                                prepared_surface.drop_axis));
+                const Vec2 p = project_point(source_mesh.mesh.point(Surface_mesh::Vertex_index(idx)),
+                                             prepared_surface.drop_axis);
+                ring_2d.push_back({p.x, p.y});
             }
-            prepared_surface.rings.push_back(std::move(ring_2d));
+            prepared_surface.rings.emplace_back(std::move(ring_2d));
         }
 
         if (!prepared_surface.rings.empty()) {
@@ -389,7 +372,53 @@ std::vector<PreparedSourceSurface> prepare_source_surfaces(const LoadedSolidMesh
         }
     }
 
-    return prepared;
+    if (prepared.empty()) {
+        return index;
+    }
+
+    // Offsets are measured from the source bounding-box center to keep the
+    // error from the normal tolerance proportional to the building size.
+    CGAL::Bbox_3 bbox = source_mesh.mesh.point(*source_mesh.mesh.vertices().begin()).bbox();
+    for (auto v : source_mesh.mesh.vertices()) {
+        bbox += source_mesh.mesh.point(v).bbox();
+    }
+    index.center = K::Point_3(
+        0.5 * (bbox.xmin() + bbox.xmax()), 0.5 * (bbox.ymin() + bbox.ymax()), 0.5 * (bbox.zmin() + bbox.zmax()));
+    index.radius = 0.5 * std::sqrt(CGAL::square(bbox.xmax() - bbox.xmin()) +
+                                   CGAL::square(bbox.ymax() - bbox.ymin()) +
+                                   CGAL::square(bbox.zmax() - bbox.zmin()));
+    // A face centroid that can match lies within reach_radius of the center
+    // (the projection along the drop axis stretches the plane tolerance by at
+    // most sqrt(3)). Its offset then differs from the source offset by at most
+    // |n_face - n_source| * reach_radius plus the plane tolerance.
+    index.reach_radius = index.radius + 2.0 * kPlaneDistanceTolerance;
+    index.offset_window = kPlaneDistanceTolerance +
+        std::sqrt(2.0 * kNormalDotTolerance) * index.reach_radius + 1e-9;
+
+    for (size_t i = 0; i < prepared.size(); ++i) {
+        const auto& surface = prepared[i];
+        const double offset = (surface.plane_point - index.center) * surface.unit_normal;
+        // Faces may be anti-parallel to their source surface, so register both
+        // orientations.
+        for (const double sign : {1.0, -1.0}) {
+            const PlaneCellKey key = plane_cell_key(sign * surface.unit_normal);
+            for (int32_t dx = -1; dx <= 1; ++dx) {
+                for (int32_t dy = -1; dy <= 1; ++dy) {
+                    for (int32_t dz = -1; dz <= 1; ++dz) {
+                        index.cells[{key.nx + dx, key.ny + dy, key.nz + dz}].push_back(
+                            {sign * offset, static_cast<uint32_t>(i)});
+                    }
+                }
+            }
+        }
+    }
+    for (auto& [key, entries] : index.cells) {
+        std::sort(entries.begin(), entries.end(), [](const PlaneCellEntry& a, const PlaneCellEntry& b) {
+            return a.offset < b.offset;
+        });
+    }
+
+    return index;
 }
 
 uint8_t classify_face_semantic(const FaceGeometry& geom, double house_min_z) {
@@ -408,9 +437,34 @@ uint8_t classify_face_semantic(const FaceGeometry& geom, double house_min_z) {
 
 uint8_t infer_face_semantic(
     const FaceGeometry& geom,
-    const std::vector<PreparedSourceSurface>& source_surfaces,
+    const SourceSurfaceIndex& source_index,
     double house_min_z) {
-    for (const auto& source : source_surfaces) {
+    const auto to_centroid = geom.centroid - source_index.center;
+    if (source_index.surfaces.empty() || geom.unit_normal == CGAL::NULL_VECTOR ||
+        to_centroid.squared_length() > CGAL::square(source_index.reach_radius)) {
+        return classify_face_semantic(geom, house_min_z);
+    }
+
+    const auto cell = source_index.cells.find(plane_cell_key(geom.unit_normal));
+    if (cell == source_index.cells.end()) {
+        return classify_face_semantic(geom, house_min_z);
+    }
+
+    // A linear scan returns the first matching surface in source order, so
+    // keep the lowest matching index; entries at or above it (including the
+    // duplicate registrations of one surface) need no test.
+    const double offset = to_centroid * geom.unit_normal;
+    const auto& entries = cell->second;
+    auto it = std::lower_bound(
+        entries.begin(), entries.end(), offset - source_index.offset_window,
+        [](const PlaneCellEntry& entry, double value) { return entry.offset < value; });
+    uint32_t best = kNoIndex;
+    for (; it != entries.end() && it->offset <= offset + source_index.offset_window; ++it) {
+        const uint32_t candidate = it->surface_index;
+        if (candidate >= best) {
+            continue;
+        }
+        const auto& source = source_index.surfaces[candidate];
         const double dot = geom.unit_normal * source.unit_normal;
         if (!std::isfinite(dot) || std::abs(std::abs(dot) - 1.0) > kNormalDotTolerance) {
             continue;
@@ -423,10 +477,13 @@ uint8_t infer_face_semantic(
         }
 
         if (point_in_surface(project_point(geom.centroid, source.drop_axis), source)) {
-            return source.semantic_type;
+            best = candidate;
         }
     }
 
+    if (best != kNoIndex) {
+        return source_index.surfaces[best].semantic_type;
+    }
     return classify_face_semantic(geom, house_min_z);
 }
 
@@ -448,96 +505,59 @@ bool face_is_coplanar_with_group(
     return true;
 }
 
+// Per-face attributes indexed by Surface_mesh face index (removed slots
+// included), together with the coplanar face groups in CSR form: the faces of
+// group g are group_faces[group_offsets[g], group_offsets[g + 1]) in BFS order.
+struct FaceGrouping {
+    std::vector<FaceGeometry> geometry;
+    std::vector<uint8_t> semantic;
+    std::vector<int32_t> underpass;
+    std::vector<uint32_t> group;
+    std::vector<uint32_t> group_offsets;
+    std::vector<Surface_mesh::Face_index> group_faces;
+
+    size_t group_count() const { return group_offsets.empty() ? 0 : group_offsets.size() - 1; }
+};
+
+// Buffers reused across the groups of one mesh by extract_group_cycles.
+struct CycleScratch {
+    std::vector<boundary_cycles::BoundaryEdge> boundary_edges;
+    boundary_cycles::WalkScratch walk;
+};
+
 std::vector<std::vector<uint32_t>> extract_group_cycles(
     const Surface_mesh& mesh,
-    const std::vector<Surface_mesh::Face_index>& group_faces,
-    const std::unordered_map<size_t, size_t>& face_group,
-    size_t group_id,
-    const std::unordered_map<size_t, uint32_t>& vertex_to_dense) {
-    std::vector<BoundaryEdge> boundary_edges;
-
-    for (auto face : group_faces) {
-        for (auto h : mesh.halfedges_around_face(mesh.halfedge(face))) {
-            const auto opposite = mesh.opposite(h);
-            const auto opposite_face = mesh.face(opposite);
+    const FaceGrouping& grouping,
+    uint32_t group_id,
+    const std::vector<uint32_t>& vertex_to_dense,
+    CycleScratch& scratch) {
+    auto& boundary_edges = scratch.boundary_edges;
+    boundary_edges.clear();
+
+    const auto group_begin = grouping.group_faces.begin() + grouping.group_offsets[group_id];
+    const auto group_end = grouping.group_faces.begin() + grouping.group_offsets[group_id + 1];
+    for (auto face_it = group_begin; face_it != group_end; ++face_it) {
+        for (auto h : mesh.halfedges_around_face(mesh.halfedge(*face_it))) {
+            const auto opposite_face = mesh.face(mesh.opposite(h));
             const bool boundary = opposite_face == Surface_mesh::null_face() ||
-                face_group.find(descriptor_id(opposite_face)) == face_group.end() ||
-                face_group.at(descriptor_id(opposite_face)) != group_id;
+                grouping.group[descriptor_id(opposite_face)] != group_id;
             if (!boundary) {
                 continue;
             }
 
-            const auto from_it = vertex_to_dense.find(descriptor_id(mesh.source(h)));
-            const auto to_it = vertex_to_dense.find(descriptor_id(mesh.target(h)));
-            if (from_it == vertex_to_dense.end() || to_it == vertex_to_dense.end()) {
+            const uint32_t from = vertex_to_dense[descriptor_id(mesh.source(h))];
+            const uint32_t to = vertex_to_dense[descriptor_id(mesh.target(h))];
+            if (from == kNoIndex || to == kNoIndex) {
                 continue;
             }
-            boundary_edges.push_back(BoundaryEdge{
-                .from = from_it->second,
-                .to = to_it->second,
+            boundary_edges.push_back(boundary_cycles::BoundaryEdge{
+                .from = from,
+                .to = to,
             });
         }
     }
 
-    std::unordered_map<uint32_t, std::vector<size_t>> outgoing;
-    for (size_t edge_idx = 0; edge_idx < boundary_edges.size(); ++edge_idx) {
-        outgoing[boundary_edges[edge_idx].from].push_back(edge_idx);
-    }
-
-    std::vector<bool> visited(boundary_edges.size(), false);
-    std::vector<std::vector<uint32_t>> cycles;
-
-    for (size_t edge_idx = 0; edge_idx < boundary_edges.size(); ++edge_idx) {
-        if (visited[edge_idx]) {
-            continue;
-        }
-
-        std::vector<uint32_t> ring;
-        const uint32_t start_vertex = boundary_edges[edge_idx].from;
-        uint32_t current_vertex = start_vertex;
-        size_t current_edge = edge_idx;
-
-        for (size_t step = 0; step <= boundary_edges.size(); ++step) {
-            if (visited[current_edge]) {
-                break;
-            }
-            visited[current_edge] = true;
-            if (ring.empty()) {
-                ring.push_back(boundary_edges[current_edge].from);
-            }
-            ring.push_back(boundary_edges[current_edge].to);
-            current_vertex = boundary_edges[current_edge].to;
-            if (current_vertex == start_vertex) {
-                ring.pop_back();
-                break;
-            }
-
-            auto next_it = outgoing.find(current_vertex);
-            if (next_it == outgoing.end()) {
-                ring.clear();
-                break;
-            }
-
-            bool found_next = false;
-            for (size_t candidate_edge : next_it->second) {
-                if (!visited[candidate_edge]) {
-                    current_edge = candidate_edge;
-                    found_next = true;
-                    break;
-                }
-            }
-            if (!found_next) {
-                ring.clear();
-                break;
-            }
-        }
-
-        if (ring.size() >= 3) {
-            cycles.push_back(std::move(ring));
-        }
-    }
-
-    return cycles;
+    return boundary_cycles::walk_boundary_cycles(boundary_edges, scratch.walk);
 }
 
 void orient_cycles(
@@ -579,15 +599,6 @@ void orient_cycles(
     }
 }
 
-struct ProjectedCycleInfo {
-    size_t cycle_index = 0;
-    std::vector<Vec2> ring_2d;
-    double signed_area = 0.0;
-    double abs_area = 0.0;
-    size_t nesting_depth = 0;
-    size_t parent_index = std::numeric_limits<size_t>::max();
-};
-
 void orient_cycle_for_area_sign(std::vector<uint32_t>& cycle, double signed_area, bool want_positive) {
     const bool is_positive = signed_area >= 0.0;
     if (is_positive != want_positive) {
@@ -605,40 +616,20 @@ std::vector<std::vector<std::vector<uint32_t>>> group_cycles_into_surfaces(
     }
 
     const int drop_axis = choose_drop_axis(normal);
-    std::vector<ProjectedCycleInfo> infos;
-    infos.reserve(cycles.size());
+    std::vector<cycle_nesting::NestingCycle> infos(cycles.size());
+    std::vector<double> signed_areas(cycles.size(), 0.0);
     for (size_t i = 0; i < cycles.size(); ++i) {
-        ProjectedCycleInfo info;
-        info.cycle_index = i;
-        info.ring_2d.reserve(cycles[i].size());
+        auto& info = infos[i];
+        info.ring.reserve(cycles[i].size());
         for (uint32_t idx : cycles[i]) {
-            info.ring_2d.push_back(project_point(dense_vertices[idx], drop_axis));
+            info.ring.push_back(project_point(dense_vertices[idx], drop_axis));
         }
-        info.signed_area = signed_area_2d(info.ring_2d);
-        info.abs_area = std::abs(info.signed_area);
-        infos.push_back(std::move(info));
+        signed_areas[i] = signed_area_2d(info.ring);
+        info.abs_area = std::abs(signed_areas[i]);
+        cycle_nesting::compute_bounds(info);
     }
 
-    for (size_t i = 0; i < infos.size(); ++i) {
-        const auto& test_point = infos[i].ring_2d.front();
-        double best_parent_area = std::numeric_limits<double>::max();
-        for (size_t j = 0; j < infos.size(); ++j) {
-            if (i == j) {
-                continue;
-            }
-            if (infos[j].abs_area <= infos[i].abs_area) {
-                continue;
-            }
-            if (!point_in_ring(test_point, infos[j].ring_2d)) {
-                continue;
-            }
-            infos[i].nesting_depth += 1;
-            if (infos[j].abs_area < best_parent_area) {
-                best_parent_area = infos[j].abs_area;
-                infos[i].parent_index = j;
-            }
-        }
-    }
+    cycle_nesting::resolve_cycle_nesting(infos);
 
     const bool outer_wants_positive_area = outer_ring_wants_positive_projected_area(normal);
     std::unordered_map<size_t, size_t> surface_index_by_outer;
@@ -648,12 +639,9 @@ std::vector<std::vector<std::vector<uint32_t>>> group_cycles_into_surfaces(
             continue;
         }
 
-        orient_cycle_for_area_sign(
-            cycles[infos[i].cycle_index],
-            infos[i].signed_area,
-            outer_wants_positive_area);
+        orient_cycle_for_area_sign(cycles[i], signed_areas[i], outer_wants_positive_area);
         surface_index_by_outer.emplace(i, surfaces.size());
-        surfaces.push_back({cycles[infos[i].cycle_index]});
+        surfaces.push_back({cycles[i]});
     }
 
     for (size_t i = 0; i < infos.size(); ++i) {
@@ -663,11 +651,11 @@ std::vector<std::vector<std::vector<uint32_t>>> group_cycles_into_surfaces(
         }
 
         size_t current_parent = infos[i].parent_index;
-        while (current_parent != std::numeric_limits<size_t>::max() &&
+        while (current_parent != cycle_nesting::kNoParent &&
                (infos[current_parent].nesting_depth % 2) == 1) {
             current_parent = infos[current_parent].parent_index;
         }
-        if (current_parent == std::numeric_limits<size_t>::max()) {
+        if (current_parent == cycle_nesting::kNoParent) {
             continue;
         }
 
@@ -676,11 +664,8 @@ std::vector<std::vector<std::vector<uint32_t>>> group_cycles_into_surfaces(
             continue;
         }
 
-        orient_cycle_for_area_sign(
-            cycles[infos[i].cycle_index],
-            infos[i].signed_area,
-            !outer_wants_positive_area);
-        surfaces[surface_it->second].push_back(cycles[infos[i].cycle_index]);
+        orient_cycle_for_area_sign(cycles[i], signed_areas[i], !outer_wants_positive_area);
+        surfaces[surface_it->second].push_back(cycles[i]);
     }
 
     return surfaces;
@@ -716,11 +701,7 @@ std::vector<uint32_t> meshgl_triangle_runs(const manifold::MeshGL& meshgl) {
 
 bool build_polygonal_output_from_grouped_mesh(
     const Surface_mesh& mesh,
-    const std::unordered_map<size_t, size_t>& face_group,
-    const std::vector<std::vector<Surface_mesh::Face_index>>& groups,
-    const std::unordered_map<size_t, int32_t>& face_underpass,
-    const LoadedSolidMesh& source_mesh,
-    double house_min_z,
+    const FaceGrouping& grouping,
     double offset_x,
     double offset_y,
     double offset_z,
@@ -730,13 +711,12 @@ bool build_polygonal_output_from_grouped_mesh(
         return false;
     }
 
-    std::unordered_map<size_t, uint32_t> vertex_to_dense;
-    vertex_to_dense.reserve(mesh.number_of_vertices());
+    std::vector<uint32_t> vertex_to_dense(mesh.num_vertices(), kNoIndex);
     std::vector<K::Point_3> dense_vertices;
     dense_vertices.reserve(mesh.number_of_vertices());
+    out.vertices_xyz_world.reserve(mesh.number_of_vertices() * 3);
     for (auto v : mesh.vertices()) {
-        const uint32_t dense_index = static_cast<uint32_t>(dense_vertices.size());
-        vertex_to_dense.emplace(descriptor_id(v), dense_index);
+        vertex_to_dense[descriptor_id(v)] = static_cast<uint32_t>(dense_vertices.size());
         const auto& p = mesh.point(v);
         dense_vertices.push_back(K::Point_3(p.x(), p.y(), p.z()));
         out.vertices_xyz_world.push_back(p.x() + offset_x);
@@ -744,30 +724,23 @@ bool build_polygonal_output_from_grouped_mesh(
         out.vertices_xyz_world.push_back(p.z() + offset_z);
     }
 
-    const auto prepared_sources = prepare_source_surfaces(source_mesh);
+    CycleScratch scratch;
+    scratch.walk.local_slot.assign(dense_vertices.size(), boundary_cycles::kNoSlot);
 
-    std::unordered_map<size_t, FaceGeometry> face_geometry;
-    std::unordered_map<size_t, uint8_t> face_semantic;
-    face_geometry.reserve(mesh.number_of_faces());
-    face_semantic.reserve(mesh.number_of_faces());
-    for (auto face : mesh.faces()) {
-        auto geom = compute_face_geometry(mesh, face);
-        const size_t face_id = descriptor_id(face);
-        face_semantic.emplace(face_id, infer_face_semantic(geom, prepared_sources, house_min_z));
-        face_geometry.emplace(face_id, std::move(geom));
-    }
-
-    for (size_t group_id = 0; group_id < groups.size(); ++group_id) {
-        if (groups[group_id].empty()) {
+    for (uint32_t group_id = 0; group_id < grouping.group_count(); ++group_id) {
+        const uint32_t group_begin = grouping.group_offsets[group_id];
+        const uint32_t group_end = grouping.group_offsets[group_id + 1];
+        if (group_begin == group_end) {
             continue;
         }
 
-        auto cycles = extract_group_cycles(mesh, groups[group_id], face_group, group_id, vertex_to_dense);
+        auto cycles = extract_group_cycles(mesh, grouping, group_id, vertex_to_dense, scratch);
         if (cycles.empty()) {
             continue;
         }
 
-        const auto& seed_geom = face_geometry.at(descriptor_id(groups[group_id].front()));
+        const size_t seed_id = descriptor_id(grouping.group_faces[group_begin]);
+        const auto& seed_geom = grouping.geometry[seed_id];
         auto grouped_surfaces = group_cycles_into_surfaces(dense_vertices, seed_geom.unit_normal, std::move(cycles));
         const int drop_axis = choose_drop_axis(seed_geom.unit_normal);
         bool valid_grouped_surfaces = !grouped_surfaces.empty();
@@ -783,19 +756,19 @@ bool build_polygonal_output_from_grouped_mesh(
             }
         }
         if (!valid_grouped_surfaces) {
-            for (auto face : groups[group_id]) {
-                const auto& geom = face_geometry.at(descriptor_id(face));
+            for (uint32_t i = group_begin; i < group_end; ++i) {
+                const size_t face_id = descriptor_id(grouping.group_faces[i]);
+                const auto& geom = grouping.geometry[face_id];
                 std::vector<uint32_t> cycle;
                 cycle.reserve(geom.vertices.size());
                 for (auto vertex : geom.vertices) {
-                    cycle.push_back(vertex_to_dense.at(descriptor_id(vertex)));
+                    cycle.push_back(vertex_to_dense[descriptor_id(vertex)]);
                 }
                 if (!cycle_is_simple(cycle, dense_vertices, choose_drop_axis(geom.unit_normal), false)) {
                     continue;
                 }
-                const size_t face_id = descriptor_id(face);
                 append_surface_header(
-                    out, 1, face_semantic.at(face_id), face_underpass.at(face_id));
+                    out, 1, grouping.semantic[face_id], grouping.underpass[face_id]);
                 append_surface_ring(out, cycle);
             }
             continue;
@@ -807,8 +780,8 @@ bool build_polygonal_output_from_grouped_mesh(
             append_surface_header(
                 out,
                 surface_rings.size(),
-                face_semantic.at(descriptor_id(groups[group_id].front())),
-                face_underpass.at(descriptor_id(groups[group_id].front())));
+                grouping.semantic[seed_id],
+                grouping.underpass[seed_id]);
             for (const auto& cycle : surface_rings) {
                 append_surface_ring(out, cycle);
             }
@@ -837,45 +810,45 @@ bool build_polygonal_output_from_cgal_mesh(
     }
 
     const auto prepared_sources = prepare_source_surfaces(source_mesh);
-    std::unordered_map<size_t, FaceGeometry> face_geometry;
-    std::unordered_map<size_t, uint8_t> face_semantic;
-    std::unordered_map<size_t, int32_t> face_underpass;
-    face_geometry.reserve(result_mesh.number_of_faces());
-    face_semantic.reserve(result_mesh.number_of_faces());
-    face_underpass.reserve(result_mesh.number_of_faces());
+    const size_t face_slots = result_mesh.num_faces();
+    FaceGrouping grouping;
+    grouping.geometry.resize(face_slots);
+    grouping.semantic.assign(face_slots, kWallSurface);
+    grouping.underpass.assign(face_slots, -1);
     for (auto face : result_mesh.faces()) {
-        auto geom = compute_face_geometry(result_mesh, face);
         const size_t face_id = descriptor_id(face);
+        auto& geom = grouping.geometry[face_id];
+        geom = compute_face_geometry(result_mesh, face);
         const uint8_t semantic_type = infer_face_semantic(geom, prepared_sources, house_min_z);
-        face_semantic.emplace(face_id, semantic_type);
-        face_underpass.emplace(
-            face_id, match_underpass_surface(geom, semantic_type, underpasses, offset_x, offset_y));
-        face_geometry.emplace(face_id, std::move(geom));
+        grouping.semantic[face_id] = semantic_type;
+        grouping.underpass[face_id] =
+            match_underpass_surface(geom, semantic_type, underpasses, offset_x, offset_y);
     }
 
-    std::unordered_map<size_t, size_t> face_group;
-    face_group.reserve(result_mesh.number_of_faces());
-    std::vector<std::vector<Surface_mesh::Face_index>> groups;
+    // Groups grow breadth-first from a seed and every candidate is tested
+    // against the seed plane, not its neighbour, so tolerances cannot chain
+    // along a curved roof. group_faces doubles as the BFS queue.
+    grouping.group.assign(face_slots, kNoIndex);
+    grouping.group_offsets.assign(1, 0);
+    grouping.group_faces.reserve(result_mesh.number_of_faces());
 
     for (auto seed_face : result_mesh.faces()) {
         const size_t seed_id = descriptor_id(seed_face);
-        if (face_group.find(seed_id) != face_group.end()) {
+        if (grouping.group[seed_id] != kNoIndex) {
             continue;
         }
 
-        const auto& seed_geom = face_geometry.at(seed_id);
-        const uint8_t seed_semantic = face_semantic.at(seed_id);
-        const size_t group_id = groups.size();
+        const auto& seed_geom = grouping.geometry[seed_id];
+        const uint8_t seed_semantic = grouping.semantic[seed_id];
+        const int32_t seed_underpass = grouping.underpass[seed_id];
+        const uint32_t group_id = static_cast<uint32_t>(grouping.group_count());
 
-        std::queue<Surface_mesh::Face_index> queue;
-        std::vector<Surface_mesh::Face_index> group_faces;
-        queue.push(seed_face);
-        face_group.emplace(seed_id, group_id);
+        size_t head = grouping.group_faces.size();
+        grouping.group_faces.push_back(seed_face);
+        grouping.group[seed_id] = group_id;
 
-        while (!queue.empty()) {
-            const auto face = queue.front();
-            queue.pop();
-            group_faces.push_back(face);
+        while (head < grouping.group_faces.size()) {
+            const auto face = grouping.group_faces[head++];
 
             for (auto h : result_mesh.halfedges_around_face(result_mesh.halfedge(face))) {
                 const auto neighbor = result_mesh.face(result_mesh.opposite(h));
@@ -883,38 +856,34 @@ bool build_polygonal_output_from_cgal_mesh(
                     continue;
                 }
                 const size_t neighbor_id = descriptor_id(neighbor);
-                if (face_group.find(neighbor_id) != face_group.end()) {
+                if (grouping.group[neighbor_id] != kNoIndex) {
                     continue;
                 }
-                if (face_semantic.at(neighbor_id) != seed_semantic) {
+                if (grouping.semantic[neighbor_id] != seed_semantic) {
                     continue;
                 }
-                if (face_underpass.at(neighbor_id) != face_underpass.at(seed_id)) {
+                if (grouping.underpass[neighbor_id] != seed_underpass) {
                     continue;
                 }
                 if (!face_is_coplanar_with_group(
                         result_mesh,
-                        face_geometry.at(neighbor_id),
+                        grouping.geometry[neighbor_id],
                         seed_geom.centroid,
                         seed_geom.unit_normal)) {
                     continue;
                 }
 
-                face_group.emplace(neighbor_id, group_id);
-                queue.push(neighbor);
+                grouping.group[neighbor_id] = group_id;
+                grouping.group_faces.push_back(neighbor);
             }
         }
 
-        groups.push_back(std::move(group_faces));
+        grouping.group_offsets.push_back(static_cast<uint32_t>(grouping.group_faces.size()));
     }
 
     return build_polygonal_output_from_grouped_mesh(
         result_mesh,
-        face_group,
-        groups,
-        face_underpass,
-        source_mesh,
-        house_min_z,
+        grouping,
         offset_x,
         offset_y,
         offset_z,
@@ -986,29 +955,38 @@ std::vector<int32_t> match_triangle_outer_ceiling_surfaces(
         return matches;
     }
 
+    // Only outer ceilings can match, so frames are computed for those alone.
+    std::vector<uint32_t> ceiling_triangles;
+    std::vector<uint32_t> ceiling_tri_verts;
     for (size_t triangle_index = 0; triangle_index < triangle_count; ++triangle_index) {
-        const uint32_t i0 = mesh.triVerts[triangle_index * 3 + 0];
-        const uint32_t i1 = mesh.triVerts[triangle_index * 3 + 1];
-        const uint32_t i2 = mesh.triVerts[triangle_index * 3 + 2];
-        if (i0 >= mesh.NumVert() || i1 >= mesh.NumVert() || i2 >= mesh.NumVert()) {
+        if (semantic_types[triangle_index] != kOuterCeilingSurface) {
+            continue;
+        }
+        const uint32_t* tri = &mesh.triVerts[triangle_index * 3];
+        if (tri[0] >= mesh.NumVert() || tri[1] >= mesh.NumVert() || tri[2] >= mesh.NumVert()) {
             continue;
         }
-        const auto point = [&](uint32_t index) {
-            return K::Point_3(
-                mesh.vertProperties[index * mesh.numProp + 0],
-                mesh.vertProperties[index * mesh.numProp + 1],
-                mesh.vertProperties[index * mesh.numProp + 2]);
-        };
-        const K::Point_3 p0 = point(i0);
-        const K::Point_3 p1 = point(i1);
-        const K::Point_3 p2 = point(i2);
+        ceiling_triangles.push_back(static_cast<uint32_t>(triangle_index));
+        ceiling_tri_verts.insert(ceiling_tri_verts.end(), tri, tri + 3);
+    }
+
+    kernels::TriangleFramesSoA frames;
+    // Same degenerate-normal cutoff as normalize_vector.
+    kernels::triangle_frames(
+        mesh.vertProperties.data(),
+        mesh.NumVert(),
+        mesh.numProp,
+        ceiling_tri_verts.data(),
+        ceiling_triangles.size(),
+        1e-18,
+        frames);
+
+    for (size_t i = 0; i < ceiling_triangles.size(); ++i) {
+        const uint32_t triangle_index = ceiling_triangles[i];
         FaceGeometry geom;
-        geom.centroid = K::Point_3(
-            (p0.x() + p1.x() + p2.x()) / 3.0,
-            (p0.y() + p1.y() + p2.y()) / 3.0,
-            (p0.z() + p1.z() + p2.z()) / 3.0);
+        geom.centroid = K::Point_3(frames.cx[i], frames.cy[i], frames.cz[i]);
         geom.avg_z = geom.centroid.z();
-        geom.unit_normal = normalize_vector(CGAL::cross_product(p1 - p0, p2 - p0));
+        geom.unit_normal = K::Vector_3(frames.nx[i], frames.ny[i], frames.nz[i]);
         matches[triangle_index] = match_underpass_surface(
             geom, semantic_types[triangle_index], underpasses, offset_x, offset_y);
     }
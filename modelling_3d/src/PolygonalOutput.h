@@ -3,16 +3,21 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <memory>
 #include <vector>
 
 #include <manifold/manifold.h>
 
 #include "BooleanOps.h"
 #include "ModelLoaders.h"
+#include "PreparedPolygon.h"
 
 struct UnderpassSurfaceSource {
     size_t polygon_feature_index = 0;
     const ogr::LinearRing* polygon = nullptr;
+    // World-coordinate grid of `polygon`, built once per OGR feature and
+    // shared by the face and triangle matchers.
+    std::shared_ptr<const pip::PreparedPolygon> prepared_polygon;
     double roof_z_local = 0.0;
 };
 
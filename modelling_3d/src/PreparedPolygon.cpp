@@ -0,0 +1,588 @@
+#include "PreparedPolygon.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace pip {
+
+namespace {
+
+constexpr uint16_t kBottomLeftIn = 0x0001;
+constexpr uint16_t kBottomRightIn = 0x0002;
+constexpr uint16_t kTopLeftIn = 0x0004;
+constexpr uint16_t kTopRightIn = 0x0008;
+constexpr uint16_t kLeftEdgeHit = 0x0010;
+constexpr uint16_t kRightEdgeHit = 0x0020;
+constexpr uint16_t kBottomEdgeHit = 0x0040;
+constexpr uint16_t kTopEdgeHit = 0x0080;
+constexpr uint16_t kBottomEdgeParity = 0x0100;
+constexpr uint16_t kTopEdgeParity = 0x0200;
+constexpr uint16_t kAimLeft = 0 << 10;
+constexpr uint16_t kAimBottom = 1 << 10;
+constexpr uint16_t kAimRight = 2 << 10;
+constexpr uint16_t kAimTop = 3 << 10;
+constexpr uint16_t kAimCorner = 4 << 10;
+constexpr uint16_t kAimMask = 0x1c00;
+constexpr uint16_t kAllEdgesHit = kLeftEdgeHit | kRightEdgeHit | kBottomEdgeHit | kTopEdgeHit;
+
+// Relative margin added around the ring bounds, as in GridSetup.
+constexpr double kBoundsEpsilon = 0.00001;
+// Grid origin nudges tried when an edge passes through a grid corner or a
+// vertex lies on a grid line.
+constexpr size_t kMaxRetryCount = 16;
+
+bool near(double a, double b, double eps) {
+    return (b - eps) < a && (a - eps) < b;
+}
+
+bool point_on_segment(double px, double py, double ax, double ay, double bx, double by) {
+    const double dx = bx - ax;
+    const double dy = by - ay;
+    const double cross = (px - ax) * dy - (py - ay) * dx;
+    const double scale = std::max({1.0, std::abs(dx), std::abs(dy)});
+    if (std::abs(cross) > 1e-9 * scale) {
+        return false;
+    }
+    const double dot = (px - ax) * dx + (py - ay) * dy;
+    const double length_sq = dx * dx + dy * dy;
+    return dot >= -1e-9 && dot <= length_sq + 1e-9;
+}
+
+size_t default_resolution(size_t vertex_count) {
+    return std::clamp<size_t>(static_cast<size_t>(std::sqrt(static_cast<double>(vertex_count))) * 2, 2, 64);
+}
+
+std::vector<Point2> to_points(const std::vector<std::array<double, 3>>& ring) {
+    std::vector<Point2> points;
+    points.reserve(ring.size());
+    for (const auto& p : ring) {
+        points.push_back({p[0], p[1]});
+    }
+    return points;
+}
+
+// Cell index of v along one axis. The multiply can round across a grid line,
+// so snap to the stored lines the edge fragments were clipped against.
+size_t grid_cell(double v, double min, double inv_delta, const std::vector<double>& lines) {
+    const size_t resolution = lines.size() - 1;
+    size_t cell = std::min(static_cast<size_t>((v - min) * inv_delta), resolution - 1);
+    if (cell + 1 < resolution && v >= lines[cell + 1]) {
+        ++cell;
+    } else if (cell > 0 && v < lines[cell]) {
+        --cell;
+    }
+    return cell;
+}
+
+} // namespace
+
+PreparedRing::PreparedRing(std::vector<Point2> points, size_t resolution)
+    : points_(std::move(points)) {
+    if (points_.size() < 3 || (resolution == 0 && points_.size() < kMinGridVertices)) {
+        return;
+    }
+    has_grid_ = build_grid(resolution == 0 ? default_resolution(points_.size()) : resolution);
+    if (!has_grid_) {
+        glx_.clear();
+        gly_.clear();
+        cells_.clear();
+        edges_.clear();
+    }
+}
+
+bool PreparedRing::build_grid(size_t resolution) {
+    double minx = points_.front().x;
+    double maxx = minx;
+    double miny = points_.front().y;
+    double maxy = miny;
+    for (const auto& p : points_) {
+        minx = std::min(minx, p.x);
+        maxx = std::max(maxx, p.x);
+        miny = std::min(miny, p.y);
+        maxy = std::max(maxy, p.y);
+    }
+
+    const double gxdiff = maxx - minx;
+    const double gydiff = maxy - miny;
+    if (!(gxdiff > 0.0) || !(gydiff > 0.0) || !std::isfinite(gxdiff) || !std::isfinite(gydiff)) {
+        return false;
+    }
+    minx -= kBoundsEpsilon * gxdiff;
+    maxx += kBoundsEpsilon * gxdiff;
+    miny -= kBoundsEpsilon * gydiff;
+    maxy += kBoundsEpsilon * gydiff;
+    const double eps = 1e-9 * (gxdiff + gydiff);
+
+    resolution_ = resolution;
+    glx_.resize(resolution + 1);
+    gly_.resize(resolution + 1);
+    std::vector<Fragment> fragments;
+    for (size_t attempt = 0; attempt < kMaxRetryCount; ++attempt) {
+        minx_ = minx;
+        maxx_ = maxx;
+        miny_ = miny;
+        maxy_ = maxy;
+        xdelta_ = (maxx_ - minx_) / static_cast<double>(resolution);
+        ydelta_ = (maxy_ - miny_) / static_cast<double>(resolution);
+        inv_xdelta_ = 1.0 / xdelta_;
+        inv_ydelta_ = 1.0 / ydelta_;
+        for (size_t i = 0; i < resolution; ++i) {
+            glx_[i] = minx_ + static_cast<double>(i) * xdelta_;
+            gly_[i] = miny_ + static_cast<double>(i) * ydelta_;
+        }
+        glx_[resolution] = maxx_;
+        gly_[resolution] = maxy_;
+
+        cells_.assign(resolution * resolution, Cell{});
+        fragments.clear();
+        if (!populate_grid(eps, fragments)) {
+            minx -= kBoundsEpsilon * gxdiff * 0.24;
+            miny -= kBoundsEpsilon * gydiff * 0.10;
+            continue;
+        }
+
+        // Bucket the fragments by cell, keeping their walk order within a cell.
+        for (const Fragment& fragment : fragments) {
+            ++cells_[fragment.cell].edge_end;
+        }
+        uint32_t offset = 0;
+        for (Cell& cell : cells_) {
+            cell.edge_begin = offset;
+            offset += cell.edge_end;
+            cell.edge_end = cell.edge_begin;
+        }
+        edges_.resize(fragments.size());
+        for (const Fragment& fragment : fragments) {
+            edges_[cells_[fragment.cell].edge_end++] = fragment.edge;
+        }
+        compute_corner_flags();
+        compute_aim_flags();
+
+        // point_on_segment accepts points up to 1e-9 * scale / length across
+        // an edge and 1e-9 / length past its ends.
+        for (size_t i = 0, j = points_.size() - 1; i < points_.size(); j = i++) {
+            const double dx = points_[i].x - points_[j].x;
+            const double dy = points_[i].y - points_[j].y;
+            const double length = std::hypot(dx, dy);
+            if (length > 0.0) {
+                const double scale = std::max({1.0, std::abs(dx), std::abs(dy)});
+                boundary_reach_ = std::max(boundary_reach_, 2e-9 * (scale + 1.0) / length);
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool PreparedRing::populate_grid(double eps, std::vector<Fragment>& fragments) {
+    const auto add_edge = [&](size_t cell, double xa, double ya, double xb, double yb, size_t source) {
+        Edge edge;
+        if (near(ya, yb, eps)) {
+            if (near(xa, xb, eps)) {
+                return false;
+            }
+            edge.slope = HUGE_VAL;
+            edge.inv_slope = 0.0;
+        } else if (near(xa, xb, eps)) {
+            edge.slope = 0.0;
+            edge.inv_slope = HUGE_VAL;
+        } else {
+            edge.slope = (xb - xa) / (yb - ya);
+            edge.inv_slope = (yb - ya) / (xb - xa);
+        }
+        edge.minx = std::min(xa, xb);
+        edge.maxx = std::max(xa, xb);
+        edge.miny = std::min(ya, yb);
+        edge.maxy = std::max(ya, yb);
+        edge.xa = xa;
+        edge.ya = ya;
+        edge.ax = xb - xa;
+        edge.ay = yb - ya;
+        edge.source = static_cast<uint32_t>(source);
+        fragments.push_back(Fragment{static_cast<uint32_t>(cell), edge});
+        return true;
+    };
+
+    // GridSetup only handles edges crossing grid corners; a vertex sitting on
+    // a grid line (common for axis-aligned rings whose bounds are split
+    // evenly) corrupts the cell parity just the same, so retry those too.
+    for (const Point2& p : points_) {
+        const double gx = (p.x - minx_) * inv_xdelta_;
+        const double gy = (p.y - miny_) * inv_ydelta_;
+        if (std::abs(gx - std::round(gx)) * xdelta_ < eps || std::abs(gy - std::round(gy)) * ydelta_ < eps) {
+            return false;
+        }
+    }
+
+    const auto res = static_cast<ptrdiff_t>(resolution_);
+    Point2 previous = points_.back();
+    for (size_t source = 0; source < points_.size(); ++source) {
+        const Point2& current = points_[source];
+        // Walk each edge upwards through the grid, splitting it at cell borders.
+        const Point2 vtxa = previous.y < current.y ? previous : current;
+        const Point2 vtxb = previous.y < current.y ? current : previous;
+        previous = current;
+
+        const double xdiff = vtxb.x - vtxa.x;
+        const double ydiff = vtxb.y - vtxa.y;
+        const double tmax = std::sqrt(xdiff * xdiff + ydiff * ydiff);
+        if (tmax == 0.0) {
+            continue;
+        }
+        const double xdir = xdiff / tmax;
+        const double ydir = ydiff / tmax;
+
+        auto gcx = static_cast<ptrdiff_t>((vtxa.x - minx_) * inv_xdelta_);
+        auto gcy = static_cast<ptrdiff_t>((vtxa.y - miny_) * inv_ydelta_);
+
+        double tx = HUGE_VAL;
+        double ty = HUGE_VAL;
+        double tgcx = 0.0;
+        double tgcy = 0.0;
+        ptrdiff_t sign_x = 0;
+        if (vtxa.x != vtxb.x) {
+            const double inv_x = tmax / xdiff;
+            tx = xdelta_ * static_cast<double>(gcx) + minx_ - vtxa.x;
+            if (vtxa.x < vtxb.x) {
+                sign_x = 1;
+                tx += xdelta_;
+                tgcx = xdelta_ * inv_x;
+            } else {
+                sign_x = -1;
+                tgcx = -xdelta_ * inv_x;
+            }
+            tx *= inv_x;
+        }
+        if (vtxa.y != vtxb.y) {
+            const double inv_y = tmax / ydiff;
+            ty = (ydelta_ * static_cast<double>(gcy + 1) + miny_ - vtxa.y) * inv_y;
+            tgcy = ydelta_ * inv_y;
+        }
+
+        const auto cell_index = [&](ptrdiff_t x, ptrdiff_t y) -> ptrdiff_t {
+            if (x < 0 || y < 0 || x >= res || y >= res) {
+                return -1;
+            }
+            return y * res + x;
+        };
+
+        ptrdiff_t cell = cell_index(gcx, gcy);
+        if (cell < 0) {
+            return false;
+        }
+        double vx0 = vtxa.x;
+        double vy0 = vtxa.y;
+        double t_near = 0.0;
+        while (true) {
+            double vx1 = 0.0;
+            double vy1 = 0.0;
+            bool y_flag = false;
+            if (tx <= ty) {
+                gcx += sign_x;
+                ty -= tx;
+                t_near += tx;
+                tx = tgcx;
+                if (t_near < tmax) {
+                    if (gcx < 0 || gcx >= res) {
+                        return false;
+                    }
+                    if (sign_x > 0) {
+                        cells_[cell].flags |= kRightEdgeHit;
+                        vx1 = glx_[gcx];
+                    } else {
+                        cells_[cell].flags |= kLeftEdgeHit;
+                        vx1 = glx_[gcx + 1];
+                    }
+                    vy1 = t_near * ydir + vtxa.y;
+                } else {
+                    vx1 = vtxb.x;
+                    vy1 = vtxb.y;
+                }
+            } else {
+                gcy += 1;
+                tx -= ty;
+                t_near += ty;
+                ty = tgcy;
+                if (t_near < tmax) {
+                    if (gcy >= res) {
+                        return false;
+                    }
+                    cells_[cell].flags |= kTopEdgeHit;
+                    cells_[cell].flags ^= kTopEdgeParity;
+                    vx1 = t_near * xdir + vtxa.x;
+                    vy1 = gly_[gcy];
+                } else {
+                    vx1 = vtxb.x;
+                    vy1 = vtxb.y;
+                }
+                y_flag = true;
+            }
+
+            if (!add_edge(static_cast<size_t>(cell), vx0, vy0, vx1, vy1, source)) {
+                return false;
+            }
+
+            if (!(t_near < tmax)) {
+                break;
+            }
+            cell = cell_index(gcx, gcy);
+            if (cell < 0) {
+                return false;
+            }
+            if (y_flag) {
+                cells_[cell].flags |= kBottomEdgeHit;
+                cells_[cell].flags ^= kBottomEdgeParity;
+            } else {
+                cells_[cell].flags |= sign_x > 0 ? kLeftEdgeHit : kRightEdgeHit;
+            }
+            vx0 = vx1;
+            vy0 = vy1;
+        }
+    }
+    return true;
+}
+
+void PreparedRing::compute_corner_flags() {
+    for (size_t row = 1; row < resolution_; ++row) {
+        bool io_state = false;
+        for (size_t column = 0; column < resolution_; ++column) {
+            Cell& top_cell = cells_[(row - 1) * resolution_ + column];
+            Cell& bottom_cell = cells_[row * resolution_ + column];
+            if (io_state) {
+                top_cell.flags |= kTopLeftIn;
+                bottom_cell.flags |= kBottomLeftIn;
+            }
+            if ((top_cell.flags & kTopEdgeParity) != 0) {
+                io_state = !io_state;
+            }
+            if (io_state) {
+                top_cell.flags |= kTopRightIn;
+                bottom_cell.flags |= kBottomRightIn;
+            }
+        }
+    }
+}
+
+void PreparedRing::compute_aim_flags() {
+    for (Cell& cell : cells_) {
+        const uint16_t clear_flags = cell.flags ^ kAllEdgesHit;
+        if ((clear_flags & kLeftEdgeHit) != 0) {
+            cell.flags |= kAimLeft;
+        } else if ((clear_flags & kBottomEdgeHit) != 0) {
+            cell.flags |= kAimBottom;
+        } else if ((clear_flags & kRightEdgeHit) != 0) {
+            cell.flags |= kAimRight;
+        } else if ((clear_flags & kTopEdgeHit) != 0) {
+            cell.flags |= kAimTop;
+        } else {
+            cell.flags |= kAimCorner;
+        }
+    }
+}
+
+bool PreparedRing::contains(double x, double y) const {
+    if (!has_grid_) {
+        return naive_contains(x, y);
+    }
+    if (!(y >= miny_ && y < maxy_ && x >= minx_ && x < maxx_)) {
+        return false;
+    }
+    // The grid and the plain scan can only disagree within rounding of an
+    // edge; on_boundary() covers that band, so keep the plain scan's answer.
+    if (on_boundary(x, y)) {
+        return naive_contains(x, y);
+    }
+    const size_t row = grid_cell(y, miny_, inv_ydelta_, gly_);
+    const size_t column = grid_cell(x, minx_, inv_xdelta_, glx_);
+    return contains_in_cell(x, y, column, row);
+}
+
+// Casts a ray from the point to an edge or corner of its cell whose inside
+// state is known and counts crossings with the cell's edge fragments.
+bool PreparedRing::contains_in_cell(double tx, double ty, size_t column, size_t row) const {
+    const Cell& cell = cells_[row * resolution_ + column];
+    if (cell.edge_begin == cell.edge_end) {
+        return (cell.flags & kBottomLeftIn) != 0;
+    }
+
+    bool inside = false;
+    switch (cell.flags & kAimMask) {
+        case kAimLeft:
+            inside = (cell.flags & kBottomLeftIn) != 0;
+            for (uint32_t i = cell.edge_begin; i < cell.edge_end; ++i) {
+                const Edge& e = edges_[i];
+                if (ty >= e.miny && ty < e.maxy &&
+                    (tx > e.maxx || (tx > e.minx && (e.xa - (e.ya - ty) * e.slope) < tx))) {
+                    inside = !inside;
+                }
+            }
+            return inside;
+        case kAimBottom:
+            inside = (cell.flags & kBottomLeftIn) != 0;
+            for (uint32_t i = cell.edge_begin; i < cell.edge_end; ++i) {
+                const Edge& e = edges_[i];
+                if (tx >= e.minx && tx < e.maxx &&
+                    (ty > e.maxy || (ty > e.miny && (e.ya - (e.xa - tx) * e.inv_slope) < ty))) {
+                    inside = !inside;
+                }
+            }
+            return inside;
+        case kAimRight:
+            inside = (cell.flags & kTopRightIn) != 0;
+            for (uint32_t i = cell.edge_begin; i < cell.edge_end; ++i) {
+                const Edge& e = edges_[i];
+                if (ty >= e.miny && ty < e.maxy &&
+                    (tx <= e.minx || (tx <= e.maxx && (e.xa - (e.ya - ty) * e.slope) >= tx))) {
+                    inside = !inside;
+                }
+            }
+            return inside;
+        case kAimTop:
+            inside = (cell.flags & kTopRightIn) != 0;
+            for (uint32_t i = cell.edge_begin; i < cell.edge_end; ++i) {
+                const Edge& e = edges_[i];
+                if (tx >= e.minx && tx < e.maxx &&
+                    (ty <= e.miny || (ty <= e.maxy && (e.ya - (e.xa - tx) * e.inv_slope) >= ty))) {
+                    inside = !inside;
+                }
+            }
+            return inside;
+        default: {
+            // All four cell borders are crossed: aim at the bottom-left corner.
+            inside = (cell.flags & kBottomLeftIn) != 0;
+            const double bx = tx - glx_[column];
+            const double by = ty - gly_[row];
+            for (uint32_t i = cell.edge_begin; i < cell.edge_end; ++i) {
+                const Edge& e = edges_[i];
+                if (tx < e.minx || ty < e.miny) {
+                    continue;
+                }
+                const double denom = e.ay * bx - e.ax * by;
+                if (denom == 0.0) {
+                    continue;
+                }
+                const double cx = e.xa - tx;
+                const double cy = e.ya - ty;
+                const double alpha = by * cx - bx * cy;
+                const double beta = e.ax * cy - e.ay * cx;
+                if (denom > 0.0) {
+                    if (alpha < 0.0 || alpha >= denom || beta < 0.0 || beta >= denom) {
+                        continue;
+                    }
+                } else if (alpha > 0.0 || alpha <= denom || beta > 0.0 || beta <= denom) {
+                    continue;
+                }
+                inside = !inside;
+            }
+            return inside;
+        }
+    }
+}
+
+bool PreparedRing::naive_contains(double x, double y) const {
+    if (points_.size() < 3) {
+        return false;
+    }
+    bool inside = false;
+    for (size_t i = 0, j = points_.size() - 1; i < points_.size(); j = i++) {
+        const auto& a = points_[i];
+        const auto& b = points_[j];
+        const bool intersects = ((a.y > y) != (b.y > y)) &&
+            (x < (b.x - a.x) * (y - a.y) / ((b.y - a.y) == 0.0 ? 1e-18 : (b.y - a.y)) + a.x);
+        if (intersects) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+bool PreparedRing::on_source_edge(double x, double y, size_t source) const {
+    const Point2& a = points_[source == 0 ? points_.size() - 1 : source - 1];
+    const Point2& b = points_[source];
+    if (a.x == b.x && a.y == b.y) {
+        return false;
+    }
+    return point_on_segment(x, y, a.x, a.y, b.x, b.y);
+}
+
+bool PreparedRing::on_boundary(double x, double y) const {
+    if (points_.size() < 3) {
+        return false;
+    }
+    if (!has_grid_) {
+        for (size_t i = 0; i < points_.size(); ++i) {
+            if (on_source_edge(x, y, i)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Test whole ring edges, not the clipped fragments, so the tolerance is
+    // the same as in the plain scan; every edge within reach of the point has
+    // a fragment in one of the cells the reach box overlaps.
+    const double reach = boundary_reach_;
+    if (!(y + reach >= miny_ && y - reach <= maxy_ && x + reach >= minx_ && x - reach <= maxx_)) {
+        return false;
+    }
+    const size_t row_begin = grid_cell(std::max(y - reach, miny_), miny_, inv_ydelta_, gly_);
+    const size_t row_end = grid_cell(std::min(y + reach, maxy_), miny_, inv_ydelta_, gly_);
+    const size_t column_begin = grid_cell(std::max(x - reach, minx_), minx_, inv_xdelta_, glx_);
+    const size_t column_end = grid_cell(std::min(x + reach, maxx_), minx_, inv_xdelta_, glx_);
+    for (size_t row = row_begin; row <= row_end; ++row) {
+        for (size_t column = column_begin; column <= column_end; ++column) {
+            const Cell& cell = cells_[row * resolution_ + column];
+            for (uint32_t i = cell.edge_begin; i < cell.edge_end; ++i) {
+                if (on_source_edge(x, y, edges_[i].source)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+PreparedPolygon::PreparedPolygon(
+    const std::vector<std::array<double, 3>>& outer,
+    const std::vector<std::vector<std::array<double, 3>>>& holes)
+    : outer_(to_points(outer)) {
+    holes_.reserve(holes.size());
+    for (const auto& hole : holes) {
+        holes_.emplace_back(to_points(hole));
+    }
+}
+
+PreparedPolygon::PreparedPolygon(std::vector<Point2> outer, std::vector<std::vector<Point2>> holes)
+    : outer_(std::move(outer)) {
+    holes_.reserve(holes.size());
+    for (auto& hole : holes) {
+        holes_.emplace_back(std::move(hole));
+    }
+}
+
+bool PreparedPolygon::contains(double x, double y) const {
+    if (!outer_.contains(x, y)) {
+        return false;
+    }
+    for (const auto& hole : holes_) {
+        if (hole.contains(x, y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PreparedPolygon::contains_or_touches(double x, double y) const {
+    if (!outer_.contains(x, y) && !outer_.on_boundary(x, y)) {
+        return false;
+    }
+    for (const auto& hole : holes_) {
+        if (hole.contains(x, y) || hole.on_boundary(x, y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace pip
@@ -0,0 +1,120 @@
+#ifndef PREPARED_POLYGON_H
+#define PREPARED_POLYGON_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Grid-prepared point-in-polygon tests, ported from Eric Haines' GridSetup /
+// GridTest (crop_las_by_polygons/c_ref/ptinpoly.cpp, also the basis of the
+// zigpip port). A ring is bucketed into a resolution x resolution grid once;
+// each query then only looks at the edge fragments of a single cell.
+
+namespace pip {
+
+struct Point2 {
+    double x = 0.0;
+    double y = 0.0;
+};
+
+class PreparedRing {
+public:
+    // Below this many vertices a plain scan is cheaper than building a grid.
+    static constexpr size_t kMinGridVertices = 16;
+
+    PreparedRing() = default;
+    // resolution 0 picks a grid size from the vertex count, or no grid for
+    // rings under kMinGridVertices. Rings whose grid cannot be built
+    // (zero-area bounds, unresolvable corner crossings) are scanned plainly.
+    explicit PreparedRing(std::vector<Point2> points, size_t resolution = 0);
+
+    // Same answer as a plain crossing-number scan of the ring, boundary points
+    // included: the grid decides points away from the edges, and points that
+    // on_boundary() accepts are handed to the plain scan.
+    bool contains(double x, double y) const;
+    // True when the point lies on an edge, with the relative tolerance of the
+    // old point_in_ogr_ring check. Zero-length edges are ignored.
+    bool on_boundary(double x, double y) const;
+    bool empty() const { return points_.size() < 3; }
+
+private:
+    struct Edge {
+        double minx = 0.0;
+        double maxx = 0.0;
+        double miny = 0.0;
+        double maxy = 0.0;
+        double xa = 0.0;
+        double ya = 0.0;
+        double slope = 0.0;
+        double inv_slope = 0.0;
+        double ax = 0.0;
+        double ay = 0.0;
+        // Ring edge this fragment was clipped from: points_[source - 1] to
+        // points_[source], wrapping at 0.
+        uint32_t source = 0;
+    };
+
+    struct Cell {
+        uint16_t flags = 0;
+        uint32_t edge_begin = 0;
+        uint32_t edge_end = 0;
+    };
+
+    struct Fragment {
+        uint32_t cell = 0;
+        Edge edge;
+    };
+
+    bool build_grid(size_t resolution);
+    bool populate_grid(double eps, std::vector<Fragment>& fragments);
+    void compute_corner_flags();
+    void compute_aim_flags();
+    bool contains_in_cell(double x, double y, size_t column, size_t row) const;
+    bool naive_contains(double x, double y) const;
+    bool on_source_edge(double x, double y, size_t source) const;
+
+    std::vector<Point2> points_;
+    bool has_grid_ = false;
+    size_t resolution_ = 0;
+    double minx_ = 0.0;
+    double maxx_ = 0.0;
+    double miny_ = 0.0;
+    double maxy_ = 0.0;
+    double xdelta_ = 0.0;
+    double ydelta_ = 0.0;
+    double inv_xdelta_ = 0.0;
+    double inv_ydelta_ = 0.0;
+    // Farthest an on_boundary() hit can lie from its edge, so a query only
+    // visits the cells within this distance.
+    double boundary_reach_ = 0.0;
+    std::vector<double> glx_;
+    std::vector<double> gly_;
+    std::vector<Cell> cells_;
+    std::vector<Edge> edges_;
+};
+
+// Outer ring with holes. Holes are assumed to lie inside the outer ring.
+class PreparedPolygon {
+public:
+    PreparedPolygon() = default;
+    PreparedPolygon(
+        const std::vector<std::array<double, 3>>& outer,
+        const std::vector<std::vector<std::array<double, 3>>>& holes);
+    PreparedPolygon(std::vector<Point2> outer, std::vector<std::vector<Point2>> holes);
+
+    // Strictly inside the outer ring and outside every hole.
+    bool contains(double x, double y) const;
+    // Like contains(), but points on the outer boundary count as inside and
+    // points on a hole boundary as outside.
+    bool contains_or_touches(double x, double y) const;
+    bool empty() const { return outer_.empty(); }
+
+private:
+    PreparedRing outer_;
+    std::vector<PreparedRing> holes_;
+};
+
+} // namespace pip
+
+#endif // PREPARED_POLYGON_H
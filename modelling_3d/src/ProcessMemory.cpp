@@ -0,0 +1,96 @@
+#include "ProcessMemory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Resetting the high-water mark also lowers ru_maxrss, so the peak seen
+// before each reset is kept here.
+std::atomic<size_t> g_peak_before_reset{0};
+
+size_t rusage_peak_bytes() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    // Linux reports kilobytes.
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+} // namespace
+
+size_t peak_rss_bytes() {
+    return std::max(rusage_peak_bytes(), g_peak_before_reset.load(std::memory_order_relaxed));
+}
+
+size_t current_rss_bytes() {
+#if defined(__linux__)
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    unsigned long long total_pages = 0;
+    unsigned long long resident_pages = 0;
+    const int fields = std::fscanf(file, "%llu %llu", &total_pages, &resident_pages);
+    std::fclose(file);
+    if (fields != 2) {
+        return 0;
+    }
+    return static_cast<size_t>(resident_pages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+bool reset_peak_rss_window() {
+#if defined(__linux__)
+    const size_t peak = peak_rss_bytes();
+    size_t kept = g_peak_before_reset.load(std::memory_order_relaxed);
+    while (kept < peak && !g_peak_before_reset.compare_exchange_weak(kept, peak, std::memory_order_relaxed)) {
+    }
+    // "5" resets only the high-water mark, not the referenced bits.
+    std::FILE* file = std::fopen("/proc/self/clear_refs", "w");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = std::fputs("5", file) >= 0;
+    return (std::fclose(file) == 0) && written;
+#else
+    return false;
+#endif
+}
+
+size_t peak_rss_window_bytes() {
+#if defined(__linux__)
+    std::FILE* file = std::fopen("/proc/self/status", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    char line[256];
+    unsigned long long kib = 0;
+    bool found = false;
+    while (!found && std::fgets(line, sizeof(line), file) != nullptr) {
+        found = std::strncmp(line, "VmHWM:", 6) == 0 && std::sscanf(line + 6, "%llu", &kib) == 1;
+    }
+    std::fclose(file);
+    return found ? static_cast<size_t>(kib) * 1024 : 0;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,21 @@
+#ifndef PROCESS_MEMORY_H
+#define PROCESS_MEMORY_H
+
+#include <cstddef>
+
+// Peak resident set size of this process in bytes, 0 when unavailable.
+// Includes peaks from before a reset_peak_rss_window().
+size_t peak_rss_bytes();
+// Current resident set size of this process in bytes, 0 when unavailable
+// (Linux only).
+size_t current_rss_bytes();
+
+// Restarts the kernel's resident-set high-water mark (VmHWM) at the current
+// resident set, so peak_rss_window_bytes() measures from here. Process-wide;
+// false where unsupported (Linux only).
+bool reset_peak_rss_window();
+// High-water mark since the last reset_peak_rss_window() (or process start)
+// in bytes, 0 when unavailable.
+size_t peak_rss_window_bytes();
+
+#endif // PROCESS_MEMORY_H
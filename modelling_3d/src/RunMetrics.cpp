@@ -0,0 +1,162 @@
+#include "RunMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+
+#include "JsonWriter.h"
+#include "ProcessMemory.h"
+
+namespace {
+
+void append_field(std::string& out, std::string_view indent, std::string_view key, size_t value, bool last = false) {
+    out += indent;
+    json::append_string(out, key);
+    out += ": ";
+    out += std::to_string(value);
+    out += last ? "\n" : ",\n";
+}
+
+void append_field(std::string& out, std::string_view indent, std::string_view key, double value, bool last = false) {
+    out += indent;
+    json::append_string(out, key);
+    out += ": ";
+    json::append_double(out, value);
+    out += last ? "\n" : ",\n";
+}
+
+void append_mesh_totals(std::string& out, std::string_view key, const MeshTotals& totals, bool with_surfaces) {
+    out += "  ";
+    json::append_string(out, key);
+    out += ": {\n";
+    append_field(out, "    ", "vertices", totals.vertices);
+    if (with_surfaces) {
+        append_field(out, "    ", "surfaces", totals.surfaces);
+    }
+    append_field(out, "    ", "triangles", totals.triangles, true);
+    out += "  },\n";
+}
+
+// Nearest-rank percentile of an ascending sample.
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+} // namespace
+
+const char* skip_reason_name(SkipReason reason) {
+    switch (reason) {
+        case SkipReason::EmptyId:
+            return "empty_id";
+        case SkipReason::ModelFeatureNotFound:
+            return "model_feature_not_found";
+        case SkipReason::InvalidModelVertices:
+            return "invalid_model_vertices";
+        case SkipReason::ModelMeshFailed:
+            return "model_mesh_failed";
+        case SkipReason::NoHouseMinZ:
+            return "no_house_min_z";
+        case SkipReason::ExtrusionFailed:
+            return "extrusion_failed";
+        case SkipReason::EmptyExtrusion:
+            return "empty_extrusion";
+        case SkipReason::BooleanFailed:
+            return "boolean_failed";
+        case SkipReason::BooleanBudgetExceeded:
+            return "boolean_budget_exceeded";
+        case SkipReason::BooleanWorkerCrashed:
+            return "boolean_worker_crashed";
+        case SkipReason::EmptyBooleanResult:
+            return "empty_boolean_result";
+    }
+    return "unknown";
+}
+
+void SkipCounts::add(const SkipCounts& other) {
+    for (size_t i = 0; i < kSkipReasonCount; ++i) {
+        by_reason[i] += other.by_reason[i];
+    }
+}
+
+size_t SkipCounts::total() const {
+    size_t sum = 0;
+    for (size_t count : by_reason) {
+        sum += count;
+    }
+    return sum;
+}
+
+void RunMetrics::add_feature_cost(std::string_view feature_id, double carve_ms) {
+    carve_ms_.push_back(carve_ms);
+    const auto later_is_slower = std::greater<>{};
+    if (slowest_.size() < kSlowestFeatureCount) {
+        slowest_.emplace_back(carve_ms, std::string(feature_id));
+        std::push_heap(slowest_.begin(), slowest_.end(), later_is_slower);
+    } else if (carve_ms > slowest_.front().first) {
+        std::pop_heap(slowest_.begin(), slowest_.end(), later_is_slower);
+        slowest_.back() = {carve_ms, std::string(feature_id)};
+        std::push_heap(slowest_.begin(), slowest_.end(), later_is_slower);
+    }
+}
+
+bool RunMetrics::write_json(
+    const std::string& path,
+    const std::vector<std::pair<std::string, double>>& timings_ms,
+    size_t processed_count,
+    size_t skipped_count) const {
+    std::string out = "{\n";
+    append_field(out, "  ", "processed", processed_count);
+    append_field(out, "  ", "skipped", skipped_count);
+
+    out += "  \"skipped_by_reason\": {\n";
+    for (size_t i = 0; i < kSkipReasonCount; ++i) {
+        append_field(out, "    ", skip_reason_name(static_cast<SkipReason>(i)), skipped.by_reason[i],
+                     i + 1 == kSkipReasonCount);
+    }
+    out += "  },\n";
+
+    out += "  \"timings_ms\": {\n";
+    for (size_t i = 0; i < timings_ms.size(); ++i) {
+        append_field(out, "    ", timings_ms[i].first, timings_ms[i].second, i + 1 == timings_ms.size());
+    }
+    out += "  },\n";
+
+    append_mesh_totals(out, "input_mesh", input, false);
+    append_mesh_totals(out, "output_mesh", output, true);
+    append_field(out, "  ", "peak_rss_bytes", peak_rss_bytes());
+    append_field(out, "  ", "boolean_worker_restarts", boolean_worker_restarts);
+
+    std::vector<double> sorted = carve_ms_;
+    std::sort(sorted.begin(), sorted.end());
+    out += "  \"feature_carve_ms\": {\n";
+    append_field(out, "    ", "count", sorted.size());
+    append_field(out, "    ", "p50", percentile(sorted, 50.0));
+    append_field(out, "    ", "p90", percentile(sorted, 90.0));
+    append_field(out, "    ", "p99", percentile(sorted, 99.0));
+    append_field(out, "    ", "max", sorted.empty() ? 0.0 : sorted.back(), true);
+    out += "  },\n";
+
+    std::vector<std::pair<double, std::string>> slowest = slowest_;
+    std::sort(slowest.begin(), slowest.end(), std::greater<>{});
+    out += "  \"slowest_features\": [";
+    for (size_t i = 0; i < slowest.size(); ++i) {
+        out += i == 0 ? "\n    {\"id\": " : ",\n    {\"id\": ";
+        json::append_string(out, slowest[i].second);
+        out += ", \"carve_ms\": ";
+        json::append_double(out, slowest[i].first);
+        out += '}';
+    }
+    out += slowest.empty() ? "]\n}\n" : "\n  ]\n}\n";
+
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    return (std::fclose(file) == 0) && written;
+}
@@ -0,0 +1,74 @@
+#ifndef RUN_METRICS_H
+#define RUN_METRICS_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Why an OGR underpass feature did not make it into the output.
+enum class SkipReason {
+    EmptyId,
+    ModelFeatureNotFound,
+    InvalidModelVertices,
+    ModelMeshFailed,
+    NoHouseMinZ,
+    ExtrusionFailed,
+    EmptyExtrusion,
+    BooleanFailed,
+    BooleanBudgetExceeded,
+    BooleanWorkerCrashed,
+    EmptyBooleanResult,
+};
+
+inline constexpr size_t kSkipReasonCount = static_cast<size_t>(SkipReason::EmptyBooleanResult) + 1;
+
+const char* skip_reason_name(SkipReason reason);
+
+struct SkipCounts {
+    std::array<size_t, kSkipReasonCount> by_reason{};
+
+    void add(SkipReason reason, size_t count = 1) { by_reason[static_cast<size_t>(reason)] += count; }
+    void add(const SkipCounts& other);
+    size_t total() const;
+};
+
+struct MeshTotals {
+    size_t vertices = 0;
+    size_t triangles = 0;
+    // Polygonal output only; triangle fallback output counts in `triangles`.
+    size_t surfaces = 0;
+};
+
+// Structured counterpart of the timing profile printed at the end of a run,
+// written with --metrics for schedulers and capacity planning.
+class RunMetrics {
+public:
+    // Only the ten slowest feature ids are kept; all durations feed the
+    // histogram.
+    void add_feature_cost(std::string_view feature_id, double carve_ms);
+
+    SkipCounts skipped;
+    MeshTotals input;
+    MeshTotals output;
+    // Boolean worker processes started after the first, with --isolate-booleans.
+    size_t boolean_worker_restarts = 0;
+
+    // `timings_ms` are the profile buckets in print order.
+    bool write_json(
+        const std::string& path,
+        const std::vector<std::pair<std::string, double>>& timings_ms,
+        size_t processed_count,
+        size_t skipped_count) const;
+
+private:
+    static constexpr size_t kSlowestFeatureCount = 10;
+
+    std::vector<double> carve_ms_;
+    // Min-heap on duration, so the fastest of the kept features is evicted.
+    std::vector<std::pair<double, std::string>> slowest_;
+};
+
+#endif // RUN_METRICS_H
@@ -0,0 +1,167 @@
+#include "Trace.h"
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "JsonWriter.h"
+
+namespace trace {
+
+namespace detail {
+std::atomic<bool> enabled{false};
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+    const char* name;
+    Clock::time_point start;
+    Clock::duration duration;
+    // Pre-serialized `"key":value` pairs.
+    std::string args;
+};
+
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    std::vector<Event> events;
+};
+
+// Buffers outlive their threads so finish() can still read them. The mutex
+// only guards registration, once per thread.
+std::mutex g_registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+std::string g_path;
+Clock::time_point g_origin;
+
+ThreadBuffer& local_buffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        std::lock_guard lock(g_registry_mutex);
+        g_buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = g_buffers.back().get();
+        buffer->tid = static_cast<uint32_t>(g_buffers.size());
+        buffer->events.reserve(4096);
+    }
+    return *buffer;
+}
+
+double microseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+} // namespace
+
+bool start(const std::string& path) {
+    std::FILE* probe = std::fopen(path.c_str(), "w");
+    if (probe == nullptr) {
+        return false;
+    }
+    std::fclose(probe);
+    g_path = path;
+    g_origin = Clock::now();
+    // The starting thread gets tid 1 and is listed first.
+    local_buffer();
+    detail::enabled.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool finish() {
+    if (!enabled()) {
+        return true;
+    }
+    detail::enabled.store(false, std::memory_order_relaxed);
+
+    std::FILE* file = std::fopen(g_path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::string out = R"({"displayTimeUnit":"ms","traceEvents":[)";
+    out += R"({"name":"process_name","ph":"M","pid":1,"tid":1,"args":{"name":"add_underpass"}})";
+    bool ok = true;
+    std::lock_guard lock(g_registry_mutex);
+    for (const auto& buffer : g_buffers) {
+        for (const Event& event : buffer->events) {
+            out += R"(,{"name":)";
+            json::append_string(out, event.name);
+            out += R"(,"ph":"X","pid":1,"tid":)";
+            out += std::to_string(buffer->tid);
+            out += R"(,"ts":)";
+            json::append_double(out, microseconds(event.start - g_origin));
+            out += R"(,"dur":)";
+            json::append_double(out, microseconds(event.duration));
+            if (!event.args.empty()) {
+                out += R"(,"args":{)";
+                out += event.args;
+                out += '}';
+            }
+            out += '}';
+            if (out.size() > (size_t{1} << 20)) {
+                ok = ok && std::fwrite(out.data(), 1, out.size(), file) == out.size();
+                out.clear();
+            }
+        }
+        buffer->events.clear();
+    }
+    out += "]}\n";
+    ok = ok && std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = (std::fclose(file) == 0) && ok;
+    return ok;
+}
+
+Span::Span(const char* name)
+    : name_(name), active_(enabled()) {
+    if (active_) {
+        start_ = Clock::now();
+    }
+}
+
+Span::~Span() {
+    end();
+}
+
+void Span::append_key(const char* key) {
+    if (!args_.empty()) {
+        args_ += ',';
+    }
+    json::append_string(args_, key);
+    args_ += ':';
+}
+
+Span& Span::arg(const char* key, std::string_view value) {
+    if (active_) {
+        append_key(key);
+        json::append_string(args_, value);
+    }
+    return *this;
+}
+
+Span& Span::arg(const char* key, double value) {
+    if (active_) {
+        append_key(key);
+        json::append_double(args_, value);
+    }
+    return *this;
+}
+
+Span& Span::arg(const char* key, bool value) {
+    if (active_) {
+        append_key(key);
+        args_ += value ? "true" : "false";
+    }
+    return *this;
+}
+
+void Span::end() {
+    if (!active_) {
+        return;
+    }
+    active_ = false;
+    const Clock::time_point now = Clock::now();
+    local_buffer().events.push_back(Event{name_, start_, now - start_, std::move(args_)});
+}
+
+} // namespace trace
@@ -0,0 +1,66 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Optional per-feature trace in Chrome trace JSON (viewable in Perfetto or
+// chrome://tracing). Recording is off until trace::start(). Every thread
+// appends completed spans to its own buffer without locking; trace::finish()
+// writes all buffers once the recording threads are done.
+namespace trace {
+
+namespace detail {
+extern std::atomic<bool> enabled;
+}
+
+inline bool enabled() {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+bool start(const std::string& path);
+// Writes the trace file and stops recording. Returns true when tracing was
+// off or the file was written.
+bool finish();
+
+// Complete ("X") event from construction to destruction or end(). `name`
+// and argument keys must be string literals. Does nothing while tracing is
+// off.
+class Span {
+public:
+    explicit Span(const char* name);
+    ~Span();
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    Span& arg(const char* key, std::string_view value);
+    Span& arg(const char* key, const char* value) { return arg(key, std::string_view(value)); }
+    Span& arg(const char* key, double value);
+    Span& arg(const char* key, bool value);
+    template <std::integral T>
+    Span& arg(const char* key, T value) {
+        if (active_) {
+            append_key(key);
+            args_ += std::to_string(value);
+        }
+        return *this;
+    }
+
+    void end();
+
+private:
+    void append_key(const char* key);
+
+    const char* name_;
+    std::chrono::steady_clock::time_point start_;
+    std::string args_;
+    bool active_;
+};
+
+} // namespace trace
+
+#endif // TRACE_H
@@ -0,0 +1,248 @@
+#include "VertexWelding.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+constexpr uint32_t kUnassigned = std::numeric_limits<uint32_t>::max();
+// Above 2^53 doubles no longer represent every integer; neither writer can
+// encode such coordinates anyway.
+constexpr double kMaxQuantized = 9007199254740992.0;
+
+using QuantizedKey = std::array<int64_t, 3>;
+
+// canonical[v] is the lowest vertex index that quantizes to the same integer
+// coordinate as v. Rounds exactly like the writers, so welded vertices are the
+// ones the writers would have encoded identically.
+bool quantized_canonical_vertices(
+    const std::vector<double>& vertices_xyz,
+    const OutputQuantization& quantization,
+    std::vector<uint32_t>& canonical) {
+    const size_t vertex_count = vertices_xyz.size() / 3;
+    if (vertex_count >= kUnassigned) {
+        return false;
+    }
+    for (size_t axis = 0; axis < 3; ++axis) {
+        if (!std::isfinite(quantization.scale[axis]) || quantization.scale[axis] == 0.0 ||
+            !std::isfinite(quantization.translate[axis])) {
+            return false;
+        }
+    }
+
+    std::vector<QuantizedKey> keys(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const double q = std::round(
+                (vertices_xyz[v * 3 + axis] - quantization.translate[axis]) / quantization.scale[axis]);
+            if (!std::isfinite(q) || std::abs(q) > kMaxQuantized) {
+                return false;
+            }
+            keys[v][axis] = static_cast<int64_t>(q);
+        }
+    }
+
+    std::vector<uint32_t> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return keys[a] != keys[b] ? keys[a] < keys[b] : a < b;
+    });
+
+    canonical.resize(vertex_count);
+    for (size_t i = 0; i < vertex_count;) {
+        const uint32_t representative = order[i];
+        for (; i < vertex_count && keys[order[i]] == keys[representative]; ++i) {
+            canonical[order[i]] = representative;
+        }
+    }
+    return true;
+}
+
+// Canonical ring with vertices equal to their predecessor removed, including
+// a closing vertex equal to the first.
+void collapse_ring(
+    const uint32_t* ring,
+    size_t size,
+    const std::vector<uint32_t>& canonical,
+    std::vector<uint32_t>& collapsed) {
+    collapsed.clear();
+    for (size_t i = 0; i < size; ++i) {
+        const uint32_t vertex = canonical[ring[i]];
+        if (collapsed.empty() || collapsed.back() != vertex) {
+            collapsed.push_back(vertex);
+        }
+    }
+    while (collapsed.size() > 1 && collapsed.back() == collapsed.front()) {
+        collapsed.pop_back();
+    }
+}
+
+// Output index of a canonical vertex, appending its coordinates on first use.
+uint32_t output_vertex(
+    uint32_t canonical_vertex,
+    const std::vector<double>& vertices_xyz,
+    std::vector<uint32_t>& output_index,
+    std::vector<double>& out_xyz) {
+    uint32_t& slot = output_index[canonical_vertex];
+    if (slot == kUnassigned) {
+        slot = static_cast<uint32_t>(out_xyz.size() / 3);
+        const auto first = vertices_xyz.begin() + static_cast<std::ptrdiff_t>(canonical_vertex) * 3;
+        out_xyz.insert(out_xyz.end(), first, first + 3);
+    }
+    return slot;
+}
+
+} // namespace
+
+bool weld_polygonal_output(
+    PolygonalOutput& out,
+    const OutputQuantization& quantization,
+    VertexWeldStats& stats) {
+    const size_t vertex_count = out.vertices_xyz_world.size() / 3;
+    const size_t surface_count = out.surface_ring_counts.size();
+    const bool has_underpass_indices = !out.surface_underpass_indices.empty();
+    if (surface_count == 0 || out.surface_semantic_types.size() != surface_count ||
+        (has_underpass_indices && out.surface_underpass_indices.size() != surface_count)) {
+        return false;
+    }
+    size_t expected_rings = 0;
+    for (uint32_t ring_count : out.surface_ring_counts) {
+        expected_rings += ring_count;
+    }
+    size_t expected_boundary = 0;
+    for (uint32_t ring_size : out.ring_vertex_counts) {
+        expected_boundary += ring_size;
+    }
+    if (expected_rings != out.ring_vertex_counts.size() || expected_boundary != out.boundary_indices.size()) {
+        return false;
+    }
+    for (uint32_t index : out.boundary_indices) {
+        if (index >= vertex_count) {
+            return false;
+        }
+    }
+
+    std::vector<uint32_t> canonical;
+    if (!quantized_canonical_vertices(out.vertices_xyz_world, quantization, canonical)) {
+        return false;
+    }
+
+    PolygonalOutput welded;
+    welded.surface_ring_counts.reserve(surface_count);
+    welded.ring_vertex_counts.reserve(out.ring_vertex_counts.size());
+    welded.boundary_indices.reserve(out.boundary_indices.size());
+    welded.surface_semantic_types.reserve(surface_count);
+    std::vector<uint32_t> output_index(vertex_count, kUnassigned);
+    std::vector<uint32_t> collapsed;
+    std::vector<uint32_t> surface_ring_sizes;
+    std::vector<uint32_t> surface_boundary;
+    size_t dropped_surfaces = 0;
+    size_t ring_cursor = 0;
+    size_t boundary_cursor = 0;
+    for (size_t surface = 0; surface < surface_count; ++surface) {
+        surface_ring_sizes.clear();
+        surface_boundary.clear();
+        bool keep_surface = true;
+        for (uint32_t ring = 0; ring < out.surface_ring_counts[surface]; ++ring) {
+            const uint32_t ring_size = out.ring_vertex_counts[ring_cursor++];
+            collapse_ring(&out.boundary_indices[boundary_cursor], ring_size, canonical, collapsed);
+            boundary_cursor += ring_size;
+            if (collapsed.size() < 3) {
+                keep_surface = keep_surface && ring != 0;
+                continue;
+            }
+            surface_ring_sizes.push_back(static_cast<uint32_t>(collapsed.size()));
+            surface_boundary.insert(surface_boundary.end(), collapsed.begin(), collapsed.end());
+        }
+        if (!keep_surface) {
+            ++dropped_surfaces;
+            continue;
+        }
+
+        welded.surface_ring_counts.push_back(static_cast<uint32_t>(surface_ring_sizes.size()));
+        welded.ring_vertex_counts.insert(
+            welded.ring_vertex_counts.end(), surface_ring_sizes.begin(), surface_ring_sizes.end());
+        for (uint32_t vertex : surface_boundary) {
+            welded.boundary_indices.push_back(
+                output_vertex(vertex, out.vertices_xyz_world, output_index, welded.vertices_xyz_world));
+        }
+        welded.surface_semantic_types.push_back(out.surface_semantic_types[surface]);
+        if (has_underpass_indices) {
+            welded.surface_underpass_indices.push_back(out.surface_underpass_indices[surface]);
+        }
+    }
+    if (welded.surface_ring_counts.empty()) {
+        return false;
+    }
+
+    stats.vertices_before = vertex_count;
+    stats.vertices_after = welded.vertices_xyz_world.size() / 3;
+    stats.dropped_surfaces = dropped_surfaces;
+    out = std::move(welded);
+    return true;
+}
+
+bool weld_triangle_output(
+    std::vector<double>& vertices_xyz_world,
+    std::vector<uint32_t>& triangle_indices,
+    std::vector<uint8_t>& semantic_types,
+    std::vector<int32_t>* triangle_underpass_indices,
+    const OutputQuantization& quantization,
+    VertexWeldStats& stats) {
+    const size_t vertex_count = vertices_xyz_world.size() / 3;
+    const size_t triangle_count = triangle_indices.size() / 3;
+    if (triangle_count == 0 || triangle_indices.size() % 3 != 0 || semantic_types.size() != triangle_count ||
+        (triangle_underpass_indices != nullptr && triangle_underpass_indices->size() != triangle_count)) {
+        return false;
+    }
+    for (uint32_t index : triangle_indices) {
+        if (index >= vertex_count) {
+            return false;
+        }
+    }
+
+    std::vector<uint32_t> canonical;
+    if (!quantized_canonical_vertices(vertices_xyz_world, quantization, canonical)) {
+        return false;
+    }
+
+    std::vector<double> welded_xyz;
+    std::vector<uint32_t> output_index(vertex_count, kUnassigned);
+    size_t kept = 0;
+    for (size_t t = 0; t < triangle_count; ++t) {
+        const uint32_t a = canonical[triangle_indices[t * 3 + 0]];
+        const uint32_t b = canonical[triangle_indices[t * 3 + 1]];
+        const uint32_t c = canonical[triangle_indices[t * 3 + 2]];
+        if (a == b || b == c || c == a) {
+            continue;
+        }
+        // Compacted in place: slot `kept` has already been read.
+        triangle_indices[kept * 3 + 0] = output_vertex(a, vertices_xyz_world, output_index, welded_xyz);
+        triangle_indices[kept * 3 + 1] = output_vertex(b, vertices_xyz_world, output_index, welded_xyz);
+        triangle_indices[kept * 3 + 2] = output_vertex(c, vertices_xyz_world, output_index, welded_xyz);
+        semantic_types[kept] = semantic_types[t];
+        if (triangle_underpass_indices != nullptr) {
+            (*triangle_underpass_indices)[kept] = (*triangle_underpass_indices)[t];
+        }
+        ++kept;
+    }
+    if (kept == 0) {
+        // Nothing was written back, so the inputs are still intact.
+        return false;
+    }
+
+    triangle_indices.resize(kept * 3);
+    semantic_types.resize(kept);
+    if (triangle_underpass_indices != nullptr) {
+        triangle_underpass_indices->resize(kept);
+    }
+    stats.vertices_before = vertex_count;
+    stats.vertices_after = welded_xyz.size() / 3;
+    stats.dropped_surfaces = triangle_count - kept;
+    vertices_xyz_world = std::move(welded_xyz);
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef VERTEX_WELDING_H
+#define VERTEX_WELDING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "PolygonalOutput.h"
+
+// Quantization the output writer applies to world coordinates:
+// q = round((world - translate) / scale) per axis.
+struct OutputQuantization {
+    std::array<double, 3> scale{1.0, 1.0, 1.0};
+    std::array<double, 3> translate{0.0, 0.0, 0.0};
+};
+
+struct VertexWeldStats {
+    size_t vertices_before = 0;
+    size_t vertices_after = 0;
+    // Surfaces (polygonal) or triangles (triangle output) that collapsed.
+    size_t dropped_surfaces = 0;
+};
+
+// Merges vertices that quantize to the same integer coordinate, removes ring
+// vertices that then coincide with their predecessor, and drops rings left
+// with fewer than three vertices (the whole surface when it is the outer
+// ring). Unreferenced vertices are dropped as well. Returns false and leaves
+// `out` untouched when a coordinate cannot be quantized, an index is out of
+// range, or nothing would be left to write.
+bool weld_polygonal_output(
+    PolygonalOutput& out,
+    const OutputQuantization& quantization,
+    VertexWeldStats& stats);
+
+// Triangle-soup variant: degenerate triangles are dropped together with their
+// entry in semantic_types and, when given, triangle_underpass_indices.
+bool weld_triangle_output(
+    std::vector<double>& vertices_xyz_world,
+    std::vector<uint32_t>& triangle_indices,
+    std::vector<uint8_t>& semantic_types,
+    std::vector<int32_t>* triangle_underpass_indices,
+    const OutputQuantization& quantization,
+    VertexWeldStats& stats);
+
+#endif // VERTEX_WELDING_H
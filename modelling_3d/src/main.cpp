@@ -1,12 +1,19 @@
 #include <iostream>
 #include <format>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <charconv>
 #include <chrono>
 #include <cstdint>
 #include <exception>
+#include <filesystem>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -19,9 +26,16 @@
 
 #include <CGAL/Polygon_mesh_processing/triangulate_faces.h>
 
+#include "BackendCostModel.h"
 #include "BooleanOps.h"
 #include "BooleanOpsManifold.h"
-#include "BooleanObjWriter.h"
+#include "BooleanMeshWriter.h"
+#include "BooleanWorker.h"
+#include "CarveServer.h"
+#include "Checkpoint.h"
+#include "FeatureSharding.h"
+#include "GeometryKernels.h"
+#include "MemoryBudget.h"
 #include "MeshConversion.h"
 #include "ModelLoaders.h"
 #include "PolygonalOutput.h"
@@ -30,6 +44,9 @@
 #include "OGRVectorReader.h"
 #include "PolygonExtruder.h"
 #include "RerunVisualization.h"
+#include "RunMetrics.h"
+#include "Trace.h"
+#include "VertexWelding.h"
 
 using Clock = std::chrono::steady_clock;
 
@@ -98,8 +115,14 @@ static std::vector<uint32_t> semantic_surface_attribute_group_indices(
     return result;
 }
 
+// "-" is FCB on stdin/stdout; "-.jsonl", "-.jsonl.zst", "-.jsonl.gz" select
+// CityJSONSeq (and the output compression) for piping.
+static bool is_stdio_path(std::string_view path) {
+    return path == "-" || path.starts_with("-.");
+}
+
 static std::string source_filename_from_path(std::string_view path) {
-    if (path == "-") {
+    if (is_stdio_path(path)) {
         return "stdin";
     }
     const size_t end = path.find_last_not_of("/\\");
@@ -154,14 +177,19 @@ static SourceAttributeBuffers source_attribute_buffers(
     const std::vector<size_t>& matched_indices,
     bool include_source_attributes,
     std::string_view feature_source_filename,
-    bool add_underpass_success) {
+    bool add_underpass_success,
+    std::string_view add_underpass_method = {}) {
     SourceAttributeBuffers out;
     std::unordered_set<std::string> emitted;
 
     static constexpr std::string_view kFeatureSourceAttributeName = "featuresource";
     static constexpr std::string_view kAddUnderpassSuccessAttributeName = "add_underpass_success";
+    static constexpr std::string_view kAddUnderpassMethodAttributeName = "add_underpass_method";
     append_string_source_attribute(out, emitted, kFeatureSourceAttributeName, feature_source_filename);
     append_integer_source_attribute(out, emitted, kAddUnderpassSuccessAttributeName, add_underpass_success ? 1 : 0);
+    if (!add_underpass_method.empty()) {
+        append_string_source_attribute(out, emitted, kAddUnderpassMethodAttributeName, add_underpass_method);
+    }
 
     if (!include_source_attributes) {
         return out;
@@ -223,70 +251,63 @@ static std::vector<uint8_t> classify_triangle_semantics(
     double nz_threshold = 0.3,
     double z_tolerance = 0.5)
 {
-    size_t num_prop = mesh.numProp;
-    size_t tri_count = mesh.triVerts.size() / 3;
-    std::vector<uint8_t> result(tri_count);
-
-    for (size_t t = 0; t < tri_count; ++t) {
-        uint32_t i0 = mesh.triVerts[t * 3 + 0];
-        uint32_t i1 = mesh.triVerts[t * 3 + 1];
-        uint32_t i2 = mesh.triVerts[t * 3 + 2];
-
-        float x0 = mesh.vertProperties[i0 * num_prop + 0];
-        float y0 = mesh.vertProperties[i0 * num_prop + 1];
-        float z0 = mesh.vertProperties[i0 * num_prop + 2];
-        float x1 = mesh.vertProperties[i1 * num_prop + 0];
-        float y1 = mesh.vertProperties[i1 * num_prop + 1];
-        float z1 = mesh.vertProperties[i1 * num_prop + 2];
-        float x2 = mesh.vertProperties[i2 * num_prop + 0];
-        float y2 = mesh.vertProperties[i2 * num_prop + 1];
-        float z2 = mesh.vertProperties[i2 * num_prop + 2];
-
-        // Cross product of edges e1 = v1-v0, e2 = v2-v0.
-        float ex1 = x1 - x0, ey1 = y1 - y0, ez1 = z1 - z0;
-        float ex2 = x2 - x0, ey2 = y2 - y0, ez2 = z2 - z0;
-        float nx = ey1 * ez2 - ez1 * ey2;
-        float ny = ez1 * ex2 - ex1 * ez2;
-        float nz = ex1 * ey2 - ey1 * ex2;
-
-        float len = std::sqrt(nx * nx + ny * ny + nz * nz);
-        if (len > 0.0f) nz /= len;
-
-        if (std::abs(nz) < nz_threshold) {
-            result[t] = SemanticSurfaceType::WallSurface;
-        } else if (nz > 0.0f) {
-            result[t] = SemanticSurfaceType::RoofSurface;
-        } else {
-            // Downward-facing: distinguish ground from outer ceiling by first vertex Z.
-            if (std::abs(static_cast<double>(z0) - ground_z) < z_tolerance) {
-                result[t] = SemanticSurfaceType::GroundSurface;
-            } else {
-                result[t] = SemanticSurfaceType::OuterCeilingSurface;
-            }
-        }
-    }
+    kernels::TriangleClassifier classifier;
+    classifier.ground_z = ground_z;
+    classifier.nz_threshold = nz_threshold;
+    classifier.z_tolerance = z_tolerance;
+    classifier.wall = SemanticSurfaceType::WallSurface;
+    classifier.roof = SemanticSurfaceType::RoofSurface;
+    classifier.ground = SemanticSurfaceType::GroundSurface;
+    classifier.outer_ceiling = SemanticSurfaceType::OuterCeilingSurface;
+
+    std::vector<uint8_t> result(mesh.triVerts.size() / 3);
+    kernels::classify_triangles(
+        mesh.vertProperties.data(),
+        mesh.NumVert(),
+        mesh.numProp,
+        mesh.triVerts.data(),
+        result.size(),
+        classifier,
+        result.data());
     return result;
 }
 
-struct FeatureCarveResult {
-    bool any_succeeded = false;
+struct SolidCarveResult {
+    // Backend that produced the result.
+    BooleanMethod method = BooleanMethod::Manifold;
     manifold::MeshGL result_meshgl;
     Surface_mesh result_surface_mesh;
     bool has_polygonal_result = false;
+};
+
+struct FeatureCarveResult {
+    // Every house solid was carved.
+    bool succeeded = false;
+    // One per house solid, in the order of the houses.
+    std::vector<SolidCarveResult> solids;
     double house_min_z = std::numeric_limits<double>::quiet_NaN();
     double underpass_z = 0.0;
     std::vector<UnderpassSurfaceSource> underpasses;
     size_t processed_count = 0;
-    size_t skipped_count = 0;
+    SkipCounts skipped;
 };
 
+// The underpasses are extruded once and carved from each house solid (one
+// per LoD in `lods`); the feature counts as processed only when every solid
+// was carved.
 static FeatureCarveResult carve_underpasses_for_feature(
-    const LoadedSolidMesh& house_data,
+    const std::vector<LoadedSolidMesh>& houses,
+    const std::vector<std::string>& lods,
     std::string_view model_feature_id,
     const std::vector<ogr::VectorReader::PolygonFeature>& polygon_features,
     const std::vector<size_t>& matched_indices,
     std::vector<bool>& seen_feature,
-    BooleanMethod method,
+    const std::vector<BooleanMethod>& methods,
+    std::chrono::milliseconds budget,
+    BooleanWorker* worker,
+    BackendCostModel* cost_model,
+    MemoryBudget* memory_budget,
+    std::string_view b3_val3dity_lod22,
     bool ignore_holes,
     double global_offset_x,
     double global_offset_y,
@@ -295,14 +316,20 @@ static FeatureCarveResult carve_underpasses_for_feature(
     std::chrono::duration<double, std::milli>& ds_conversion_ms,
     std::chrono::duration<double, std::milli>& intersection_ms) {
     FeatureCarveResult result;
-    result.house_min_z = mesh_min_z(house_data.mesh);
+    // The extrusions start below the lowest solid, so they cut through all
+    // of them; a solid without a finite min z skips the feature below.
+    result.house_min_z = std::numeric_limits<double>::infinity();
+    for (const auto& house_data : houses) {
+        const double min_z = mesh_min_z(house_data.mesh);
+        result.house_min_z = std::isfinite(min_z) ? std::min(result.house_min_z, min_z) : min_z;
+    }
     if (!std::isfinite(result.house_min_z)) {
         for (size_t feature_idx : matched_indices) {
             seen_feature[feature_idx] = true;
             const auto& feature = polygon_features[feature_idx];
             std::cerr << std::format("Skipping feature {} (id='{}'): could not determine house min z{}",
                                      feature_idx, feature.id, val3dity_suffix) << std::endl;
-            ++result.skipped_count;
+            result.skipped.add(SkipReason::NoHouseMinZ);
         }
         return result;
     }
@@ -314,6 +341,8 @@ static FeatureCarveResult carve_underpasses_for_feature(
         seen_feature[feature_idx] = true;
         const auto& feature = polygon_features[feature_idx];
 
+        trace::Span extrude_span("extrude");
+        extrude_span.arg("underpass", std::string_view(feature.id));
         auto t_conversion_start = Clock::now();
         // Boolean operations use coordinates relative to the shared model offset.
         // Convert the absolute OGR elevation to that same local coordinate frame.
@@ -334,23 +363,25 @@ static FeatureCarveResult carve_underpasses_for_feature(
             ds_conversion_ms += t_conversion_end - t_conversion_start;
             std::cerr << std::format("Skipping feature {} (id='{}'): underpass extrusion failed ({}){}",
                                      feature_idx, feature.id, e.what(), val3dity_suffix) << std::endl;
-            ++result.skipped_count;
+            result.skipped.add(SkipReason::ExtrusionFailed);
             continue;
         } catch (...) {
             auto t_conversion_end = Clock::now();
             ds_conversion_ms += t_conversion_end - t_conversion_start;
             std::cerr << std::format("Skipping feature {} (id='{}'): underpass extrusion failed (unknown exception){}",
                                      feature_idx, feature.id, val3dity_suffix) << std::endl;
-            ++result.skipped_count;
+            result.skipped.add(SkipReason::ExtrusionFailed);
             continue;
         }
         auto t_conversion_end = Clock::now();
         ds_conversion_ms += t_conversion_end - t_conversion_start;
+        extrude_span.arg("faces", underpass_sm.number_of_faces());
+        extrude_span.end();
 
         if (underpass_sm.number_of_faces() == 0) {
             std::cerr << std::format("Skipping feature {} (id='{}'): underpass extrusion produced empty mesh{}",
                                      feature_idx, feature.id, val3dity_suffix) << std::endl;
-            ++result.skipped_count;
+            result.skipped.add(SkipReason::EmptyExtrusion);
             continue;
         }
 
@@ -359,6 +390,7 @@ static FeatureCarveResult carve_underpasses_for_feature(
         result.underpasses.push_back(UnderpassSurfaceSource{
             .polygon_feature_index = feature_idx,
             .polygon = &feature.polygon,
+            .prepared_polygon = feature.prepared_polygon,
             .roof_z_local = roof_height,
         });
         ++merged_feature_count;
@@ -368,65 +400,143 @@ static FeatureCarveResult carve_underpasses_for_feature(
         return result;
     }
 
-    BooleanOpTiming timing;
-    bool success = true;
-    Surface_mesh house_sm = house_data.mesh;
-    if (method == BooleanMethod::Manifold) {
-        ManifoldBooleanError error = ManifoldBooleanError::None;
-        success = manifold_boolean_difference(
-            house_sm, underpass_meshes, result.result_meshgl, &timing, &error);
-        if (!success) {
-            if (error == ManifoldBooleanError::EmptyInputMesh) {
-                std::cerr << std::format("Skipping {} merged features (id='{}'): empty mesh for manifold boolean{}",
-                                         merged_feature_count, std::string(model_feature_id), val3dity_suffix) << std::endl;
-            } else if (error == ManifoldBooleanError::InvalidInput) {
-                std::cerr << std::format("Skipping {} merged features (id='{}'): invalid manifold input{}",
-                                         merged_feature_count, std::string(model_feature_id), val3dity_suffix) << std::endl;
+    const bool count_faces = trace::enabled() || memory_budget != nullptr;
+    size_t underpass_faces = 0;
+    if (count_faces) {
+        for (const auto& underpass_mesh : underpass_meshes) {
+            underpass_faces += underpass_mesh.number_of_faces();
+        }
+    }
+    std::vector<double> ceiling_z;
+    if (cost_model != nullptr) {
+        for (const auto& underpass : result.underpasses) {
+            ceiling_z.push_back(underpass.roof_z_local);
+        }
+    }
+
+    result.solids.reserve(houses.size());
+    for (size_t house_index = 0; house_index < houses.size(); ++house_index) {
+        const LoadedSolidMesh& house_data = houses[house_index];
+        const std::string_view lod = lods[house_index];
+        const std::string lod_suffix = houses.size() > 1 ? std::format(" (LoD {})", lod) : std::string{};
+        const size_t input_faces = count_faces ? underpass_faces + house_data.mesh.number_of_faces() : 0;
+        // With the auto method the chain is every backend, cheapest expected
+        // cost for this building first.
+        BooleanFeatureTraits traits;
+        std::vector<BooleanMethod> ranked_methods;
+        if (cost_model != nullptr) {
+            auto t_traits_start = Clock::now();
+            traits = boolean_feature_traits(house_data.mesh, underpass_meshes, ceiling_z, b3_val3dity_lod22);
+            ds_conversion_ms += Clock::now() - t_traits_start;
+            ranked_methods = cost_model->rank(traits);
+        }
+        const std::vector<BooleanMethod>& chain = cost_model != nullptr ? ranked_methods : methods;
+
+        // Each backend in the chain gets its own budget; the first non-empty
+        // result wins.
+        bool carved = false;
+        SkipReason failure_reason = SkipReason::BooleanFailed;
+        for (size_t attempt = 0; attempt < chain.size(); ++attempt) {
+            const BooleanMethod method = chain[attempt];
+            const char* method_name = boolean_method_name(method);
+            trace::Span boolean_span("boolean");
+            boolean_span.arg("backend", method_name)
+                .arg("lod", lod)
+                .arg("attempt", attempt)
+                .arg("underpasses", underpass_meshes.size())
+                .arg("input_faces", input_faces);
+
+            // Held for this attempt only.
+            MemoryBudget::Reservation memory_reservation;
+            if (memory_budget != nullptr) {
+                trace::Span memory_wait_span("memory_wait");
+                memory_reservation = memory_budget->reserve(method, input_faces, underpass_meshes.size());
+            }
+            BooleanAttempt outcome;
+            // Wall time of the attempt itself, without the memory wait, so
+            // failures that return without phase timings still cost time.
+            const auto t_attempt_start = Clock::now();
+            if (worker != nullptr) {
+                std::string detail;
+                const BooleanWorker::Status status =
+                    worker->run(method, house_data.mesh, underpass_meshes, budget, outcome, detail);
+                memory_reservation.observe_worker_peak(outcome.peak_bytes);
+                if (status == BooleanWorker::Status::Killed) {
+                    outcome.budget_exceeded = true;
+                    outcome.failure = std::format("{} boolean worker killed ({})", method_name, detail);
+                } else if (status == BooleanWorker::Status::Crashed) {
+                    boolean_span.arg("success", false).arg("crashed", true);
+                    boolean_span.end();
+                    std::cerr << std::format("Skipping {} merged features (id='{}'): {} boolean worker crashed ({}){}{}",
+                                             merged_feature_count, std::string(model_feature_id), method_name, detail,
+                                             lod_suffix, val3dity_suffix) << std::endl;
+                    result.skipped.add(SkipReason::BooleanWorkerCrashed, merged_feature_count);
+                    if (cost_model != nullptr) {
+                        const std::chrono::duration<double, std::milli> wall = Clock::now() - t_attempt_start;
+                        cost_model->record(method, traits, charged_boolean_ms(0.0, wall.count(), false), false);
+                    }
+                    return result;
+                } else if (status == BooleanWorker::Status::Unavailable) {
+                    std::cerr << std::format("Warning: {}; running {} boolean in-process", detail, method_name) << std::endl;
+                    outcome = run_boolean_attempt(method, house_data.mesh, underpass_meshes, budget);
+                    memory_reservation.observe_in_process_peak();
+                }
             } else {
-                std::cerr << std::format("Skipping {} merged features (id='{}'): manifold boolean failed{}",
-                                         merged_feature_count, std::string(model_feature_id), val3dity_suffix) << std::endl;
+                outcome = run_boolean_attempt(method, house_data.mesh, underpass_meshes, budget);
+                memory_reservation.observe_in_process_peak();
+            }
+            const std::chrono::duration<double, std::milli> attempt_wall_ms = Clock::now() - t_attempt_start;
+            intersection_ms += outcome.timing.boolean_ms;
+            ds_conversion_ms += outcome.timing.conversion_ms;
+
+            const size_t output_faces = outcome.has_polygonal_result
+                ? outcome.result_surface_mesh.number_of_faces()
+                : outcome.result_meshgl.NumTri();
+            const bool has_output_mesh = outcome.success && output_faces > 0;
+            if (cost_model != nullptr) {
+                cost_model->record(
+                    method, traits,
+                    charged_boolean_ms(outcome.timing.boolean_ms.count(), attempt_wall_ms.count(), has_output_mesh),
+                    has_output_mesh);
+            }
+            boolean_span.arg("output_faces", output_faces).arg("success", has_output_mesh);
+            boolean_span.end();
+            if (has_output_mesh) {
+                result.solids.push_back(SolidCarveResult{
+                    .method = method,
+                    .result_meshgl = std::move(outcome.result_meshgl),
+                    .result_surface_mesh = std::move(outcome.result_surface_mesh),
+                    .has_polygonal_result = outcome.has_polygonal_result,
+                });
+                carved = true;
+                break;
+            }
+
+            if (outcome.success) {
+                outcome.failure = std::format("{} boolean produced empty mesh", method_name);
+                failure_reason = SkipReason::EmptyBooleanResult;
+            } else {
+                failure_reason = outcome.budget_exceeded ? SkipReason::BooleanBudgetExceeded : SkipReason::BooleanFailed;
+            }
+            if (attempt + 1 < chain.size()) {
+                std::cerr << std::format("Retrying {} merged features (id='{}') with {}: {}{}{}",
+                                         merged_feature_count, std::string(model_feature_id),
+                                         boolean_method_name(chain[attempt + 1]), outcome.failure, lod_suffix,
+                                         val3dity_suffix) << std::endl;
+            } else {
+                std::cerr << std::format("Skipping {} merged features (id='{}'): {}{}{}",
+                                         merged_feature_count, std::string(model_feature_id), outcome.failure,
+                                         lod_suffix, val3dity_suffix) << std::endl;
             }
         }
-    } else if (method == BooleanMethod::CgalNef) {
-        Surface_mesh result_sm = nef_boolean_difference(house_sm, underpass_meshes, &timing);
-        auto t_conversion_start_local = Clock::now();
-        result.result_surface_mesh = std::move(result_sm);
-        result.has_polygonal_result = true;
-        auto t_conversion_end_local = Clock::now();
-        ds_conversion_ms += t_conversion_end_local - t_conversion_start_local;
-#ifdef ENABLE_GEOGRAM
-    } else if (method == BooleanMethod::Geogram) {
-        Surface_mesh result_sm = geogram_boolean_difference(house_sm, underpass_meshes, &timing);
-        auto t_conversion_start_local = Clock::now();
-        result.result_meshgl = surface_mesh_to_meshgl(result_sm, false);
-        auto t_conversion_end_local = Clock::now();
-        ds_conversion_ms += t_conversion_end_local - t_conversion_start_local;
-#endif
-    } else {
-        Surface_mesh result_sm = corefine_boolean_difference(house_sm, underpass_meshes, &timing);
-        auto t_conversion_start_local = Clock::now();
-        result.result_surface_mesh = std::move(result_sm);
-        result.has_polygonal_result = true;
-        auto t_conversion_end_local = Clock::now();
-        ds_conversion_ms += t_conversion_end_local - t_conversion_start_local;
-    }
-    intersection_ms += timing.boolean_ms;
-    ds_conversion_ms += timing.conversion_ms;
-
-    const bool has_output_mesh =
-        result.has_polygonal_result ? result.result_surface_mesh.number_of_faces() > 0
-                                    : result.result_meshgl.NumTri() > 0;
-    if (success && has_output_mesh) {
-        result.any_succeeded = true;
-        result.processed_count += merged_feature_count;
-    } else {
-        if (success) {
-            std::cerr << std::format("Skipping {} merged features (id='{}'): boolean produced empty mesh{}",
-                                     merged_feature_count, std::string(model_feature_id), val3dity_suffix) << std::endl;
+        if (!carved) {
+            result.skipped.add(failure_reason, merged_feature_count);
+            return result;
         }
-        result.skipped_count += merged_feature_count;
     }
 
+    result.succeeded = true;
+    result.processed_count += merged_feature_count;
     return result;
 }
 
@@ -435,23 +545,35 @@ static std::vector<double> meshgl_to_world_vertices(
     double offset_x,
     double offset_y,
     double offset_z) {
-    size_t num_verts = meshgl.NumVert();
-    size_t num_prop = meshgl.numProp;
-    std::vector<double> world_verts(num_verts * 3);
-    for (size_t v = 0; v < num_verts; ++v) {
-        world_verts[v * 3 + 0] = static_cast<double>(meshgl.vertProperties[v * num_prop + 0]) + offset_x;
-        world_verts[v * 3 + 1] = static_cast<double>(meshgl.vertProperties[v * num_prop + 1]) + offset_y;
-        world_verts[v * 3 + 2] = static_cast<double>(meshgl.vertProperties[v * num_prop + 2]) + offset_z;
-    }
+    std::vector<double> world_verts(meshgl.NumVert() * 3);
+    kernels::to_world_xyz(
+        meshgl.vertProperties.data(),
+        meshgl.NumVert(),
+        meshgl.numProp,
+        offset_x,
+        offset_y,
+        offset_z,
+        world_verts.data());
     return world_verts;
 }
 
+static void add_weld_stats(VertexWeldStats& totals, const VertexWeldStats& stats) {
+    totals.vertices_before += stats.vertices_before;
+    totals.vertices_after += stats.vertices_after;
+    totals.dropped_surfaces += stats.dropped_surfaces;
+}
+
 struct StreamProcessingContext {
     const std::vector<ogr::VectorReader::PolygonFeature>& polygon_features;
     std::unordered_map<std::string_view, std::vector<size_t>>& features_by_exact_id;
     std::vector<bool>& seen_feature;
     const std::string& feature_source_filename;
-    BooleanMethod method;
+    const std::vector<BooleanMethod>& methods;
+    std::chrono::milliseconds boolean_budget;
+    // Null unless --isolate-booleans.
+    BooleanWorker* boolean_worker;
+    // Null unless the method is auto.
+    BackendCostModel* cost_model;
     SourceAttributeTarget source_attribute_target;
     bool ignore_holes;
     bool& global_offset_set;
@@ -464,25 +586,176 @@ struct StreamProcessingContext {
     std::chrono::duration<double, std::milli>& intersection_ms;
     std::chrono::duration<double, std::milli>& output_write_ms;
     std::chrono::duration<double, std::milli>& output_write_changed_ms;
+    std::chrono::duration<double, std::milli>& output_write_polygonal_ms;
+    std::chrono::duration<double, std::milli>& output_write_weld_ms;
     std::chrono::duration<double, std::milli>& output_write_passthrough_ms;
     std::chrono::duration<double, std::milli>& model_stream_read_ms;
-    BooleanObjWriter& boolean_obj_writer;
+    VertexWeldStats& output_weld_totals;
+    RunMetrics& run_metrics;
+    BooleanMeshWriter& boolean_mesh_writer;
     std::ostream& log_out;
+    // With --shard-only, model features owned by other shards are dropped
+    // instead of passed through.
+    ShardSpec shard{};
+    bool shard_only = false;
+    // With --checkpoint, the run state is saved to `checkpoint_path` every
+    // `checkpoint_every` model features; `checkpoint` carries the paths.
+    RunCheckpoint* checkpoint = nullptr;
+    std::string checkpoint_path;
+    size_t checkpoint_every = 0;
+    // Null unless --max-memory; shared by concurrent --serve jobs or .city.json
+    // --jobs threads.
+    MemoryBudget* memory_budget = nullptr;
+    // --lods: solids carved from each model feature and replaced in one write.
+    std::vector<std::string> lods{std::string(kDefaultSolidLod)};
 };
 
+// Polygonal replacement for a carved solid, keeping the planar faces of
+// `house`. False when the backend result has no polygonal form or it could
+// not be built.
+static bool build_polygonal_replacement(
+    const SolidCarveResult& solid,
+    const LoadedSolidMesh& house,
+    const FeatureCarveResult& carve_result,
+    StreamProcessingContext& ctx,
+    const OutputQuantization* weld_quantization,
+    PolygonalOutput& out) {
+    const bool from_meshgl = solid.method == BooleanMethod::Manifold && solid.result_meshgl.NumTri() > 0;
+    if (!from_meshgl && !solid.has_polygonal_result) {
+        return false;
+    }
+    out = PolygonalOutput{};
+    trace::Span polygonal_span("polygonal_output");
+    auto t_polygonal_start = Clock::now();
+    const bool built = from_meshgl
+        ? build_polygonal_output_from_manifold_meshgl(
+              solid.result_meshgl,
+              house,
+              carve_result.house_min_z,
+              carve_result.underpass_z,
+              carve_result.underpasses,
+              ctx.global_offset_x,
+              ctx.global_offset_y,
+              ctx.global_offset_z,
+              out)
+        : build_polygonal_output_from_cgal_mesh(
+              solid.result_surface_mesh,
+              house,
+              carve_result.house_min_z,
+              carve_result.underpass_z,
+              carve_result.underpasses,
+              ctx.global_offset_x,
+              ctx.global_offset_y,
+              ctx.global_offset_z,
+              out);
+    ctx.output_write_polygonal_ms += Clock::now() - t_polygonal_start;
+    polygonal_span.arg("surfaces", out.surface_ring_counts.size()).arg("success", built);
+    polygonal_span.end();
+    if (built && weld_quantization != nullptr) {
+        trace::Span weld_span("weld");
+        auto t_weld_start = Clock::now();
+        VertexWeldStats weld_stats;
+        if (weld_polygonal_output(out, *weld_quantization, weld_stats)) {
+            add_weld_stats(ctx.output_weld_totals, weld_stats);
+        }
+        ctx.output_write_weld_ms += Clock::now() - t_weld_start;
+    }
+    return built;
+}
+
+// Triangle fallback for a carved solid: `out.boundary_indices` holds
+// triangles with one semantic type each and the ring counts stay empty.
+// A polygonal CGAL result is triangulated into `solid.result_meshgl` first.
+static bool build_triangle_replacement(
+    SolidCarveResult& solid,
+    const FeatureCarveResult& carve_result,
+    StreamProcessingContext& ctx,
+    const OutputQuantization* weld_quantization,
+    bool match_underpasses,
+    PolygonalOutput& out) {
+    if (solid.has_polygonal_result && solid.result_meshgl.NumTri() == 0) {
+        Surface_mesh triangulated_mesh = solid.result_surface_mesh;
+        CGAL::Polygon_mesh_processing::triangulate_faces(triangulated_mesh);
+        solid.result_meshgl = surface_mesh_to_meshgl(triangulated_mesh, false);
+    }
+    if (solid.result_meshgl.NumTri() == 0) {
+        return false;
+    }
+    out = PolygonalOutput{};
+    out.vertices_xyz_world = meshgl_to_world_vertices(
+        solid.result_meshgl,
+        ctx.global_offset_x,
+        ctx.global_offset_y,
+        ctx.global_offset_z);
+    out.surface_semantic_types = classify_triangle_semantics(
+        solid.result_meshgl, carve_result.house_min_z, carve_result.underpass_z);
+    if (match_underpasses) {
+        out.surface_underpass_indices = match_triangle_outer_ceiling_surfaces(
+            solid.result_meshgl,
+            out.surface_semantic_types,
+            carve_result.underpasses,
+            ctx.global_offset_x,
+            ctx.global_offset_y);
+    }
+    out.boundary_indices = solid.result_meshgl.triVerts;
+    if (weld_quantization != nullptr) {
+        trace::Span weld_span("weld");
+        auto t_weld_start = Clock::now();
+        VertexWeldStats weld_stats;
+        if (weld_triangle_output(
+                out.vertices_xyz_world,
+                out.boundary_indices,
+                out.surface_semantic_types,
+                match_underpasses ? &out.surface_underpass_indices : nullptr,
+                *weld_quantization,
+                weld_stats)) {
+            add_weld_stats(ctx.output_weld_totals, weld_stats);
+        }
+        ctx.output_write_weld_ms += Clock::now() - t_weld_start;
+    }
+    return true;
+}
+
+static MeshTotals replacement_totals(const PolygonalOutput& replacement) {
+    MeshTotals totals{.vertices = replacement.vertices_xyz_world.size() / 3};
+    if (replacement.surface_ring_counts.empty()) {
+        totals.triangles = replacement.boundary_indices.size() / 3;
+    } else {
+        totals.surfaces = replacement.surface_ring_counts.size();
+    }
+    return totals;
+}
+
 struct FcbStreamBackend {
     ZfcbReaderHandle reader = nullptr;
     ZfcbWriterHandle writer = nullptr;
     bool output_to_stdout = false;
     const char* output_path = nullptr;
+    // Connection of a --serve job; output_path then only labels it.
+    int output_fd = -1;
+    // --resume: continue the output of an interrupted run at its checkpoint.
+    const RunCheckpoint* resume_from = nullptr;
+    // Solid LoD that next() decodes; empty decodes every LoD, for --lods.
+    std::string_view mesh_lod = kDefaultSolidLod;
 
     const char* stream_label() const { return "FlatCityBuf"; }
     const char* output_label() const { return "FCB"; }
     const char* output_destination() const { return output_to_stdout ? "stdout" : output_path; }
     const char* missing_current_error() const { return "FlatCityBuf stream error: decoded feature unavailable"; }
 
+    bool output_quantization(OutputQuantization& quantization) const {
+        return zfcb_reader_header_transform(reader, quantization.scale.data(), quantization.translate.data()) == 1;
+    }
+
     bool open_writer() {
-        if (output_to_stdout) {
+        if (resume_from != nullptr) {
+            if (zfcb_reader_seek_feature(reader, resume_from->input_offset) != 0) {
+                return false;
+            }
+            writer = zfcb_writer_open_resume_from_reader(reader, output_path, resume_from->output_offset);
+        } else if (output_fd >= 0) {
+            writer = zfcb_writer_open_from_reader_no_index_fd(reader, output_fd, 0);
+        } else if (output_to_stdout) {
             writer = zfcb_writer_open_from_reader_no_index_fd(reader, stdout_fd(), 0);
         } else {
             writer = zfcb_writer_open_from_reader_no_index(reader, output_path);
@@ -490,11 +763,12 @@ struct FcbStreamBackend {
         return writer != nullptr;
     }
 
-    void close_writer() {
+    bool close_writer() {
         if (writer != nullptr) {
             zfcb_writer_destroy(writer);
             writer = nullptr;
         }
+        return true;
     }
 
     int peek_next_id(const char** out_id, size_t* out_len) {
@@ -502,7 +776,7 @@ struct FcbStreamBackend {
     }
 
     int next() {
-        return zfcb_next(reader);
+        return fcb_next_for_mesh_loading(reader, mesh_lod);
     }
 
     bool ensure_current_available() const {
@@ -513,6 +787,23 @@ struct FcbStreamBackend {
         return zfcb_writer_write_pending_raw(reader, writer);
     }
 
+    int skip_pending() {
+        return zfcb_skip_next(reader);
+    }
+
+    // Flushes the output and reports where the next feature is read from and
+    // written to.
+    bool sync_offsets(uint64_t& input_offset, uint64_t& output_offset) {
+        const int64_t input = zfcb_reader_next_feature_offset(reader);
+        const int64_t output = zfcb_writer_offset(writer);
+        if (input < 0 || output < 0 || zfcb_writer_sync(writer) != 0) {
+            return false;
+        }
+        input_offset = static_cast<uint64_t>(input);
+        output_offset = static_cast<uint64_t>(output);
+        return true;
+    }
+
     int write_current_raw() {
         return zfcb_writer_write_current_raw(reader, writer);
     }
@@ -627,6 +918,50 @@ struct FcbStreamBackend {
             surface_semantic_types, surface_semantic_types_count);
     }
 
+    // One solid per LoD in `lods`; triangle solids leave the ring counts empty.
+    int write_current_replaced_solids(
+        const char* feature_id_ptr,
+        size_t feature_id_len,
+        const std::vector<std::string>& lods,
+        const std::vector<PolygonalOutput>& solids,
+        const SourceAttributeBuffers& source_attributes,
+        SourceAttributeTarget source_attribute_target) {
+        std::vector<ZfcbSolidReplacement> replacements;
+        replacements.reserve(solids.size());
+        for (size_t i = 0; i < solids.size(); ++i) {
+            const PolygonalOutput& solid = solids[i];
+            const bool triangles = solid.surface_ring_counts.empty();
+            replacements.push_back(ZfcbSolidReplacement{
+                .lod = lods[i].data(),
+                .lod_len = lods[i].size(),
+                .vertices_xyz_world = solid.vertices_xyz_world.data(),
+                .vertex_count = solid.vertices_xyz_world.size() / 3,
+                .surface_ring_counts = triangles ? nullptr : solid.surface_ring_counts.data(),
+                .surface_count = solid.surface_ring_counts.size(),
+                .ring_vertex_counts = triangles ? nullptr : solid.ring_vertex_counts.data(),
+                .ring_count = solid.ring_vertex_counts.size(),
+                .boundary_indices = solid.boundary_indices.data(),
+                .boundary_index_count = solid.boundary_indices.size(),
+                .surface_semantic_types = solid.surface_semantic_types.data(),
+                .surface_semantic_types_count = solid.surface_semantic_types.size(),
+            });
+        }
+        const bool with_attributes = source_attribute_target != SourceAttributeTarget::None;
+        return zfcb_writer_write_current_replaced_solids(
+            reader, writer,
+            feature_id_ptr, feature_id_len,
+            replacements.data(), replacements.size(),
+            source_attributes.names.data(),
+            source_attributes.name_lens.data(),
+            source_attributes.types.data(),
+            source_attributes.integer_values.data(),
+            source_attributes.real_values.data(),
+            source_attributes.string_values.data(),
+            source_attributes.string_value_lens.data(),
+            with_attributes ? source_attributes.size() : 0,
+            static_cast<uint8_t>(source_attribute_target));
+    }
+
     bool prepare_current_feature(
         std::string_view next_id,
         const std::vector<size_t>& matched_indices,
@@ -676,41 +1011,58 @@ struct FcbStreamBackend {
 
     bool load_current_house_mesh(
         std::string_view next_id,
+        std::string_view lod,
         LoadedSolidMesh& house,
         double offset_x,
         double offset_y,
         double offset_z,
-        std::string& val3dity_suffix) {
-        std::string fcb_b3_val3dity_lod22;
-        bool loaded = load_fcb_feature_mesh(
-            reader, next_id, house, offset_x, offset_y, offset_z, &fcb_b3_val3dity_lod22);
-        val3dity_suffix = fcb_b3_val3dity_lod22.empty()
-            ? std::string{}
-            : std::format(" (b3_val3dity_lod22='{}')", fcb_b3_val3dity_lod22);
-        return loaded;
+        std::string& b3_val3dity_lod22) {
+        return load_fcb_feature_mesh(
+            reader, next_id, house, offset_x, offset_y, offset_z, &b3_val3dity_lod22, lod);
     }
 };
 
 struct CjseqStreamBackend {
     CityJSONSeqReaderHandle reader = nullptr;
     CityJSONSeqWriterHandle writer = nullptr;
+    bool output_to_stdout = false;
     const char* output_path = nullptr;
 
     const char* stream_label() const { return "CityJSONSeq"; }
     const char* output_label() const { return "CityJSONSeq"; }
-    const char* output_destination() const { return output_path; }
+    const char* output_destination() const { return output_to_stdout ? "stdout" : output_path; }
     const char* missing_current_error() const { return "CityJSONSeq stream error: decoded feature unavailable"; }
 
+    bool output_quantization(OutputQuantization& quantization) const {
+        return cityjsonseq_reader_header_transform(
+            reader, quantization.scale.data(), quantization.translate.data()) == 1;
+    }
+
     bool open_writer() {
-        writer = cityjsonseq_writer_open_from_reader(reader, output_path);
+        if (output_to_stdout) {
+            const std::string_view path(output_path);
+            const uint8_t compression = path.ends_with(".zst") ? CITYJSONSEQ_COMPRESSION_ZSTD
+                : path.ends_with(".gz") ? CITYJSONSEQ_COMPRESSION_GZIP
+                : CITYJSONSEQ_COMPRESSION_NONE;
+            writer = cityjsonseq_writer_open_from_reader_fd(reader, stdout_fd(), compression, 0);
+        } else {
+            writer = cityjsonseq_writer_open_from_reader(reader, output_path);
+        }
         return writer != nullptr;
     }
 
-    void close_writer() {
-        if (writer != nullptr) {
-            cityjsonseq_writer_destroy(writer);
-            writer = nullptr;
+    bool close_writer() {
+        if (writer == nullptr) {
+            return true;
+        }
+        const bool finished = cityjsonseq_writer_finish(writer) == 0;
+        const bool destroyed = cityjsonseq_writer_destroy(writer) == 0;
+        writer = nullptr;
+        if (!finished || !destroyed) {
+            std::cerr << "Failed to finish CityJSONSeq output: " << output_destination() << std::endl;
+            return false;
         }
+        return true;
     }
 
     int peek_next_id(const char** out_id, size_t* out_len) {
@@ -729,6 +1081,16 @@ struct CjseqStreamBackend {
         return cityjsonseq_writer_write_pending_raw(reader, writer);
     }
 
+    // CityJSONSeq has no skip; decoding the line consumes it.
+    int skip_pending() {
+        return cityjsonseq_next(reader);
+    }
+
+    // Compressed and piped CityJSONSeq streams cannot be resumed.
+    bool sync_offsets(uint64_t&, uint64_t&) {
+        return false;
+    }
+
     int write_current_raw() {
         return cityjsonseq_writer_write_current_raw(reader, writer);
     }
@@ -893,6 +1255,24 @@ struct CjseqStreamBackend {
             static_cast<uint8_t>(source_attribute_target));
     }
 
+    // The CityJSONSeq writers replace the LoD 2.2 solid only; main() rejects
+    // --lods for CityJSONSeq.
+    int write_current_replaced_solids(
+        const char* feature_id_ptr,
+        size_t feature_id_len,
+        const std::vector<std::string>& lods,
+        const std::vector<PolygonalOutput>& solids,
+        const SourceAttributeBuffers& source_attributes,
+        SourceAttributeTarget source_attribute_target) {
+        (void)feature_id_ptr;
+        (void)feature_id_len;
+        (void)lods;
+        (void)solids;
+        (void)source_attributes;
+        (void)source_attribute_target;
+        return -1;
+    }
+
     bool prepare_current_feature(
         std::string_view next_id,
         const std::vector<size_t>& matched_indices,
@@ -942,11 +1322,12 @@ struct CjseqStreamBackend {
 
     bool load_current_house_mesh(
         std::string_view next_id,
+        std::string_view lod,
         LoadedSolidMesh& house,
         double offset_x,
         double offset_y,
         double offset_z,
-        std::string& val3dity_suffix) {
+        std::string& b3_val3dity_lod22) {
         CityJSONHandle current_feature_cj = cityjsonseq_current_cityjson(reader);
         if (current_feature_cj == nullptr) {
             return false;
@@ -955,17 +1336,36 @@ struct CjseqStreamBackend {
         if (object_index < 0) {
             return false;
         }
-        val3dity_suffix.clear();
+        b3_val3dity_lod22.clear();
         return load_cityjson_object_mesh(
             current_feature_cj,
             static_cast<size_t>(object_index),
             house,
             offset_x,
             offset_y,
-            offset_z);
+            offset_z,
+            lod);
     }
 };
 
+template <typename Backend>
+static bool save_checkpoint(Backend& backend, StreamProcessingContext& ctx) {
+    trace::Span checkpoint_span("checkpoint");
+    RunCheckpoint& checkpoint = *ctx.checkpoint;
+    if (!backend.sync_offsets(checkpoint.input_offset, checkpoint.output_offset)) {
+        return false;
+    }
+    checkpoint.processed_count = ctx.processed_count;
+    checkpoint.skipped_count = ctx.skipped_count;
+    checkpoint.skipped = ctx.run_metrics.skipped;
+    checkpoint.global_offset_set = ctx.global_offset_set;
+    checkpoint.global_offset_x = ctx.global_offset_x;
+    checkpoint.global_offset_y = ctx.global_offset_y;
+    checkpoint.global_offset_z = ctx.global_offset_z;
+    checkpoint.seen_feature = ctx.seen_feature;
+    return write_checkpoint(ctx.checkpoint_path, checkpoint);
+}
+
 template <typename Backend>
 static bool process_stream_features(Backend& backend, StreamProcessingContext& ctx) {
     auto t_output_write_start = Clock::now();
@@ -978,15 +1378,36 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
         return false;
     }
     ctx.log_out << std::format("{} output: {}", backend.output_label(), backend.output_destination()) << std::endl;
+    // Replacement geometry is welded on the writer's quantization grid, so
+    // vertices that would be encoded identically are written once.
+    OutputQuantization output_quantization;
+    const bool weld_output = backend.output_quantization(output_quantization);
+    const OutputQuantization* weld_quantization = weld_output ? &output_quantization : nullptr;
+    // LoD 2.2 alone keeps the single-solid writers, which also handle
+    // CityJSONSeq and per-surface attributes.
+    const bool lod22_only = ctx.lods.size() == 1 && ctx.lods.front() == kDefaultSolidLod;
 
     bool stream_error = false;
+    size_t features_since_checkpoint = 0;
 
     while (true) {
+        // Sync point: the previous feature is fully written and no feature is
+        // pending, so offsets and counters describe the same boundary.
+        if (ctx.checkpoint != nullptr && features_since_checkpoint >= ctx.checkpoint_every) {
+            if (!save_checkpoint(backend, ctx)) {
+                std::cerr << "Failed to write checkpoint: " << ctx.checkpoint_path << std::endl;
+                stream_error = true;
+                break;
+            }
+            features_since_checkpoint = 0;
+        }
         const char* peek_id_ptr = nullptr;
         size_t peek_id_len = 0;
+        trace::Span peek_span("peek");
         auto t_stream_read_start = Clock::now();
         int peek_result = backend.peek_next_id(&peek_id_ptr, &peek_id_len);
         auto t_stream_read_end = Clock::now();
+        peek_span.end();
         ctx.model_stream_read_ms += t_stream_read_end - t_stream_read_start;
         if (peek_result < 0) {
             std::cerr << backend.stream_label() << " stream error while peeking next feature id" << std::endl;
@@ -996,10 +1417,28 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
         if (peek_result == 0) {
             break;
         }
+        ++features_since_checkpoint;
 
         std::string_view next_id(peek_id_ptr, peek_id_len);
+        if (ctx.shard_only && !ctx.shard.owns(next_id)) {
+            t_stream_read_start = Clock::now();
+            const int skip_result = backend.skip_pending();
+            ctx.model_stream_read_ms += Clock::now() - t_stream_read_start;
+            if (skip_result < 0) {
+                std::cerr << backend.stream_label() << " stream error while skipping feature of another shard" << std::endl;
+                stream_error = true;
+                break;
+            }
+            if (skip_result == 0) {
+                break;
+            }
+            continue;
+        }
+        // Features of other shards are not in the index and pass through.
         auto exact_hint_it = ctx.features_by_exact_id.find(next_id);
         if (exact_hint_it == ctx.features_by_exact_id.end()) {
+            trace::Span passthrough_span("write_passthrough");
+            passthrough_span.arg("id", next_id);
             auto t_output_write_start_local = Clock::now();
             int write_result = backend.write_pending_raw();
             auto t_output_write_end_local = Clock::now();
@@ -1017,9 +1456,14 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
             continue;
         }
 
+        // Spans the whole matched feature; `outcome` records how it ended.
+        trace::Span feature_span("feature");
+        feature_span.arg("id", next_id).arg("underpasses", exact_hint_it->second.size());
+        trace::Span decode_span("decode");
         auto t_stream_read_start_next = Clock::now();
         int next_result = backend.next();
         auto t_stream_read_end_next = Clock::now();
+        decode_span.end();
         ctx.model_stream_read_ms += t_stream_read_end_next - t_stream_read_start_next;
         if (next_result < 0) {
             std::cerr << backend.stream_label() << " stream error while decoding feature" << std::endl;
@@ -1048,6 +1492,7 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
                 ctx.source_attribute_target == SourceAttributeTarget::Parent,
             ctx.feature_source_filename,
             false);
+        const size_t skipped_before_prepare = ctx.skipped_count;
         if (!backend.prepare_current_feature(
                 next_id,
                 matched_indices,
@@ -1062,22 +1507,31 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
                 ctx.output_write_passthrough_ms,
                 aborted_attributes,
                 output_attribute_target)) {
+            ctx.run_metrics.skipped.add(SkipReason::InvalidModelVertices, ctx.skipped_count - skipped_before_prepare);
+            feature_span.arg("outcome", "invalid_vertices");
             continue;
         }
 
-        LoadedSolidMesh house;
+        std::vector<LoadedSolidMesh> houses(ctx.lods.size());
         bool house_mesh_loaded = false;
         std::string house_mesh_error;
-        std::string val3dity_suffix;
+        std::string b3_val3dity_lod22;
+        std::string_view failed_lod = ctx.lods.front();
+        trace::Span load_span("load");
         auto t_stream_read_start_mesh = Clock::now();
         try {
-            house_mesh_loaded = backend.load_current_house_mesh(
-                next_id,
-                house,
-                ctx.global_offset_x,
-                ctx.global_offset_y,
-                ctx.global_offset_z,
-                val3dity_suffix);
+            house_mesh_loaded = true;
+            for (size_t i = 0; i < houses.size() && house_mesh_loaded; ++i) {
+                failed_lod = ctx.lods[i];
+                house_mesh_loaded = backend.load_current_house_mesh(
+                    next_id,
+                    ctx.lods[i],
+                    houses[i],
+                    ctx.global_offset_x,
+                    ctx.global_offset_y,
+                    ctx.global_offset_z,
+                    b3_val3dity_lod22);
+            }
         } catch (const std::exception& e) {
             house_mesh_error = e.what();
             house_mesh_loaded = false;
@@ -1085,20 +1539,34 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
             house_mesh_error = "unknown exception";
             house_mesh_loaded = false;
         }
+        size_t house_faces = 0;
+        for (const auto& house : houses) {
+            house_faces += house.mesh.number_of_faces();
+        }
+        load_span.arg("faces", house_faces).arg("success", house_mesh_loaded);
+        load_span.end();
+        const std::string val3dity_suffix = b3_val3dity_lod22.empty()
+            ? std::string{}
+            : std::format(" (b3_val3dity_lod22='{}')", b3_val3dity_lod22);
         if (!house_mesh_loaded) {
+            feature_span.arg("outcome", "load_failed");
             auto t_stream_read_end_mesh = Clock::now();
             ctx.model_stream_read_ms += t_stream_read_end_mesh - t_stream_read_start_mesh;
+            const std::string mesh_label = houses.size() > 1
+                ? std::format("{} LoD {}", backend.stream_label(), failed_lod)
+                : std::string(backend.stream_label());
             for (size_t feature_idx : matched_indices) {
                 ctx.seen_feature[feature_idx] = true;
                 const auto& feature = ctx.polygon_features[feature_idx];
                 if (house_mesh_error.empty()) {
                     std::cerr << std::format("Skipping feature {} (id='{}'): could not build {} mesh{}",
-                                             feature_idx, feature.id, backend.stream_label(), val3dity_suffix) << std::endl;
+                                             feature_idx, feature.id, mesh_label, val3dity_suffix) << std::endl;
                 } else {
                     std::cerr << std::format("Skipping feature {} (id='{}'): failed to build {} mesh ({}){}",
-                                             feature_idx, feature.id, backend.stream_label(), house_mesh_error, val3dity_suffix) << std::endl;
+                                             feature_idx, feature.id, mesh_label, house_mesh_error, val3dity_suffix) << std::endl;
                 }
                 ++ctx.skipped_count;
+                ctx.run_metrics.skipped.add(SkipReason::ModelMeshFailed);
             }
             auto t_output_write_start_local = Clock::now();
             if (backend.write_current_with_attributes(
@@ -1113,14 +1581,25 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
         }
         auto t_stream_read_end_mesh = Clock::now();
         ctx.model_stream_read_ms += t_stream_read_end_mesh - t_stream_read_start_mesh;
+        for (const auto& house : houses) {
+            ctx.run_metrics.input.vertices += house.mesh.number_of_vertices();
+            ctx.run_metrics.input.triangles += house.mesh.number_of_faces();
+        }
 
+        auto t_carve_start = Clock::now();
         auto carve_result = carve_underpasses_for_feature(
-            house,
+            houses,
+            ctx.lods,
             next_id,
             ctx.polygon_features,
             matched_indices,
             ctx.seen_feature,
-            ctx.method,
+            ctx.methods,
+            ctx.boolean_budget,
+            ctx.boolean_worker,
+            ctx.cost_model,
+            ctx.memory_budget,
+            b3_val3dity_lod22,
             ctx.ignore_holes,
             ctx.global_offset_x,
             ctx.global_offset_y,
@@ -1128,16 +1607,22 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
             val3dity_suffix,
             ctx.ds_conversion_ms,
             ctx.intersection_ms);
+        ctx.run_metrics.add_feature_cost(
+            next_id, std::chrono::duration<double, std::milli>(Clock::now() - t_carve_start).count());
         ctx.processed_count += carve_result.processed_count;
-        ctx.skipped_count += carve_result.skipped_count;
+        ctx.skipped_count += carve_result.skipped.total();
+        ctx.run_metrics.skipped.add(carve_result.skipped);
 
-        if (carve_result.any_succeeded) {
+        if (carve_result.succeeded) {
             std::string feature_id_str(next_id);
-            const bool obj_written = carve_result.has_polygonal_result
-                ? ctx.boolean_obj_writer.append(next_id, carve_result.result_surface_mesh)
-                : ctx.boolean_obj_writer.append(next_id, carve_result.result_meshgl);
-            if (!obj_written) {
-                std::cerr << std::format("Warning: failed to append feature '{}' to boolean OBJ", feature_id_str)
+            // The boolean mesh output carries a single solid; main() rejects
+            // it together with --lods.
+            SolidCarveResult& first_solid = carve_result.solids.front();
+            const bool mesh_written = first_solid.has_polygonal_result
+                ? ctx.boolean_mesh_writer.append(next_id, first_solid.result_surface_mesh)
+                : ctx.boolean_mesh_writer.append(next_id, first_solid.result_meshgl);
+            if (!mesh_written) {
+                std::cerr << std::format("Warning: failed to append feature '{}' to boolean mesh output", feature_id_str)
                           << std::endl;
             }
             SourceAttributeBuffers source_attributes = source_attribute_buffers(
@@ -1146,7 +1631,8 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
                 ctx.source_attribute_target == SourceAttributeTarget::Feature ||
                     ctx.source_attribute_target == SourceAttributeTarget::Parent,
                 ctx.feature_source_filename,
-                true);
+                true,
+                boolean_method_name(first_solid.method));
             SurfaceAttributeGroups grouped_surface_attributes;
             const SurfaceAttributeGroups* grouped_surface_attributes_ptr = nullptr;
             if (ctx.source_attribute_target == SourceAttributeTarget::SemanticSurface) {
@@ -1154,101 +1640,91 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
                     ctx.polygon_features, carve_result.underpasses);
                 grouped_surface_attributes_ptr = &grouped_surface_attributes;
             }
+            const bool match_underpasses = grouped_surface_attributes_ptr != nullptr;
+            trace::Span write_span("write");
             auto t_output_write_start_local = Clock::now();
             int write_result = -1;
-            if (ctx.method == BooleanMethod::Manifold && carve_result.result_meshgl.NumTri() > 0) {
-                PolygonalOutput polygonal_output;
-                if (build_polygonal_output_from_manifold_meshgl(
-                        carve_result.result_meshgl,
-                        house,
-                        carve_result.house_min_z,
-                        carve_result.underpass_z,
-                        carve_result.underpasses,
-                        ctx.global_offset_x,
-                        ctx.global_offset_y,
-                        ctx.global_offset_z,
-                        polygonal_output)) {
+            // Geometry handed to the writer by the last write attempt.
+            MeshTotals written;
+            if (lod22_only) {
+                PolygonalOutput replacement;
+                if (build_polygonal_replacement(
+                        first_solid, houses.front(), carve_result, ctx, weld_quantization, replacement)) {
+                    written = replacement_totals(replacement);
                     write_result = backend.write_current_replaced_lod22_polygonal(
                         feature_id_str.c_str(), feature_id_str.size(),
-                        polygonal_output.vertices_xyz_world.data(), polygonal_output.vertices_xyz_world.size() / 3,
-                        polygonal_output.surface_ring_counts.data(), polygonal_output.surface_ring_counts.size(),
-                        polygonal_output.ring_vertex_counts.data(), polygonal_output.ring_vertex_counts.size(),
-                        polygonal_output.boundary_indices.data(), polygonal_output.boundary_indices.size(),
-                        polygonal_output.surface_semantic_types.data(), polygonal_output.surface_semantic_types.size(),
+                        replacement.vertices_xyz_world.data(), replacement.vertices_xyz_world.size() / 3,
+                        replacement.surface_ring_counts.data(), replacement.surface_ring_counts.size(),
+                        replacement.ring_vertex_counts.data(), replacement.ring_vertex_counts.size(),
+                        replacement.boundary_indices.data(), replacement.boundary_indices.size(),
+                        replacement.surface_semantic_types.data(), replacement.surface_semantic_types.size(),
                         source_attributes,
                         output_attribute_target,
-                        grouped_surface_attributes_ptr != nullptr
-                            ? &polygonal_output.surface_underpass_indices
-                            : nullptr,
+                        match_underpasses ? &replacement.surface_underpass_indices : nullptr,
                         grouped_surface_attributes_ptr);
                 }
-            } else if (carve_result.has_polygonal_result) {
-                PolygonalOutput polygonal_output;
-                if (build_polygonal_output_from_cgal_mesh(
-                        carve_result.result_surface_mesh,
-                        house,
-                        carve_result.house_min_z,
-                        carve_result.underpass_z,
-                        carve_result.underpasses,
-                        ctx.global_offset_x,
-                        ctx.global_offset_y,
-                        ctx.global_offset_z,
-                        polygonal_output)) {
-                    write_result = backend.write_current_replaced_lod22_polygonal(
+                if (write_result < 0 &&
+                    build_triangle_replacement(
+                        first_solid, carve_result, ctx, weld_quantization, match_underpasses, replacement)) {
+                    written = replacement_totals(replacement);
+                    write_result = backend.write_current_replaced_lod22(
                         feature_id_str.c_str(), feature_id_str.size(),
-                        polygonal_output.vertices_xyz_world.data(), polygonal_output.vertices_xyz_world.size() / 3,
-                        polygonal_output.surface_ring_counts.data(), polygonal_output.surface_ring_counts.size(),
-                        polygonal_output.ring_vertex_counts.data(), polygonal_output.ring_vertex_counts.size(),
-                        polygonal_output.boundary_indices.data(), polygonal_output.boundary_indices.size(),
-                        polygonal_output.surface_semantic_types.data(), polygonal_output.surface_semantic_types.size(),
+                        replacement.vertices_xyz_world.data(), replacement.vertices_xyz_world.size() / 3,
+                        replacement.boundary_indices.data(), replacement.boundary_indices.size(),
+                        replacement.surface_semantic_types.data(), replacement.surface_semantic_types.size(),
                         source_attributes,
                         output_attribute_target,
-                        grouped_surface_attributes_ptr != nullptr
-                            ? &polygonal_output.surface_underpass_indices
-                            : nullptr,
+                        match_underpasses ? &replacement.surface_underpass_indices : nullptr,
                         grouped_surface_attributes_ptr);
                 }
-
-                if (write_result < 0) {
-                    Surface_mesh triangulated_mesh = carve_result.result_surface_mesh;
-                    CGAL::Polygon_mesh_processing::triangulate_faces(triangulated_mesh);
-                    carve_result.result_meshgl = surface_mesh_to_meshgl(triangulated_mesh, false);
-                }
-            }
-
-            if (write_result < 0 && carve_result.result_meshgl.NumTri() > 0) {
-                auto world_verts = meshgl_to_world_vertices(
-                    carve_result.result_meshgl,
-                    ctx.global_offset_x,
-                    ctx.global_offset_y,
-                    ctx.global_offset_z);
-                auto semantics = classify_triangle_semantics(
-                    carve_result.result_meshgl, carve_result.house_min_z, carve_result.underpass_z);
-                std::vector<int32_t> triangle_underpass_indices;
-                const std::vector<int32_t>* triangle_underpass_indices_ptr = nullptr;
-                if (grouped_surface_attributes_ptr != nullptr) {
-                    triangle_underpass_indices = match_triangle_outer_ceiling_surfaces(
-                        carve_result.result_meshgl,
-                        semantics,
-                        carve_result.underpasses,
-                        ctx.global_offset_x,
-                        ctx.global_offset_y);
-                    triangle_underpass_indices_ptr = &triangle_underpass_indices;
+            } else {
+                // Every LoD goes into the one rewrite of the feature; if the
+                // polygonal solids are rejected, all are retried as triangles.
+                std::vector<PolygonalOutput> replacements(carve_result.solids.size());
+                for (bool triangles_only : {false, true}) {
+                    bool built = true;
+                    for (size_t i = 0; i < replacements.size() && built; ++i) {
+                        built = (!triangles_only &&
+                                 build_polygonal_replacement(
+                                     carve_result.solids[i], houses[i], carve_result, ctx, weld_quantization,
+                                     replacements[i])) ||
+                            build_triangle_replacement(
+                                carve_result.solids[i], carve_result, ctx, weld_quantization, match_underpasses,
+                                replacements[i]);
+                    }
+                    if (!built) {
+                        break;
+                    }
+                    written = MeshTotals{};
+                    for (const auto& replacement : replacements) {
+                        const MeshTotals totals = replacement_totals(replacement);
+                        written.vertices += totals.vertices;
+                        written.triangles += totals.triangles;
+                        written.surfaces += totals.surfaces;
+                    }
+                    write_result = backend.write_current_replaced_solids(
+                        feature_id_str.c_str(), feature_id_str.size(),
+                        ctx.lods,
+                        replacements,
+                        source_attributes,
+                        output_attribute_target);
+                    if (write_result >= 0) {
+                        break;
+                    }
                 }
-                write_result = backend.write_current_replaced_lod22(
-                    feature_id_str.c_str(), feature_id_str.size(),
-                    world_verts.data(), world_verts.size() / 3,
-                    carve_result.result_meshgl.triVerts.data(), carve_result.result_meshgl.triVerts.size(),
-                    semantics.data(), semantics.size(),
-                    source_attributes,
-                    output_attribute_target,
-                    triangle_underpass_indices_ptr,
-                    grouped_surface_attributes_ptr);
             }
             auto t_output_write_end_local = Clock::now();
             auto d_output_write = t_output_write_end_local - t_output_write_start_local;
             ctx.output_write_ms += d_output_write;
             ctx.output_write_changed_ms += d_output_write;
+            write_span.arg("success", write_result >= 0);
+            write_span.end();
+            if (write_result >= 0) {
+                ctx.run_metrics.output.vertices += written.vertices;
+                ctx.run_metrics.output.triangles += written.triangles;
+                ctx.run_metrics.output.surfaces += written.surfaces;
+            }
+            feature_span.arg("outcome", write_result < 0 ? "write_failed" : "carved");
             if (write_result < 0) {
                 std::cerr << std::format("Warning: failed to write modified feature '{}' to {}, writing raw instead",
                                          feature_id_str, backend.output_label()) << std::endl;
@@ -1263,6 +1739,7 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
                 ctx.output_write_passthrough_ms += d_output_write_fallback;
             }
         } else {
+            feature_span.arg("outcome", "not_carved");
             auto t_output_write_start_local = Clock::now();
             if (backend.write_current_with_attributes(
                     next_id.data(), next_id.size(), aborted_attributes, output_attribute_target) < 0) {
@@ -1276,65 +1753,816 @@ static bool process_stream_features(Backend& backend, StreamProcessingContext& c
     }
 
     auto t_output_write_start_local = Clock::now();
-    backend.close_writer();
+    if (!backend.close_writer()) {
+        stream_error = true;
+    }
     auto t_output_write_end_local = Clock::now();
     ctx.output_write_ms += t_output_write_end_local - t_output_write_start_local;
 
     return !stream_error;
 }
 
+// A tile object with matching OGR features.
+struct TileFeature {
+    std::string_view id;
+    // The "<id>-0" part when present, like the CityJSONSeq loader.
+    size_t object_index = 0;
+    const std::vector<size_t>* matched_indices = nullptr;
+};
+
+// What a thread carved for one tile feature, recorded into the tile in tile
+// order so the output does not depend on the thread schedule.
+struct TileFeatureResult {
+    bool ready = false;
+    bool loaded = false;
+    double carve_ms = 0.0;
+    FeatureCarveResult carve_result;
+    bool polygonal_built = false;
+    PolygonalOutput replacement;
+    SourceAttributeBuffers source_attributes;
+    SourceAttributeBuffers aborted_attributes;
+};
+
+// Counters of one thread carving a tile, merged into the run's when all
+// threads are done.
+struct TileThreadState {
+    std::vector<bool> seen_feature;
+    size_t processed_count = 0;
+    size_t skipped_count = 0;
+    std::chrono::duration<double, std::milli> ds_conversion_ms{0.0};
+    std::chrono::duration<double, std::milli> intersection_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_changed_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_polygonal_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_weld_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_passthrough_ms{0.0};
+    std::chrono::duration<double, std::milli> model_stream_read_ms{0.0};
+    VertexWeldStats output_weld_totals;
+    // Skips and mesh totals; feature costs go to the run's metrics.
+    RunMetrics run_metrics;
+    // Null for the first thread, which uses the run's.
+    std::unique_ptr<BooleanWorker> boolean_worker;
+    std::unique_ptr<BackendCostModel> cost_model;
+};
+
+static void add_mesh_totals(MeshTotals& totals, const MeshTotals& other) {
+    totals.vertices += other.vertices;
+    totals.triangles += other.triangles;
+    totals.surfaces += other.surfaces;
+}
+
+static int replace_tile_lod22(
+    CityJSONTileHandle tile,
+    std::string_view feature_id,
+    const PolygonalOutput& replacement,
+    const SourceAttributeBuffers& source_attributes,
+    SourceAttributeTarget source_attribute_target) {
+    return cityjson_tile_replace_lod22_polygonal(
+        tile,
+        feature_id.data(), feature_id.size(),
+        replacement.vertices_xyz_world.data(), replacement.vertices_xyz_world.size() / 3,
+        replacement.surface_ring_counts.data(), replacement.surface_ring_counts.size(),
+        replacement.ring_vertex_counts.data(), replacement.ring_vertex_counts.size(),
+        replacement.boundary_indices.data(), replacement.boundary_indices.size(),
+        replacement.surface_semantic_types.data(), replacement.surface_semantic_types.size(),
+        source_attributes.names.data(),
+        source_attributes.name_lens.data(),
+        source_attributes.types.data(),
+        source_attributes.integer_values.data(),
+        source_attributes.real_values.data(),
+        source_attributes.string_values.data(),
+        source_attributes.string_value_lens.data(),
+        source_attributes.size(),
+        static_cast<uint8_t>(source_attribute_target));
+}
+
+static int merge_tile_attributes(
+    CityJSONTileHandle tile,
+    std::string_view feature_id,
+    const SourceAttributeBuffers& source_attributes,
+    SourceAttributeTarget source_attribute_target) {
+    return cityjson_tile_merge_attributes(
+        tile,
+        feature_id.data(), feature_id.size(),
+        source_attributes.names.data(),
+        source_attributes.name_lens.data(),
+        source_attributes.types.data(),
+        source_attributes.integer_values.data(),
+        source_attributes.real_values.data(),
+        source_attributes.string_values.data(),
+        source_attributes.string_value_lens.data(),
+        source_attributes.size(),
+        static_cast<uint8_t>(source_attribute_target));
+}
+
+// Loads and carves one tile feature and builds its polygonal replacement;
+// runs on any thread, with that thread's `ctx`.
+static void carve_tile_feature(
+    CityJSONHandle cj,
+    const TileFeature& feature,
+    StreamProcessingContext& ctx,
+    const OutputQuantization* weld_quantization,
+    TileFeatureResult& result) {
+    const auto& matched_indices = *feature.matched_indices;
+    trace::Span feature_span("feature");
+    feature_span.arg("id", feature.id).arg("underpasses", matched_indices.size());
+    result.aborted_attributes = source_attribute_buffers(
+        ctx.polygon_features,
+        matched_indices,
+        ctx.source_attribute_target == SourceAttributeTarget::Feature ||
+            ctx.source_attribute_target == SourceAttributeTarget::Parent,
+        ctx.feature_source_filename,
+        false);
+
+    std::vector<LoadedSolidMesh> houses(1);
+    std::string house_mesh_error;
+    trace::Span load_span("load");
+    auto t_load_start = Clock::now();
+    try {
+        result.loaded = load_cityjson_object_mesh(
+            cj,
+            feature.object_index,
+            houses.front(),
+            ctx.global_offset_x,
+            ctx.global_offset_y,
+            ctx.global_offset_z);
+    } catch (const std::exception& e) {
+        house_mesh_error = e.what();
+    } catch (...) {
+        house_mesh_error = "unknown exception";
+    }
+    ctx.model_stream_read_ms += Clock::now() - t_load_start;
+    load_span.arg("faces", houses.front().mesh.number_of_faces()).arg("success", result.loaded);
+    load_span.end();
+    if (!result.loaded) {
+        feature_span.arg("outcome", "load_failed");
+        for (size_t feature_idx : matched_indices) {
+            ctx.seen_feature[feature_idx] = true;
+            const auto& polygon_feature = ctx.polygon_features[feature_idx];
+            if (house_mesh_error.empty()) {
+                std::cerr << std::format("Skipping feature {} (id='{}'): could not build CityJSON mesh",
+                                         feature_idx, polygon_feature.id) << std::endl;
+            } else {
+                std::cerr << std::format("Skipping feature {} (id='{}'): failed to build CityJSON mesh ({})",
+                                         feature_idx, polygon_feature.id, house_mesh_error) << std::endl;
+            }
+            ++ctx.skipped_count;
+            ctx.run_metrics.skipped.add(SkipReason::ModelMeshFailed);
+        }
+        return;
+    }
+    ctx.run_metrics.input.vertices += houses.front().mesh.number_of_vertices();
+    ctx.run_metrics.input.triangles += houses.front().mesh.number_of_faces();
+
+    auto t_carve_start = Clock::now();
+    result.carve_result = carve_underpasses_for_feature(
+        houses,
+        ctx.lods,
+        feature.id,
+        ctx.polygon_features,
+        matched_indices,
+        ctx.seen_feature,
+        ctx.methods,
+        ctx.boolean_budget,
+        ctx.boolean_worker,
+        ctx.cost_model,
+        ctx.memory_budget,
+        {},
+        ctx.ignore_holes,
+        ctx.global_offset_x,
+        ctx.global_offset_y,
+        ctx.global_offset_z,
+        {},
+        ctx.ds_conversion_ms,
+        ctx.intersection_ms);
+    result.carve_ms = std::chrono::duration<double, std::milli>(Clock::now() - t_carve_start).count();
+    ctx.processed_count += result.carve_result.processed_count;
+    ctx.skipped_count += result.carve_result.skipped.total();
+    ctx.run_metrics.skipped.add(result.carve_result.skipped);
+    if (!result.carve_result.succeeded) {
+        feature_span.arg("outcome", "not_carved");
+        return;
+    }
+    feature_span.arg("outcome", "carved");
+
+    const SolidCarveResult& first_solid = result.carve_result.solids.front();
+    result.source_attributes = source_attribute_buffers(
+        ctx.polygon_features,
+        matched_indices,
+        ctx.source_attribute_target == SourceAttributeTarget::Feature ||
+            ctx.source_attribute_target == SourceAttributeTarget::Parent,
+        ctx.feature_source_filename,
+        true,
+        boolean_method_name(first_solid.method));
+    result.polygonal_built = build_polygonal_replacement(
+        first_solid, houses.front(), result.carve_result, ctx, weld_quantization, result.replacement);
+}
+
+// Records a carved tile feature into the tile, falling back to triangles when
+// the polygonal replacement is rejected, or merges the aborted attributes into
+// a feature that keeps its geometry. Called in tile order under the commit
+// lock, with the calling thread's `ctx`.
+static void commit_tile_feature(
+    CityJSONTileHandle tile,
+    const TileFeature& feature,
+    TileFeatureResult& result,
+    StreamProcessingContext& ctx,
+    const OutputQuantization* weld_quantization,
+    RunMetrics& run_metrics) {
+    const SourceAttributeTarget output_attribute_target = ctx.source_attribute_target == SourceAttributeTarget::None
+        ? SourceAttributeTarget::Feature
+        : ctx.source_attribute_target;
+    if (result.loaded) {
+        run_metrics.add_feature_cost(feature.id, result.carve_ms);
+    }
+
+    int write_result = -1;
+    if (result.carve_result.succeeded) {
+        SolidCarveResult& first_solid = result.carve_result.solids.front();
+        const bool mesh_written = first_solid.has_polygonal_result
+            ? ctx.boolean_mesh_writer.append(feature.id, first_solid.result_surface_mesh)
+            : ctx.boolean_mesh_writer.append(feature.id, first_solid.result_meshgl);
+        if (!mesh_written) {
+            std::cerr << std::format("Warning: failed to append feature '{}' to boolean mesh output", feature.id)
+                      << std::endl;
+        }
+        trace::Span write_span("write");
+        write_span.arg("id", feature.id);
+        auto t_output_write_start = Clock::now();
+        MeshTotals written;
+        if (result.polygonal_built) {
+            written = replacement_totals(result.replacement);
+            write_result = replace_tile_lod22(
+                tile, feature.id, result.replacement, result.source_attributes, output_attribute_target);
+        }
+        if (write_result < 0 &&
+            build_triangle_replacement(
+                first_solid, result.carve_result, ctx, weld_quantization, false, result.replacement)) {
+            written = replacement_totals(result.replacement);
+            // The tile takes polygons only: one single-ring surface per triangle.
+            const size_t triangle_count = result.replacement.boundary_indices.size() / 3;
+            result.replacement.surface_ring_counts.assign(triangle_count, 1);
+            result.replacement.ring_vertex_counts.assign(triangle_count, 3);
+            write_result = replace_tile_lod22(
+                tile, feature.id, result.replacement, result.source_attributes, output_attribute_target);
+        }
+        auto d_output_write = Clock::now() - t_output_write_start;
+        ctx.output_write_ms += d_output_write;
+        ctx.output_write_changed_ms += d_output_write;
+        write_span.arg("success", write_result >= 0);
+        write_span.end();
+        if (write_result >= 0) {
+            add_mesh_totals(ctx.run_metrics.output, written);
+        } else {
+            std::cerr << std::format("Warning: failed to replace feature '{}' in the CityJSON tile, keeping its geometry",
+                                     feature.id) << std::endl;
+        }
+    }
+    if (write_result < 0) {
+        auto t_output_write_start = Clock::now();
+        merge_tile_attributes(tile, feature.id, result.aborted_attributes, output_attribute_target);
+        auto d_output_write = Clock::now() - t_output_write_start;
+        ctx.output_write_ms += d_output_write;
+        ctx.output_write_passthrough_ms += d_output_write;
+    }
+}
+
+// Carves a whole .city.json tile held in memory. The tile objects with
+// matching OGR features are carved by `jobs` threads, each with its own
+// boolean worker, cost model copy and counters; finished features are
+// recorded into the tile in tile order as soon as every earlier one is, and
+// the tile is saved once at the end. Objects without a match are written
+// back unchanged by the save.
+static bool process_cityjson_tile(
+    CityJSONTileHandle tile,
+    const char* output_path,
+    StreamProcessingContext& ctx,
+    size_t jobs,
+    const std::string& worker_executable_path) {
+    CityJSONHandle cj = cityjson_tile_cityjson(tile);
+    std::vector<TileFeature> tile_features;
+    const size_t object_count = cityjson_object_count(cj);
+    for (size_t i = 0; i < object_count; ++i) {
+        const std::string_view id(cityjson_get_object_name(cj, i));
+        auto exact_hint_it = ctx.features_by_exact_id.find(id);
+        if (exact_hint_it == ctx.features_by_exact_id.end()) {
+            continue;
+        }
+        const ssize_t object_index = resolve_cityjson_object_index(cj, id);
+        if (object_index >= 0) {
+            tile_features.push_back(TileFeature{
+                .id = id,
+                .object_index = static_cast<size_t>(object_index),
+                .matched_indices = &exact_hint_it->second,
+            });
+        }
+    }
+    // Every thread carves relative to the same offset, taken like the
+    // streams do from the first feature that has one.
+    for (const TileFeature& feature : tile_features) {
+        if (ctx.global_offset_set) {
+            break;
+        }
+        ctx.global_offset_set = cityjson_lod22_first_vertex(
+            cj, feature.object_index, ctx.global_offset_x, ctx.global_offset_y, ctx.global_offset_z);
+    }
+    // Replacement geometry is welded on the tile's quantization grid.
+    OutputQuantization output_quantization;
+    const bool weld_output =
+        cityjson_tile_transform(tile, output_quantization.scale.data(), output_quantization.translate.data()) == 1;
+    const OutputQuantization* weld_quantization = weld_output ? &output_quantization : nullptr;
+
+    const size_t thread_count = std::max<size_t>(1, std::min(jobs, tile_features.size()));
+    ctx.log_out << std::format(
+        "CityJSON tile: {} of {} objects to carve on {} thread(s)",
+        tile_features.size(), object_count, thread_count) << std::endl;
+
+    std::vector<TileThreadState> states(thread_count);
+    // Further threads get their own worker and cost model. The copies are
+    // made here, before any thread runs, because thread 0 updates
+    // ctx.cost_model as soon as it starts carving.
+    for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+        if (!worker_executable_path.empty()) {
+            states[thread_index].boolean_worker = std::make_unique<BooleanWorker>(worker_executable_path);
+        }
+        if (ctx.cost_model != nullptr) {
+            states[thread_index].cost_model = std::make_unique<BackendCostModel>(*ctx.cost_model);
+        }
+    }
+    std::vector<TileFeatureResult> results(tile_features.size());
+    std::atomic<size_t> next_feature{0};
+    std::mutex commit_mutex;
+    size_t next_commit = 0;
+    auto carve_features = [&](size_t thread_index) {
+        TileThreadState& state = states[thread_index];
+        state.seen_feature.assign(ctx.seen_feature.size(), false);
+        BooleanWorker* boolean_worker = thread_index > 0 ? state.boolean_worker.get() : ctx.boolean_worker;
+        BackendCostModel* cost_model = thread_index > 0 ? state.cost_model.get() : ctx.cost_model;
+        StreamProcessingContext thread_ctx{
+            .polygon_features = ctx.polygon_features,
+            .features_by_exact_id = ctx.features_by_exact_id,
+            .seen_feature = state.seen_feature,
+            .feature_source_filename = ctx.feature_source_filename,
+            .methods = ctx.methods,
+            .boolean_budget = ctx.boolean_budget,
+            .boolean_worker = boolean_worker,
+            .cost_model = cost_model,
+            .source_attribute_target = ctx.source_attribute_target,
+            .ignore_holes = ctx.ignore_holes,
+            .global_offset_set = ctx.global_offset_set,
+            .global_offset_x = ctx.global_offset_x,
+            .global_offset_y = ctx.global_offset_y,
+            .global_offset_z = ctx.global_offset_z,
+            .processed_count = state.processed_count,
+            .skipped_count = state.skipped_count,
+            .ds_conversion_ms = state.ds_conversion_ms,
+            .intersection_ms = state.intersection_ms,
+            .output_write_ms = state.output_write_ms,
+            .output_write_changed_ms = state.output_write_changed_ms,
+            .output_write_polygonal_ms = state.output_write_polygonal_ms,
+            .output_write_weld_ms = state.output_write_weld_ms,
+            .output_write_passthrough_ms = state.output_write_passthrough_ms,
+            .model_stream_read_ms = state.model_stream_read_ms,
+            .output_weld_totals = state.output_weld_totals,
+            .run_metrics = state.run_metrics,
+            .boolean_mesh_writer = ctx.boolean_mesh_writer,
+            .log_out = ctx.log_out,
+            .memory_budget = ctx.memory_budget,
+            .lods = ctx.lods,
+        };
+        for (size_t item = next_feature++; item < tile_features.size(); item = next_feature++) {
+            carve_tile_feature(cj, tile_features[item], thread_ctx, weld_quantization, results[item]);
+            std::lock_guard<std::mutex> lock(commit_mutex);
+            results[item].ready = true;
+            for (; next_commit < results.size() && results[next_commit].ready; ++next_commit) {
+                commit_tile_feature(
+                    tile, tile_features[next_commit], results[next_commit], thread_ctx, weld_quantization,
+                    ctx.run_metrics);
+                // Drops the carved meshes; `ready` stays set.
+                results[next_commit] = TileFeatureResult{.ready = true};
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+        threads.emplace_back(carve_features, thread_index);
+    }
+    carve_features(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (TileThreadState& state : states) {
+        for (size_t i = 0; i < state.seen_feature.size(); ++i) {
+            if (state.seen_feature[i]) {
+                ctx.seen_feature[i] = true;
+            }
+        }
+        ctx.processed_count += state.processed_count;
+        ctx.skipped_count += state.skipped_count;
+        ctx.ds_conversion_ms += state.ds_conversion_ms;
+        ctx.intersection_ms += state.intersection_ms;
+        ctx.output_write_ms += state.output_write_ms;
+        ctx.output_write_changed_ms += state.output_write_changed_ms;
+        ctx.output_write_polygonal_ms += state.output_write_polygonal_ms;
+        ctx.output_write_weld_ms += state.output_write_weld_ms;
+        ctx.output_write_passthrough_ms += state.output_write_passthrough_ms;
+        ctx.model_stream_read_ms += state.model_stream_read_ms;
+        add_weld_stats(ctx.output_weld_totals, state.output_weld_totals);
+        ctx.run_metrics.skipped.add(state.run_metrics.skipped);
+        add_mesh_totals(ctx.run_metrics.input, state.run_metrics.input);
+        add_mesh_totals(ctx.run_metrics.output, state.run_metrics.output);
+        if (state.boolean_worker != nullptr) {
+            ctx.run_metrics.boolean_worker_restarts += state.boolean_worker->restarts();
+        }
+    }
+
+    trace::Span save_span("save");
+    auto t_output_write_start = Clock::now();
+    const bool saved = cityjson_tile_save(tile, output_path) == 0;
+    ctx.output_write_ms += Clock::now() - t_output_write_start;
+    save_span.arg("success", saved);
+    save_span.end();
+    if (!saved) {
+        std::cerr << "Failed to write CityJSON output: " << output_path << std::endl;
+        return false;
+    }
+    ctx.log_out << std::format("CityJSON output: {}", output_path) << std::endl;
+    return true;
+}
+
+// Warm state of --serve, shared by its jobs: the whole OGR layer and its id
+// index are read once at startup instead of per tile.
+struct CarveService {
+    const std::vector<ogr::VectorReader::PolygonFeature>& polygon_features;
+    std::unordered_map<std::string_view, std::vector<size_t>>& features_by_exact_id;
+    const std::vector<BooleanMethod>& methods;
+    std::chrono::milliseconds boolean_budget;
+    // Empty unless --isolate-booleans.
+    std::string worker_executable_path;
+    // Null unless the method is auto. Jobs rank with their own copy, so the
+    // observations of concurrent jobs never race.
+    const BackendCostModel* cost_model;
+    // Null unless --max-memory.
+    MemoryBudget* memory_budget;
+    const std::vector<std::string>& lods;
+    std::string_view mesh_lod;
+    SourceAttributeTarget source_attribute_target;
+    bool ignore_holes;
+    std::ostream& log_out;
+
+    std::atomic<size_t> job_count{0};
+    // Worker processes between jobs, at most one per job slot; a job takes a
+    // warm one instead of starting its own.
+    std::mutex worker_mutex;
+    std::vector<std::unique_ptr<BooleanWorker>> idle_workers;
+};
+
+// One --serve job: the request line is a server-side .fcb path, the response
+// is "OK\n" followed by the carved FlatCityBuf stream, or one "ERROR ...\n"
+// line. A failure after "OK" ends the stream early.
+static void run_carve_job(CarveService& service, int fd, const std::string& model_path) {
+    const size_t job_id = ++service.job_count;
+    auto t_job_start = Clock::now();
+    if (!is_fcb_path(model_path)) {
+        write_all(fd, "ERROR model input must be a .fcb file\n");
+        return;
+    }
+    ZfcbReaderHandle fcb = zfcb_reader_open(model_path.c_str());
+    if (fcb == nullptr) {
+        write_all(fd, std::format("ERROR failed to open FlatCityBuf stream: {}\n", model_path));
+        return;
+    }
+    if (!write_all(fd, "OK\n")) {
+        zfcb_reader_destroy(fcb);
+        return;
+    }
+
+    std::unique_ptr<BooleanWorker> boolean_worker;
+    if (!service.worker_executable_path.empty()) {
+        std::lock_guard<std::mutex> lock(service.worker_mutex);
+        if (service.idle_workers.empty()) {
+            boolean_worker = std::make_unique<BooleanWorker>(service.worker_executable_path);
+        } else {
+            boolean_worker = std::move(service.idle_workers.back());
+            service.idle_workers.pop_back();
+        }
+    }
+    std::unique_ptr<BackendCostModel> cost_model;
+    if (service.cost_model != nullptr) {
+        cost_model = std::make_unique<BackendCostModel>(*service.cost_model);
+    }
+
+    std::vector<bool> seen_feature(service.polygon_features.size(), false);
+    const std::string feature_source_filename = source_filename_from_path(model_path);
+    bool global_offset_set = false;
+    double global_offset_x = 0.0;
+    double global_offset_y = 0.0;
+    double global_offset_z = 0.0;
+    size_t processed_count = 0;
+    size_t skipped_count = 0;
+    std::chrono::duration<double, std::milli> ds_conversion_ms{0.0};
+    std::chrono::duration<double, std::milli> intersection_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_changed_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_polygonal_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_weld_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_passthrough_ms{0.0};
+    std::chrono::duration<double, std::milli> model_stream_read_ms{0.0};
+    VertexWeldStats output_weld_totals;
+    RunMetrics run_metrics;
+    BooleanMeshWriter boolean_mesh_writer;
+    StreamProcessingContext stream_ctx{
+        .polygon_features = service.polygon_features,
+        .features_by_exact_id = service.features_by_exact_id,
+        .seen_feature = seen_feature,
+        .feature_source_filename = feature_source_filename,
+        .methods = service.methods,
+        .boolean_budget = service.boolean_budget,
+        .boolean_worker = boolean_worker.get(),
+        .cost_model = cost_model.get(),
+        .source_attribute_target = service.source_attribute_target,
+        .ignore_holes = service.ignore_holes,
+        .global_offset_set = global_offset_set,
+        .global_offset_x = global_offset_x,
+        .global_offset_y = global_offset_y,
+        .global_offset_z = global_offset_z,
+        .processed_count = processed_count,
+        .skipped_count = skipped_count,
+        .ds_conversion_ms = ds_conversion_ms,
+        .intersection_ms = intersection_ms,
+        .output_write_ms = output_write_ms,
+        .output_write_changed_ms = output_write_changed_ms,
+        .output_write_polygonal_ms = output_write_polygonal_ms,
+        .output_write_weld_ms = output_write_weld_ms,
+        .output_write_passthrough_ms = output_write_passthrough_ms,
+        .model_stream_read_ms = model_stream_read_ms,
+        .output_weld_totals = output_weld_totals,
+        .run_metrics = run_metrics,
+        .boolean_mesh_writer = boolean_mesh_writer,
+        .log_out = service.log_out,
+        .memory_budget = service.memory_budget,
+        .lods = service.lods,
+    };
+    FcbStreamBackend backend{
+        .reader = fcb,
+        .writer = nullptr,
+        .output_to_stdout = false,
+        .output_path = "client socket",
+        .output_fd = fd,
+        .mesh_lod = service.mesh_lod,
+    };
+    const bool stream_ok = process_stream_features(backend, stream_ctx);
+    zfcb_reader_destroy(fcb);
+
+    if (boolean_worker != nullptr) {
+        std::lock_guard<std::mutex> lock(service.worker_mutex);
+        service.idle_workers.push_back(std::move(boolean_worker));
+    }
+    service.log_out << std::format(
+        "Job {} ({}): processed underpasses: {}, skipped: {}, {:.3f} ms{}",
+        job_id, model_path, processed_count, skipped_count,
+        std::chrono::duration<double, std::milli>(Clock::now() - t_job_start).count(),
+        stream_ok ? "" : " (stream error)") << std::endl;
+}
+
+enum class OptionMatch {
+    None,
+    Value,
+    MissingValue,
+};
+
+// Matches `name value` or `name=value` at argv[i]; a separate value advances i.
+static OptionMatch match_value_option(std::string_view name, int& i, int argc, char* argv[], std::string& value) {
+    const std::string_view arg(argv[i]);
+    if (arg.size() > name.size() && arg.starts_with(name) && arg[name.size()] == '=') {
+        value = std::string(arg.substr(name.size() + 1));
+        return OptionMatch::Value;
+    }
+    if (arg != name) {
+        return OptionMatch::None;
+    }
+    if (i + 1 >= argc) {
+        return OptionMatch::MissingValue;
+    }
+    value = argv[++i];
+    return OptionMatch::Value;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc > 1 && argv[1] == kBooleanWorkerFlag) {
+        return run_boolean_worker(argc, argv);
+    }
     auto t_program_start = Clock::now();
 
-    if (argc < 5) {
+    // `--name value` / `--name=value` options may appear anywhere; the
+    // remaining arguments are positional.
+    std::string trace_path;
+    std::string metrics_path;
+    std::string budget_str;
+    std::string cost_model_path;
+    std::string cost_model_out_path;
+    std::string serve_socket_path;
+    std::string max_jobs_str;
+    std::string jobs_str;
+    std::string shard_str;
+    std::string checkpoint_path;
+    std::string checkpoint_every_str;
+    std::string max_memory_str;
+    std::string lods_str;
+    bool isolate_booleans = false;
+    bool shard_only = false;
+    bool resume = false;
+    std::vector<char*> positional_args{argv[0]};
+    for (int i = 1; i < argc; ++i) {
+        if (std::string_view(argv[i]) == "--isolate-booleans") {
+            isolate_booleans = true;
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--shard-only") {
+            shard_only = true;
+            continue;
+        }
+        if (std::string_view(argv[i]) == "--resume") {
+            resume = true;
+            continue;
+        }
+        OptionMatch match = match_value_option("--trace", i, argc, argv, trace_path);
+        if (match == OptionMatch::None) {
+            match = match_value_option("--metrics", i, argc, argv, metrics_path);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--budget-ms", i, argc, argv, budget_str);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--cost-model-out", i, argc, argv, cost_model_out_path);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--cost-model", i, argc, argv, cost_model_path);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--serve", i, argc, argv, serve_socket_path);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--max-jobs", i, argc, argv, max_jobs_str);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--jobs", i, argc, argv, jobs_str);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--max-memory", i, argc, argv, max_memory_str);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--lods", i, argc, argv, lods_str);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--shard", i, argc, argv, shard_str);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--checkpoint-every", i, argc, argv, checkpoint_every_str);
+        }
+        if (match == OptionMatch::None) {
+            match = match_value_option("--checkpoint", i, argc, argv, checkpoint_path);
+        }
+        if (match == OptionMatch::MissingValue) {
+            std::cerr << argv[i] << " requires a value" << std::endl;
+            return 1;
+        }
+        if (match == OptionMatch::None) {
+            positional_args.push_back(argv[i]);
+        }
+    }
+    argc = static_cast<int>(positional_args.size());
+    positional_args.push_back(nullptr);
+    argv = positional_args.data();
+
+    // --serve takes the model paths from its jobs, so its positional
+    // arguments continue with the elevation attribute.
+    const bool serve = !serve_socket_path.empty();
+    const int attribute_arg = serve ? 2 : 4;
+    if (argc <= attribute_arg) {
         std::cerr << "Usage: " << argv[0]
-                  << " <ogr_source> <model_input> <model_output> <absolute_underpass_elevation_attribute> [id_attribute] [method] [copy_source_attributes] [boolean_obj_output]" << std::endl;
-        std::cerr << "  model formats: .fcb (FlatCityBuf) or .jsonl (CityJSONSeq)" << std::endl;
+                  << " <ogr_source> <model_input> <model_output> <absolute_underpass_elevation_attribute> [id_attribute] [method] [copy_source_attributes] [boolean_mesh_output] [--trace trace.json] [--metrics metrics.json] [--budget-ms ms] [--isolate-booleans] [--cost-model table.csv] [--cost-model-out table.csv] [--shard i/n [--shard-only]] [--checkpoint state.txt [--checkpoint-every n] [--resume]] [--lods 1.2,1.3,2.2] [--jobs n] [--max-memory bytes]" << std::endl;
+        std::cerr << "       " << argv[0]
+                  << " --serve <socket> [--max-jobs n] [--max-memory bytes] <ogr_source> <absolute_underpass_elevation_attribute> [id_attribute] [method] [copy_source_attributes] [--trace trace.json] [--budget-ms ms] [--isolate-booleans] [--cost-model table.csv] [--lods 1.2,1.3,2.2]" << std::endl;
+        std::cerr << "  model formats: .fcb (FlatCityBuf), .jsonl/.jsonl.zst/.jsonl.gz (CityJSONSeq) or .city.json (CityJSON tile)" << std::endl;
         std::cerr << "  id_attribute default: identificatie" << std::endl;
         std::cerr << "  missing absolute underpass elevation falls back to 2.5 m above the local ground reference" << std::endl;
         std::cerr << "  method: pmp (default), manifold, nef"
 #ifdef ENABLE_GEOGRAM
                   << ", geogram"
 #endif
-                  << std::endl;
+                  << ", a fallback chain such as manifold,pmp,nef, or auto" << std::endl;
+        std::cerr << "  auto: rank all backends per building with a cost model (triangle count, val3dity status," << std::endl;
+        std::cerr << "    manifoldness, ceiling/roof coplanarity) and use them as the fallback chain" << std::endl;
         std::cerr << "  copy_source_attributes: none (default), feature, parent, surface (CityJSONSeq only)" << std::endl;
-        std::cerr << "  boolean_obj_output: optional OBJ file containing all meshes directly after boolean operations" << std::endl;
+        std::cerr << "  boolean_mesh_output: optional .obj, .ply or .glb file containing all meshes directly after boolean operations" << std::endl;
+        std::cerr << "  --trace: write per-feature spans as Chrome trace JSON (open in ui.perfetto.dev)" << std::endl;
+        std::cerr << "  --budget-ms: wall-clock budget per boolean attempt; slower attempts fall back to the next method." << std::endl;
+        std::cerr << "    In-process it is checked between boolean phases, so one Nef or Manifold operation can overrun it;" << std::endl;
+        std::cerr << "    only --isolate-booleans enforces it (the worker is killed)" << std::endl;
+        std::cerr << "  --cost-model: load the auto cost table (as written by --cost-model-out or the benchmark)" << std::endl;
+        std::cerr << "  --cost-model-out: write the auto cost table updated with this run's boolean timings and failures" << std::endl;
+        std::cerr << "  --isolate-booleans: run booleans in a worker process; a crash skips the feature and the worker is restarted" << std::endl;
+        std::cerr << "  --metrics: write run metrics (timings, skip reasons, mesh totals, peak RSS, carve latency) as JSON" << std::endl;
+        std::cerr << "  --serve: keep the OGR layer loaded and carve .fcb tiles for clients of a Unix socket; a job sends" << std::endl;
+        std::cerr << "    the tile path as one line and receives 'OK' and the carved FCB stream, 'ERROR ...' or 'BUSY n'" << std::endl;
+        std::cerr << "  --max-jobs: jobs --serve runs at once (default 1); further clients get 'BUSY n'" << std::endl;
+        std::cerr << "  --jobs: threads carving the features of a .city.json tile (default: one per core); the tile is" << std::endl;
+        std::cerr << "    loaded once, carved in memory and saved once" << std::endl;
+        std::cerr << "  --max-memory: memory budget (e.g. 16G) for the booleans of concurrent --serve jobs or --jobs threads; attempts wait" << std::endl;
+        std::cerr << "    until their estimated peak fits, and one estimated above the budget runs alone" << std::endl;
+        std::cerr << "  --shard i/n: carve only features whose id hashes to shard i of n and pass the others through;" << std::endl;
+        std::cerr << "    --shard-only drops them instead. Combine the shard outputs with fcb_merge" << std::endl;
+        std::cerr << "  --checkpoint: save the run state every --checkpoint-every model features (default 1000;" << std::endl;
+        std::cerr << "    FCB files only); --resume continues an interrupted run from it, or starts over without one" << std::endl;
+        std::cerr << "  --lods: solid LoDs to carve (default 2.2); each is carved with the same underpass extrusions" << std::endl;
+        std::cerr << "    and all are replaced in one write of the feature (FCB only unless just 2.2)" << std::endl;
         std::cerr << "  use '-' as input to read FCB from stdin" << std::endl;
         std::cerr << "  use '-' as output to write FCB to stdout" << std::endl;
-        std::cerr << "  CityJSONSeq stdin/stdout piping is not supported yet" << std::endl;
+        std::cerr << "  use '-.jsonl' to pipe CityJSONSeq (stdin compression is auto-detected;" << std::endl;
+        std::cerr << "  '-.jsonl.zst' or '-.jsonl.gz' as output compresses stdout)" << std::endl;
         return 1;
     }
 
     const char* ogr_source_path = argv[1];
-    const char* model_path = argv[2];
-    const char* output_path = argv[3];
-    std::string height_attribute = argv[4];
-    std::string id_attribute = argc > 5 ? argv[5] : "identificatie";
-    std::string method_str = argc > 6 ? argv[6] : "pmp";
-    std::string copy_source_attributes_str = argc > 7 ? argv[7] : "none";
-    std::string boolean_obj_output = argc > 8 ? argv[8] : "";
-    const bool model_from_stdin = std::string_view(model_path) == "-";
-    const bool output_to_stdout = std::string_view(output_path) == "-";
+    const char* model_path = serve ? "" : argv[2];
+    const char* output_path = serve ? "" : argv[3];
+    std::string height_attribute = argv[attribute_arg];
+    std::string id_attribute = argc > attribute_arg + 1 ? argv[attribute_arg + 1] : "identificatie";
+    std::string method_str = argc > attribute_arg + 2 ? argv[attribute_arg + 2] : "pmp";
+    std::string copy_source_attributes_str = argc > attribute_arg + 3 ? argv[attribute_arg + 3] : "none";
+    std::string boolean_mesh_output = argc > attribute_arg + 4 ? argv[attribute_arg + 4] : "";
+    const bool model_from_stdin = is_stdio_path(model_path);
+    const bool output_to_stdout = is_stdio_path(output_path);
+    const bool model_is_cityjson = !serve && is_cityjson_path(model_path);
     std::ostream& log_out = output_to_stdout ? static_cast<std::ostream&>(std::cerr) : static_cast<std::ostream&>(std::cout);
 
-    BooleanMethod method = BooleanMethod::Manifold;
-    if (method_str == "nef") {
-        method = BooleanMethod::CgalNef;
-    } else if (method_str == "pmp") {
-        method = BooleanMethod::CgalPMP;
+    // A comma-separated method is a fallback chain, tried in order per feature.
+    // `auto` leaves the chain to the cost model.
+    const bool auto_method = method_str == "auto";
+    std::vector<BooleanMethod> methods;
+    for (std::string_view remaining(auto_method ? std::string_view{} : method_str); !remaining.empty();) {
+        const size_t comma = remaining.find(',');
+        const std::string_view name = remaining.substr(0, comma);
+        remaining = comma == std::string_view::npos ? std::string_view{} : remaining.substr(comma + 1);
+        BooleanMethod method = BooleanMethod::Manifold;
+        if (name == "nef") {
+            method = BooleanMethod::CgalNef;
+        } else if (name == "pmp") {
+            method = BooleanMethod::CgalPMP;
 #ifdef ENABLE_GEOGRAM
-    } else if (method_str == "geogram") {
-        method = BooleanMethod::Geogram;
+        } else if (name == "geogram") {
+            method = BooleanMethod::Geogram;
 #endif
-    } else if (method_str != "manifold") {
-        std::cerr << "Unknown method: " << method_str << " (use manifold, nef, pmp"
+        } else if (name != "manifold") {
+            std::cerr << "Unknown method: " << name << " (use manifold, nef, pmp"
 #ifdef ENABLE_GEOGRAM
-                  << ", geogram"
+                      << ", geogram"
 #endif
-                  << ")" << std::endl;
+                      << ", a comma-separated chain of them, or auto)" << std::endl;
+            return 1;
+        }
+        methods.push_back(method);
+    }
+    if (methods.empty() && !auto_method) {
+        std::cerr << "Empty method" << std::endl;
+        return 1;
+    }
+    std::unique_ptr<BackendCostModel> cost_model;
+    if (auto_method) {
+        cost_model = std::make_unique<BackendCostModel>();
+        std::string error;
+        if (!cost_model_path.empty() && !cost_model->load_csv(cost_model_path, error)) {
+            std::cerr << "Failed to load cost model " << cost_model_path << ": " << error << std::endl;
+            return 1;
+        }
+    } else if (!cost_model_path.empty() || !cost_model_out_path.empty()) {
+        std::cerr << "--cost-model and --cost-model-out require method auto" << std::endl;
         return 1;
     }
 
+    std::chrono::milliseconds boolean_budget{0};
+    if (!budget_str.empty()) {
+        int64_t budget_ms = 0;
+        const auto parsed = std::from_chars(budget_str.data(), budget_str.data() + budget_str.size(), budget_ms);
+        if (parsed.ec != std::errc{} || parsed.ptr != budget_str.data() + budget_str.size() || budget_ms < 0) {
+            std::cerr << "Invalid --budget-ms: " << budget_str << " (use a non-negative number of milliseconds)" << std::endl;
+            return 1;
+        }
+        boolean_budget = std::chrono::milliseconds(budget_ms);
+        if (boolean_budget.count() > 0 && !isolate_booleans) {
+            log_out << "Warning: without --isolate-booleans, --budget-ms is only checked between boolean phases;"
+                       " a single Nef or Manifold operation can run past it" << std::endl;
+        }
+    }
+    // --serve keeps a worker per job slot instead.
+    std::unique_ptr<BooleanWorker> boolean_worker;
+    if (isolate_booleans && !serve) {
+        boolean_worker = std::make_unique<BooleanWorker>(current_executable_path(argv[0]));
+    }
+
     SourceAttributeTarget source_attribute_target = SourceAttributeTarget::None;
     if (copy_source_attributes_str == "feature") {
         source_attribute_target = SourceAttributeTarget::Feature;
@@ -1348,33 +2576,210 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    BooleanObjWriter boolean_obj_writer;
-    if (!boolean_obj_output.empty()) {
-        if (boolean_obj_output == model_path || boolean_obj_output == output_path) {
-            std::cerr << "Boolean OBJ output must differ from the model input and primary output paths" << std::endl;
+    size_t max_jobs = 1;
+    if (!max_jobs_str.empty()) {
+        const auto parsed = std::from_chars(max_jobs_str.data(), max_jobs_str.data() + max_jobs_str.size(), max_jobs);
+        if (!serve || parsed.ec != std::errc{} || parsed.ptr != max_jobs_str.data() + max_jobs_str.size() ||
+            max_jobs == 0) {
+            std::cerr << "Invalid --max-jobs: " << max_jobs_str << " (use a positive number with --serve)" << std::endl;
             return 1;
         }
-        if (!boolean_obj_writer.open(boolean_obj_output)) {
-            std::cerr << "Failed to open boolean OBJ output: " << boolean_obj_output << std::endl;
+    }
+    size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    if (!jobs_str.empty()) {
+        const auto parsed = std::from_chars(jobs_str.data(), jobs_str.data() + jobs_str.size(), jobs);
+        if (!model_is_cityjson || parsed.ec != std::errc{} || parsed.ptr != jobs_str.data() + jobs_str.size() ||
+            jobs == 0) {
+            std::cerr << "Invalid --jobs: " << jobs_str << " (use a positive number with a .city.json model)" << std::endl;
             return 1;
         }
     }
+    std::unique_ptr<MemoryBudget> memory_budget;
+    if (!max_memory_str.empty()) {
+        size_t max_memory_bytes = 0;
+        if ((!serve && !model_is_cityjson) || !parse_memory_size(max_memory_str, max_memory_bytes)) {
+            std::cerr << "Invalid --max-memory: " << max_memory_str
+                      << " (use a size such as 16G with --serve or a .city.json model)" << std::endl;
+            return 1;
+        }
+        memory_budget = std::make_unique<MemoryBudget>(max_memory_bytes);
+    }
+    // A feature is carved only when every listed LoD carves; otherwise it
+    // passes through unchanged.
+    std::vector<std::string> lods{std::string(kDefaultSolidLod)};
+    if (!lods_str.empty()) {
+        lods.clear();
+        for (std::string_view remaining(lods_str);;) {
+            const size_t comma = remaining.find(',');
+            const std::string_view lod = remaining.substr(0, comma);
+            if (lod.empty() || std::find(lods.begin(), lods.end(), lod) != lods.end()) {
+                std::cerr << "Invalid --lods: " << lods_str << " (use distinct LoDs such as 1.2,1.3,2.2)" << std::endl;
+                return 1;
+            }
+            lods.emplace_back(lod);
+            if (comma == std::string_view::npos) {
+                break;
+            }
+            remaining.remove_prefix(comma + 1);
+        }
+    }
+    const bool lod22_only = lods.size() == 1 && lods.front() == kDefaultSolidLod;
+    // The FCB reader decodes the one LoD carved, or every LoD for several.
+    const std::string_view mesh_lod = lods.size() == 1 ? std::string_view(lods.front()) : std::string_view{};
+    if (!lod22_only && !boolean_mesh_output.empty()) {
+        std::cerr << "--lods other than 2.2 does not support boolean_mesh_output" << std::endl;
+        return 1;
+    }
+    ShardSpec shard;
+    if (!shard_str.empty() && !parse_shard_spec(shard_str, shard)) {
+        std::cerr << "Invalid --shard: " << shard_str << " (use i/n with 0 <= i < n)" << std::endl;
+        return 1;
+    }
+    if (shard_only && shard_str.empty()) {
+        std::cerr << "--shard-only requires --shard" << std::endl;
+        return 1;
+    }
+    // The header's feature count is corrected once the output is closed, which
+    // needs a seekable file.
+    if (shard_only && output_to_stdout) {
+        std::cerr << "--shard-only requires an output file (not stdout)" << std::endl;
+        return 1;
+    }
+    size_t checkpoint_every = 1000;
+    if (!checkpoint_every_str.empty()) {
+        const auto parsed = std::from_chars(
+            checkpoint_every_str.data(), checkpoint_every_str.data() + checkpoint_every_str.size(), checkpoint_every);
+        if (parsed.ec != std::errc{} || parsed.ptr != checkpoint_every_str.data() + checkpoint_every_str.size() ||
+            checkpoint_every == 0) {
+            std::cerr << "Invalid --checkpoint-every: " << checkpoint_every_str << " (use a positive number of features)" << std::endl;
+            return 1;
+        }
+    }
+    if ((resume || !checkpoint_every_str.empty()) && checkpoint_path.empty()) {
+        std::cerr << "--resume and --checkpoint-every require --checkpoint" << std::endl;
+        return 1;
+    }
+    // The boolean mesh output is not resumable, so it would lose the meshes
+    // of the features before the checkpoint.
+    if (!checkpoint_path.empty() && !boolean_mesh_output.empty()) {
+        std::cerr << "--checkpoint does not support boolean_mesh_output" << std::endl;
+        return 1;
+    }
+    if (serve) {
+        if (!boolean_mesh_output.empty() || !metrics_path.empty() || !cost_model_out_path.empty() ||
+            !shard_str.empty() || !checkpoint_path.empty()) {
+            std::cerr << "--serve does not support boolean_mesh_output, --metrics, --cost-model-out, --shard or --checkpoint"
+                      << std::endl;
+            return 1;
+        }
+        if (source_attribute_target == SourceAttributeTarget::SemanticSurface) {
+            std::cerr << "copy_source_attributes=surface is supported only for CityJSONSeq input/output" << std::endl;
+            return 1;
+        }
+#ifdef ENABLE_GEOGRAM
+        // Geogram keeps process-wide state; worker processes keep jobs apart.
+        const bool uses_geogram = auto_method ||
+            std::find(methods.begin(), methods.end(), BooleanMethod::Geogram) != methods.end();
+        if (uses_geogram && max_jobs > 1 && !isolate_booleans) {
+            std::cerr << "--max-jobs above 1 with geogram requires --isolate-booleans" << std::endl;
+            return 1;
+        }
+#endif
+    }
 
-    const bool model_is_fcb = model_from_stdin || is_fcb_path(model_path);
-    const bool model_is_cityjsonseq = !model_from_stdin && is_cityjsonseq_path(model_path);
-    const bool output_is_fcb = output_to_stdout || is_fcb_path(output_path);
-    const bool output_is_cityjsonseq = !output_to_stdout && is_cityjsonseq_path(output_path);
-
-    if (!model_is_fcb && !model_is_cityjsonseq) {
-        std::cerr << "Unsupported input model format. Use .fcb or .jsonl" << std::endl;
+    BooleanMeshWriter boolean_mesh_writer;
+    if (!boolean_mesh_output.empty()) {
+        if (boolean_mesh_output == model_path || boolean_mesh_output == output_path) {
+            std::cerr << "Boolean mesh output must differ from the model input and primary output paths" << std::endl;
+            return 1;
+        }
+        if (!boolean_mesh_writer.open(boolean_mesh_output)) {
+            std::cerr << "Failed to open boolean mesh output: " << boolean_mesh_output << std::endl;
+            return 1;
+        }
+    }
+    if (!metrics_path.empty() &&
+        (metrics_path == model_path || metrics_path == output_path || metrics_path == boolean_mesh_output)) {
+        std::cerr << "Metrics output must differ from the model and boolean mesh paths" << std::endl;
         return 1;
     }
-    if (model_is_cityjsonseq && model_from_stdin) {
-        std::cerr << "CityJSONSeq stdin input is not supported yet" << std::endl;
+    if (!cost_model_out_path.empty() &&
+        (cost_model_out_path == model_path || cost_model_out_path == output_path ||
+         cost_model_out_path == boolean_mesh_output || cost_model_out_path == metrics_path)) {
+        std::cerr << "Cost model output must differ from the model, boolean mesh and metrics paths" << std::endl;
         return 1;
     }
-    if (model_is_cityjsonseq && output_to_stdout) {
-        std::cerr << "CityJSONSeq stdout output is not supported yet" << std::endl;
+    if (!trace_path.empty()) {
+        if (trace_path == model_path || trace_path == output_path || trace_path == boolean_mesh_output ||
+            trace_path == metrics_path || trace_path == cost_model_out_path) {
+            std::cerr << "Trace output must differ from the model and boolean mesh paths" << std::endl;
+            return 1;
+        }
+        if (!trace::start(trace_path)) {
+            std::cerr << "Failed to open trace output: " << trace_path << std::endl;
+            return 1;
+        }
+    }
+
+    if (serve) {
+        ogr::VectorReader reader;
+        auto t_ogr_read_start = Clock::now();
+        reader.open(ogr_source_path);
+        const auto polygon_features = reader.read_polygon_features(id_attribute, height_attribute);
+        std::unordered_map<std::string_view, std::vector<size_t>> features_by_exact_id;
+        size_t empty_id_count = 0;
+        for (size_t i = 0; i < polygon_features.size(); ++i) {
+            if (polygon_features[i].id.empty()) {
+                ++empty_id_count;
+                continue;
+            }
+            features_by_exact_id[std::string_view(polygon_features[i].id)].push_back(i);
+        }
+        log_out << std::format(
+            "Read {} OGR features in {:.3f} ms ({} with an empty id attribute '{}' are ignored)",
+            polygon_features.size(),
+            std::chrono::duration<double, std::milli>(Clock::now() - t_ogr_read_start).count(),
+            empty_id_count,
+            id_attribute) << std::endl;
+
+        CarveService service{
+            .polygon_features = polygon_features,
+            .features_by_exact_id = features_by_exact_id,
+            .methods = methods,
+            .boolean_budget = boolean_budget,
+            .worker_executable_path = isolate_booleans ? current_executable_path(argv[0]) : std::string{},
+            .cost_model = cost_model.get(),
+            .memory_budget = memory_budget.get(),
+            .lods = lods,
+            .mesh_lod = mesh_lod,
+            .source_attribute_target = source_attribute_target,
+            .ignore_holes = false,
+            .log_out = log_out,
+        };
+        const bool served = run_carve_server(
+            CarveServerOptions{.socket_path = serve_socket_path, .max_jobs = max_jobs},
+            [&service](int fd, const std::string& request) { run_carve_job(service, fd, request); },
+            log_out);
+        if (memory_budget != nullptr) {
+            log_out << std::format(
+                "Memory budget {} MiB: at most {} MiB reserved at once, {} boolean attempt(s) ran alone",
+                memory_budget->budget_bytes() >> 20,
+                memory_budget->peak_reserved_bytes() >> 20,
+                memory_budget->serialized_count()) << std::endl;
+        }
+        if (!trace::finish()) {
+            std::cerr << "Failed to write trace output: " << trace_path << std::endl;
+        }
+        return served ? 0 : 1;
+    }
+
+    const bool model_is_fcb = std::string_view(model_path) == "-" || is_fcb_path(model_path);
+    const bool model_is_cityjsonseq = is_cityjsonseq_path(model_path);
+    const bool output_is_fcb = std::string_view(output_path) == "-" || is_fcb_path(output_path);
+    const bool output_is_cityjsonseq = is_cityjsonseq_path(output_path);
+
+    if (!model_is_fcb && !model_is_cityjsonseq && !model_is_cityjson) {
+        std::cerr << "Unsupported input model format. Use .fcb, .jsonl, .jsonl.zst, .jsonl.gz or .city.json" << std::endl;
         return 1;
     }
     if (model_is_fcb && !output_is_fcb) {
@@ -1382,16 +2787,55 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     if (model_is_cityjsonseq && !output_is_cityjsonseq) {
-        std::cerr << "CityJSONSeq input currently requires CityJSONSeq (.jsonl) output" << std::endl;
+        std::cerr << "CityJSONSeq input currently requires CityJSONSeq (.jsonl[.zst|.gz]) output" << std::endl;
         return 1;
     }
+    if (model_is_cityjson) {
+        if (!is_cityjson_path(output_path) || model_from_stdin || output_to_stdout) {
+            std::cerr << "CityJSON input requires a CityJSON (.city.json) output file (not stdin/stdout)" << std::endl;
+            return 1;
+        }
+        // Other shards' objects pass through; dropping them is not supported.
+        if (shard_only) {
+            std::cerr << "--shard-only is not supported for CityJSON input" << std::endl;
+            return 1;
+        }
+        // Threads after the first rank with their own copy of the cost model.
+        if (!cost_model_out_path.empty() && jobs > 1) {
+            std::cerr << "--cost-model-out with CityJSON input requires --jobs 1" << std::endl;
+            return 1;
+        }
+#ifdef ENABLE_GEOGRAM
+        const bool uses_geogram = auto_method ||
+            std::find(methods.begin(), methods.end(), BooleanMethod::Geogram) != methods.end();
+        if (uses_geogram && jobs > 1 && !isolate_booleans) {
+            std::cerr << "--jobs above 1 with geogram requires --isolate-booleans" << std::endl;
+            return 1;
+        }
+#endif
+    }
     if (source_attribute_target == SourceAttributeTarget::SemanticSurface && !model_is_cityjsonseq) {
         std::cerr << "copy_source_attributes=surface is supported only for CityJSONSeq input/output" << std::endl;
         return 1;
     }
+    if (!lod22_only && !model_is_fcb) {
+        std::cerr << "--lods other than 2.2 requires FCB input/output" << std::endl;
+        return 1;
+    }
+    if (!checkpoint_path.empty()) {
+        if (!model_is_fcb || model_from_stdin || output_to_stdout) {
+            std::cerr << "--checkpoint requires FCB file input and output (not stdin/stdout)" << std::endl;
+            return 1;
+        }
+        if (checkpoint_path == model_path || checkpoint_path == output_path || checkpoint_path == metrics_path) {
+            std::cerr << "Checkpoint path must differ from the model, output and metrics paths" << std::endl;
+            return 1;
+        }
+    }
 
     ZfcbReaderHandle fcb = nullptr;
     CityJSONSeqReaderHandle cjseq_reader = nullptr;
+    CityJSONTileHandle cj_tile = nullptr;
 
     auto t_model_read_start = Clock::now();
     if (model_is_fcb) {
@@ -1404,10 +2848,20 @@ int main(int argc, char* argv[]) {
             std::cerr << "Failed to open FlatCityBuf stream: " << (model_from_stdin ? "stdin" : model_path) << std::endl;
             return 1;
         }
+    } else if (model_is_cityjson) {
+        cj_tile = cityjson_tile_open(model_path);
+        if (cj_tile == nullptr) {
+            std::cerr << "Failed to open CityJSON tile: " << model_path << std::endl;
+            return 1;
+        }
     } else {
-        cjseq_reader = cityjsonseq_reader_open(model_path);
+        if (model_from_stdin) {
+            cjseq_reader = cityjsonseq_reader_open_fd(stdin_fd(), 0);
+        } else {
+            cjseq_reader = cityjsonseq_reader_open(model_path);
+        }
         if (cjseq_reader == nullptr) {
-            std::cerr << "Failed to open CityJSONSeq stream: " << model_path << std::endl;
+            std::cerr << "Failed to open CityJSONSeq stream: " << (model_from_stdin ? "stdin" : model_path) << std::endl;
             return 1;
         }
     }
@@ -1417,11 +2871,16 @@ int main(int argc, char* argv[]) {
     double model_extent_max[3] = {0.0, 0.0, 0.0};
     int extent_result = model_is_fcb
         ? zfcb_reader_header_geographical_extent(fcb, model_extent_min, model_extent_max)
+        : model_is_cityjson
+        ? cityjson_tile_geographical_extent(cj_tile, model_extent_min, model_extent_max)
         : cityjsonseq_reader_header_geographical_extent(cjseq_reader, model_extent_min, model_extent_max);
     if (extent_result < 0) {
         if (model_is_fcb) {
             std::cerr << "Failed to read FlatCityBuf header geographical_extent; cannot apply OGR extent filter" << std::endl;
             zfcb_reader_destroy(fcb);
+        } else if (model_is_cityjson) {
+            std::cerr << "Failed to read CityJSON metadata geographicalExtent; cannot apply OGR extent filter" << std::endl;
+            cityjson_tile_destroy(cj_tile);
         } else {
             std::cerr << "Failed to read CityJSONSeq header geographical_extent; cannot apply OGR extent filter" << std::endl;
             cityjsonseq_reader_destroy(cjseq_reader);
@@ -1450,9 +2909,9 @@ int main(int argc, char* argv[]) {
     log_out << std::format(
         "Model input: {} ({})",
         model_from_stdin ? "stdin" : model_path,
-        model_is_fcb ? "FlatCityBuf stream" : "CityJSONSeq stream") << std::endl;
-    if (!boolean_obj_output.empty()) {
-        log_out << std::format("Boolean OBJ output: {}", boolean_obj_output) << std::endl;
+        model_is_fcb ? "FlatCityBuf stream" : model_is_cityjson ? "CityJSON tile" : "CityJSONSeq stream") << std::endl;
+    if (!boolean_mesh_output.empty()) {
+        log_out << std::format("Boolean mesh output: {}", boolean_mesh_output) << std::endl;
     }
 
     bool ignore_holes = false;
@@ -1466,31 +2925,83 @@ int main(int argc, char* argv[]) {
     std::chrono::duration<double, std::milli> intersection_ms{0.0};
     std::chrono::duration<double, std::milli> output_write_ms{0.0};
     std::chrono::duration<double, std::milli> output_write_changed_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_polygonal_ms{0.0};
+    std::chrono::duration<double, std::milli> output_write_weld_ms{0.0};
     std::chrono::duration<double, std::milli> output_write_passthrough_ms{0.0};
     std::chrono::duration<double, std::milli> model_stream_read_ms{0.0};
+    VertexWeldStats output_weld_totals;
+    RunMetrics run_metrics;
     std::string feature_source_filename = source_filename_from_path(model_path);
 
     std::unordered_map<std::string_view, std::vector<size_t>> features_by_exact_id;
     std::vector<size_t> valid_feature_indices;
     std::vector<bool> seen_feature(polygon_features.size(), false);
+    size_t other_shard_count = 0;
     for (size_t i = 0; i < polygon_features.size(); ++i) {
         const auto& feature = polygon_features[i];
         if (feature.id.empty()) {
             std::cerr << std::format("Skipping feature {}: empty id attribute '{}'", i, id_attribute) << std::endl;
             ++skipped_count;
+            run_metrics.skipped.add(SkipReason::EmptyId);
             continue;
         }
         std::string_view exact_id(feature.id);
+        // Another shard carves it; it is neither processed nor reported here.
+        if (!shard.owns(exact_id)) {
+            ++other_shard_count;
+            continue;
+        }
         features_by_exact_id[exact_id].push_back(i);
         valid_feature_indices.push_back(i);
     }
 
+    RunCheckpoint checkpoint{.model_path = model_path, .output_path = output_path};
+    bool resuming = false;
+    std::error_code checkpoint_exists_error;
+    if (resume && std::filesystem::exists(checkpoint_path, checkpoint_exists_error)) {
+        RunCheckpoint saved;
+        std::string error;
+        if (!read_checkpoint(checkpoint_path, saved, error)) {
+            std::cerr << std::format("Failed to read checkpoint {}: {}", checkpoint_path, error) << std::endl;
+            zfcb_reader_destroy(fcb);
+            return 1;
+        }
+        // The bitmap size stands in for the OGR source, filter and attributes.
+        if (saved.model_path != checkpoint.model_path || saved.output_path != checkpoint.output_path ||
+            saved.seen_feature.size() != seen_feature.size()) {
+            std::cerr << std::format(
+                "Checkpoint {} belongs to another run ({} -> {}, {} OGR features)",
+                checkpoint_path, saved.model_path, saved.output_path, saved.seen_feature.size()) << std::endl;
+            zfcb_reader_destroy(fcb);
+            return 1;
+        }
+        checkpoint = std::move(saved);
+        processed_count = checkpoint.processed_count;
+        skipped_count = checkpoint.skipped_count;
+        run_metrics.skipped = checkpoint.skipped;
+        global_offset_set = checkpoint.global_offset_set;
+        global_offset_x = checkpoint.global_offset_x;
+        global_offset_y = checkpoint.global_offset_y;
+        global_offset_z = checkpoint.global_offset_z;
+        seen_feature = checkpoint.seen_feature;
+        resuming = true;
+        log_out << std::format(
+            "Resuming from checkpoint {}: input offset {}, output offset {}, processed {}, skipped {}",
+            checkpoint_path, checkpoint.input_offset, checkpoint.output_offset, processed_count, skipped_count)
+                << std::endl;
+    } else if (resume) {
+        log_out << std::format("No checkpoint at {}; starting from the beginning", checkpoint_path) << std::endl;
+    }
+
     StreamProcessingContext stream_ctx{
         .polygon_features = polygon_features,
         .features_by_exact_id = features_by_exact_id,
         .seen_feature = seen_feature,
         .feature_source_filename = feature_source_filename,
-        .method = method,
+        .methods = methods,
+        .boolean_budget = boolean_budget,
+        .boolean_worker = boolean_worker.get(),
+        .cost_model = cost_model.get(),
         .source_attribute_target = source_attribute_target,
         .ignore_holes = ignore_holes,
         .global_offset_set = global_offset_set,
@@ -1503,11 +3014,27 @@ int main(int argc, char* argv[]) {
         .intersection_ms = intersection_ms,
         .output_write_ms = output_write_ms,
         .output_write_changed_ms = output_write_changed_ms,
+        .output_write_polygonal_ms = output_write_polygonal_ms,
+        .output_write_weld_ms = output_write_weld_ms,
         .output_write_passthrough_ms = output_write_passthrough_ms,
         .model_stream_read_ms = model_stream_read_ms,
-        .boolean_obj_writer = boolean_obj_writer,
+        .output_weld_totals = output_weld_totals,
+        .run_metrics = run_metrics,
+        .boolean_mesh_writer = boolean_mesh_writer,
         .log_out = log_out,
+        .shard = shard,
+        .shard_only = shard_only,
+        .checkpoint = checkpoint_path.empty() ? nullptr : &checkpoint,
+        .checkpoint_path = checkpoint_path,
+        .checkpoint_every = checkpoint_every,
+        .memory_budget = memory_budget.get(),
+        .lods = lods,
     };
+    if (shard.active()) {
+        log_out << std::format(
+            "Shard {}/{}: {} OGR features belong to other shards; their model features are {}",
+            shard.index, shard.count, other_shard_count, shard_only ? "dropped" : "passed through") << std::endl;
+    }
 
     bool stream_ok = false;
     if (model_is_fcb) {
@@ -1516,16 +3043,32 @@ int main(int argc, char* argv[]) {
             .writer = nullptr,
             .output_to_stdout = output_to_stdout,
             .output_path = output_path,
+            .resume_from = resuming ? &checkpoint : nullptr,
+            .mesh_lod = mesh_lod,
         };
         stream_ok = process_stream_features(backend, stream_ctx);
         if (!stream_ok) {
             zfcb_reader_destroy(fcb);
             return 1;
         }
+        // A finished run leaves nothing to resume.
+        if (!checkpoint_path.empty()) {
+            std::error_code remove_error;
+            std::filesystem::remove(checkpoint_path, remove_error);
+        }
+    } else if (model_is_cityjson) {
+        stream_ok = process_cityjson_tile(
+            cj_tile, output_path, stream_ctx, jobs,
+            isolate_booleans ? current_executable_path(argv[0]) : std::string{});
+        if (!stream_ok) {
+            cityjson_tile_destroy(cj_tile);
+            return 1;
+        }
     } else {
         CjseqStreamBackend backend{
             .reader = cjseq_reader,
             .writer = nullptr,
+            .output_to_stdout = output_to_stdout,
             .output_path = output_path,
         };
         stream_ok = process_stream_features(backend, stream_ctx);
@@ -1542,18 +3085,52 @@ int main(int argc, char* argv[]) {
         const auto& feature = polygon_features[feature_idx];
         std::cerr << std::format("Skipping feature {}: {} feature not found for id '{}'",
                                  feature_idx,
-                                 model_is_fcb ? "FlatCityBuf" : "CityJSONSeq",
+                                 model_is_fcb ? "FlatCityBuf" : model_is_cityjson ? "CityJSON" : "CityJSONSeq",
                                  feature.id) << std::endl;
         ++skipped_count;
+        run_metrics.skipped.add(SkipReason::ModelFeatureNotFound);
     }
 
     if (model_is_fcb) {
         zfcb_reader_destroy(fcb);
+    } else if (model_is_cityjson) {
+        cityjson_tile_destroy(cj_tile);
     } else {
         cityjsonseq_reader_destroy(cjseq_reader);
     }
 
+    if (!boolean_mesh_writer.close()) {
+        std::cerr << "Failed to write boolean mesh output: " << boolean_mesh_output << std::endl;
+    }
+    if (!trace::finish()) {
+        std::cerr << "Failed to write trace output: " << trace_path << std::endl;
+    }
+    if (!cost_model_out_path.empty() && !cost_model->write_csv(cost_model_out_path)) {
+        std::cerr << "Failed to write cost model output: " << cost_model_out_path << std::endl;
+    }
+
     log_out << std::format("Processed underpasses: {}, skipped: {}", processed_count, skipped_count) << std::endl;
+    if (output_weld_totals.vertices_before > 0) {
+        log_out << std::format(
+            "Output vertices after welding: {} -> {} ({} collapsed surfaces dropped)",
+            output_weld_totals.vertices_before,
+            output_weld_totals.vertices_after,
+            output_weld_totals.dropped_surfaces) << std::endl;
+    }
+    // The workers of further tile threads are counted already.
+    if (boolean_worker != nullptr) {
+        run_metrics.boolean_worker_restarts += boolean_worker->restarts();
+    }
+    if (run_metrics.boolean_worker_restarts > 0) {
+        log_out << std::format("Boolean worker restarts: {}", run_metrics.boolean_worker_restarts) << std::endl;
+    }
+    if (memory_budget != nullptr) {
+        log_out << std::format(
+            "Memory budget {} MiB: at most {} MiB reserved at once, {} boolean attempt(s) ran alone",
+            memory_budget->budget_bytes() >> 20,
+            memory_budget->peak_reserved_bytes() >> 20,
+            memory_budget->serialized_count()) << std::endl;
+    }
 
     if (processed_count == 0) {
         std::cerr << "Warning: no underpasses were successfully added." << std::endl;
@@ -1577,9 +3154,33 @@ int main(int argc, char* argv[]) {
     log_out << std::format("  boolean ops: {:.3f}", intersection_ms.count()) << std::endl;
     log_out << std::format("  output writing: {:.3f}", output_write_ms_value) << std::endl;
     log_out << std::format("    changed features: {:.3f}", output_write_changed_ms.count()) << std::endl;
+    log_out << std::format("      polygonal output build: {:.3f}", output_write_polygonal_ms.count()) << std::endl;
+    log_out << std::format("      vertex welding: {:.3f}", output_write_weld_ms.count()) << std::endl;
     log_out << std::format("    pass-through features: {:.3f}", output_write_passthrough_ms.count()) << std::endl;
     log_out << std::format("  other: {:.3f}", other_ms) << std::endl;
     log_out << std::format("  total: {:.3f}", total_ms) << std::endl;
 
+    if (!metrics_path.empty()) {
+        const std::vector<std::pair<std::string, double>> timings_ms{
+            {"model_reading", model_read_ms},
+            {"ogr_reading", ogr_read_ms},
+            {"datastructure_conversion", ds_conversion_ms.count()},
+            {"boolean_ops", intersection_ms.count()},
+            {"output_writing", output_write_ms_value},
+            {"output_writing_changed", output_write_changed_ms.count()},
+            {"output_writing_polygonal_build", output_write_polygonal_ms.count()},
+            {"output_writing_vertex_welding", output_write_weld_ms.count()},
+            {"output_writing_passthrough", output_write_passthrough_ms.count()},
+            {"other", other_ms},
+            {"total", total_ms},
+        };
+        if (!run_metrics.write_json(metrics_path, timings_ms, processed_count, skipped_count)) {
+            std::cerr << "Failed to write metrics output: " << metrics_path << std::endl;
+            // Schedulers read this file instead of the log; a run without it
+            // must not look successful.
+            return 1;
+        }
+    }
+
     return 0;
 }
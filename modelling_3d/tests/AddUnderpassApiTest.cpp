@@ -0,0 +1,260 @@
+// Carves an underpass through a small box building with add_underpass_carve
+// from several threads at once and checks every result against one carved
+// alone. Also checks the argument validation.
+// Exits non-zero on the first failing check and prints it.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "add_underpass.h"
+
+namespace {
+
+constexpr size_t kThreads = 8;
+constexpr size_t kCarvesPerThread = 4;
+
+bool check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL %s\n", what);
+    }
+    return condition;
+}
+
+// 10 x 10 x 10 m box in RD-like world coordinates, one outward ring per face.
+struct BoxBuilding {
+    std::vector<double> vertices;
+    std::vector<uint32_t> surfaces;
+    std::vector<uint32_t> strings;
+    std::vector<uint32_t> boundaries;
+    std::vector<uint8_t> semantic_types;
+
+    BoxBuilding() {
+        constexpr double x0 = 85000.0;
+        constexpr double y0 = 446000.0;
+        for (const double z : {0.0, 10.0}) {
+            vertices.insert(vertices.end(), {x0, y0, z, x0 + 10.0, y0, z, x0 + 10.0, y0 + 10.0, z, x0, y0 + 10.0, z});
+        }
+        // FCB SemanticSurfaceType: 0 roof, 1 ground, 2 wall.
+        const uint32_t faces[6][4] = {
+            {0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}};
+        const uint8_t types[6] = {1, 0, 2, 2, 2, 2};
+        for (size_t f = 0; f < 6; ++f) {
+            surfaces.push_back(1);
+            strings.push_back(4);
+            boundaries.insert(boundaries.end(), faces[f], faces[f] + 4);
+            semantic_types.push_back(types[f]);
+        }
+    }
+
+    AddUnderpassBuilding view() const {
+        return AddUnderpassBuilding{
+            .vertices = vertices.data(),
+            .vertex_count = vertices.size() / 3,
+            .surfaces = surfaces.data(),
+            .surface_count = surfaces.size(),
+            .strings = strings.data(),
+            .string_count = strings.size(),
+            .boundaries = boundaries.data(),
+            .boundary_count = boundaries.size(),
+            .surface_semantic_types = semantic_types.data(),
+        };
+    }
+};
+
+// A 4 m wide passage straight through the box, 3 m high.
+const double kPassageXy[] = {
+    84998.0, 446003.0, 85012.0, 446003.0, 85012.0, 446007.0, 84998.0, 446007.0};
+const uint32_t kPassageRing[] = {4};
+
+AddUnderpassFootprint passage() {
+    return AddUnderpassFootprint{
+        .xy = kPassageXy,
+        .ring_vertex_counts = kPassageRing,
+        .ring_count = 1,
+        .ceiling_z = 3.0,
+    };
+}
+
+template <typename T>
+std::vector<T> to_vector(const T* values, size_t count) {
+    return values == nullptr ? std::vector<T>{} : std::vector<T>(values, values + count);
+}
+
+// Copy of a result, so results from different threads can be compared.
+struct Carved {
+    int status = ADD_UNDERPASS_ERROR_INTERNAL;
+    std::vector<double> vertices;
+    std::vector<uint32_t> surfaces;
+    std::vector<uint32_t> strings;
+    std::vector<uint32_t> boundaries;
+    std::vector<uint8_t> semantic_types;
+    std::vector<int32_t> underpass_indices;
+    uint8_t method = 0;
+    std::string message;
+
+    bool operator==(const Carved&) const = default;
+};
+
+Carved carve(const BoxBuilding& building, const std::vector<uint8_t>& methods) {
+    const AddUnderpassBuilding view = building.view();
+    const AddUnderpassFootprint footprint = passage();
+    AddUnderpassOptions options{};
+    options.methods = methods.data();
+    options.method_count = methods.size();
+
+    AddUnderpassResult result{};
+    Carved carved;
+    carved.status = add_underpass_carve(&view, &footprint, 1, &options, &result);
+    carved.vertices = to_vector(result.vertices, result.vertex_count * 3);
+    carved.surfaces = to_vector(result.surfaces, result.surface_count);
+    carved.strings = to_vector(result.strings, result.string_count);
+    carved.boundaries = to_vector(result.boundaries, result.boundary_count);
+    carved.semantic_types = to_vector(result.surface_semantic_types, result.surface_count);
+    carved.underpass_indices = to_vector(result.surface_underpass_indices, result.surface_count);
+    carved.method = result.method;
+    carved.message = result.message;
+    add_underpass_result_free(&result);
+    return carved;
+}
+
+// The arrays describe a closed shell around the passage: counts add up,
+// indices are in range, vertices stay within the box and some surface is the
+// passage ceiling.
+bool valid_carve(const Carved& carved) {
+    bool ok = check(carved.status == ADD_UNDERPASS_OK, "carve succeeds");
+    ok = ok && check(carved.message.empty(), "no message on success");
+    ok = ok && check(!carved.vertices.empty() && !carved.surfaces.empty(), "result has vertices and surfaces");
+    ok = ok && check(carved.semantic_types.size() == carved.surfaces.size() &&
+                         carved.underpass_indices.size() == carved.surfaces.size(),
+                     "one semantic type and underpass index per surface");
+    if (!ok) {
+        return false;
+    }
+
+    size_t ring_total = 0;
+    for (const uint32_t rings : carved.surfaces) {
+        ring_total += rings;
+    }
+    size_t index_total = 0;
+    for (const uint32_t count : carved.strings) {
+        index_total += count;
+    }
+    ok = check(ring_total == carved.strings.size(), "surface ring counts add up to the rings");
+    ok = ok && check(index_total == carved.boundaries.size(), "ring vertex counts add up to the boundaries");
+    const size_t vertex_count = carved.vertices.size() / 3;
+    for (const uint32_t index : carved.boundaries) {
+        ok = ok && check(index < vertex_count, "boundary index within the vertices");
+    }
+    for (size_t v = 0; ok && v < vertex_count; ++v) {
+        const double x = carved.vertices[v * 3 + 0] - 85000.0;
+        const double y = carved.vertices[v * 3 + 1] - 446000.0;
+        const double z = carved.vertices[v * 3 + 2];
+        ok = check(x > -1e-3 && x < 10.001 && y > -1e-3 && y < 10.001 && z > -1e-3 && z < 10.001,
+                   "vertices stay within the box");
+    }
+    bool has_ceiling = false;
+    for (size_t s = 0; s < carved.surfaces.size(); ++s) {
+        // 4 is OuterCeilingSurface.
+        if (carved.underpass_indices[s] == 0) {
+            ok = ok && check(carved.semantic_types[s] == 4, "passage surfaces are outer ceilings");
+            has_ceiling = true;
+        } else {
+            ok = ok && check(carved.underpass_indices[s] == -1, "other surfaces have no underpass index");
+        }
+    }
+    return ok && check(has_ceiling, "the passage ceiling is a surface");
+}
+
+bool concurrent_carves_match_a_single_carve() {
+    const BoxBuilding building;
+    const std::vector<std::vector<uint8_t>> chains = {
+        {ADD_UNDERPASS_METHOD_PMP},
+        {ADD_UNDERPASS_METHOD_MANIFOLD, ADD_UNDERPASS_METHOD_PMP},
+    };
+    std::vector<Carved> reference;
+    bool ok = true;
+    for (const auto& chain : chains) {
+        reference.push_back(carve(building, chain));
+        ok = ok && valid_carve(reference.back());
+    }
+    if (!ok) {
+        return false;
+    }
+
+    // Every thread works from its own building copy; the reference is only read.
+    std::vector<std::vector<Carved>> carved(kThreads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            const BoxBuilding own_building;
+            for (size_t i = 0; i < kCarvesPerThread; ++i) {
+                carved[t].push_back(carve(own_building, chains[(t + i) % chains.size()]));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t t = 0; ok && t < kThreads; ++t) {
+        for (size_t i = 0; ok && i < kCarvesPerThread; ++i) {
+            ok = check(carved[t][i] == reference[(t + i) % chains.size()],
+                       "a concurrent carve returns the same result as the single-threaded one");
+        }
+    }
+    return ok;
+}
+
+bool invalid_arguments_are_rejected() {
+    const BoxBuilding box;
+    const AddUnderpassFootprint footprint = passage();
+    AddUnderpassResult result{};
+    bool ok = true;
+
+    // Each array is NULL in turn while its count says it has elements.
+    for (int missing = 0; missing < 3; ++missing) {
+        AddUnderpassBuilding building = box.view();
+        if (missing == 0) building.surfaces = nullptr;
+        if (missing == 1) building.strings = nullptr;
+        if (missing == 2) building.boundaries = nullptr;
+        ok = ok && check(add_underpass_carve(&building, &footprint, 1, nullptr, &result) ==
+                             ADD_UNDERPASS_ERROR_INVALID_ARGUMENT,
+                         "a NULL building array with a non-zero count is an invalid argument");
+        ok = ok && check(result.vertices == nullptr && result.surfaces == nullptr && result.message[0] != '\0',
+                         "a rejected call returns no arrays and a message");
+        add_underpass_result_free(&result);
+    }
+
+    const AddUnderpassBuilding building = box.view();
+    ok = ok && check(add_underpass_carve(&building, &footprint, 1, nullptr, nullptr) ==
+                         ADD_UNDERPASS_ERROR_INVALID_ARGUMENT,
+                     "a NULL result is an invalid argument");
+    ok = ok && check(add_underpass_carve(&building, nullptr, 1, nullptr, &result) ==
+                         ADD_UNDERPASS_ERROR_INVALID_ARGUMENT,
+                     "NULL footprints are an invalid argument");
+    add_underpass_result_free(&result);
+
+    const uint8_t unknown_method = 200;
+    AddUnderpassOptions options{};
+    options.methods = &unknown_method;
+    options.method_count = 1;
+    ok = ok && check(add_underpass_carve(&building, &footprint, 1, &options, &result) ==
+                         ADD_UNDERPASS_ERROR_INVALID_ARGUMENT,
+                     "an unknown method is an invalid argument");
+    add_underpass_result_free(&result);
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    bool ok = invalid_arguments_are_rejected();
+    ok = ok && concurrent_carves_match_a_single_carve();
+    if (!ok) {
+        return 1;
+    }
+    std::printf("add_underpass_carve: ok\n");
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Checks that boolean attempts which fail without phase timings (killed at
+// the budget, crashed worker, in-process deadline) make a backend look slower
+// in the auto cost model instead of faster.
+// Exits non-zero on the first failing check and prints it.
+
+#include <cstdio>
+#include <vector>
+
+#include "BackendCostModel.h"
+
+namespace {
+
+bool check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL %s\n", what);
+    }
+    return condition;
+}
+
+size_t rank_of(const std::vector<BooleanMethod>& ranked, BooleanMethod method) {
+    for (size_t i = 0; i < ranked.size(); ++i) {
+        if (ranked[i] == method) {
+            return i;
+        }
+    }
+    return ranked.size();
+}
+
+// A --isolate-booleans worker killed one second after a 2 s budget: the
+// worker reports no timings, the attempt held its slot for ~3 s.
+constexpr double kKilledWallMs = 3000.0;
+
+bool killed_attempt_raises_predicted_cost() {
+    BooleanFeatureTraits traits;
+    traits.input_triangles = 5000;
+    traits.underpass_count = 1;
+
+    BackendCostModel model;
+    const double before = model.predicted_ms(BooleanMethod::CgalNef, traits);
+    model.record(BooleanMethod::CgalNef, traits, charged_boolean_ms(0.0, kKilledWallMs, false), false);
+    const double after = model.predicted_ms(BooleanMethod::CgalNef, traits);
+
+    bool ok = check(after > before, "killed attempt raises the predicted time");
+    ok = ok && check(model.failure_probability(BooleanMethod::CgalNef, traits) >
+                         BackendCostModel().failure_probability(BooleanMethod::CgalNef, traits),
+                     "killed attempt raises the failure probability");
+    return ok;
+}
+
+bool repeated_kills_demote_backend() {
+    BooleanFeatureTraits traits;
+    traits.input_triangles = 5000;
+    traits.underpass_count = 1;
+
+    BackendCostModel model;
+    bool ok = check(rank_of(model.rank(traits), BooleanMethod::Manifold) == 0, "manifold ranks first by prior");
+    for (int i = 0; i < 4; ++i) {
+        model.record(BooleanMethod::Manifold, traits, charged_boolean_ms(0.0, kKilledWallMs, false), false);
+    }
+    ok = ok && check(rank_of(model.rank(traits), BooleanMethod::Manifold) > 0,
+                     "manifold killed four times no longer ranks first");
+    return ok;
+}
+
+bool charged_time() {
+    bool ok = check(charged_boolean_ms(12.0, 40.0, true) == 12.0, "success is charged its boolean time");
+    ok = ok && check(charged_boolean_ms(0.0, 40.0, false) == 40.0, "failure without timings is charged wall time");
+    ok = ok && check(charged_boolean_ms(55.0, 40.0, false) == 55.0, "failure keeps a longer boolean time");
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    bool ok = charged_time();
+    ok = ok && killed_attempt_raises_predicted_cost();
+    ok = ok && repeated_kills_demote_backend();
+    if (!ok) {
+        return 1;
+    }
+    std::printf("BackendCostModel: ok\n");
+    return 0;
+}
@@ -0,0 +1,184 @@
+// Checks cycle_nesting::resolve_cycle_nesting against the pairwise loop it
+// replaced in group_cycles_into_surfaces, on random cycle sets with shared,
+// touching and collinear boundaries: depths and parents must be identical.
+// Exits non-zero on the first mismatching case and prints it.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "CycleNesting.h"
+
+namespace {
+
+constexpr size_t kCycleSets = 20000;
+constexpr size_t kMaxCyclesPerSet = 24;
+
+using Ring = std::vector<pip::Point2>;
+
+// point_in_ring from PolygonalOutput.cpp.
+bool reference_point_in_ring(const pip::Point2& p, const Ring& ring) {
+    if (ring.size() < 3) {
+        return false;
+    }
+    bool inside = false;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        const auto& a = ring[i];
+        const auto& b = ring[j];
+        const bool intersects = ((a.y > p.y) != (b.y > p.y)) &&
+            (p.x < (b.x - a.x) * (p.y - a.y) / ((b.y - a.y) == 0.0 ? 1e-18 : (b.y - a.y)) + a.x);
+        if (intersects) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// The nesting loop of the pre-sweep group_cycles_into_surfaces.
+void reference_nesting(std::vector<cycle_nesting::NestingCycle>& infos) {
+    for (size_t i = 0; i < infos.size(); ++i) {
+        const auto& test_point = infos[i].ring.front();
+        double best_parent_area = std::numeric_limits<double>::max();
+        for (size_t j = 0; j < infos.size(); ++j) {
+            if (i == j) {
+                continue;
+            }
+            if (infos[j].abs_area <= infos[i].abs_area) {
+                continue;
+            }
+            if (!reference_point_in_ring(test_point, infos[j].ring)) {
+                continue;
+            }
+            infos[i].nesting_depth += 1;
+            if (infos[j].abs_area < best_parent_area) {
+                best_parent_area = infos[j].abs_area;
+                infos[i].parent_index = j;
+            }
+        }
+    }
+}
+
+double abs_area(const Ring& ring) {
+    double area = 0.0;
+    for (size_t i = 0; i < ring.size(); ++i) {
+        const size_t j = (i + 1) % ring.size();
+        area += ring[i].x * ring[j].y - ring[j].x * ring[i].y;
+    }
+    return std::abs(0.5 * area);
+}
+
+// Axis-aligned rectangle on the integer lattice. With `splits` > 1 every edge
+// is cut into that many collinear pieces, which makes rings large enough for
+// the grid-prepared test.
+Ring rectangle(double x0, double y0, double w, double h, size_t splits) {
+    const pip::Point2 corners[4] = {{x0, y0}, {x0 + w, y0}, {x0 + w, y0 + h}, {x0, y0 + h}};
+    Ring ring;
+    for (size_t c = 0; c < 4; ++c) {
+        const auto& a = corners[c];
+        const auto& b = corners[(c + 1) % 4];
+        for (size_t s = 0; s < splits; ++s) {
+            const double t = static_cast<double>(s) / static_cast<double>(splits);
+            ring.push_back({a.x + t * (b.x - a.x), a.y + t * (b.y - a.y)});
+        }
+    }
+    return ring;
+}
+
+// A star with `spikes` points around (cx, cy).
+Ring star(double cx, double cy, double inner, double outer, size_t spikes) {
+    Ring ring;
+    for (size_t i = 0; i < 2 * spikes; ++i) {
+        const double angle = M_PI * static_cast<double>(i) / static_cast<double>(spikes);
+        const double r = i % 2 == 0 ? outer : inner;
+        ring.push_back({cx + r * std::cos(angle), cy + r * std::sin(angle)});
+    }
+    return ring;
+}
+
+// Cycles on a small lattice far from the origin, like RD coordinates, so
+// rings nest, share edges and start on each other's boundaries. Some rings
+// repeat an earlier one, reversed or from another start vertex.
+std::vector<cycle_nesting::NestingCycle> random_cycle_set(std::mt19937& rng) {
+    constexpr double x_origin = 85000.0;
+    constexpr double y_origin = 446000.0;
+    std::uniform_int_distribution<size_t> cycle_count(1, kMaxCyclesPerSet);
+    std::uniform_int_distribution<int> shape(0, 9);
+    std::uniform_int_distribution<int> corner(0, 16);
+    std::uniform_int_distribution<int> extent(1, 16);
+    std::uniform_int_distribution<size_t> splits(1, 6);
+    std::uniform_int_distribution<size_t> spikes(3, 12);
+
+    std::vector<Ring> rings;
+    const size_t count = cycle_count(rng);
+    for (size_t c = 0; c < count; ++c) {
+        const int kind = shape(rng);
+        Ring ring;
+        if (kind == 0 && !rings.empty()) {
+            ring = rings[std::uniform_int_distribution<size_t>(0, rings.size() - 1)(rng)];
+            if (rng() % 2 == 0) {
+                std::reverse(ring.begin(), ring.end());
+            }
+            std::rotate(ring.begin(), ring.begin() + static_cast<std::ptrdiff_t>(rng() % ring.size()), ring.end());
+        } else if (kind <= 2) {
+            const double radius = static_cast<double>(extent(rng));
+            ring = star(x_origin + corner(rng), y_origin + corner(rng), 0.5 * radius, radius, spikes(rng));
+        } else {
+            ring = rectangle(x_origin + corner(rng), y_origin + corner(rng), extent(rng), extent(rng), splits(rng));
+        }
+        rings.push_back(std::move(ring));
+    }
+
+    std::vector<cycle_nesting::NestingCycle> cycles(rings.size());
+    for (size_t i = 0; i < rings.size(); ++i) {
+        cycles[i].ring = std::move(rings[i]);
+        cycles[i].abs_area = abs_area(cycles[i].ring);
+        cycle_nesting::compute_bounds(cycles[i]);
+    }
+    return cycles;
+}
+
+bool check_cycle_sets(std::mt19937& rng) {
+    size_t total_cycles = 0;
+    size_t nested_cycles = 0;
+    size_t prepared_rings = 0;
+    for (size_t set = 0; set < kCycleSets; ++set) {
+        auto swept = random_cycle_set(rng);
+        auto expected = swept;
+        cycle_nesting::resolve_cycle_nesting(swept);
+        reference_nesting(expected);
+        for (size_t i = 0; i < swept.size(); ++i) {
+            if (swept[i].nesting_depth != expected[i].nesting_depth ||
+                swept[i].parent_index != expected[i].parent_index) {
+                std::fprintf(stderr,
+                             "FAIL set %zu cycle %zu: depth %zu parent %zu, pairwise loop gives depth %zu parent %zu\n",
+                             set, i, swept[i].nesting_depth, swept[i].parent_index,
+                             expected[i].nesting_depth, expected[i].parent_index);
+                return false;
+            }
+            nested_cycles += expected[i].nesting_depth > 0 ? 1 : 0;
+            prepared_rings += swept[i].ring.size() >= pip::PreparedRing::kMinGridVertices ? 1 : 0;
+        }
+        total_cycles += swept.size();
+    }
+    // Guards the generator: the sets must exercise nesting and the grid path.
+    if (nested_cycles * 4 < total_cycles || prepared_rings * 4 < total_cycles) {
+        std::fprintf(stderr, "FAIL cycle sets: only %zu nested and %zu grid-sized rings of %zu cycles\n",
+                     nested_cycles, prepared_rings, total_cycles);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(0x5eed);
+    if (!check_cycle_sets(rng)) {
+        return 1;
+    }
+    std::printf("CycleNesting: ok\n");
+    return 0;
+}
@@ -0,0 +1,188 @@
+// Checks pip::PreparedRing / PreparedPolygon against the plain scans they
+// replaced: point_in_ring for semantic inference and nesting, and
+// point_in_ogr_ring (boundary counts as inside) for underpass matching.
+// Exits non-zero on the first mismatching case and prints it.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "PreparedPolygon.h"
+
+namespace {
+
+using Ring3 = std::vector<std::array<double, 3>>;
+
+// point_in_ring from PolygonalOutput.cpp.
+bool reference_point_in_ring(double x, double y, const std::vector<pip::Point2>& ring) {
+    if (ring.size() < 3) {
+        return false;
+    }
+    bool inside = false;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        const auto& a = ring[i];
+        const auto& b = ring[j];
+        const bool intersects = ((a.y > y) != (b.y > y)) &&
+            (x < (b.x - a.x) * (y - a.y) / ((b.y - a.y) == 0.0 ? 1e-18 : (b.y - a.y)) + a.x);
+        if (intersects) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+bool reference_point_on_segment(double px, double py, const pip::Point2& a, const pip::Point2& b) {
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const double cross = (px - a.x) * dy - (py - a.y) * dx;
+    const double scale = std::max({1.0, std::abs(dx), std::abs(dy)});
+    if (std::abs(cross) > 1e-9 * scale) {
+        return false;
+    }
+    const double dot = (px - a.x) * dx + (py - a.y) * dy;
+    const double length_sq = dx * dx + dy * dy;
+    return dot >= -1e-9 && dot <= length_sq + 1e-9;
+}
+
+bool reference_on_boundary(double x, double y, const std::vector<pip::Point2>& ring) {
+    if (ring.size() < 3) {
+        return false;
+    }
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        if (reference_point_on_segment(x, y, ring[j], ring[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// point_in_ogr_ring from the pre-grid PolygonalOutput.cpp.
+bool reference_point_in_ogr_ring(double x, double y, const std::vector<pip::Point2>& ring) {
+    return reference_on_boundary(x, y, ring) || reference_point_in_ring(x, y, ring);
+}
+
+std::vector<pip::Point2> to_points(const Ring3& ring) {
+    std::vector<pip::Point2> points;
+    for (const auto& p : ring) {
+        points.push_back({p[0], p[1]});
+    }
+    return points;
+}
+
+// A star with `spikes` points around (cx, cy), far from the origin like RD
+// coordinates.
+Ring3 star(double cx, double cy, double inner, double outer, size_t spikes, double phase) {
+    Ring3 ring;
+    for (size_t i = 0; i < 2 * spikes; ++i) {
+        const double angle = phase + M_PI * static_cast<double>(i) / static_cast<double>(spikes);
+        const double r = i % 2 == 0 ? outer : inner;
+        ring.push_back({cx + r * std::cos(angle), cy + r * std::sin(angle), 0.0});
+    }
+    return ring;
+}
+
+// An axis-aligned staircase whose vertices fall on the default grid lines.
+Ring3 staircase(size_t steps) {
+    Ring3 ring{{0.0, 0.0, 0.0}};
+    for (size_t i = 0; i < steps; ++i) {
+        ring.push_back({static_cast<double>(i + 1), static_cast<double>(i), 0.0});
+        ring.push_back({static_cast<double>(i + 1), static_cast<double>(i + 1), 0.0});
+    }
+    ring.push_back({0.0, static_cast<double>(steps), 0.0});
+    return ring;
+}
+
+// Random points plus every vertex, edge midpoint and a point a hair to each
+// side of every edge.
+std::vector<pip::Point2> query_points(const std::vector<std::vector<pip::Point2>>& rings, std::mt19937& rng) {
+    double minx = rings.front().front().x;
+    double maxx = minx;
+    double miny = rings.front().front().y;
+    double maxy = miny;
+    std::vector<pip::Point2> queries;
+    for (const auto& ring : rings) {
+        for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+            const auto& a = ring[j];
+            const auto& b = ring[i];
+            minx = std::min(minx, b.x);
+            maxx = std::max(maxx, b.x);
+            miny = std::min(miny, b.y);
+            maxy = std::max(maxy, b.y);
+            queries.push_back(b);
+            const pip::Point2 mid{0.5 * (a.x + b.x), 0.5 * (a.y + b.y)};
+            queries.push_back(mid);
+            const double length = std::hypot(b.x - a.x, b.y - a.y);
+            for (const double offset : {-1e-7, -1e-10, 1e-10, 1e-7}) {
+                queries.push_back({mid.x - offset * (b.y - a.y) / length, mid.y + offset * (b.x - a.x) / length});
+            }
+        }
+    }
+    std::uniform_real_distribution<double> ux(minx - 0.1 * (maxx - minx), maxx + 0.1 * (maxx - minx));
+    std::uniform_real_distribution<double> uy(miny - 0.1 * (maxy - miny), maxy + 0.1 * (maxy - miny));
+    for (size_t i = 0; i < 20000; ++i) {
+        queries.push_back({ux(rng), uy(rng)});
+    }
+    return queries;
+}
+
+bool check_ring(const char* name, const Ring3& ring, size_t resolution, std::mt19937& rng) {
+    const auto points = to_points(ring);
+    const pip::PreparedRing prepared(points, resolution);
+    for (const auto& q : query_points({points}, rng)) {
+        if (prepared.contains(q.x, q.y) != reference_point_in_ring(q.x, q.y, points)) {
+            std::fprintf(stderr, "FAIL %s: contains(%.17g, %.17g) differs from point_in_ring\n", name, q.x, q.y);
+            return false;
+        }
+        if (prepared.on_boundary(q.x, q.y) != reference_on_boundary(q.x, q.y, points)) {
+            std::fprintf(stderr, "FAIL %s: on_boundary(%.17g, %.17g) differs from point_on_segment\n", name, q.x, q.y);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool check_polygon(const char* name, const Ring3& outer, const std::vector<Ring3>& holes, std::mt19937& rng) {
+    const pip::PreparedPolygon prepared(outer, holes);
+    std::vector<std::vector<pip::Point2>> rings{to_points(outer)};
+    for (const auto& hole : holes) {
+        rings.push_back(to_points(hole));
+    }
+    for (const auto& q : query_points(rings, rng)) {
+        bool expected = reference_point_in_ogr_ring(q.x, q.y, rings.front());
+        for (size_t i = 1; expected && i < rings.size(); ++i) {
+            expected = !reference_point_in_ogr_ring(q.x, q.y, rings[i]);
+        }
+        if (prepared.contains_or_touches(q.x, q.y) != expected) {
+            std::fprintf(stderr, "FAIL %s: contains_or_touches(%.17g, %.17g) differs from point_in_ogr_ring\n",
+                         name, q.x, q.y);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(0x5eed);
+    bool ok = true;
+    ok = ok && check_ring("triangle", {{0.0, 0.0, 0.0}, {4.0, 0.0, 0.0}, {0.0, 3.0, 0.0}}, 0, rng);
+    ok = ok && check_ring("star", star(121000.0, 487000.0, 4.0, 11.0, 24, 0.1), 0, rng);
+    ok = ok && check_ring("star_coarse_grid", star(121000.0, 487000.0, 4.0, 11.0, 24, 0.1), 3, rng);
+    ok = ok && check_ring("staircase", staircase(12), 0, rng);
+    ok = ok && check_polygon("star_with_holes",
+                             star(121000.0, 487000.0, 20.0, 40.0, 16, 0.0),
+                             {star(121000.0, 487000.0, 3.0, 6.0, 9, 0.3),
+                              {{120992.0, 486975.0, 0.0}, {120992.0, 486980.0, 0.0}, {120997.0, 486975.0, 0.0}}},
+                             rng);
+    ok = ok && check_polygon("staircase_square_hole", staircase(10),
+                             {{{2.0, 7.0, 0.0}, {2.0, 8.0, 0.0}, {3.0, 8.0, 0.0}, {3.0, 7.0, 0.0}}}, rng);
+    if (!ok) {
+        return 1;
+    }
+    std::printf("PreparedPolygon: ok\n");
+    return 0;
+}
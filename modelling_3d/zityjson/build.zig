@@ -39,7 +39,11 @@ pub fn build(b: *std.Build) void {
         // Later on we'll use this module as the root module of a test executable
         // which requires us to specify a target.
         .target = target,
+        .link_libc = true,
     });
+    // CityJSONSeq .jsonl.zst/.jsonl.gz streams go through libzstd and zlib.
+    mod.linkSystemLibrary("zstd", .{});
+    mod.linkSystemLibrary("z", .{});
 
     // Here we define an executable. An executable needs to have a root module
     // which needs to expose a `main` function. While we could add a main function
@@ -93,12 +97,23 @@ pub fn build(b: *std.Build) void {
         }),
     });
 
+    // Merges the outputs of add_underpass --shard runs in original order.
+    const fcb_merge_exe = b.addExecutable(.{
+        .name = "fcb_merge",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/fcb_merge.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+
     // This declares intent for the executable to be installed into the
     // install prefix when running `zig build` (i.e. when executing the default
     // step). By default the install prefix is `zig-out/` but can be overridden
     // by passing `--prefix` or `-p`.
     b.installArtifact(exe);
     b.installArtifact(fcb_info_exe);
+    b.installArtifact(fcb_merge_exe);
 
     // ==========================================================================
     // Static library for C/C++ interop
@@ -110,8 +125,11 @@ pub fn build(b: *std.Build) void {
             .root_source_file = b.path("src/zityjson.zig"),
             .target = target,
             .optimize = optimize,
+            .link_libc = true,
         }),
     });
+    lib.root_module.linkSystemLibrary("zstd", .{});
+    lib.root_module.linkSystemLibrary("z", .{});
 
     // Bundle compiler-rt to avoid missing symbols like _roundq when linking from C++
     lib.bundle_compiler_rt = true;
@@ -166,6 +184,14 @@ pub fn build(b: *std.Build) void {
     }
     run_fcb_info_step.dependOn(&run_fcb_info_cmd.step);
 
+    // zig build run-fcb-merge -- original.fcb merged.fcb shard_0.fcb shard_1.fcb
+    const run_fcb_merge_step = b.step("run-fcb-merge", "Merge add_underpass shard outputs");
+    const run_fcb_merge_cmd = b.addRunArtifact(fcb_merge_exe);
+    if (b.args) |args| {
+        run_fcb_merge_cmd.addArgs(args);
+    }
+    run_fcb_merge_step.dependOn(&run_fcb_merge_cmd.step);
+
     // Creates an executable that will run `test` blocks from the provided module.
     // Here `mod` needs to define a target, which is why earlier we made sure to
     // set the releative field.
@@ -192,6 +218,10 @@ pub fn build(b: *std.Build) void {
     const test_step = b.step("test", "Run tests");
     test_step.dependOn(&run_mod_tests.step);
     test_step.dependOn(&run_exe_tests.step);
+    const fcb_merge_tests = b.addTest(.{
+        .root_module = fcb_merge_exe.root_module,
+    });
+    test_step.dependOn(&b.addRunArtifact(fcb_merge_tests).step);
 
     // Just like flags, top level steps are also listed in the `--help` menu.
     //
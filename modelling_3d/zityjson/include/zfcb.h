@@ -91,6 +91,17 @@ int zfcb_reader_header_geographical_extent(
     double* out_min_xyz,
     double* out_max_xyz);
 
+// Get the header transform that writers opened from this reader quantize
+// replacement vertices with: q = round((world - translate) / scale).
+// out_scale_xyz/out_translate_xyz must each point to an array of at least 3 doubles.
+// Returns:
+//   1 => success
+//  -1 => error (invalid args/handle)
+int zfcb_reader_header_transform(
+    ZfcbReaderHandle handle,
+    double* out_scale_xyz,
+    double* out_translate_xyz);
+
 // Streaming iteration.
 // peek/skip/next return:
 //   1 => success with data (for peek/next) or feature skipped (skip)
@@ -100,6 +111,38 @@ int zfcb_peek_next_id(ZfcbReaderHandle handle, const char** out_id, size_t* out_
 int zfcb_skip_next(ZfcbReaderHandle handle);
 int zfcb_next(ZfcbReaderHandle handle);
 
+// File offset of the feature the next peek/next/skip returns (a peeked feature
+// is not consumed yet), or -1 on error. Together with
+// zfcb_writer_offset it marks a point to resume a rewrite from.
+int64_t zfcb_reader_next_feature_offset(ZfcbReaderHandle handle);
+// Seek to an offset returned by zfcb_reader_next_feature_offset for the same
+// file. Returns 0 on success, -1 on error (e.g. the input is not seekable).
+int zfcb_reader_seek_feature(ZfcbReaderHandle handle, uint64_t offset);
+
+// Selects what zfcb_next_selective decodes. Strings are (pointer, length) pairs;
+// a NULL pointer disables that part of the filter.
+// Every object and geometry of the feature is still listed (ids, types and LoDs
+// stay queryable and indices stay stable), but geometries outside the filter
+// report zero surfaces/strings/boundaries and only the selected attributes are
+// returned by zfcb_current_object_string_attribute.
+typedef struct {
+    // Decode geometries only for the object "<feature id><suffix>", e.g. "-0".
+    const char* geometry_object_suffix;
+    size_t geometry_object_suffix_len;
+    // Decode only geometries with this LoD, e.g. "2.2".
+    const char* lod;
+    size_t lod_len;
+    // Decode only attributes with these names. NULL => all attributes,
+    // non-NULL with attribute_name_count == 0 => no attributes.
+    const char* const* attribute_names;
+    const size_t* attribute_name_lens;
+    size_t attribute_name_count;
+} ZfcbDecodeFilter;
+
+// Like zfcb_next, but decodes only what filter selects (NULL => everything).
+// Raw-rewrite writers are unaffected: they always work from the full feature bytes.
+int zfcb_next_selective(ZfcbReaderHandle handle, const ZfcbDecodeFilter* filter);
+
 // Current decoded feature data (valid after successful zfcb_next and until next skip/next/destroy).
 int zfcb_current_feature_id(ZfcbReaderHandle handle, const char** out_id, size_t* out_len);
 size_t zfcb_current_vertex_count(ZfcbReaderHandle handle);
@@ -128,6 +171,11 @@ int zfcb_current_geometry_lod(
     size_t geometry_index,
     const char** out_lod,
     size_t* out_len);
+// Returns:
+//   1 => geometry arrays decoded
+//   0 => geometry skipped by the zfcb_next_selective filter
+//  -1 => invalid args/handle/indices
+int zfcb_current_geometry_is_decoded(ZfcbReaderHandle handle, size_t object_index, size_t geometry_index);
 size_t zfcb_current_geometry_surface_count(ZfcbReaderHandle handle, size_t object_index, size_t geometry_index);
 size_t zfcb_current_geometry_string_count(ZfcbReaderHandle handle, size_t object_index, size_t geometry_index);
 size_t zfcb_current_geometry_boundary_count(ZfcbReaderHandle handle, size_t object_index, size_t geometry_index);
@@ -145,6 +193,53 @@ int zfcb_current_geometry_surface_semantic_type(
     size_t surface_index,
     uint8_t* out_semantic_type);
 
+// Semantic type reported in ZfcbGeometrySpans for surfaces without a semantic assignment.
+#define ZFCB_SEMANTIC_TYPE_NONE 255
+
+// Contiguous views over one geometry of the current feature. All pointers are
+// NULL when the matching count is 0.
+typedef struct {
+    size_t object_index;
+    size_t geometry_index;
+    uint8_t geometry_type;               // ZfcbGeometryType
+    const double* vertices;              // feature vertex pool, xyz packed, world coordinates
+    size_t vertex_count;
+    const uint32_t* surfaces;            // ring count per surface
+    size_t surface_count;
+    const uint32_t* strings;             // vertex count per ring
+    size_t string_count;
+    const uint32_t* boundaries;          // ring vertex indices into vertices
+    size_t boundary_count;
+    const uint8_t* surface_semantic_types; // length surface_count, ZFCB_SEMANTIC_TYPE_NONE if unassigned
+} ZfcbGeometrySpans;
+
+// Find an object of the current feature by id.
+// Returns:
+//   1 => object found, index written to out_index
+//   0 => no object with that id
+//  -1 => invalid args/handle
+int zfcb_current_find_object(
+    ZfcbReaderHandle handle,
+    const char* object_id,
+    size_t object_id_len,
+    size_t* out_index);
+
+// Fill out with spans over the first Solid/MultiSolid/CompositeSolid geometry
+// with the given LoD on the given object, in a single call.
+// Spans remain valid until the next zfcb_next / zfcb_skip_next /
+// zfcb_current_solid_geometry / destroy.
+// Returns:
+//   1 => geometry found
+//   0 => object or geometry not found
+//  -1 => invalid args/handle
+int zfcb_current_solid_geometry(
+    ZfcbReaderHandle handle,
+    const char* object_id,
+    size_t object_id_len,
+    const char* lod,
+    size_t lod_len,
+    ZfcbGeometrySpans* out);
+
 // Writer API – open from an existing reader (copies preamble), write features.
 typedef struct Writer* ZfcbWriterHandle;
 
@@ -175,6 +270,17 @@ ZfcbWriterHandle zfcb_writer_open_new_no_index(
     double translate_x,
     double translate_y,
     double translate_z);
+// Reopen an output written by a zfcb_writer_open_from_reader* writer for this
+// reader and continue it at offset (a value of zfcb_writer_offset), truncating
+// whatever follows. The header is not rewritten. Returns NULL on failure.
+ZfcbWriterHandle zfcb_writer_open_resume_from_reader(
+    ZfcbReaderHandle reader_handle,
+    const char* output_path,
+    uint64_t offset);
+// Bytes written so far (header included), or -1 on error.
+int64_t zfcb_writer_offset(ZfcbWriterHandle writer_handle);
+// fsync the output. Returns 0 on success, -1 on error.
+int zfcb_writer_sync(ZfcbWriterHandle writer_handle);
 void zfcb_writer_destroy(ZfcbWriterHandle writer_handle);
 
 // Write the pending (peeked but not yet decoded) raw feature bytes. Returns 1/0/-1.
@@ -301,6 +407,46 @@ int zfcb_writer_write_current_replaced_lod22_polygonal_with_attributes(
     size_t source_attribute_count,
     uint8_t source_attribute_target);
 
+// One solid replaced by zfcb_writer_write_current_replaced_solids. A NULL
+// surface_ring_counts makes boundary_indices a flat triangle list with one
+// semantic type per triangle; otherwise the arrays follow the polygonal layout
+// of zfcb_writer_write_current_replaced_lod22_polygonal.
+typedef struct {
+    const char* lod;
+    size_t lod_len;
+    const double* vertices_xyz_world;
+    size_t vertex_count;
+    const uint32_t* surface_ring_counts;
+    size_t surface_count;
+    const uint32_t* ring_vertex_counts;
+    size_t ring_count;
+    const uint32_t* boundary_indices;
+    size_t boundary_index_count;
+    const uint8_t* surface_semantic_types;
+    size_t surface_semantic_types_count;
+} ZfcbSolidReplacement;
+
+// Replaces the Solid of each replacement's LoD in object "<feature_id>-0" and
+// writes the feature once; solids of other LoDs are kept.
+// source_attribute_count == 0 leaves the attributes unchanged.
+// Returns 0 on success, -1 on error (nothing is written then).
+int zfcb_writer_write_current_replaced_solids(
+    ZfcbReaderHandle reader_handle,
+    ZfcbWriterHandle writer_handle,
+    const char* feature_id,
+    size_t feature_id_len,
+    const ZfcbSolidReplacement* replacements,
+    size_t replacement_count,
+    const char* const* source_attribute_names,
+    const size_t* source_attribute_name_lens,
+    const uint8_t* source_attribute_types,
+    const int64_t* source_attribute_integer_values,
+    const double* source_attribute_real_values,
+    const char* const* source_attribute_string_values,
+    const size_t* source_attribute_string_value_lens,
+    size_t source_attribute_count,
+    uint8_t source_attribute_target);
+
 #ifdef __cplusplus
 }
 #endif
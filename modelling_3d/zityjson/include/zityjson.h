@@ -13,6 +13,7 @@ extern "C" {
 typedef struct CityJSON* CityJSONHandle;
 typedef struct CityJSONSeqReader* CityJSONSeqReaderHandle;
 typedef struct CityJSONSeqWriter* CityJSONSeqWriterHandle;
+typedef struct CityJSONTile* CityJSONTileHandle;
 
 // Face type enumeration (matches Zig FaceType enum)
 typedef enum {
@@ -130,6 +131,37 @@ int cityjson_get_geometry_surface_semantic_type(
     uint8_t* out_semantic_type
 );
 
+// Zero-copy views over one stored geometry. All pointers are NULL when the
+// matching count is 0.
+typedef struct {
+    size_t geometry_index;
+    uint8_t geometry_type;               // CITYJSON_MULTISURFACE / CITYJSON_SOLID
+    const double* vertices;              // geometry-local vertices, xyz packed, world coordinates
+    size_t vertex_count;
+    const size_t* surfaces;              // ring count per surface
+    size_t surface_count;
+    const size_t* strings;               // vertex count per ring
+    size_t string_count;
+    const size_t* boundaries;            // ring vertex indices into vertices
+    size_t boundary_count;
+    const uint8_t* surface_semantic_types; // length surface_count (zfcb semantic enum values)
+} CityJSONGeometrySpans;
+
+// Fill out with spans over the first Solid geometry with the given LoD on an
+// object, in a single call. Spans stay valid until the object is modified or
+// the handle is destroyed.
+// Returns:
+//   1 => geometry found
+//   0 => object has no such geometry
+//  -1 => invalid args/handle/object index
+int cityjson_get_solid_geometry(
+    CityJSONHandle handle,
+    size_t object_index,
+    const char* lod,
+    size_t lod_len,
+    CityJSONGeometrySpans* out
+);
+
 // Get the vertex count for a geometry by object and geometry index.
 size_t cityjson_get_vertex_count(CityJSONHandle handle, size_t object_index, size_t geometry_index);
 
@@ -163,8 +195,19 @@ int cityjson_get_face_info(
 // CityJSONSeq streaming reader/writer API
 // ---------------------------------------------------------------------------
 
+// Output compression for cityjsonseq_writer_open_from_reader_fd. Path-based
+// writers pick zstd/gzip from a .zst/.gz extension.
+#define CITYJSONSEQ_COMPRESSION_NONE 0
+#define CITYJSONSEQ_COMPRESSION_ZSTD 1
+#define CITYJSONSEQ_COMPRESSION_GZIP 2
+
 // Open / close a CityJSONSeq reader.
+// zstd and gzip input is detected from the stream magic, so .jsonl, .jsonl.zst
+// and .jsonl.gz paths (or pipes) are all accepted.
 CityJSONSeqReaderHandle cityjsonseq_reader_open(const char* path);
+// Read from an open descriptor (e.g. STDIN_FILENO). The descriptor is closed
+// on destroy only when close_on_destroy is non-zero.
+CityJSONSeqReaderHandle cityjsonseq_reader_open_fd(int fd, int close_on_destroy);
 void cityjsonseq_reader_destroy(CityJSONSeqReaderHandle handle);
 
 // Get world-coordinate extent from the CityJSONSeq header metadata.geographicalExtent.
@@ -178,16 +221,30 @@ int cityjsonseq_reader_header_geographical_extent(
     double* out_max_xyz
 );
 
+// Get the header transform that writers opened from this reader quantize
+// replacement vertices with: q = round((world - translate) / scale).
+// Returns:
+//   1 => success
+//  -1 => error
+int cityjsonseq_reader_header_transform(
+    CityJSONSeqReaderHandle handle,
+    double* out_scale_xyz,
+    double* out_translate_xyz
+);
+
 // Streaming iteration.
 // Returns:
 //   1 => success with data
 //   0 => end-of-file
 //  -1 => error
+// Peeking only scans the top-level "type" and "id" keys of the next line.
 int cityjsonseq_peek_next_id(CityJSONSeqReaderHandle handle, const char** out_id, size_t* out_len);
 int cityjsonseq_next(CityJSONSeqReaderHandle handle);
 int cityjsonseq_current_feature_id(CityJSONSeqReaderHandle handle, const char** out_id, size_t* out_len);
 
 // Access decoded CityJSON for the current feature (valid until next/peek/destroy).
+// Every CityObject of the feature is present, but geometry is only decoded for
+// the LoD 2.2 Solids of the "<id>" and "<id>-0" objects.
 CityJSONHandle cityjsonseq_current_cityjson(CityJSONSeqReaderHandle handle);
 
 // Open / close a CityJSONSeq writer from an existing reader (writes the header).
@@ -195,7 +252,19 @@ CityJSONSeqWriterHandle cityjsonseq_writer_open_from_reader(
     CityJSONSeqReaderHandle reader_handle,
     const char* output_path
 );
-void cityjsonseq_writer_destroy(CityJSONSeqWriterHandle writer_handle);
+// Write to an open descriptor (e.g. STDOUT_FILENO) with one of the
+// CITYJSONSEQ_COMPRESSION_* codecs.
+CityJSONSeqWriterHandle cityjsonseq_writer_open_from_reader_fd(
+    CityJSONSeqReaderHandle reader_handle,
+    int fd,
+    uint8_t compression,
+    int close_on_destroy
+);
+// Flush buffered output and end the compressed stream. Returns 0/-1.
+// Destroy finishes the stream too when finish was not called, and returns -1
+// if that fails; the writer is released either way.
+int cityjsonseq_writer_finish(CityJSONSeqWriterHandle writer_handle);
+int cityjsonseq_writer_destroy(CityJSONSeqWriterHandle writer_handle);
 
 // Write pending/current raw feature lines.
 // cityjsonseq_writer_write_pending_raw returns 1/0/-1.
@@ -210,7 +279,8 @@ int cityjsonseq_writer_write_current_raw(
 );
 
 // Write current feature unchanged except for typed attributes merged into the
-// target object attributes.
+// target object attributes. Only the attribute members are inserted; the rest
+// of the line is copied verbatim.
 int cityjsonseq_writer_write_current_with_attributes(
     CityJSONSeqReaderHandle reader_handle,
     CityJSONSeqWriterHandle writer_handle,
@@ -228,6 +298,9 @@ int cityjsonseq_writer_write_current_with_attributes(
 );
 
 // Write current feature with LoD 2.2 Solid geometry replaced by a triangle mesh.
+// The replacement is spliced into the original line: other CityObjects and
+// geometries are copied byte for byte, new vertices are appended after the
+// existing ones, and vertices only the old geometry used are kept.
 // Semantics type values match zfcb semantic enum values:
 //   0=RoofSurface, 1=GroundSurface, 2=WallSurface, 4=OuterCeilingSurface.
 // Returns 0 on success, -1 on failure.
@@ -364,6 +437,100 @@ int cityjsonseq_writer_write_current_replaced_lod22_polygonal_with_semantic_surf
     size_t surface_attribute_count
 );
 
+// ---------------------------------------------------------------------------
+// CityJSON tile API
+// ---------------------------------------------------------------------------
+
+// A whole .city.json file held in memory. Replacements and attribute merges
+// are recorded as byte splices into the original document and written by
+// cityjson_tile_save in one pass, so everything they do not touch (metadata,
+// attributes, other LoDs) is preserved byte for byte. New vertices are
+// appended to the shared "vertices" array.
+//
+// Reading the CityJSON from cityjson_tile_cityjson is safe from several
+// threads at once; recording and saving are not and must be serialized by
+// the caller.
+
+// Open / close a tile. Returns NULL on failure.
+CityJSONTileHandle cityjson_tile_open(const char* path);
+void cityjson_tile_destroy(CityJSONTileHandle handle);
+
+// Every CityObject of the tile, with geometry decoded for LoD 2.2 Solids
+// only. Owned by the tile; it does not reflect recorded replacements.
+CityJSONHandle cityjson_tile_cityjson(CityJSONTileHandle handle);
+
+// Get world-coordinate extent from metadata.geographicalExtent.
+// Returns:
+//   1 => success, extent available
+//   0 => no extent available
+//  -1 => error
+int cityjson_tile_geographical_extent(
+    CityJSONTileHandle handle,
+    double* out_min_xyz,
+    double* out_max_xyz
+);
+
+// Get the transform replacement vertices are quantized with.
+// Returns:
+//   1 => success
+//  -1 => error
+int cityjson_tile_transform(
+    CityJSONTileHandle handle,
+    double* out_scale_xyz,
+    double* out_translate_xyz
+);
+
+// Record the replacement of a feature's LoD 2.2 Solid (on its "<id>-0"
+// building part when present) by polygonal surfaces, with the same
+// arguments as cityjsonseq_writer_write_current_replaced_lod22_polygonal_with_attributes.
+// Each feature can be replaced or merged into once.
+// Returns 0 on success, -1 on failure; a failed call records nothing.
+int cityjson_tile_replace_lod22_polygonal(
+    CityJSONTileHandle handle,
+    const char* feature_id,
+    size_t feature_id_len,
+    const double* vertices_xyz_world,
+    size_t vertex_count,
+    const uint32_t* surface_ring_counts,
+    size_t surface_count,
+    const uint32_t* ring_vertex_counts,
+    size_t ring_count,
+    const uint32_t* boundary_indices,
+    size_t boundary_index_count,
+    const uint8_t* surface_semantic_types,
+    size_t surface_semantic_types_count,
+    const char* const* source_attribute_names,
+    const size_t* source_attribute_name_lens,
+    const uint8_t* source_attribute_types,
+    const int64_t* source_attribute_integer_values,
+    const double* source_attribute_real_values,
+    const char* const* source_attribute_string_values,
+    const size_t* source_attribute_string_value_lens,
+    size_t source_attribute_count,
+    uint8_t source_attribute_target
+);
+
+// Record source attributes to merge into a feature whose geometry is kept.
+// Returns 0 on success, -1 on failure.
+int cityjson_tile_merge_attributes(
+    CityJSONTileHandle handle,
+    const char* feature_id,
+    size_t feature_id_len,
+    const char* const* source_attribute_names,
+    const size_t* source_attribute_name_lens,
+    const uint8_t* source_attribute_types,
+    const int64_t* source_attribute_integer_values,
+    const double* source_attribute_real_values,
+    const char* const* source_attribute_string_values,
+    const size_t* source_attribute_string_value_lens,
+    size_t source_attribute_count,
+    uint8_t source_attribute_target
+);
+
+// Write the tile with every recorded splice applied.
+// Returns 0 on success, -1 on failure.
+int cityjson_tile_save(CityJSONTileHandle handle, const char* path);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,376 @@
+//! Streaming zstd/gzip decode and encode for CityJSONSeq I/O.
+//!
+//! Decoding sniffs the frame magic, so plain, .zst and .gz inputs can all be
+//! read from a path or a pipe. Encoding is selected by the caller (from the
+//! output extension or explicitly for fds). zstd output uses libzstd worker
+//! threads; gzip goes through zlib.
+
+const std = @import("std");
+
+pub const Codec = enum(u8) {
+    none = 0,
+    zstd = 1,
+    gzip = 2,
+
+    pub fn fromPath(path: []const u8) Codec {
+        if (std.mem.endsWith(u8, path, ".zst")) return .zstd;
+        if (std.mem.endsWith(u8, path, ".gz")) return .gzip;
+        return .none;
+    }
+
+    pub fn sniff(prefix: []const u8) Codec {
+        if (std.mem.startsWith(u8, prefix, &.{ 0x28, 0xB5, 0x2F, 0xFD })) return .zstd;
+        if (std.mem.startsWith(u8, prefix, &.{ 0x1F, 0x8B })) return .gzip;
+        return .none;
+    }
+};
+
+// =============================================================================
+// libzstd / zlib bindings
+// =============================================================================
+
+const c = @cImport({
+    // const-correct next_in, so input slices need no casts.
+    @cDefine("ZLIB_CONST", {});
+    @cInclude("zstd.h");
+    @cInclude("zlib.h");
+});
+
+const ZSTD_DStream = c.ZSTD_DStream;
+const ZSTD_CCtx = c.ZSTD_CCtx;
+const ZStream = c.z_stream;
+
+// windowBits 15 plus 16 selects the gzip wrapper.
+const GZIP_WINDOW_BITS: c_int = 15 + 16;
+
+// inflateInit2/deflateInit2 are macros over these, passing the header's
+// version and struct size so a mismatched libz refuses the stream.
+fn inflateInit2(strm: *ZStream, window_bits: c_int) c_int {
+    return c.inflateInit2_(strm, window_bits, c.ZLIB_VERSION, @sizeOf(ZStream));
+}
+
+fn deflateInit2(strm: *ZStream, level: c_int, method: c_int, window_bits: c_int, mem_level: c_int, strategy: c_int) c_int {
+    return c.deflateInit2_(strm, level, method, window_bits, mem_level, strategy, c.ZLIB_VERSION, @sizeOf(ZStream));
+}
+
+const COMPRESSED_BUF_SIZE = 128 * 1024;
+
+fn writeFdAll(fd: std.posix.fd_t, bytes: []const u8) !void {
+    var written: usize = 0;
+    while (written < bytes.len) {
+        written += try std.posix.write(fd, bytes[written..]);
+    }
+}
+
+// =============================================================================
+// Source: fd-backed byte stream with transparent decompression
+// =============================================================================
+
+pub const Source = struct {
+    fd: std.posix.fd_t,
+    owns_fd: bool,
+    codec: Codec,
+    // Compressed input (or the sniffed prefix of a plain stream).
+    in_buf: []u8,
+    in_len: usize = 0,
+    in_pos: usize = 0,
+    in_eof: bool = false,
+    zstd: ?*ZSTD_DStream = null,
+    zlib: ZStream = std.mem.zeroes(ZStream),
+    zlib_active: bool = false,
+    // Set when the decoder sits on a frame/member boundary, so EOF there is clean.
+    at_frame_end: bool = true,
+
+    /// Takes over `fd` (closed on deinit when `owns_fd`) and detects the codec
+    /// from the first bytes of the stream.
+    pub fn init(allocator: std.mem.Allocator, fd: std.posix.fd_t, owns_fd: bool) !Source {
+        errdefer if (owns_fd) std.posix.close(fd);
+
+        var source: Source = .{
+            .fd = fd,
+            .owns_fd = owns_fd,
+            .codec = .none,
+            .in_buf = try allocator.alloc(u8, COMPRESSED_BUF_SIZE),
+        };
+        errdefer allocator.free(source.in_buf);
+
+        // A short first read from a pipe could split the magic; keep reading
+        // until four bytes are buffered or the stream ends.
+        while (source.in_len < 4 and !source.in_eof) {
+            try source.refill();
+        }
+        source.codec = Codec.sniff(source.in_buf[0..source.in_len]);
+
+        switch (source.codec) {
+            .none => {},
+            .zstd => {
+                source.zstd = c.ZSTD_createDStream() orelse return error.OutOfMemory;
+                if (c.ZSTD_isError(c.ZSTD_initDStream(source.zstd.?)) != 0) {
+                    _ = c.ZSTD_freeDStream(source.zstd);
+                    return error.ZstdInitFailed;
+                }
+            },
+            .gzip => {
+                if (inflateInit2(&source.zlib, GZIP_WINDOW_BITS) != c.Z_OK) {
+                    return error.GzipInitFailed;
+                }
+                source.zlib_active = true;
+            },
+        }
+        return source;
+    }
+
+    pub fn deinit(self: *Source, allocator: std.mem.Allocator) void {
+        if (self.zstd) |zds| _ = c.ZSTD_freeDStream(zds);
+        if (self.zlib_active) _ = c.inflateEnd(&self.zlib);
+        allocator.free(self.in_buf);
+        if (self.owns_fd) std.posix.close(self.fd);
+    }
+
+    /// Appends raw bytes from the fd to in_buf, compacting consumed input first.
+    fn refill(self: *Source) !void {
+        if (self.in_pos > 0) {
+            const remaining = self.in_len - self.in_pos;
+            std.mem.copyForwards(u8, self.in_buf[0..remaining], self.in_buf[self.in_pos..self.in_len]);
+            self.in_len = remaining;
+            self.in_pos = 0;
+        }
+        if (self.in_len == self.in_buf.len) return;
+        const n = try std.posix.read(self.fd, self.in_buf[self.in_len..]);
+        if (n == 0) self.in_eof = true;
+        self.in_len += n;
+    }
+
+    /// Reads decoded bytes into `out`. Returns 0 at end of stream.
+    pub fn read(self: *Source, out: []u8) !usize {
+        return switch (self.codec) {
+            .none => self.readPlain(out),
+            .zstd => self.readZstd(out),
+            .gzip => self.readGzip(out),
+        };
+    }
+
+    fn readPlain(self: *Source, out: []u8) !usize {
+        if (self.in_pos < self.in_len) {
+            const n = @min(out.len, self.in_len - self.in_pos);
+            @memcpy(out[0..n], self.in_buf[self.in_pos..][0..n]);
+            self.in_pos += n;
+            return n;
+        }
+        if (self.in_eof) return 0;
+        return std.posix.read(self.fd, out);
+    }
+
+    fn readZstd(self: *Source, out: []u8) !usize {
+        const zds = self.zstd.?;
+        while (true) {
+            if (self.in_pos == self.in_len and !self.in_eof) try self.refill();
+
+            var input: c.ZSTD_inBuffer = .{ .src = self.in_buf.ptr, .size = self.in_len, .pos = self.in_pos };
+            var output: c.ZSTD_outBuffer = .{ .dst = out.ptr, .size = out.len, .pos = 0 };
+            const ret = c.ZSTD_decompressStream(zds, &output, &input);
+            if (c.ZSTD_isError(ret) != 0) return error.ZstdDecompressFailed;
+            self.in_pos = input.pos;
+            self.at_frame_end = ret == 0;
+
+            if (output.pos > 0) return output.pos;
+            if (self.in_eof and self.in_pos == self.in_len) {
+                if (!self.at_frame_end) return error.TruncatedCompressedStream;
+                return 0;
+            }
+        }
+    }
+
+    fn readGzip(self: *Source, out: []u8) !usize {
+        while (true) {
+            if (self.in_pos == self.in_len and !self.in_eof) try self.refill();
+            if (self.in_eof and self.in_pos == self.in_len) {
+                if (!self.at_frame_end) return error.TruncatedCompressedStream;
+                return 0;
+            }
+
+            // Concatenated gzip members (e.g. from pigz or appended files)
+            // decode as one stream.
+            if (self.at_frame_end and self.zlib.total_in != 0) {
+                if (c.inflateReset(&self.zlib) != c.Z_OK) return error.GzipDecompressFailed;
+            }
+
+            const avail_in = self.in_len - self.in_pos;
+            self.zlib.next_in = self.in_buf.ptr + self.in_pos;
+            self.zlib.avail_in = @intCast(avail_in);
+            self.zlib.next_out = out.ptr;
+            self.zlib.avail_out = @intCast(@min(out.len, std.math.maxInt(c_uint)));
+            const avail_out = self.zlib.avail_out;
+
+            const ret = c.inflate(&self.zlib, c.Z_NO_FLUSH);
+            if (ret != c.Z_OK and ret != c.Z_STREAM_END and ret != c.Z_BUF_ERROR) return error.GzipDecompressFailed;
+            self.in_pos += avail_in - self.zlib.avail_in;
+            self.at_frame_end = ret == c.Z_STREAM_END;
+
+            const produced = avail_out - self.zlib.avail_out;
+            if (produced > 0) return produced;
+        }
+    }
+};
+
+// =============================================================================
+// Sink: buffered fd writer with optional compression
+// =============================================================================
+
+pub const Sink = struct {
+    fd: std.posix.fd_t,
+    owns_fd: bool,
+    codec: Codec,
+    buf: []u8,
+    buf_len: usize = 0,
+    zstd: ?*ZSTD_CCtx = null,
+    zlib: ZStream = std.mem.zeroes(ZStream),
+    zlib_active: bool = false,
+    finished: bool = false,
+
+    /// Takes over `fd` (closed on deinit when `owns_fd`). zstd output uses one
+    /// libzstd worker per CPU; libzstd builds without threading fall back to
+    /// single-threaded compression.
+    pub fn init(allocator: std.mem.Allocator, fd: std.posix.fd_t, owns_fd: bool, codec: Codec) !Sink {
+        errdefer if (owns_fd) std.posix.close(fd);
+
+        var sink: Sink = .{
+            .fd = fd,
+            .owns_fd = owns_fd,
+            .codec = codec,
+            .buf = try allocator.alloc(u8, COMPRESSED_BUF_SIZE),
+        };
+        errdefer allocator.free(sink.buf);
+
+        switch (codec) {
+            .none => {},
+            .zstd => {
+                const cctx = c.ZSTD_createCCtx() orelse return error.OutOfMemory;
+                sink.zstd = cctx;
+                _ = c.ZSTD_CCtx_setParameter(cctx, c.ZSTD_c_compressionLevel, 3);
+                const workers: c_int = @intCast(@min(std.Thread.getCpuCount() catch 1, 64));
+                _ = c.ZSTD_CCtx_setParameter(cctx, c.ZSTD_c_nbWorkers, workers);
+            },
+            .gzip => {
+                if (deflateInit2(
+                    &sink.zlib,
+                    c.Z_DEFAULT_COMPRESSION,
+                    c.Z_DEFLATED,
+                    GZIP_WINDOW_BITS,
+                    8,
+                    c.Z_DEFAULT_STRATEGY,
+                ) != c.Z_OK) {
+                    return error.GzipInitFailed;
+                }
+                sink.zlib_active = true;
+            },
+        }
+        return sink;
+    }
+
+    pub fn deinit(self: *Sink, allocator: std.mem.Allocator) void {
+        if (self.zstd) |cctx| _ = c.ZSTD_freeCCtx(cctx);
+        if (self.zlib_active) _ = c.deflateEnd(&self.zlib);
+        allocator.free(self.buf);
+        if (self.owns_fd) std.posix.close(self.fd);
+    }
+
+    fn flushBuf(self: *Sink) !void {
+        if (self.buf_len == 0) return;
+        try writeFdAll(self.fd, self.buf[0..self.buf_len]);
+        self.buf_len = 0;
+    }
+
+    pub fn writeAll(self: *Sink, bytes: []const u8) !void {
+        switch (self.codec) {
+            .none => {
+                if (bytes.len > self.buf.len - self.buf_len) try self.flushBuf();
+                if (bytes.len >= self.buf.len) return writeFdAll(self.fd, bytes);
+                @memcpy(self.buf[self.buf_len..][0..bytes.len], bytes);
+                self.buf_len += bytes.len;
+            },
+            .zstd => try self.compressZstd(bytes, c.ZSTD_e_continue),
+            .gzip => try self.compressGzip(bytes, c.Z_NO_FLUSH),
+        }
+    }
+
+    /// Ends the compressed frame and writes out everything still buffered.
+    pub fn finish(self: *Sink) !void {
+        if (self.finished) return;
+        self.finished = true;
+        switch (self.codec) {
+            .none => {},
+            .zstd => try self.compressZstd(&.{}, c.ZSTD_e_end),
+            .gzip => try self.compressGzip(&.{}, c.Z_FINISH),
+        }
+        try self.flushBuf();
+    }
+
+    fn compressZstd(self: *Sink, bytes: []const u8, end_op: c.ZSTD_EndDirective) !void {
+        const cctx = self.zstd.?;
+        var input: c.ZSTD_inBuffer = .{ .src = bytes.ptr, .size = bytes.len, .pos = 0 };
+        while (true) {
+            if (self.buf_len == self.buf.len) try self.flushBuf();
+            const input_pos = input.pos;
+            var output: c.ZSTD_outBuffer = .{ .dst = self.buf.ptr + self.buf_len, .size = self.buf.len - self.buf_len, .pos = 0 };
+            const remaining = c.ZSTD_compressStream2(cctx, &output, &input, end_op);
+            if (c.ZSTD_isError(remaining) != 0) return error.ZstdCompressFailed;
+            self.buf_len += output.pos;
+            const done = if (end_op == c.ZSTD_e_end) remaining == 0 else input.pos == input.size;
+            if (done) return;
+            // With worker threads, libzstd blocks on a running job when it can
+            // take no more input, as long as there is output space to flush
+            // into. Guarantee that space: a call that made no progress at all
+            // gets the whole buffer next time rather than spinning.
+            if (input.pos == input_pos and output.pos == 0) try self.flushBuf();
+        }
+    }
+
+    fn compressGzip(self: *Sink, bytes: []const u8, flush: c_int) !void {
+        var offset: usize = 0;
+        while (true) {
+            if (self.buf_len == self.buf.len) try self.flushBuf();
+            const chunk_len = @min(bytes.len - offset, std.math.maxInt(c_uint));
+            self.zlib.next_in = bytes.ptr + offset;
+            self.zlib.avail_in = @intCast(chunk_len);
+            self.zlib.next_out = self.buf.ptr + self.buf_len;
+            self.zlib.avail_out = @intCast(self.buf.len - self.buf_len);
+            const avail_out = self.zlib.avail_out;
+
+            const ret = c.deflate(&self.zlib, flush);
+            if (ret != c.Z_OK and ret != c.Z_STREAM_END and ret != c.Z_BUF_ERROR) return error.GzipCompressFailed;
+            offset += chunk_len - self.zlib.avail_in;
+            self.buf_len += avail_out - self.zlib.avail_out;
+
+            const done = if (flush == c.Z_FINISH) ret == c.Z_STREAM_END else offset == bytes.len and self.zlib.avail_out != 0;
+            if (done) return;
+        }
+    }
+};
+
+test "zstd and gzip sinks round-trip through a sniffing source" {
+    const allocator = std.testing.allocator;
+    const payload = "{\"type\":\"CityJSON\"}\n{\"type\":\"CityJSONFeature\",\"id\":\"a\"}\n" ** 64;
+
+    for ([_]Codec{ .none, .zstd, .gzip }) |codec| {
+        const pipe_fds = try std.posix.pipe();
+        var sink = try Sink.init(allocator, pipe_fds[1], true, codec);
+        try sink.writeAll(payload);
+        try sink.finish();
+        sink.deinit(allocator);
+
+        var source = try Source.init(allocator, pipe_fds[0], true);
+        defer source.deinit(allocator);
+        try std.testing.expectEqual(codec, source.codec);
+
+        var decoded: std.ArrayList(u8) = .empty;
+        defer decoded.deinit(allocator);
+        var chunk: [512]u8 = undefined;
+        while (true) {
+            const n = try source.read(&chunk);
+            if (n == 0) break;
+            try decoded.appendSlice(allocator, chunk[0..n]);
+        }
+        try std.testing.expectEqualStrings(payload, decoded.items);
+    }
+}
@@ -0,0 +1,96 @@
+const std = @import("std");
+const zfcb = @import("zfcb.zig");
+
+// Must match ShardSpec::owns in src/FeatureSharding.h of add_underpass.
+fn ownerShard(feature_id: []const u8, shard_count: usize) usize {
+    return @intCast(std.hash.Fnv1a_64.hash(feature_id) % @as(u64, @intCast(shard_count)));
+}
+
+// Combines the outputs of `add_underpass --shard i/n` into one FlatCityBuf in
+// the feature order of the original input. Every feature is copied from the
+// shard that owns it, so shard outputs written with and without --shard-only
+// merge the same way; other shards' copies of it are skipped.
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    const args = try std.process.argsAlloc(allocator);
+    defer std.process.argsFree(allocator, args);
+
+    if (args.len < 4) {
+        const exe = args[0];
+        std.debug.print("Usage: {s} <original.fcb> <merged.fcb> <shard_0.fcb> [shard_1.fcb ...]\n", .{exe});
+        std.debug.print("  shard outputs in shard order, i.e. the output of --shard i/n as the i-th shard file\n", .{});
+        return error.InvalidArguments;
+    }
+    const original_path = args[1];
+    const merged_path = args[2];
+    const shard_paths = args[3..];
+
+    var original = try zfcb.Reader.openPath(allocator, original_path);
+    defer original.deinit();
+
+    const shards = try allocator.alloc(zfcb.Reader, shard_paths.len);
+    defer allocator.free(shards);
+    var opened: usize = 0;
+    defer {
+        for (shards[0..opened]) |*shard| shard.deinit();
+    }
+    for (shard_paths) |path| {
+        shards[opened] = try zfcb.Reader.openPath(allocator, path);
+        opened += 1;
+    }
+    // All shards copy the header of the same input, so any one of them
+    // provides the merged header. Only their feature counts differ when they
+    // were written with --shard-only.
+    for (shards[1..], shard_paths[1..]) |*shard, path| {
+        if (!try shard.preambleMatchesExceptFeatureCount(&shards[0])) {
+            std.debug.print("{s}: header differs from {s}\n", .{ path, shard_paths[0] });
+            return error.ShardHeaderMismatch;
+        }
+    }
+
+    var writer = try zfcb.Writer.openPathFromReaderNoIndex(&shards[0], merged_path);
+    defer writer.deinit();
+
+    var merged: u64 = 0;
+    while (try original.peekNextId()) |feature_id| {
+        const owner = ownerShard(feature_id, shards.len);
+        var copied = false;
+        for (shards, 0..) |*shard, shard_index| {
+            const shard_id = (try shard.peekNextId()) orelse continue;
+            if (!std.mem.eql(u8, shard_id, feature_id)) continue;
+            if (shard_index == owner) {
+                try writer.writeFeatureRaw(shard.feature_buf.items);
+                copied = true;
+            }
+            _ = try shard.skipNext();
+        }
+        if (!copied) {
+            std.debug.print(
+                "feature '{s}' is not next in its shard {d} ({s}); are the shard files complete and in shard order?\n",
+                .{ feature_id, owner, shard_paths[owner] },
+            );
+            return error.MissingShardFeature;
+        }
+        _ = try original.skipNext();
+        merged += 1;
+    }
+
+    for (shards, shard_paths) |*shard, path| {
+        if (try shard.peekNextId()) |extra_id| {
+            std.debug.print("{s}: feature '{s}' is not in {s}\n", .{ path, extra_id, original_path });
+            return error.UnexpectedShardFeature;
+        }
+    }
+
+    std.debug.print("Merged {d} features from {d} shards into {s}\n", .{ merged, shards.len, merged_path });
+}
+
+test "owner shard matches the FNV-1a split of add_underpass" {
+    // Same values as ShardSpec{1, 7}.owns() in add_underpass.
+    try std.testing.expectEqual(@as(u64, 0xb45c8c166dbdf43c), std.hash.Fnv1a_64.hash("NL.IMBAG.Pand.0363100012185598"));
+    try std.testing.expectEqual(@as(usize, 1), ownerShard("NL.IMBAG.Pand.0363100012185598", 7));
+    try std.testing.expectEqual(@as(usize, 0), ownerShard("NL.IMBAG.Pand.0363100012185598", 1));
+}
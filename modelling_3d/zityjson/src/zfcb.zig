@@ -10,6 +10,13 @@ fn openFileRead(path: []const u8) !File {
     return std.Io.Dir.cwd().openFile(default_io, path, .{ .mode = .read_only });
 }
 
+fn openFileReadWrite(path: []const u8) !File {
+    if (std.fs.path.isAbsolute(path)) {
+        return std.Io.Dir.openFileAbsolute(default_io, path, .{ .mode = .read_write });
+    }
+    return std.Io.Dir.cwd().openFile(default_io, path, .{ .mode = .read_write });
+}
+
 fn createFileTruncate(path: []const u8) !File {
     if (std.fs.path.isAbsolute(path)) {
         return std.Io.Dir.createFileAbsolute(default_io, path, .{ .truncate = true });
@@ -186,6 +193,10 @@ pub const GeometryType = enum(u8) {
     CompositeSolid = 6,
     GeometryInstance = 7,
     _,
+
+    pub fn isSolidLike(self: GeometryType) bool {
+        return self == .Solid or self == .MultiSolid or self == .CompositeSolid;
+    }
 };
 
 pub const ObjectType = enum(u8) {
@@ -236,11 +247,23 @@ pub const GeometryView = struct {
     boundaries: []const u32,
     semantics: []const u32,
     semantics_objects: []const u8,
+    /// Flatbuffer table position inside the feature buffer.
+    table_pos: usize = 0,
+    /// False when a DecodeFilter skipped this geometry; the arrays are then empty.
+    decoded: bool = true,
 
     pub fn ringCount(self: GeometryView) usize {
         return self.strings.len;
     }
 
+    /// Semantic type of a surface, or null when the surface has no assignment.
+    pub fn surfaceSemanticType(self: GeometryView, surface_index: usize) ?u8 {
+        if (surface_index >= self.semantics.len) return null;
+        const semantic_object_index = self.semantics[surface_index];
+        if (semantic_object_index >= self.semantics_objects.len) return null;
+        return self.semantics_objects[semantic_object_index];
+    }
+
     pub fn ringIndices(self: GeometryView, ring_index: usize) ?[]const u32 {
         if (ring_index >= self.strings.len) return null;
         var start: usize = 0;
@@ -259,6 +282,8 @@ pub const ObjectView = struct {
     extension_type: ?[]const u8,
     geometries: []const GeometryView,
     attributes: []const Attribute,
+    /// Flatbuffer table position inside the feature buffer.
+    table_pos: usize = 0,
 };
 
 pub const FeatureView = struct {
@@ -267,6 +292,52 @@ pub const FeatureView = struct {
     objects: []const ObjectView,
 };
 
+/// Selects which parts of a feature `Reader.nextSelective` decodes. Every object
+/// and geometry still gets a view (id, type, LoD, table position) so indices
+/// are stable, but unselected geometry arrays and attributes are left in the
+/// raw feature buffer.
+pub const DecodeFilter = struct {
+    /// Decode geometries only for the object with id `<feature id><suffix>`.
+    /// null => geometries of every object.
+    geometry_object_suffix: ?[]const u8 = null,
+    /// Decode only geometries with this LoD. null => every LoD.
+    lod: ?[]const u8 = null,
+    /// Decode only attributes with these column names. null => every attribute.
+    attribute_names: ?[]const []const u8 = null,
+
+    pub const all: DecodeFilter = .{};
+
+    fn selectsAllGeometries(self: DecodeFilter) bool {
+        return self.geometry_object_suffix == null and self.lod == null;
+    }
+
+    fn objectSelected(self: DecodeFilter, feature_id: []const u8, object_id: []const u8) bool {
+        const suffix = self.geometry_object_suffix orelse return true;
+        if (object_id.len != feature_id.len + suffix.len) return false;
+        return std.mem.startsWith(u8, object_id, feature_id) and
+            std.mem.eql(u8, object_id[feature_id.len..], suffix);
+    }
+
+    fn lodSelected(self: DecodeFilter, lod: ?[]const u8) bool {
+        const wanted = self.lod orelse return true;
+        const actual = lod orelse return false;
+        return std.mem.eql(u8, actual, wanted);
+    }
+
+    fn decodesAttributes(self: DecodeFilter) bool {
+        const names = self.attribute_names orelse return true;
+        return names.len > 0;
+    }
+
+    fn attributeSelected(self: DecodeFilter, name: []const u8) bool {
+        const names = self.attribute_names orelse return true;
+        for (names) |wanted| {
+            if (std.mem.eql(u8, wanted, name)) return true;
+        }
+        return false;
+    }
+};
+
 pub const Reader = struct {
     allocator: std.mem.Allocator,
     file: File,
@@ -293,10 +364,16 @@ pub const Reader = struct {
     scratch_column_types: std.ArrayList(ColumnTypeByIndex) = .empty,
     scratch_u32: std.ArrayList(u32) = .empty,
     scratch_u8: std.ArrayList(u8) = .empty,
+    scratch_filter_names: std.ArrayList([]const u8) = .empty,
+    scratch_surface_semantics: std.ArrayList(u8) = .empty,
 
     pending_loaded: bool = false,
     pending_id_owned: ?[]u8 = null,
     reached_eof: bool = false,
+    // File offsets: end of the bytes read so far, and start of the pending
+    // feature. Counted rather than queried, so they also work on pipes.
+    stream_offset: u64 = 0,
+    pending_offset: u64 = 0,
 
     current_feature: FeatureView = .{
         .id = "",
@@ -334,6 +411,8 @@ pub const Reader = struct {
         self.scratch_column_types.deinit(self.allocator);
         self.scratch_u32.deinit(self.allocator);
         self.scratch_u8.deinit(self.allocator);
+        self.scratch_filter_names.deinit(self.allocator);
+        self.scratch_surface_semantics.deinit(self.allocator);
 
         if (self.pending_id_owned) |id| self.allocator.free(id);
         if (self.owns_root_columns) self.allocator.free(self.root_columns);
@@ -367,6 +446,26 @@ pub const Reader = struct {
         return self.header_buf.len - 4;
     }
 
+    /// Position of the header's features_count in the preamble, or null when
+    /// the header does not store it.
+    pub fn featureCountPos(self: *const Reader) !?u64 {
+        const header_table = try fb.sizePrefixedRootTable(self.header_buf);
+        const field_pos = try fb.tableFieldPos(self.header_buf, header_table, VT_HEADER_FEATURES_COUNT) orelse return null;
+        // header_buf starts after the magic bytes.
+        return try checkedAddU64(MAGIC_BYTES.len, field_pos);
+    }
+
+    /// Whether both preambles are the same apart from features_count, as for
+    /// outputs rewritten from one input that kept different features.
+    pub fn preambleMatchesExceptFeatureCount(self: *const Reader, other: *const Reader) !bool {
+        const a = self.preamble();
+        const b = other.preamble();
+        if (a.len != b.len) return false;
+        const pos: usize = @intCast((try self.featureCountPos()) orelse return std.mem.eql(u8, a, b));
+        if (pos + 8 > a.len) return error.InvalidFlatBuffer;
+        return std.mem.eql(u8, a[0..pos], b[0..pos]) and std.mem.eql(u8, a[pos + 8 ..], b[pos + 8 ..]);
+    }
+
     pub fn peekNextId(self: *Reader) !?[]const u8 {
         if (!try self.ensurePending()) return null;
         return self.pending_id_owned;
@@ -379,8 +478,30 @@ pub const Reader = struct {
     }
 
     pub fn next(self: *Reader) !?*const FeatureView {
+        return self.nextSelective(.all);
+    }
+
+    /// File offset of the next feature `peekNextId`/`next` returns; a peeked
+    /// feature has not been consumed yet.
+    pub fn nextFeatureOffset(self: *const Reader) u64 {
+        return if (self.pending_loaded) self.pending_offset else self.stream_offset;
+    }
+
+    /// Repositions the stream at a feature boundary previously returned by
+    /// `nextFeatureOffset` of a reader over the same file. Seekable files only.
+    pub fn seekToFeature(self: *Reader, offset: u64) !void {
+        if (offset < self.preamble_buf.len) return error.InvalidFeatureOffset;
+        try seekTo(self.file, offset);
+        self.stream_offset = offset;
+        self.pending_loaded = false;
+        self.reached_eof = false;
+    }
+
+    /// Like `next`, but only decodes the geometries and attributes selected by
+    /// `filter`. The raw feature bytes stay available for the rewrite path.
+    pub fn nextSelective(self: *Reader, filter: DecodeFilter) !?*const FeatureView {
         if (!try self.ensurePending()) return null;
-        try self.decodePendingFeature();
+        try self.decodePendingFeature(filter);
         self.pending_loaded = false;
         return &self.current_feature;
     }
@@ -431,12 +552,14 @@ pub const Reader = struct {
         if (to_skip_usize > 0) {
             try readExact(&self.file, self.preamble_buf[12 + header_size ..]);
         }
+        self.stream_offset = preamble_len;
     }
 
     fn ensurePending(self: *Reader) !bool {
         if (self.reached_eof) return false;
         if (self.pending_loaded) return true;
 
+        self.pending_offset = self.stream_offset;
         var size_buf: [4]u8 = undefined;
         const size_read = try std.posix.read(self.file.handle, &size_buf);
         if (size_read == 0) {
@@ -454,6 +577,7 @@ pub const Reader = struct {
         try self.feature_buf.resize(self.allocator, feature_size + 4);
         @memcpy(self.feature_buf.items[0..4], &size_buf);
         try readExact(&self.file, self.feature_buf.items[4..]);
+        self.stream_offset = try checkedAddU64(self.stream_offset, feature_size + 4);
 
         const feature_table = try fb.sizePrefixedRootTable(self.feature_buf.items);
         const pending_id = try fb.getRequiredString(self.feature_buf.items, feature_table, VT_FEATURE_ID);
@@ -465,7 +589,7 @@ pub const Reader = struct {
         return true;
     }
 
-    fn decodePendingFeature(self: *Reader) !void {
+    fn decodePendingFeature(self: *Reader, filter: DecodeFilter) !void {
         self.scratch_vertices.clearRetainingCapacity();
         self.scratch_objects.clearRetainingCapacity();
         self.scratch_geometries.clearRetainingCapacity();
@@ -479,7 +603,7 @@ pub const Reader = struct {
         const feature_id = try fb.getRequiredString(self.feature_buf.items, feature_table, VT_FEATURE_ID);
 
         const vertex_count = try self.countFeatureVertices(feature_table);
-        const totals = try self.countFeatureObjectData(feature_table);
+        const totals = try self.countFeatureObjectData(feature_table, feature_id, filter);
         try self.scratch_vertices.ensureTotalCapacity(self.allocator, vertex_count);
         try self.scratch_objects.ensureTotalCapacity(self.allocator, totals.object_count);
         try self.scratch_geometries.ensureTotalCapacity(self.allocator, totals.geometry_count);
@@ -487,8 +611,12 @@ pub const Reader = struct {
         try self.scratch_u32.ensureTotalCapacity(self.allocator, totals.u32_count);
         try self.scratch_u8.ensureTotalCapacity(self.allocator, totals.semantic_object_count);
 
-        try self.decodeVertices(feature_table);
-        try self.decodeObjects(feature_table);
+        // Vertices are shared by all geometries, so they are only skipped when
+        // the filter selected geometries and none of them matched.
+        if (filter.selectsAllGeometries() or totals.decoded_geometry_count > 0) {
+            try self.decodeVertices(feature_table);
+        }
+        try self.decodeObjects(feature_table, feature_id, filter);
 
         self.current_feature = .{
             .id = feature_id,
@@ -500,6 +628,7 @@ pub const Reader = struct {
     const CountTotals = struct {
         object_count: usize = 0,
         geometry_count: usize = 0,
+        decoded_geometry_count: usize = 0,
         attribute_count: usize = 0,
         u32_count: usize = 0,
         semantic_object_count: usize = 0,
@@ -516,7 +645,12 @@ pub const Reader = struct {
         return if (maybe_vec) |vec| vec.len else 0;
     }
 
-    fn countFeatureObjectData(self: *Reader, feature_table: usize) !CountTotals {
+    fn countFeatureObjectData(
+        self: *Reader,
+        feature_table: usize,
+        feature_id: []const u8,
+        filter: DecodeFilter,
+    ) !CountTotals {
         var totals: CountTotals = .{};
         const maybe_objects = try fb.getVectorInfo(self.feature_buf.items, feature_table, VT_FEATURE_OBJECTS);
         if (maybe_objects == null) return totals;
@@ -525,20 +659,34 @@ pub const Reader = struct {
         totals.object_count = objects_vec.len;
         for (0..objects_vec.len) |i| {
             const obj_table = try fb.vectorTableAt(self.feature_buf.items, objects_vec, i);
-            try self.countObjectData(obj_table, &totals);
+            try self.countObjectData(obj_table, feature_id, filter, &totals);
         }
         return totals;
     }
 
-    fn countObjectData(self: *Reader, obj_table: usize, totals: *CountTotals) !void {
+    fn countObjectData(
+        self: *Reader,
+        obj_table: usize,
+        feature_id: []const u8,
+        filter: DecodeFilter,
+        totals: *CountTotals,
+    ) !void {
         if (try fb.getVectorInfo(self.feature_buf.items, obj_table, VT_OBJECT_GEOMETRY)) |geom_vec| {
             totals.geometry_count = try checkedAdd(totals.geometry_count, geom_vec.len);
-            for (0..geom_vec.len) |i| {
-                const geom_table = try fb.vectorTableAt(self.feature_buf.items, geom_vec, i);
-                try self.countGeometryData(geom_table, totals);
+            const object_id = try fb.getRequiredString(self.feature_buf.items, obj_table, VT_OBJECT_ID);
+            if (filter.objectSelected(feature_id, object_id)) {
+                for (0..geom_vec.len) |i| {
+                    const geom_table = try fb.vectorTableAt(self.feature_buf.items, geom_vec, i);
+                    const lod = try fb.getString(self.feature_buf.items, geom_table, VT_GEOMETRY_LOD);
+                    if (!filter.lodSelected(lod)) continue;
+                    totals.decoded_geometry_count = try checkedAdd(totals.decoded_geometry_count, 1);
+                    try self.countGeometryData(geom_table, totals);
+                }
             }
         }
 
+        if (!filter.decodesAttributes()) return;
+
         self.scratch_column_types.clearRetainingCapacity();
         try self.parseColumnTypesInto(self.feature_buf.items, obj_table, VT_OBJECT_COLUMNS, &self.scratch_column_types);
         const attr_schema = if (self.scratch_column_types.items.len > 0) self.scratch_column_types.items else EMPTY_COLUMN_TYPES;
@@ -590,7 +738,7 @@ pub const Reader = struct {
         }
     }
 
-    fn decodeObjects(self: *Reader, feature_table: usize) !void {
+    fn decodeObjects(self: *Reader, feature_table: usize, feature_id: []const u8, filter: DecodeFilter) !void {
         const maybe_objects = try fb.getVectorInfo(self.feature_buf.items, feature_table, VT_FEATURE_OBJECTS);
         if (maybe_objects == null) return;
         const objects_vec = maybe_objects.?;
@@ -598,11 +746,11 @@ pub const Reader = struct {
         try self.scratch_objects.ensureTotalCapacity(self.allocator, objects_vec.len);
         for (0..objects_vec.len) |i| {
             const obj_table = try fb.vectorTableAt(self.feature_buf.items, objects_vec, i);
-            try self.decodeObject(obj_table);
+            try self.decodeObject(obj_table, feature_id, filter);
         }
     }
 
-    fn decodeObject(self: *Reader, obj_table: usize) !void {
+    fn decodeObject(self: *Reader, obj_table: usize, feature_id: []const u8, filter: DecodeFilter) !void {
         const object_id = try fb.getRequiredString(self.feature_buf.items, obj_table, VT_OBJECT_ID);
         const object_type_raw = try fb.getScalarU8Default(self.feature_buf.items, obj_table, VT_OBJECT_TYPE, 0);
         const object_type: ObjectType = @enumFromInt(object_type_raw);
@@ -610,19 +758,22 @@ pub const Reader = struct {
 
         const geom_start = self.scratch_geometries.items.len;
         if (try fb.getVectorInfo(self.feature_buf.items, obj_table, VT_OBJECT_GEOMETRY)) |geom_vec| {
+            const object_selected = filter.objectSelected(feature_id, object_id);
             for (0..geom_vec.len) |i| {
                 const geom_table = try fb.vectorTableAt(self.feature_buf.items, geom_vec, i);
-                try self.decodeGeometry(geom_table);
+                try self.decodeGeometry(geom_table, object_selected, filter);
             }
         }
         const geometries = self.scratch_geometries.items[geom_start..];
 
         const attr_start = self.scratch_attributes.items.len;
-        try self.parseColumnsInto(self.feature_buf.items, obj_table, VT_OBJECT_COLUMNS, &self.scratch_columns);
-        const attr_schema = if (self.scratch_columns.items.len > 0) self.scratch_columns.items else self.root_columns;
-        if (try fb.getVectorBytes(self.feature_buf.items, obj_table, VT_OBJECT_ATTRIBUTES)) |attr_bytes| {
-            if (attr_bytes.len > 0 and attr_schema.len == 0) return error.MissingAttributeSchema;
-            try self.decodeAttributes(attr_schema, attr_bytes);
+        if (filter.decodesAttributes()) {
+            try self.parseColumnsInto(self.feature_buf.items, obj_table, VT_OBJECT_COLUMNS, &self.scratch_columns);
+            const attr_schema = if (self.scratch_columns.items.len > 0) self.scratch_columns.items else self.root_columns;
+            if (try fb.getVectorBytes(self.feature_buf.items, obj_table, VT_OBJECT_ATTRIBUTES)) |attr_bytes| {
+                if (attr_bytes.len > 0 and attr_schema.len == 0) return error.MissingAttributeSchema;
+                try self.decodeAttributes(attr_schema, attr_bytes, filter);
+            }
         }
         const attributes = self.scratch_attributes.items[attr_start..];
 
@@ -632,14 +783,32 @@ pub const Reader = struct {
             .extension_type = extension_type,
             .geometries = geometries,
             .attributes = attributes,
+            .table_pos = obj_table,
         });
     }
 
-    fn decodeGeometry(self: *Reader, geom_table: usize) !void {
+    fn decodeGeometry(self: *Reader, geom_table: usize, object_selected: bool, filter: DecodeFilter) !void {
         const geometry_type_raw = try fb.getScalarU8Default(self.feature_buf.items, geom_table, VT_GEOMETRY_TYPE, 0);
         const geometry_type: GeometryType = @enumFromInt(geometry_type_raw);
         const lod = try fb.getString(self.feature_buf.items, geom_table, VT_GEOMETRY_LOD);
 
+        if (!object_selected or !filter.lodSelected(lod)) {
+            try self.scratch_geometries.append(self.allocator, .{
+                .geometry_type = geometry_type,
+                .lod = lod,
+                .solids = EMPTY_U32,
+                .shells = EMPTY_U32,
+                .surfaces = EMPTY_U32,
+                .strings = EMPTY_U32,
+                .boundaries = EMPTY_U32,
+                .semantics = EMPTY_U32,
+                .semantics_objects = EMPTY_U8,
+                .table_pos = geom_table,
+                .decoded = false,
+            });
+            return;
+        }
+
         const solids = try self.appendVectorU32(self.feature_buf.items, geom_table, VT_GEOMETRY_SOLIDS);
         const shells = try self.appendVectorU32(self.feature_buf.items, geom_table, VT_GEOMETRY_SHELLS);
         const surfaces = try self.appendVectorU32(self.feature_buf.items, geom_table, VT_GEOMETRY_SURFACES);
@@ -658,6 +827,7 @@ pub const Reader = struct {
             .boundaries = boundaries,
             .semantics = semantics,
             .semantics_objects = semantics_objects,
+            .table_pos = geom_table,
         });
     }
 
@@ -689,7 +859,7 @@ pub const Reader = struct {
         return EMPTY_U8;
     }
 
-    fn decodeAttributes(self: *Reader, schema: []const ColumnSchema, attr_bytes: []const u8) !void {
+    fn decodeAttributes(self: *Reader, schema: []const ColumnSchema, attr_bytes: []const u8, filter: DecodeFilter) !void {
         var offset: usize = 0;
         while (offset < attr_bytes.len) {
             if (offset + 2 > attr_bytes.len) return error.InvalidAttributeEncoding;
@@ -697,6 +867,10 @@ pub const Reader = struct {
             offset += 2;
 
             const column = findColumn(schema, column_index) orelse return error.UnknownColumnIndex;
+            if (!filter.attributeSelected(column.name)) {
+                try skipAttributeValue(column.column_type, attr_bytes, &offset);
+                continue;
+            }
             const attribute = Attribute{
                 .name = column.name,
                 .value = switch (column.column_type) {
@@ -1204,6 +1378,8 @@ pub const Writer = struct {
     transform: Transform = .{},
     feature_count_patch_pos: ?u64 = null,
     written_feature_count: u64 = 0,
+    // Bytes written so far, i.e. the output offset of the next feature.
+    written_bytes: u64 = 0,
 
     pub fn openPathFromReader(reader: *const Reader, path: []const u8) !Writer {
         const file = try createFileTruncate(path);
@@ -1222,6 +1398,7 @@ pub const Writer = struct {
             .file = file,
             .owns_file = owns_file,
             .transform = reader.transform,
+            .written_bytes = reader.preamble().len,
         };
     }
 
@@ -1241,11 +1418,18 @@ pub const Writer = struct {
     /// index and attribute indexes from the preamble. Use this variant when features
     /// may be modified (e.g. via FeatureBuilder-based rewrites), since changed
     /// feature byte lengths invalidate the original index offsets.
+    ///
+    /// Features may also be left out, so the copied features_count is patched
+    /// to the number written on deinit. Writers on a descriptor keep the input's
+    /// count, since the descriptor may not be seekable.
     pub fn openPathFromReaderNoIndex(reader: *const Reader, path: []const u8) !Writer {
+        const patch_pos = try reader.featureCountPos();
         const file = try createFileTruncate(path);
         errdefer closeFile(file);
 
-        return openFileFromReaderNoIndex(reader, file, true);
+        var writer = try openFileFromReaderNoIndex(reader, file, true);
+        writer.feature_count_patch_pos = patch_pos;
+        return writer;
     }
 
     pub fn openFileFromReaderNoIndex(reader: *const Reader, file: File, owns_file: bool) !Writer {
@@ -1317,9 +1501,80 @@ pub const Writer = struct {
             .file = file,
             .owns_file = owns_file,
             .transform = reader.transform,
+            .written_bytes = write_len,
+        };
+    }
+
+    /// Reopens an output written by one of the `FromReader` writers for `reader`
+    /// and continues it at `offset`, a feature boundary recorded from
+    /// `written_bytes`. Anything after `offset` (a partly written feature from an
+    /// interrupted run) is cut off; the header is kept as is, except that the
+    /// features_count of a no-index output is patched on deinit like
+    /// `openPathFromReaderNoIndex` does.
+    pub fn openPathResumeFromReader(reader: *const Reader, path: []const u8, offset: u64) !Writer {
+        var file = try openFileReadWrite(path);
+        errdefer closeFile(file);
+
+        const stat = try std.posix.fstat(file.handle);
+        if (offset < MAGIC_BYTES.len or offset > @as(u64, @intCast(stat.size))) return error.InvalidResumeOffset;
+        var magic: [MAGIC_BYTES.len]u8 = undefined;
+        try readExact(&file, &magic);
+        if (!std.mem.eql(u8, &magic, &MAGIC_BYTES)) return error.InvalidMagicBytes;
+        const kept = try countKeptFeatures(&file, offset);
+
+        try std.posix.ftruncate(file.handle, offset);
+        try seekTo(file, offset);
+        return .{
+            .file = file,
+            .owns_file = true,
+            .transform = reader.transform,
+            .feature_count_patch_pos = if (kept) |k| k.patch_pos else null,
+            .written_feature_count = if (kept) |k| k.count else 0,
+            .written_bytes = offset,
         };
     }
 
+    /// For an output whose preamble is only its header (no spatial or attribute
+    /// index, as the no-index writers leave it) and which stores
+    /// features_count: where that count is and how many features precede
+    /// `offset`. `file` is positioned right after the magic bytes.
+    fn countKeptFeatures(file: *File, offset: u64) !?struct { patch_pos: u64, count: u64 } {
+        var size_buf: [4]u8 = undefined;
+        try readExact(file, &size_buf);
+        const header_size: usize = @intCast(std.mem.readInt(u32, &size_buf, .little));
+        if (header_size < 8 or header_size > HEADER_MAX_BUFFER_SIZE) return error.IllegalHeaderSize;
+
+        const allocator = std.heap.page_allocator;
+        const header_buf = try allocator.alloc(u8, header_size + 4);
+        defer allocator.free(header_buf);
+        @memcpy(header_buf[0..4], &size_buf);
+        try readExact(file, header_buf[4..]);
+
+        const header_table = try fb.sizePrefixedRootTable(header_buf);
+        if (try fb.getScalarU16Default(header_buf, header_table, VT_HEADER_INDEX_NODE_SIZE, 16) != 0) return null;
+        if (try fb.tableFieldPos(header_buf, header_table, VT_HEADER_ATTRIBUTE_INDEX) != null) return null;
+        const field_pos = try fb.tableFieldPos(header_buf, header_table, VT_HEADER_FEATURES_COUNT) orelse return null;
+
+        // Features are size-prefixed, so their boundaries can be walked without
+        // reading the features themselves.
+        var pos: u64 = MAGIC_BYTES.len + header_buf.len;
+        var count: u64 = 0;
+        while (pos < offset) {
+            try seekTo(file.*, pos);
+            try readExact(file, &size_buf);
+            pos = try checkedAddU64(pos, 4 + @as(u64, std.mem.readInt(u32, &size_buf, .little)));
+            count += 1;
+        }
+        if (pos != offset) return error.InvalidResumeOffset;
+        return .{ .patch_pos = try checkedAddU64(MAGIC_BYTES.len, field_pos), .count = count };
+    }
+
+    /// Flushes written features to stable storage, so a checkpoint recorded
+    /// after it never points past the data on disk.
+    pub fn sync(self: *Writer) !void {
+        try std.posix.fsync(self.file.handle);
+    }
+
     pub fn openPathNewNoIndex(path: []const u8, transform: Transform, root_columns: []const ColumnSchema) !Writer {
         const file = try createFileTruncate(path);
         errdefer closeFile(file);
@@ -1336,11 +1591,13 @@ pub const Writer = struct {
             .owns_file = true,
             .transform = transform,
             .feature_count_patch_pos = patch_pos,
+            .written_bytes = MAGIC_BYTES.len + header.bytes.len,
         };
     }
 
     pub fn writeFeatureRaw(self: *Writer, feature_bytes: []const u8) !void {
         try writeAll(self.file, feature_bytes);
+        self.written_bytes = try checkedAddU64(self.written_bytes, feature_bytes.len);
         if (self.feature_count_patch_pos != null) {
             self.written_feature_count = try checkedAddU64(self.written_feature_count, 1);
         }
@@ -1824,6 +2081,39 @@ pub const FeatureBuilder = struct {
         vertices_xyz_world: []const f64,
         triangle_indices: []const u32,
         semantic_types: []const u8,
+    ) !void {
+        try self.replaceSolid(feature_id, "2.2", vertices_xyz_world, triangle_indices, semantic_types);
+    }
+
+    pub fn replaceLod22SolidPolygonal(
+        self: *FeatureBuilder,
+        feature_id: []const u8,
+        vertices_xyz_world: []const f64,
+        surface_ring_counts: []const u32,
+        ring_vertex_counts: []const u32,
+        boundary_indices: []const u32,
+        surface_semantic_types: []const u8,
+    ) !void {
+        try self.replaceSolidPolygonal(
+            feature_id,
+            "2.2",
+            vertices_xyz_world,
+            surface_ring_counts,
+            ring_vertex_counts,
+            boundary_indices,
+            surface_semantic_types,
+        );
+    }
+
+    /// Replaces the Solid geometry with LoD `lod` of object "<feature_id>-0"
+    /// by a triangle solid.
+    pub fn replaceSolid(
+        self: *FeatureBuilder,
+        feature_id: []const u8,
+        lod: []const u8,
+        vertices_xyz_world: []const f64,
+        triangle_indices: []const u32,
+        semantic_types: []const u8,
     ) !void {
         if (triangle_indices.len % 3 != 0) return error.InvalidTriangleIndexArray;
         const tri_count = triangle_indices.len / 3;
@@ -1834,8 +2124,9 @@ pub const FeatureBuilder = struct {
         @memset(surface_ring_counts, 1);
         @memset(ring_vertex_counts, 3);
 
-        try self.replaceLod22SolidPolygonal(
+        try self.replaceSolidPolygonal(
             feature_id,
+            lod,
             vertices_xyz_world,
             surface_ring_counts,
             ring_vertex_counts,
@@ -1844,9 +2135,12 @@ pub const FeatureBuilder = struct {
         );
     }
 
-    pub fn replaceLod22SolidPolygonal(
+    /// Polygonal variant of `replaceSolid`. Other LoDs of the object keep
+    /// their geometry, so several LoDs can be replaced before one encode.
+    pub fn replaceSolidPolygonal(
         self: *FeatureBuilder,
         feature_id: []const u8,
+        lod: []const u8,
         vertices_xyz_world: []const f64,
         surface_ring_counts: []const u32,
         ring_vertex_counts: []const u32,
@@ -1882,10 +2176,9 @@ pub const FeatureBuilder = struct {
         for (self.objects) |*obj| {
             if (!std.mem.eql(u8, obj.id, object_id)) continue;
             for (obj.geometries) |*geom| {
-                const solid_like = geom.geometry_type == .Solid or geom.geometry_type == .MultiSolid or geom.geometry_type == .CompositeSolid;
-                if (!solid_like) continue;
-                const lod = geom.lod orelse continue;
-                if (std.mem.eql(u8, lod, "2.2")) {
+                if (!geom.geometry_type.isSolidLike()) continue;
+                const geom_lod = geom.lod orelse continue;
+                if (std.mem.eql(u8, geom_lod, lod)) {
                     target_geom = geom;
                     break;
                 }
@@ -2805,6 +3098,84 @@ var c_allocator: std.mem.Allocator = std.heap.c_allocator;
 pub const ZfcbReaderHandle = *Reader;
 pub const ZfcbWriterHandle = *Writer;
 
+/// Semantic type reported for surfaces without a semantic assignment.
+const SEMANTIC_TYPE_NONE: u8 = 255;
+
+/// Mirrors ZfcbGeometrySpans in zfcb.h.
+pub const ZfcbGeometrySpans = extern struct {
+    object_index: usize,
+    geometry_index: usize,
+    geometry_type: u8,
+    vertices: [*c]const f64,
+    vertex_count: usize,
+    surfaces: [*c]const u32,
+    surface_count: usize,
+    strings: [*c]const u32,
+    string_count: usize,
+    boundaries: [*c]const u32,
+    boundary_count: usize,
+    surface_semantic_types: [*c]const u8,
+};
+
+/// C layout of `DecodeFilter`; mirrors ZfcbDecodeFilter in zfcb.h.
+pub const ZfcbDecodeFilter = extern struct {
+    geometry_object_suffix: [*c]const u8,
+    geometry_object_suffix_len: usize,
+    lod: [*c]const u8,
+    lod_len: usize,
+    attribute_names: [*c]const [*c]const u8,
+    attribute_name_lens: [*c]const usize,
+    attribute_name_count: usize,
+};
+
+/// One replaced solid of `zfcb_writer_write_current_replaced_solids`; mirrors
+/// ZfcbSolidReplacement in zfcb.h. A null `surface_ring_counts` makes
+/// `boundary_indices` a flat triangle list with one semantic type per triangle.
+pub const ZfcbSolidReplacement = extern struct {
+    lod: [*c]const u8,
+    lod_len: usize,
+    vertices_xyz_world: [*c]const f64,
+    vertex_count: usize,
+    surface_ring_counts: [*c]const u32,
+    surface_count: usize,
+    ring_vertex_counts: [*c]const u32,
+    ring_count: usize,
+    boundary_indices: [*c]const u32,
+    boundary_index_count: usize,
+    surface_semantic_types: [*c]const u8,
+    surface_semantic_types_count: usize,
+};
+
+fn replaceSolidFromC(builder: *FeatureBuilder, feature_id: []const u8, replacement: *const ZfcbSolidReplacement) !void {
+    if (replacement.lod == null or replacement.lod_len == 0) return error.InvalidReplacementGeometry;
+    if (replacement.vertices_xyz_world == null or replacement.vertex_count == 0) return error.InvalidVertexArray;
+    if (replacement.boundary_indices == null or replacement.boundary_index_count == 0) return error.InvalidReplacementGeometry;
+    if (replacement.surface_semantic_types == null) return error.InvalidSemanticTypesArray;
+
+    const lod = replacement.lod[0..replacement.lod_len];
+    const vertices_xyz_world = replacement.vertices_xyz_world[0 .. replacement.vertex_count * 3];
+    const boundary_indices = replacement.boundary_indices[0..replacement.boundary_index_count];
+    const surface_semantic_types = replacement.surface_semantic_types[0..replacement.surface_semantic_types_count];
+    if (replacement.surface_ring_counts == null) {
+        if (boundary_indices.len % 3 != 0 or surface_semantic_types.len != boundary_indices.len / 3) {
+            return error.InvalidSemanticTypesArray;
+        }
+        return builder.replaceSolid(feature_id, lod, vertices_xyz_world, boundary_indices, surface_semantic_types);
+    }
+    if (replacement.surface_count == 0 or replacement.ring_vertex_counts == null or replacement.ring_count == 0) {
+        return error.InvalidReplacementGeometry;
+    }
+    try builder.replaceSolidPolygonal(
+        feature_id,
+        lod,
+        vertices_xyz_world,
+        replacement.surface_ring_counts[0..replacement.surface_count],
+        replacement.ring_vertex_counts[0..replacement.ring_count],
+        boundary_indices,
+        surface_semantic_types,
+    );
+}
+
 fn getCurrentObject(reader: *Reader, object_index: usize) ?*const ObjectView {
     if (object_index >= reader.current_feature.objects.len) return null;
     return &reader.current_feature.objects[object_index];
@@ -2816,6 +3187,35 @@ fn getCurrentGeometry(reader: *Reader, object_index: usize, geometry_index: usiz
     return &obj.geometries[geometry_index];
 }
 
+fn findCurrentObject(reader: *Reader, object_id: []const u8) ?usize {
+    for (reader.current_feature.objects, 0..) |obj, i| {
+        if (std.mem.eql(u8, obj.id, object_id)) return i;
+    }
+    return null;
+}
+
+fn decodeFilterFromC(reader: *Reader, c_filter: *const ZfcbDecodeFilter) !DecodeFilter {
+    var filter: DecodeFilter = .{};
+    if (c_filter.geometry_object_suffix != null) {
+        filter.geometry_object_suffix = c_filter.geometry_object_suffix[0..c_filter.geometry_object_suffix_len];
+    }
+    if (c_filter.lod != null) {
+        filter.lod = c_filter.lod[0..c_filter.lod_len];
+    }
+    if (c_filter.attribute_names != null) {
+        if (c_filter.attribute_name_count > 0 and c_filter.attribute_name_lens == null) return error.InvalidDecodeFilter;
+        reader.scratch_filter_names.clearRetainingCapacity();
+        try reader.scratch_filter_names.ensureTotalCapacity(reader.allocator, c_filter.attribute_name_count);
+        for (0..c_filter.attribute_name_count) |i| {
+            const name_ptr = c_filter.attribute_names[i];
+            if (name_ptr == null) return error.InvalidDecodeFilter;
+            reader.scratch_filter_names.appendAssumeCapacity(name_ptr[0..c_filter.attribute_name_lens[i]]);
+        }
+        filter.attribute_names = reader.scratch_filter_names.items;
+    }
+    return filter;
+}
+
 fn sourceAttributesFromC(
     names: [*c]const [*c]const u8,
     name_lens: [*c]const usize,
@@ -2906,6 +3306,25 @@ export fn zfcb_reader_header_geographical_extent(
     return -1;
 }
 
+// Returns:
+//   1 => success
+//  -1 => error (invalid args/handle)
+export fn zfcb_reader_header_transform(
+    handle: ?ZfcbReaderHandle,
+    out_scale_xyz: [*c]f64,
+    out_translate_xyz: [*c]f64,
+) callconv(.c) c_int {
+    if (out_scale_xyz == null or out_translate_xyz == null) return -1;
+    const reader = handle orelse return -1;
+
+    const transform = reader.headerTransform();
+    for (0..3) |axis| {
+        out_scale_xyz[axis] = transform.scale[axis];
+        out_translate_xyz[axis] = transform.translate[axis];
+    }
+    return 1;
+}
+
 // Returns: 1 when an ID is available, 0 at EOF, -1 on error.
 export fn zfcb_peek_next_id(
     handle: ?ZfcbReaderHandle,
@@ -2932,6 +3351,19 @@ export fn zfcb_skip_next(handle: ?ZfcbReaderHandle) callconv(.c) c_int {
     return if (skipped) 1 else 0;
 }
 
+// Returns the file offset of the next feature, or -1 on error.
+export fn zfcb_reader_next_feature_offset(handle: ?ZfcbReaderHandle) callconv(.c) i64 {
+    const reader = handle orelse return -1;
+    return std.math.cast(i64, reader.nextFeatureOffset()) orelse -1;
+}
+
+// Returns 0 on success, -1 on error (e.g. the input is a pipe).
+export fn zfcb_reader_seek_feature(handle: ?ZfcbReaderHandle, offset: u64) callconv(.c) c_int {
+    const reader = handle orelse return -1;
+    reader.seekToFeature(offset) catch return -1;
+    return 0;
+}
+
 // Returns: 1 when a feature was loaded, 0 at EOF, -1 on error.
 export fn zfcb_next(handle: ?ZfcbReaderHandle) callconv(.c) c_int {
     const reader = handle orelse return -1;
@@ -2939,6 +3371,16 @@ export fn zfcb_next(handle: ?ZfcbReaderHandle) callconv(.c) c_int {
     return if (maybe_feature != null) 1 else 0;
 }
 
+// Like zfcb_next, decoding only what `filter` selects (NULL => everything).
+// Returns: 1 when a feature was loaded, 0 at EOF, -1 on error.
+export fn zfcb_next_selective(handle: ?ZfcbReaderHandle, c_filter: ?*const ZfcbDecodeFilter) callconv(.c) c_int {
+    const reader = handle orelse return -1;
+    var filter = DecodeFilter.all;
+    if (c_filter) |f| filter = decodeFilterFromC(reader, f) catch return -1;
+    const maybe_feature = reader.nextSelective(filter) catch return -1;
+    return if (maybe_feature != null) 1 else 0;
+}
+
 // Returns 0 on success, -1 on error.
 export fn zfcb_current_feature_id(
     handle: ?ZfcbReaderHandle,
@@ -3070,6 +3512,18 @@ export fn zfcb_current_geometry_lod(
     return 0;
 }
 
+// Returns 1 when the geometry arrays were decoded, 0 when a decode filter
+// skipped them, -1 on invalid indices/handle.
+export fn zfcb_current_geometry_is_decoded(
+    handle: ?ZfcbReaderHandle,
+    object_index: usize,
+    geometry_index: usize,
+) callconv(.c) c_int {
+    const reader = handle orelse return -1;
+    const geom = getCurrentGeometry(reader, object_index, geometry_index) orelse return -1;
+    return if (geom.decoded) 1 else 0;
+}
+
 export fn zfcb_current_geometry_surface_count(
     handle: ?ZfcbReaderHandle,
     object_index: usize,
@@ -3144,10 +3598,78 @@ export fn zfcb_current_geometry_surface_semantic_type(
     const reader = handle orelse return -1;
     const geom = getCurrentGeometry(reader, object_index, geometry_index) orelse return -1;
     if (surface_index >= geom.surfaces.len) return -1;
-    if (surface_index >= geom.semantics.len) return 0;
-    const semantic_object_index = geom.semantics[surface_index];
-    if (semantic_object_index >= geom.semantics_objects.len) return 0;
-    out_semantic_type.* = geom.semantics_objects[semantic_object_index];
+    out_semantic_type.* = geom.surfaceSemanticType(surface_index) orelse return 0;
+    return 1;
+}
+
+// Returns:
+//   1 => object found, index written to out_index
+//   0 => no object with that id
+//  -1 => invalid args/handle
+export fn zfcb_current_find_object(
+    handle: ?ZfcbReaderHandle,
+    object_id_ptr: [*c]const u8,
+    object_id_len: usize,
+    out_index: *usize,
+) callconv(.c) c_int {
+    out_index.* = 0;
+    if (object_id_ptr == null) return -1;
+    const reader = handle orelse return -1;
+    const index = findCurrentObject(reader, object_id_ptr[0..object_id_len]) orelse return 0;
+    out_index.* = index;
+    return 1;
+}
+
+// Fills out with spans over the first solid-like geometry of the given LoD on
+// the given object. Per-surface semantic types are materialized into reader
+// scratch; all spans stay valid until the next zfcb_next / zfcb_skip_next /
+// zfcb_current_solid_geometry / destroy.
+// Returns:
+//   1 => geometry found
+//   0 => object or geometry not found
+//  -1 => invalid args/handle or allocation failure
+export fn zfcb_current_solid_geometry(
+    handle: ?ZfcbReaderHandle,
+    object_id_ptr: [*c]const u8,
+    object_id_len: usize,
+    lod_ptr: [*c]const u8,
+    lod_len: usize,
+    out: *ZfcbGeometrySpans,
+) callconv(.c) c_int {
+    out.* = std.mem.zeroes(ZfcbGeometrySpans);
+    if (object_id_ptr == null or lod_ptr == null) return -1;
+    const reader = handle orelse return -1;
+    const lod = lod_ptr[0..lod_len];
+
+    const object_index = findCurrentObject(reader, object_id_ptr[0..object_id_len]) orelse return 0;
+    const obj = &reader.current_feature.objects[object_index];
+    const geometry_index = for (obj.geometries, 0..) |geom, i| {
+        if (!geom.geometry_type.isSolidLike()) continue;
+        const geom_lod = geom.lod orelse continue;
+        if (std.mem.eql(u8, geom_lod, lod)) break i;
+    } else return 0;
+    const geom = &obj.geometries[geometry_index];
+
+    reader.scratch_surface_semantics.resize(reader.allocator, geom.surfaces.len) catch return -1;
+    for (reader.scratch_surface_semantics.items, 0..) |*semantic_type, i| {
+        semantic_type.* = geom.surfaceSemanticType(i) orelse SEMANTIC_TYPE_NONE;
+    }
+
+    const vertices = reader.current_feature.vertices;
+    out.* = .{
+        .object_index = object_index,
+        .geometry_index = geometry_index,
+        .geometry_type = @intFromEnum(geom.geometry_type),
+        .vertices = if (vertices.len > 0) @ptrCast(vertices.ptr) else null,
+        .vertex_count = vertices.len,
+        .surfaces = if (geom.surfaces.len > 0) geom.surfaces.ptr else null,
+        .surface_count = geom.surfaces.len,
+        .strings = if (geom.strings.len > 0) geom.strings.ptr else null,
+        .string_count = geom.strings.len,
+        .boundaries = if (geom.boundaries.len > 0) geom.boundaries.ptr else null,
+        .boundary_count = geom.boundaries.len,
+        .surface_semantic_types = if (geom.surfaces.len > 0) reader.scratch_surface_semantics.items.ptr else null,
+    };
     return 1;
 }
 
@@ -3244,6 +3766,35 @@ export fn zfcb_writer_open_new_no_index(
     return writer;
 }
 
+export fn zfcb_writer_open_resume_from_reader(
+    reader_handle: ?ZfcbReaderHandle,
+    output_path: [*c]const u8,
+    offset: u64,
+) callconv(.c) ?ZfcbWriterHandle {
+    const reader = reader_handle orelse return null;
+    const output_path_slice = std.mem.span(output_path);
+
+    const writer = c_allocator.create(Writer) catch return null;
+    writer.* = Writer.openPathResumeFromReader(reader, output_path_slice, offset) catch {
+        c_allocator.destroy(writer);
+        return null;
+    };
+    return writer;
+}
+
+// Returns the number of bytes written so far, or -1 on error.
+export fn zfcb_writer_offset(writer_handle: ?ZfcbWriterHandle) callconv(.c) i64 {
+    const writer = writer_handle orelse return -1;
+    return std.math.cast(i64, writer.written_bytes) orelse -1;
+}
+
+// Returns 0 on success, -1 on error.
+export fn zfcb_writer_sync(writer_handle: ?ZfcbWriterHandle) callconv(.c) c_int {
+    const writer = writer_handle orelse return -1;
+    writer.sync() catch return -1;
+    return 0;
+}
+
 export fn zfcb_writer_destroy(writer_handle: ?ZfcbWriterHandle) callconv(.c) void {
     if (writer_handle) |writer| {
         writer.deinit();
@@ -3567,6 +4118,64 @@ export fn zfcb_writer_write_current_replaced_lod22_polygonal_with_attributes(
     return 0;
 }
 
+// Replaces several Solid geometries of object "<feature_id>-0", one per
+// replacement (each with its own LoD), and writes the feature once.
+// source_attribute_count == 0 leaves the attributes unchanged.
+// Returns 0 on success, -1 on error (nothing is written then).
+// NOTE: Like the LoD2.2 variants, this needs a writer without indexes.
+export fn zfcb_writer_write_current_replaced_solids(
+    reader_handle: ?ZfcbReaderHandle,
+    writer_handle: ?ZfcbWriterHandle,
+    feature_id_ptr: [*c]const u8,
+    feature_id_len: usize,
+    replacements_ptr: [*c]const ZfcbSolidReplacement,
+    replacement_count: usize,
+    source_attribute_names: [*c]const [*c]const u8,
+    source_attribute_name_lens: [*c]const usize,
+    source_attribute_types: [*c]const u8,
+    source_attribute_integer_values: [*c]const i64,
+    source_attribute_real_values: [*c]const f64,
+    source_attribute_string_values: [*c]const [*c]const u8,
+    source_attribute_string_value_lens: [*c]const usize,
+    source_attribute_count: usize,
+    source_attribute_target: u8,
+) callconv(.c) c_int {
+    const reader = reader_handle orelse return -1;
+    const writer = writer_handle orelse return -1;
+    if (feature_id_ptr == null or feature_id_len == 0) return -1;
+    if (replacements_ptr == null or replacement_count == 0) return -1;
+
+    const source_attributes = sourceAttributesFromC(
+        source_attribute_names,
+        source_attribute_name_lens,
+        source_attribute_types,
+        source_attribute_integer_values,
+        source_attribute_real_values,
+        source_attribute_string_values,
+        source_attribute_string_value_lens,
+        source_attribute_count,
+    );
+    if (source_attribute_target != 0 and source_attribute_count != 0 and source_attributes == null) return -1;
+
+    const feature_id = feature_id_ptr[0..feature_id_len];
+
+    var builder = FeatureBuilder.init(c_allocator, reader.transform);
+    defer builder.deinit();
+    builder.loadCurrentFromReader(reader) catch return -1;
+    for (replacements_ptr[0..replacement_count]) |*replacement| {
+        replaceSolidFromC(&builder, feature_id, replacement) catch return -1;
+    }
+    if (source_attributes) |attrs| {
+        builder.mergeSourceAttributes(reader.root_columns, feature_id, attrs, source_attribute_target) catch return -1;
+    }
+
+    var rewritten_feature = std.ArrayList(u8).empty;
+    defer rewritten_feature.deinit(c_allocator);
+    builder.encodeFeature(&rewritten_feature) catch return -1;
+    writer.writeFeatureRaw(rewritten_feature.items) catch return -1;
+    return 0;
+}
+
 fn openSampleReader(allocator: std.mem.Allocator) !Reader {
     const candidates = [_][]const u8{
         "../sample_data/9-444-728.fcb",
@@ -3729,6 +4338,83 @@ test "stream all features and aggregate geometry safely" {
     try std.testing.expect(attribute_count > 0);
 }
 
+test "selective decode only materializes the requested lod22 geometry" {
+    var full_reader = try openSampleReader(std.testing.allocator);
+    defer full_reader.deinit();
+    var selective_reader = try openSampleReader(std.testing.allocator);
+    defer selective_reader.deinit();
+
+    const attribute_names = [_][]const u8{"b3_val3dity_lod22"};
+    const filter = DecodeFilter{
+        .geometry_object_suffix = "-0",
+        .lod = "2.2",
+        .attribute_names = &attribute_names,
+    };
+
+    var compared_geometries: usize = 0;
+    while (try full_reader.next()) |full| {
+        const selective = (try selective_reader.nextSelective(filter)).?;
+        try std.testing.expectEqualStrings(full.id, selective.id);
+        try std.testing.expectEqual(full.objects.len, selective.objects.len);
+
+        for (full.objects, selective.objects) |full_obj, sel_obj| {
+            try std.testing.expectEqualStrings(full_obj.id, sel_obj.id);
+            try std.testing.expectEqual(full_obj.geometries.len, sel_obj.geometries.len);
+            for (sel_obj.attributes) |attr| {
+                try std.testing.expectEqualStrings("b3_val3dity_lod22", attr.name);
+            }
+
+            const wanted_object = filter.objectSelected(full.id, full_obj.id);
+            for (full_obj.geometries, sel_obj.geometries) |full_geom, sel_geom| {
+                try std.testing.expectEqual(full_geom.table_pos, sel_geom.table_pos);
+                const wanted = wanted_object and filter.lodSelected(full_geom.lod);
+                try std.testing.expectEqual(wanted, sel_geom.decoded);
+                if (!wanted) {
+                    try std.testing.expectEqual(@as(usize, 0), sel_geom.boundaries.len);
+                    continue;
+                }
+                try std.testing.expectEqualSlices(u32, full_geom.surfaces, sel_geom.surfaces);
+                try std.testing.expectEqualSlices(u32, full_geom.strings, sel_geom.strings);
+                try std.testing.expectEqualSlices(u32, full_geom.boundaries, sel_geom.boundaries);
+                try std.testing.expectEqualSlices(u8, full_geom.semantics_objects, sel_geom.semantics_objects);
+                compared_geometries += 1;
+            }
+        }
+        if (selective.vertices.len > 0) {
+            try std.testing.expectEqualSlices([3]f64, full.vertices, selective.vertices);
+        }
+    }
+    try std.testing.expect(compared_geometries > 0);
+}
+
+test "solid geometry spans match the per-field accessors" {
+    var reader = try openSampleReader(std.testing.allocator);
+    defer reader.deinit();
+
+    var found: usize = 0;
+    while (try reader.next()) |feature| {
+        for (feature.objects, 0..) |obj, obj_i| {
+            var spans: ZfcbGeometrySpans = undefined;
+            const rc = zfcb_current_solid_geometry(&reader, obj.id.ptr, obj.id.len, "2.2", 3, &spans);
+            try std.testing.expect(rc >= 0);
+            if (rc == 0) continue;
+            found += 1;
+
+            try std.testing.expectEqual(obj_i, spans.object_index);
+            const geom = obj.geometries[spans.geometry_index];
+            try std.testing.expect(geom.geometry_type.isSolidLike());
+            try std.testing.expectEqual(feature.vertices.len, spans.vertex_count);
+            try std.testing.expectEqualSlices(u32, geom.boundaries, spans.boundaries[0..spans.boundary_count]);
+            try std.testing.expectEqualSlices(u32, geom.strings, spans.strings[0..spans.string_count]);
+            for (0..spans.surface_count) |surface_i| {
+                const expected = geom.surfaceSemanticType(surface_i) orelse SEMANTIC_TYPE_NONE;
+                try std.testing.expectEqual(expected, spans.surface_semantic_types[surface_i]);
+            }
+        }
+    }
+    try std.testing.expect(found > 0);
+}
+
 test "feature builder encode/decode preserves geometry semantics" {
     var builder = try buildSyntheticFeatureBuilder(std.testing.allocator, .{}, false);
     defer builder.deinit();
@@ -3802,6 +4488,75 @@ test "feature builder replace lod22 compacts unused vertices" {
     }
 }
 
+test "feature builder replaces several lods and keeps the others" {
+    var reader = try openSampleReader(std.testing.allocator);
+    defer reader.deinit();
+
+    // A feature whose "-0" object has LoD 1.2, 1.3 and 2.2 solids.
+    const feature = found: while (try reader.next()) |candidate| {
+        for (candidate.objects) |obj| {
+            if (!std.mem.endsWith(u8, obj.id, "-0")) continue;
+            var lods_found: usize = 0;
+            for (obj.geometries) |geom| {
+                const lod = geom.lod orelse continue;
+                if (!geom.geometry_type.isSolidLike()) continue;
+                if (std.mem.eql(u8, lod, "1.2") or std.mem.eql(u8, lod, "1.3") or std.mem.eql(u8, lod, "2.2")) {
+                    lods_found += 1;
+                }
+            }
+            if (lods_found == 3) break :found candidate;
+        }
+    } else return error.SkipZigTest;
+
+    var builder = FeatureBuilder.init(std.testing.allocator, reader.transform);
+    defer builder.deinit();
+    try builder.loadCurrentFromReader(&reader);
+
+    var lod13_surface_count: ?usize = null;
+    for (builder.objects) |obj| {
+        for (obj.geometries) |geom| {
+            const lod = geom.lod orelse continue;
+            if (std.mem.endsWith(u8, obj.id, "-0") and std.mem.eql(u8, lod, "1.3")) {
+                lod13_surface_count = geom.surfaces.len;
+            }
+        }
+    }
+
+    // A tetrahedron at the feature's first vertex.
+    const base = feature.vertices[0];
+    const tetrahedron_vertices = [_]f64{
+        base[0],       base[1],       base[2],
+        base[0] + 1.0, base[1],       base[2],
+        base[0],       base[1] + 1.0, base[2],
+        base[0],       base[1],       base[2] + 1.0,
+    };
+    const tetrahedron_triangles = [_]u32{ 0, 2, 1, 0, 1, 3, 1, 2, 3, 0, 3, 2 };
+    const tetrahedron_semantics = [_]u8{ 1, 2, 0, 2 };
+    for ([_][]const u8{ "1.2", "2.2" }) |lod| {
+        try builder.replaceSolid(feature.id, lod, &tetrahedron_vertices, &tetrahedron_triangles, &tetrahedron_semantics);
+    }
+
+    for (builder.objects) |obj| {
+        if (!std.mem.endsWith(u8, obj.id, "-0")) continue;
+        for (obj.geometries) |geom| {
+            const lod = geom.lod orelse continue;
+            if (std.mem.eql(u8, lod, "1.2") or std.mem.eql(u8, lod, "2.2")) {
+                try std.testing.expectEqual(@as(usize, 4), geom.surfaces.len);
+                try std.testing.expectEqual(@as(usize, 12), geom.boundaries.len);
+            } else if (std.mem.eql(u8, lod, "1.3")) {
+                try std.testing.expectEqual(lod13_surface_count.?, geom.surfaces.len);
+            }
+        }
+    }
+    for (builder.objects) |obj| {
+        for (obj.geometries) |geom| {
+            for (geom.boundaries) |idx| {
+                try std.testing.expect(idx < builder.vertices_q.len);
+            }
+        }
+    }
+}
+
 test "feature builder encoded tables are aligned" {
     var builder = try buildSyntheticFeatureBuilder(std.testing.allocator, .{}, false);
     defer builder.deinit();
@@ -3891,3 +4646,104 @@ test "writer open new no index patches feature count on close" {
     }
     try std.testing.expectEqual(@as(u64, 2), streamed_count);
 }
+
+fn readWholeFileForTest(allocator: std.mem.Allocator, path: []const u8) ![]u8 {
+    var file = try openFileRead(path);
+    defer closeFile(file);
+    const stat = try std.posix.fstat(file.handle);
+    const bytes = try allocator.alloc(u8, @intCast(stat.size));
+    errdefer allocator.free(bytes);
+    try readExact(&file, bytes);
+    return bytes;
+}
+
+test "no-index writers record the number of features kept" {
+    const path = "/tmp/zfcb_kept_feature_count.fcb";
+
+    var output_offset: u64 = 0;
+    {
+        var reader = try openSampleReader(std.testing.allocator);
+        defer reader.deinit();
+        if (try reader.featureCountPos() == null or reader.feature_count < 3) return error.SkipZigTest;
+        var writer = try Writer.openPathFromReaderNoIndex(&reader, path);
+        defer writer.deinit();
+
+        // Keep the first feature only, as --shard-only does for other shards'.
+        _ = (try reader.peekNextId()) orelse return error.UnexpectedEndOfStream;
+        try writer.writeFeatureRaw(reader.feature_buf.items);
+        output_offset = writer.written_bytes;
+    }
+    {
+        var output = try Reader.openPath(std.testing.allocator, path);
+        defer output.deinit();
+        try std.testing.expectEqual(@as(u64, 1), output.feature_count);
+    }
+
+    // A resumed run counts the features it keeps and adds its own.
+    {
+        var reader = try openSampleReader(std.testing.allocator);
+        defer reader.deinit();
+        _ = try reader.skipNext();
+        var writer = try Writer.openPathResumeFromReader(&reader, path, output_offset);
+        defer writer.deinit();
+        _ = (try reader.peekNextId()) orelse return error.UnexpectedEndOfStream;
+        try writer.writeFeatureRaw(reader.feature_buf.items);
+    }
+    var output = try Reader.openPath(std.testing.allocator, path);
+    defer output.deinit();
+    try std.testing.expectEqual(@as(u64, 2), output.feature_count);
+    var read_back: u64 = 0;
+    while (try output.peekNextId()) |_| {
+        _ = try output.skipNext();
+        read_back += 1;
+    }
+    try std.testing.expectEqual(@as(u64, 2), read_back);
+}
+
+test "resuming at recorded offsets reproduces an uninterrupted copy" {
+    const path = "/tmp/zfcb_resume_writer.fcb";
+
+    var input_offset: u64 = 0;
+    var output_offset: u64 = 0;
+    {
+        var reader = try openSampleReader(std.testing.allocator);
+        defer reader.deinit();
+        var writer = try Writer.openPathFromReaderNoIndex(&reader, path);
+        defer writer.deinit();
+
+        var copied: u64 = 0;
+        while (true) {
+            const offset_before_peek = reader.nextFeatureOffset();
+            if (try reader.peekNextId() == null) break;
+            // Peeking does not consume the feature.
+            try std.testing.expectEqual(offset_before_peek, reader.nextFeatureOffset());
+            try writer.writeFeatureRaw(reader.feature_buf.items);
+            _ = try reader.skipNext();
+            copied += 1;
+            if (copied == 1) {
+                input_offset = reader.nextFeatureOffset();
+                output_offset = writer.written_bytes;
+            }
+        }
+        try std.testing.expect(copied >= 2);
+    }
+    const uninterrupted = try readWholeFileForTest(std.testing.allocator, path);
+    defer std.testing.allocator.free(uninterrupted);
+    try std.testing.expect(output_offset < uninterrupted.len);
+
+    {
+        var reader = try openSampleReader(std.testing.allocator);
+        defer reader.deinit();
+        try reader.seekToFeature(input_offset);
+        var writer = try Writer.openPathResumeFromReader(&reader, path, output_offset);
+        defer writer.deinit();
+        while (try reader.peekNextId()) |_| {
+            try writer.writeFeatureRaw(reader.feature_buf.items);
+            _ = try reader.skipNext();
+        }
+        try std.testing.expectEqual(@as(u64, uninterrupted.len), writer.written_bytes);
+    }
+    const resumed = try readWholeFileForTest(std.testing.allocator, path);
+    defer std.testing.allocator.free(resumed);
+    try std.testing.expectEqualSlices(u8, uninterrupted, resumed);
+}
@@ -1,4 +1,5 @@
 const std = @import("std");
+const compression = @import("compression.zig");
 const File = std.Io.File;
 const default_io = std.Options.debug_io;
 
@@ -202,12 +203,18 @@ pub const CityJSON = struct {
     }
 
     pub fn deinit(self: *CityJSON) void {
+        self.clearRetainingCapacity();
+        self.objects.deinit(self.allocator);
+    }
+
+    /// Remove all objects but keep the object map's capacity for reuse.
+    pub fn clearRetainingCapacity(self: *CityJSON) void {
         for (self.objects.keys(), self.objects.values()) |key, *object| {
             object.deinit(self.allocator);
             // need to add 1 to account for null terminator (needed for C api)
             self.allocator.free(key.ptr[0 .. key.len + 1]);
         }
-        self.objects.deinit(self.allocator);
+        self.objects.clearRetainingCapacity();
     }
 
     /// Add a new CityObject. Returns the object index.
@@ -1094,6 +1101,60 @@ export fn cityjson_get_geometry_boundaries(handle: ?CityJSONHandle, object_index
     return geometries[geometry_index].boundaries.items.ptr;
 }
 
+/// Mirrors CityJSONGeometrySpans in zityjson.h.
+pub const CityJSONGeometrySpans = extern struct {
+    geometry_index: usize,
+    geometry_type: u8,
+    vertices: [*c]const f64,
+    vertex_count: usize,
+    surfaces: [*c]const usize,
+    surface_count: usize,
+    strings: [*c]const usize,
+    string_count: usize,
+    boundaries: [*c]const usize,
+    boundary_count: usize,
+    surface_semantic_types: [*c]const u8,
+};
+
+/// Fill out with zero-copy spans over the first Solid geometry with the given LoD.
+/// Returns 1 when found, 0 when the object has no such geometry, -1 on invalid args.
+export fn cityjson_get_solid_geometry(
+    handle: ?CityJSONHandle,
+    object_index: usize,
+    lod_ptr: [*c]const u8,
+    lod_len: usize,
+    out: *CityJSONGeometrySpans,
+) callconv(.c) c_int {
+    out.* = std.mem.zeroes(CityJSONGeometrySpans);
+    if (lod_ptr == null) return -1;
+    const cj = handle orelse return -1;
+    const values = cj.objects.values();
+    if (object_index >= values.len) return -1;
+    const lod = lod_ptr[0..lod_len];
+
+    const geometries = values[object_index].geometries;
+    const geometry_index = for (geometries, 0..) |geom, i| {
+        if (geom.type == .Solid and std.mem.eql(u8, geom.lod, lod)) break i;
+    } else return 0;
+    const geom = &geometries[geometry_index];
+    if (geom.surface_semantic_types.items.len != geom.surfaces.items.len) return -1;
+
+    out.* = .{
+        .geometry_index = geometry_index,
+        .geometry_type = @intFromEnum(geom.type),
+        .vertices = if (geom.vertices.items.len > 0) geom.vertices.items.ptr else null,
+        .vertex_count = geom.vertices.items.len / 3,
+        .surfaces = if (geom.surfaces.items.len > 0) geom.surfaces.items.ptr else null,
+        .surface_count = geom.surfaces.items.len,
+        .strings = if (geom.strings.items.len > 0) geom.strings.items.ptr else null,
+        .string_count = geom.strings.items.len,
+        .boundaries = if (geom.boundaries.items.len > 0) geom.boundaries.items.ptr else null,
+        .boundary_count = geom.boundaries.items.len,
+        .surface_semantic_types = if (geom.surface_semantic_types.items.len > 0) geom.surface_semantic_types.items.ptr else null,
+    };
+    return 1;
+}
+
 const CJSeqHeaderMetadata = struct {
     geographicalExtent: ?[6]f64 = null,
 };
@@ -1104,11 +1165,6 @@ const CJSeqHeader = struct {
     metadata: ?CJSeqHeaderMetadata = null,
 };
 
-const CJSeqFeatureId = struct {
-    type: []const u8,
-    id: []const u8,
-};
-
 fn semanticSurfaceTypeName(semantic_type: u8) []const u8 {
     return switch (semantic_type) {
         SemanticRoofSurface => "RoofSurface",
@@ -1142,22 +1198,6 @@ fn parseJsonIntegerIndex(value: std.json.Value) !usize {
     return @intCast(i);
 }
 
-fn parseJsonI64(value: std.json.Value) !i64 {
-    return switch (value) {
-        .integer => |v| v,
-        .float => |v| blk: {
-            if (!std.math.isFinite(v)) return error.InvalidJsonNumber;
-            const rounded = @round(v);
-            if (rounded != v) return error.InvalidJsonNumber;
-            if (rounded < @as(f64, @floatFromInt(std.math.minInt(i64)))) return error.InvalidJsonNumber;
-            if (rounded > @as(f64, @floatFromInt(std.math.maxInt(i64)))) return error.InvalidJsonNumber;
-            break :blk @intFromFloat(rounded);
-        },
-        .number_string => |v| try std.fmt.parseInt(i64, v, 10),
-        else => error.InvalidJsonNumber,
-    };
-}
-
 fn parseSemanticSurfaceTypeName(type_name: []const u8) u8 {
     if (std.mem.eql(u8, type_name, "RoofSurface")) return SemanticRoofSurface;
     if (std.mem.eql(u8, type_name, "GroundSurface")) return SemanticGroundSurface;
@@ -1255,84 +1295,210 @@ fn quantizeWorldCoordinate(value: f64, scale: f64, translate: f64) !i64 {
     return @intFromFloat(q);
 }
 
-fn collectBoundaryIndices(value: *const std.json.Value, used: *std.AutoHashMap(usize, void)) !void {
-    switch (value.*) {
-        .array => |arr| {
-            for (arr.items) |*child| {
-                try collectBoundaryIndices(child, used);
-            }
-        },
-        .integer, .float, .number_string => {
-            const idx = try parseJsonIntegerIndex(value.*);
-            try used.put(idx, {});
-        },
-        else => {},
-    }
+fn expectJsonToken(scanner: *std.json.Scanner, comptime expected: std.meta.Tag(std.json.Token)) !void {
+    if ((try scanner.next()) != expected) return error.InvalidCityJSONSeqFeature;
 }
 
-fn remapBoundaryIndices(value: *std.json.Value, old_to_new: *const std.AutoHashMap(usize, usize)) !void {
-    switch (value.*) {
-        .array => |*arr| {
-            for (arr.items) |*child| {
-                try remapBoundaryIndices(child, old_to_new);
-            }
-        },
-        .integer, .float, .number_string => {
-            const old_idx = try parseJsonIntegerIndex(value.*);
-            const new_idx = old_to_new.get(old_idx) orelse return error.InvalidBoundaryIndex;
-            value.* = .{ .integer = @intCast(new_idx) };
-        },
-        else => {},
-    }
+/// Returns the next object key, or null at the closing brace. Keys without
+/// escapes point into the scanned line; escaped keys are copied into `arena`.
+fn nextJsonObjectKey(scanner: *std.json.Scanner, arena: std.mem.Allocator) !?[]const u8 {
+    return switch (try scanner.nextAlloc(arena, .alloc_if_needed)) {
+        .string => |s| s,
+        .allocated_string => |s| s,
+        .object_end => null,
+        else => error.InvalidCityJSONSeqFeature,
+    };
 }
 
-fn readFeatureIdAlloc(allocator: std.mem.Allocator, line: []const u8) ![]u8 {
-    const parsed = try std.json.parseFromSlice(CJSeqFeatureId, allocator, line, .{
-        .ignore_unknown_fields = true,
-    });
-    defer parsed.deinit();
-    if (!std.mem.eql(u8, parsed.value.type, "CityJSONFeature")) {
-        return error.InvalidCityJSONSeqFeature;
+fn nextJsonString(scanner: *std.json.Scanner, arena: std.mem.Allocator) ![]const u8 {
+    return switch (try scanner.nextAlloc(arena, .alloc_if_needed)) {
+        .string => |s| s,
+        .allocated_string => |s| s,
+        else => error.InvalidCityJSONSeqFeature,
+    };
+}
+
+/// LoD values are strings in CityJSON 2.0 but numbers in some older files.
+fn nextJsonLod(scanner: *std.json.Scanner, arena: std.mem.Allocator) ![]const u8 {
+    return switch (try scanner.nextAlloc(arena, .alloc_if_needed)) {
+        .string, .number => |s| s,
+        .allocated_string, .allocated_number => |s| s,
+        else => error.InvalidCityJSONSeqFeature,
+    };
+}
+
+/// Bounded id scan over a CityJSONFeature line. Only top-level keys are
+/// visited and the scan stops once both "type" and "id" are seen, so with
+/// the usual key order CityObjects and vertices are never tokenized.
+fn scanFeatureId(arena: std.mem.Allocator, line: []const u8) ![]const u8 {
+    var scanner = std.json.Scanner.initCompleteInput(arena, line);
+    defer scanner.deinit();
+
+    try expectJsonToken(&scanner, .object_begin);
+    var id: ?[]const u8 = null;
+    var saw_type = false;
+    while (try nextJsonObjectKey(&scanner, arena)) |key| {
+        if (std.mem.eql(u8, key, "type")) {
+            const type_name = try nextJsonString(&scanner, arena);
+            if (!std.mem.eql(u8, type_name, "CityJSONFeature")) return error.InvalidCityJSONSeqFeature;
+            saw_type = true;
+        } else if (std.mem.eql(u8, key, "id")) {
+            id = try nextJsonString(&scanner, arena);
+        } else {
+            try scanner.skipValue();
+        }
+        if (saw_type) {
+            if (id) |found| {
+                if (found.len == 0) return error.InvalidCityJSONSeqFeature;
+                return found;
+            }
+        }
     }
-    if (parsed.value.id.len == 0) {
-        return error.InvalidCityJSONSeqFeature;
+    return error.InvalidCityJSONSeqFeature;
+}
+
+const CJSEQ_DECODED_LOD = "2.2";
+
+/// Parses one entry of a "geometry" array and returns it only when it is a
+/// LoD 2.2 Solid. Boundaries and semantics of other geometries are skipped
+/// without building a value tree, unless they precede "type" and "lod".
+fn decodeLod22SolidGeometry(
+    scanner: *std.json.Scanner,
+    arena: std.mem.Allocator,
+    options: std.json.ParseOptions,
+) !?CJGeometry {
+    try expectJsonToken(scanner, .object_begin);
+    var type_name: ?[]const u8 = null;
+    var lod: ?[]const u8 = null;
+    var boundaries: ?std.json.Value = null;
+    var semantics: ?std.json.Value = null;
+    while (try nextJsonObjectKey(scanner, arena)) |key| {
+        if (std.mem.eql(u8, key, "type")) {
+            type_name = try nextJsonString(scanner, arena);
+        } else if (std.mem.eql(u8, key, "lod")) {
+            lod = try nextJsonLod(scanner, arena);
+        } else if (std.mem.eql(u8, key, "boundaries") or std.mem.eql(u8, key, "semantics")) {
+            const rejected = (type_name != null and !std.mem.eql(u8, type_name.?, "Solid")) or
+                (lod != null and !std.mem.eql(u8, lod.?, CJSEQ_DECODED_LOD));
+            if (rejected) {
+                try scanner.skipValue();
+                continue;
+            }
+            const value = try std.json.innerParse(std.json.Value, arena, scanner, options);
+            if (std.mem.eql(u8, key, "boundaries")) boundaries = value else semantics = value;
+        } else {
+            try scanner.skipValue();
+        }
     }
-    return try allocator.dupe(u8, parsed.value.id);
+
+    const solid_type = type_name orelse return error.InvalidCityJSONSeqFeature;
+    const solid_lod = lod orelse return error.InvalidCityJSONSeqFeature;
+    if (!std.mem.eql(u8, solid_type, "Solid") or !std.mem.eql(u8, solid_lod, CJSEQ_DECODED_LOD)) return null;
+    return .{
+        .type = .Solid,
+        .lod = solid_lod,
+        .boundaries = boundaries orelse return error.InvalidCityJSONSeqFeature,
+        .semantics = semantics,
+    };
 }
 
-fn featureCityObjectsContainsKey(city_objs: std.json.ArrayHashMap(CJObject), key: []const u8) bool {
-    for (city_objs.map.keys()) |obj_key| {
-        if (std.mem.eql(u8, obj_key, key)) return true;
+const SelectedGeometry = struct {
+    object_index: usize,
+    geometry: CJGeometry,
+};
+
+fn selectsObject(ids: ?[]const []const u8, object_id: []const u8) bool {
+    const wanted = ids orelse return true;
+    for (wanted) |id| {
+        if (std.mem.eql(u8, object_id, id)) return true;
     }
     return false;
 }
 
+/// Adds every CityObject of a "CityObjects" member to `cj` and collects the
+/// LoD 2.2 Solids of the objects named in `ids`, or of every object when
+/// `ids` is null. All other geometries are skipped at the token level.
+fn decodeCityObjects(
+    cj: *CityJSON,
+    scanner: *std.json.Scanner,
+    arena: std.mem.Allocator,
+    options: std.json.ParseOptions,
+    ids: ?[]const []const u8,
+    selected: *std.ArrayList(SelectedGeometry),
+) !void {
+    try expectJsonToken(scanner, .object_begin);
+    while (try nextJsonObjectKey(scanner, arena)) |object_id| {
+        if (cj.objects.contains(object_id)) return error.InvalidCityJSONSeqFeature;
+        const object_index = cj.objects.count();
+        const decode_geometry = selectsObject(ids, object_id);
+        var object_type: ?CJObjectType = null;
+
+        try expectJsonToken(scanner, .object_begin);
+        while (try nextJsonObjectKey(scanner, arena)) |key| {
+            if (std.mem.eql(u8, key, "type")) {
+                const type_name = try nextJsonString(scanner, arena);
+                object_type = std.meta.stringToEnum(CJObjectType, type_name) orelse return error.InvalidCityJSONSeqFeature;
+            } else if (decode_geometry and std.mem.eql(u8, key, "geometry")) {
+                try expectJsonToken(scanner, .array_begin);
+                while ((try scanner.peekNextTokenType()) != .array_end) {
+                    if (try decodeLod22SolidGeometry(scanner, arena, options)) |geometry| {
+                        try selected.append(arena, .{ .object_index = object_index, .geometry = geometry });
+                    }
+                }
+                try expectJsonToken(scanner, .array_end);
+            } else {
+                try scanner.skipValue();
+            }
+        }
+
+        _ = try cj.addObject(object_id, object_type orelse return error.InvalidCityJSONSeqFeature);
+    }
+}
+
 const CityJSONSeqReader = struct {
     allocator: std.mem.Allocator,
-    file: File,
+    // Decoded byte stream; plain, zstd and gzip input are detected by magic.
+    source: compression.Source,
     read_buf: [8192]u8,
     read_len: usize,
     read_pos: usize,
     header_line: []u8,
     seq_transform: CJTransform,
     header_extent: ?[6]f64,
-    pending_line: []u8,
-    pending_id: []u8,
+    // Pending and current lines live in two reusable buffers that are
+    // swapped by next(), so pass-through features are never copied.
+    pending_buf: std.ArrayList(u8),
+    pending_line: []const u8,
+    pending_id: std.ArrayList(u8),
     has_pending: bool,
-    current_line: []u8,
-    current_id: []u8,
+    current_buf: std.ArrayList(u8),
+    current_line: []const u8,
+    current_id: std.ArrayList(u8),
     current_cj: CityJSON,
+    // Scratch for id scans and feature decoding, reset per line.
+    parse_arena: std.heap.ArenaAllocator,
 
     fn init(allocator: std.mem.Allocator, path: []const u8) !*CityJSONSeqReader {
         const file = try openFileRead(path);
+        return initFd(allocator, file.handle, true);
+    }
+
+    /// Reads from an already open descriptor such as stdin. The descriptor is
+    /// closed on deinit only when `owns_fd` is set.
+    fn initFd(allocator: std.mem.Allocator, fd: std.posix.fd_t, owns_fd: bool) !*CityJSONSeqReader {
+        var source = try compression.Source.init(allocator, fd, owns_fd);
+        // Once reader.* is populated, reader.deinit() releases everything.
+        var reader_owns_state = false;
+        errdefer if (!reader_owns_state) source.deinit(allocator);
 
         var current_cj = try CityJSON.init(allocator);
-        errdefer current_cj.deinit();
+        errdefer if (!reader_owns_state) current_cj.deinit();
 
         const reader = try allocator.create(CityJSONSeqReader);
+        errdefer if (!reader_owns_state) allocator.destroy(reader);
         reader.* = .{
             .allocator = allocator,
-            .file = file,
+            .source = source,
             .read_buf = undefined,
             .read_len = 0,
             .read_pos = 0,
@@ -1342,19 +1508,30 @@ const CityJSONSeqReader = struct {
                 .translate = .{ 0.0, 0.0, 0.0 },
             },
             .header_extent = null,
+            .pending_buf = .empty,
             .pending_line = &[_]u8{},
-            .pending_id = &[_]u8{},
+            .pending_id = .empty,
             .has_pending = false,
+            .current_buf = .empty,
             .current_line = &[_]u8{},
-            .current_id = &[_]u8{},
+            .current_id = .empty,
             .current_cj = current_cj,
+            .parse_arena = std.heap.ArenaAllocator.init(allocator),
         };
+
+        reader_owns_state = true;
         errdefer reader.deinit();
 
-        const header_line = try reader.readNextMeaningfulLineAlloc() orelse return error.InvalidCityJSONSeqHeader;
-        reader.header_line = header_line;
+        try reader.readHeader();
+        return reader;
+    }
+
+    fn readHeader(self: *CityJSONSeqReader) !void {
+        const allocator = self.allocator;
+        const header_line = try self.readNextMeaningfulLine(&self.pending_buf) orelse return error.InvalidCityJSONSeqHeader;
+        self.header_line = try allocator.dupe(u8, header_line);
 
-        var parse_line = header_line;
+        var parse_line: []const u8 = self.header_line;
         if (std.mem.startsWith(u8, parse_line, "\xEF\xBB\xBF")) {
             parse_line = parse_line[3..];
         }
@@ -1367,134 +1544,202 @@ const CityJSONSeqReader = struct {
             return error.InvalidCityJSONSeqHeader;
         }
 
-        reader.seq_transform = parsed_header.value.transform;
+        self.seq_transform = parsed_header.value.transform;
         if (parsed_header.value.metadata) |metadata| {
-            reader.header_extent = metadata.geographicalExtent;
+            self.header_extent = metadata.geographicalExtent;
         }
-
-        return reader;
     }
 
     fn deinit(self: *CityJSONSeqReader) void {
-        self.clearPending();
-        self.clearCurrent();
         if (self.header_line.len > 0) {
             self.allocator.free(self.header_line);
         }
+        self.pending_buf.deinit(self.allocator);
+        self.pending_id.deinit(self.allocator);
+        self.current_buf.deinit(self.allocator);
+        self.current_id.deinit(self.allocator);
         self.current_cj.deinit();
-        closeFile(self.file);
+        self.parse_arena.deinit();
+        self.source.deinit(self.allocator);
         self.allocator.destroy(self);
     }
 
     fn clearPending(self: *CityJSONSeqReader) void {
-        if (!self.has_pending) return;
-        if (self.pending_line.len > 0) self.allocator.free(self.pending_line);
-        if (self.pending_id.len > 0) self.allocator.free(self.pending_id);
         self.pending_line = &[_]u8{};
-        self.pending_id = &[_]u8{};
+        self.pending_id.clearRetainingCapacity();
         self.has_pending = false;
     }
 
     fn clearCurrent(self: *CityJSONSeqReader) void {
-        if (self.current_line.len > 0) self.allocator.free(self.current_line);
-        if (self.current_id.len > 0) self.allocator.free(self.current_id);
         self.current_line = &[_]u8{};
-        self.current_id = &[_]u8{};
+        self.current_id.clearRetainingCapacity();
     }
 
-    fn readNextMeaningfulLineAlloc(self: *CityJSONSeqReader) !?[]u8 {
-        var line: std.ArrayList(u8) = .empty;
-        defer line.deinit(self.allocator);
-
+    /// Reads the next non-blank line into `buf` and returns it trimmed. The
+    /// slice is valid until `buf` is reused.
+    fn readNextMeaningfulLine(self: *CityJSONSeqReader, buf: *std.ArrayList(u8)) !?[]const u8 {
         while (true) {
-            line.clearRetainingCapacity();
+            buf.clearRetainingCapacity();
             var saw_bytes = false;
 
             while (true) {
                 if (self.read_pos >= self.read_len) {
-                    self.read_len = try std.posix.read(self.file.handle, &self.read_buf);
+                    self.read_len = try self.source.read(&self.read_buf);
                     self.read_pos = 0;
                     if (self.read_len == 0) break;
                 }
 
                 const chunk = self.read_buf[self.read_pos..self.read_len];
                 if (std.mem.indexOfScalar(u8, chunk, '\n')) |rel_end| {
-                    try line.appendSlice(self.allocator, chunk[0..rel_end]);
+                    try buf.appendSlice(self.allocator, chunk[0..rel_end]);
                     self.read_pos += rel_end + 1;
                     saw_bytes = true;
                     break;
                 }
 
-                try line.appendSlice(self.allocator, chunk);
+                try buf.appendSlice(self.allocator, chunk);
                 self.read_pos = self.read_len;
                 saw_bytes = true;
             }
 
-            if (!saw_bytes and line.items.len == 0 and self.read_len == 0) {
+            if (!saw_bytes and buf.items.len == 0 and self.read_len == 0) {
                 return null;
             }
 
-            const trimmed = std.mem.trim(u8, line.items, " \t\r");
+            const trimmed = std.mem.trim(u8, buf.items, " \t\r");
             if (trimmed.len == 0) {
                 continue;
             }
-            return try self.allocator.dupe(u8, trimmed);
+            return trimmed;
         }
     }
 
+    /// Makes sure a feature line and its id are pending. Returns false at
+    /// end of stream.
+    fn fillPending(self: *CityJSONSeqReader) !bool {
+        if (self.has_pending) return true;
+        const line = try self.readNextMeaningfulLine(&self.pending_buf) orelse return false;
+
+        _ = self.parse_arena.reset(.retain_capacity);
+        const id = try scanFeatureId(self.parse_arena.allocator(), line);
+        self.pending_id.clearRetainingCapacity();
+        try self.pending_id.appendSlice(self.allocator, id);
+        self.pending_line = line;
+        self.has_pending = true;
+        return true;
+    }
+
+    fn promotePending(self: *CityJSONSeqReader) void {
+        std.mem.swap(std.ArrayList(u8), &self.pending_buf, &self.current_buf);
+        std.mem.swap(std.ArrayList(u8), &self.pending_id, &self.current_id);
+        self.current_line = self.pending_line;
+        self.clearPending();
+    }
+
+    /// Decodes the current line into current_cj. Every CityObject is added
+    /// so object lookups behave as before, but geometry is only decoded for
+    /// LoD 2.2 Solids of the "<id>" and "<id>-0" objects; all other
+    /// geometries are skipped at the token level.
     fn decodeCurrentFeature(self: *CityJSONSeqReader) !void {
-        self.current_cj.deinit();
-        self.current_cj = try CityJSON.init(self.allocator);
+        self.current_cj.clearRetainingCapacity();
+        _ = self.parse_arena.reset(.retain_capacity);
+        const arena = self.parse_arena.allocator();
+
+        const line = self.current_line;
+        const id = self.current_id.items;
+        const part_id = try std.fmt.allocPrint(arena, "{s}-0", .{id});
+        const options: std.json.ParseOptions = .{
+            .max_value_len = line.len,
+            .allocate = .alloc_if_needed,
+        };
 
-        const parsed_feature = try std.json.parseFromSlice(CJFeature, self.allocator, self.current_line, .{
-            .ignore_unknown_fields = true,
-        });
-        defer parsed_feature.deinit();
+        var scanner = std.json.Scanner.initCompleteInput(arena, line);
+        defer scanner.deinit();
 
-        if (!std.mem.eql(u8, parsed_feature.value.type, "CityJSONFeature")) {
-            return error.InvalidCityJSONSeqFeature;
-        }
-        if (parsed_feature.value.id.len == 0) {
-            return error.InvalidCityJSONSeqFeature;
+        var selected: std.ArrayList(SelectedGeometry) = .empty;
+        var vertices: ?[]const [3]i64 = null;
+        var saw_city_objects = false;
+
+        try expectJsonToken(&scanner, .object_begin);
+        while (try nextJsonObjectKey(&scanner, arena)) |key| {
+            if (std.mem.eql(u8, key, "CityObjects")) {
+                try decodeCityObjects(&self.current_cj, &scanner, arena, options, &.{ id, part_id }, &selected);
+                saw_city_objects = true;
+            } else if (std.mem.eql(u8, key, "vertices")) {
+                vertices = try std.json.innerParse([]const [3]i64, arena, &scanner, options);
+            } else {
+                try scanner.skipValue();
+            }
         }
-        if (!featureCityObjectsContainsKey(parsed_feature.value.CityObjects, parsed_feature.value.id)) {
+        try expectJsonToken(&scanner, .end_of_document);
+
+        if (!saw_city_objects) return error.InvalidCityJSONSeqFeature;
+        if (self.current_cj.objects.getIndex(id) == null) {
             return error.InvalidCityJSONSeqFeatureParent;
         }
+        const feature_vertices = vertices orelse return error.InvalidCityJSONSeqFeature;
 
-        try self.current_cj.ingestCityObjects(
-            parsed_feature.value.CityObjects,
-            parsed_feature.value.vertices,
-            self.seq_transform,
-        );
+        for (selected.items) |entry| {
+            const geometry_index = try self.current_cj.addGeometry(entry.object_index, .Solid, entry.geometry.lod);
+            const geom = try self.current_cj.getGeometry(entry.object_index, geometry_index);
+            try self.current_cj.ingestGeometry(geom, entry.geometry, feature_vertices, self.seq_transform);
+        }
     }
 };
 
 const CityJSONSeqWriter = struct {
     allocator: std.mem.Allocator,
-    file: File,
+    // Buffered output; compressed when the path ends in .zst/.gz or the fd
+    // writer was opened with a codec.
+    sink: compression.Sink,
 
     fn init(allocator: std.mem.Allocator, reader: *const CityJSONSeqReader, path: []const u8) !*CityJSONSeqWriter {
         const file = try createFileTruncate(path);
+        return initFd(allocator, reader, file.handle, true, compression.Codec.fromPath(path));
+    }
+
+    fn initFd(
+        allocator: std.mem.Allocator,
+        reader: *const CityJSONSeqReader,
+        fd: std.posix.fd_t,
+        owns_fd: bool,
+        codec: compression.Codec,
+    ) !*CityJSONSeqWriter {
+        var sink = try compression.Sink.init(allocator, fd, owns_fd, codec);
+        errdefer sink.deinit(allocator);
 
         const writer = try allocator.create(CityJSONSeqWriter);
         writer.* = .{
             .allocator = allocator,
-            .file = file,
+            .sink = sink,
         };
-        errdefer writer.deinit();
 
-        try writer.writeLine(reader.header_line);
+        writer.writeLine(reader.header_line) catch |err| {
+            allocator.destroy(writer);
+            return err;
+        };
         return writer;
     }
 
-    fn deinit(self: *CityJSONSeqWriter) void {
-        closeFile(self.file);
-        self.allocator.destroy(self);
+    /// Flushes buffered lines and ends the compressed stream. Safe to call
+    /// more than once; deinit() calls it too.
+    fn finish(self: *CityJSONSeqWriter) !void {
+        try self.sink.finish();
+    }
+
+    /// Finishes the stream if finish() was not called, then releases the
+    /// writer. The writer is released even when finishing fails.
+    fn deinit(self: *CityJSONSeqWriter) !void {
+        defer {
+            self.sink.deinit(self.allocator);
+            self.allocator.destroy(self);
+        }
+        try self.finish();
     }
 
     fn writeLine(self: *CityJSONSeqWriter, line: []const u8) !void {
-        try writeAll(self.file, line);
-        try writeAll(self.file, "\n");
+        try self.sink.writeAll(line);
+        try self.sink.writeAll("\n");
     }
 };
 
@@ -1510,6 +1755,14 @@ export fn cityjsonseq_reader_open(path: [*c]const u8) callconv(.c) ?CityJSONSeqR
     };
 }
 
+export fn cityjsonseq_reader_open_fd(fd: c_int, close_on_destroy: c_int) callconv(.c) ?CityJSONSeqReaderHandle {
+    if (fd < 0) return null;
+    return CityJSONSeqReader.initFd(c_allocator, fd, close_on_destroy != 0) catch |err| {
+        std.debug.print("Error opening CityJSONSeq reader from fd: {}\n", .{err});
+        return null;
+    };
+}
+
 export fn cityjsonseq_reader_destroy(handle: ?CityJSONSeqReaderHandle) callconv(.c) void {
     if (handle) |reader| {
         reader.deinit();
@@ -1533,63 +1786,40 @@ export fn cityjsonseq_reader_header_geographical_extent(
     return 1;
 }
 
+export fn cityjsonseq_reader_header_transform(
+    handle: ?CityJSONSeqReaderHandle,
+    out_scale_xyz: [*c]f64,
+    out_translate_xyz: [*c]f64,
+) callconv(.c) c_int {
+    const reader = handle orelse return -1;
+    if (out_scale_xyz == null or out_translate_xyz == null) return -1;
+    for (0..3) |axis| {
+        out_scale_xyz[axis] = reader.seq_transform.scale[axis];
+        out_translate_xyz[axis] = reader.seq_transform.translate[axis];
+    }
+    return 1;
+}
+
 export fn cityjsonseq_peek_next_id(
     handle: ?CityJSONSeqReaderHandle,
     out_id: *[*c]const u8,
     out_len: *usize,
 ) callconv(.c) c_int {
     const reader = handle orelse return -1;
+    const has_feature = reader.fillPending() catch return -1;
+    if (!has_feature) return 0;
 
-    if (reader.has_pending) {
-        out_id.* = reader.pending_id.ptr;
-        out_len.* = reader.pending_id.len;
-        return 1;
-    }
-
-    const next_line = reader.readNextMeaningfulLineAlloc() catch return -1;
-    if (next_line == null) return 0;
-    const line = next_line.?;
-
-    const parsed_id = readFeatureIdAlloc(reader.allocator, line) catch {
-        reader.allocator.free(line);
-        return -1;
-    };
-
-    reader.pending_line = line;
-    reader.pending_id = parsed_id;
-    reader.has_pending = true;
-
-    out_id.* = reader.pending_id.ptr;
-    out_len.* = reader.pending_id.len;
+    out_id.* = reader.pending_id.items.ptr;
+    out_len.* = reader.pending_id.items.len;
     return 1;
 }
 
 export fn cityjsonseq_next(handle: ?CityJSONSeqReaderHandle) callconv(.c) c_int {
     const reader = handle orelse return -1;
+    const has_feature = reader.fillPending() catch return -1;
+    if (!has_feature) return 0;
 
-    var line: []u8 = &[_]u8{};
-    var id: []u8 = &[_]u8{};
-
-    if (reader.has_pending) {
-        line = reader.pending_line;
-        id = reader.pending_id;
-        reader.pending_line = &[_]u8{};
-        reader.pending_id = &[_]u8{};
-        reader.has_pending = false;
-    } else {
-        const next_line = reader.readNextMeaningfulLineAlloc() catch return -1;
-        if (next_line == null) return 0;
-        line = next_line.?;
-        id = readFeatureIdAlloc(reader.allocator, line) catch {
-            reader.allocator.free(line);
-            return -1;
-        };
-    }
-
-    reader.clearCurrent();
-    reader.current_line = line;
-    reader.current_id = id;
-
+    reader.promotePending();
     reader.decodeCurrentFeature() catch {
         reader.clearCurrent();
         return -1;
@@ -1604,15 +1834,15 @@ export fn cityjsonseq_current_feature_id(
     out_len: *usize,
 ) callconv(.c) c_int {
     const reader = handle orelse return -1;
-    if (reader.current_id.len == 0) return 0;
-    out_id.* = reader.current_id.ptr;
-    out_len.* = reader.current_id.len;
+    if (reader.current_id.items.len == 0) return 0;
+    out_id.* = reader.current_id.items.ptr;
+    out_len.* = reader.current_id.items.len;
     return 1;
 }
 
 export fn cityjsonseq_current_cityjson(handle: ?CityJSONSeqReaderHandle) callconv(.c) ?CityJSONHandle {
     const reader = handle orelse return null;
-    if (reader.current_id.len == 0) return null;
+    if (reader.current_id.items.len == 0) return null;
     return &reader.current_cj;
 }
 
@@ -1629,10 +1859,34 @@ export fn cityjsonseq_writer_open_from_reader(
     };
 }
 
-export fn cityjsonseq_writer_destroy(handle: ?CityJSONSeqWriterHandle) callconv(.c) void {
-    if (handle) |writer| {
-        writer.deinit();
-    }
+export fn cityjsonseq_writer_open_from_reader_fd(
+    reader_handle: ?CityJSONSeqReaderHandle,
+    fd: c_int,
+    compression_codec: u8,
+    close_on_destroy: c_int,
+) callconv(.c) ?CityJSONSeqWriterHandle {
+    const reader = reader_handle orelse return null;
+    if (fd < 0) return null;
+    const codec = enumFromIntChecked(compression.Codec, compression_codec) orelse return null;
+    return CityJSONSeqWriter.initFd(c_allocator, reader, fd, close_on_destroy != 0, codec) catch |err| {
+        std.debug.print("Error opening CityJSONSeq writer from fd: {}\n", .{err});
+        return null;
+    };
+}
+
+export fn cityjsonseq_writer_finish(handle: ?CityJSONSeqWriterHandle) callconv(.c) c_int {
+    const writer = handle orelse return -1;
+    writer.finish() catch |err| {
+        std.debug.print("Error finishing CityJSONSeq output: {}\n", .{err});
+        return -1;
+    };
+    return 0;
+}
+
+export fn cityjsonseq_writer_destroy(handle: ?CityJSONSeqWriterHandle) callconv(.c) c_int {
+    const writer = handle orelse return 0;
+    writer.deinit() catch return -1;
+    return 0;
 }
 
 export fn cityjsonseq_writer_write_pending_raw(
@@ -1665,6 +1919,234 @@ export fn cityjsonseq_writer_write_current_raw(
     return 0;
 }
 
+const ByteSpan = struct {
+    start: usize,
+    end: usize,
+
+    fn bytes(self: ByteSpan, line: []const u8) []const u8 {
+        return line[self.start..self.end];
+    }
+
+    /// Offset of the closing brace or bracket of an object/array span.
+    fn closing(self: ByteSpan) usize {
+        return self.end - 1;
+    }
+};
+
+/// Skips the next value and returns its byte span in the scanned input.
+/// peekNextTokenType() consumes the separator, leaving the cursor on the
+/// first byte of the value.
+fn scanValueSpan(scanner: *std.json.Scanner) !ByteSpan {
+    _ = try scanner.peekNextTokenType();
+    const start = scanner.cursor;
+    try scanner.skipValue();
+    return .{ .start = start, .end = scanner.cursor };
+}
+
+/// Byte layout of one CityObject in a feature line, as needed to splice
+/// attributes and a replacement LoD 2.2 geometry into the original bytes.
+const CJSeqObjectLayout = struct {
+    id: []const u8,
+    span: ByteSpan,
+    member_count: usize = 0,
+    attributes: ?ByteSpan = null,
+    first_parent: ?[]const u8 = null,
+    lod22_solid: ?ByteSpan = null,
+};
+
+const CJSeqFeatureLayout = struct {
+    objects: []const CJSeqObjectLayout,
+    vertices: ByteSpan,
+    vertex_values: []const [3]i64,
+
+    fn find(self: CJSeqFeatureLayout, id: []const u8) ?*const CJSeqObjectLayout {
+        for (self.objects) |*object| {
+            if (std.mem.eql(u8, object.id, id)) return object;
+        }
+        return null;
+    }
+
+    /// The "<id>-0" building part when present, otherwise the feature object.
+    fn target(self: CJSeqFeatureLayout, arena: std.mem.Allocator, feature_id: []const u8) !*const CJSeqObjectLayout {
+        const part_id = try std.fmt.allocPrint(arena, "{s}-0", .{feature_id});
+        return self.find(part_id) orelse self.find(feature_id) orelse error.TargetObjectNotFound;
+    }
+
+    /// Target 1 is the target object, target 2 its parent building.
+    fn attributeDestination(
+        self: CJSeqFeatureLayout,
+        target_object: *const CJSeqObjectLayout,
+        feature_id: []const u8,
+        source_attribute_target: u8,
+    ) !*const CJSeqObjectLayout {
+        return switch (source_attribute_target) {
+            1 => target_object,
+            2 => self.find(feature_id) orelse blk: {
+                const parent_id = target_object.first_parent orelse break :blk target_object;
+                break :blk self.find(parent_id) orelse target_object;
+            },
+            else => error.InvalidSourceAttributeTarget,
+        };
+    }
+};
+
+/// Consumes one geometry object and reports whether it is a solid-like
+/// LoD 2.2 geometry.
+fn scanGeometryIsLod22Solid(scanner: *std.json.Scanner, arena: std.mem.Allocator) !bool {
+    try expectJsonToken(scanner, .object_begin);
+    var solid_like = false;
+    var lod22 = false;
+    while (try nextJsonObjectKey(scanner, arena)) |key| {
+        if (std.mem.eql(u8, key, "type")) {
+            solid_like = isSolidLikeGeometryType(try nextJsonString(scanner, arena));
+        } else if (std.mem.eql(u8, key, "lod")) {
+            lod22 = std.mem.eql(u8, try nextJsonLod(scanner, arena), CJSEQ_DECODED_LOD);
+        } else {
+            try scanner.skipValue();
+        }
+    }
+    return solid_like and lod22;
+}
+
+fn scanObjectLayout(
+    scanner: *std.json.Scanner,
+    arena: std.mem.Allocator,
+    options: std.json.ParseOptions,
+    object_id: []const u8,
+) !CJSeqObjectLayout {
+    _ = try scanner.peekNextTokenType();
+    var layout: CJSeqObjectLayout = .{
+        .id = object_id,
+        .span = .{ .start = scanner.cursor, .end = scanner.cursor },
+    };
+
+    try expectJsonToken(scanner, .object_begin);
+    while (try nextJsonObjectKey(scanner, arena)) |key| {
+        layout.member_count += 1;
+        if (std.mem.eql(u8, key, "attributes")) {
+            layout.attributes = try scanValueSpan(scanner);
+        } else if (std.mem.eql(u8, key, "parents")) {
+            const parents = try std.json.innerParse([]const []const u8, arena, scanner, options);
+            if (parents.len > 0) layout.first_parent = parents[0];
+        } else if (std.mem.eql(u8, key, "geometry")) {
+            try expectJsonToken(scanner, .array_begin);
+            while ((try scanner.peekNextTokenType()) != .array_end) {
+                const start = scanner.cursor;
+                const is_lod22_solid = try scanGeometryIsLod22Solid(scanner, arena);
+                if (is_lod22_solid and layout.lod22_solid == null) {
+                    layout.lod22_solid = .{ .start = start, .end = scanner.cursor };
+                }
+            }
+            try expectJsonToken(scanner, .array_end);
+        } else {
+            try scanner.skipValue();
+        }
+    }
+    layout.span.end = scanner.cursor;
+    return layout;
+}
+
+/// Records where each CityObject, its attributes and its first LoD 2.2
+/// solid live in `line`. Vertices are only decoded when `decode_vertices`
+/// is set; their span is always recorded.
+fn scanFeatureLayout(arena: std.mem.Allocator, line: []const u8, decode_vertices: bool) !CJSeqFeatureLayout {
+    const options: std.json.ParseOptions = .{
+        .max_value_len = line.len,
+        .allocate = .alloc_if_needed,
+    };
+    var scanner = std.json.Scanner.initCompleteInput(arena, line);
+    defer scanner.deinit();
+
+    var objects: std.ArrayList(CJSeqObjectLayout) = .empty;
+    var vertices: ?ByteSpan = null;
+    var vertex_values: []const [3]i64 = &.{};
+
+    try expectJsonToken(&scanner, .object_begin);
+    while (try nextJsonObjectKey(&scanner, arena)) |key| {
+        if (std.mem.eql(u8, key, "CityObjects")) {
+            try expectJsonToken(&scanner, .object_begin);
+            while (try nextJsonObjectKey(&scanner, arena)) |object_id| {
+                try objects.append(arena, try scanObjectLayout(&scanner, arena, options, object_id));
+            }
+        } else if (std.mem.eql(u8, key, "vertices")) {
+            _ = try scanner.peekNextTokenType();
+            const start = scanner.cursor;
+            if (decode_vertices) {
+                vertex_values = try std.json.innerParse([]const [3]i64, arena, &scanner, options);
+            } else {
+                try scanner.skipValue();
+            }
+            vertices = .{ .start = start, .end = scanner.cursor };
+        } else {
+            try scanner.skipValue();
+        }
+    }
+    try expectJsonToken(&scanner, .end_of_document);
+
+    return .{
+        .objects = objects.items,
+        .vertices = vertices orelse return error.InvalidCityJSONSeqFeature,
+        .vertex_values = vertex_values,
+    };
+}
+
+/// Writes attributes that `seen` does not contain yet as comma-separated
+/// JSON members. `first` tracks whether a separator is needed.
+fn writeNewJsonMembers(
+    w: *std.Io.Writer,
+    seen: *std.StringHashMap(void),
+    attrs: SourceAttributes,
+    first: *bool,
+) !void {
+    for (0..attrs.count) |i| {
+        const name = attrs.name(i) orelse continue;
+        if (name.len == 0 or seen.contains(name)) continue;
+        try seen.put(name, {});
+        if (!first.*) try w.writeByte(',');
+        first.* = false;
+        try std.json.Stringify.value(name, .{}, w);
+        try w.writeByte(':');
+        try std.json.Stringify.value(try attrs.jsonValue(i), .{}, w);
+    }
+}
+
+/// Offset at which writeAttributeSplice output must be inserted.
+fn attributeSpliceOffset(destination: *const CJSeqObjectLayout) usize {
+    if (destination.attributes) |span| return span.closing();
+    return destination.span.closing();
+}
+
+/// Writes the bytes to insert at attributeSpliceOffset(destination): new
+/// members for an existing "attributes" object (existing names win), or a
+/// whole "attributes" member when the object has none.
+fn writeAttributeSplice(
+    w: *std.Io.Writer,
+    arena: std.mem.Allocator,
+    line: []const u8,
+    destination: *const CJSeqObjectLayout,
+    attrs: SourceAttributes,
+) !void {
+    var seen = std.StringHashMap(void).init(arena);
+    var first = true;
+    if (destination.attributes) |span| {
+        var scanner = std.json.Scanner.initCompleteInput(arena, span.bytes(line));
+        defer scanner.deinit();
+        try expectJsonToken(&scanner, .object_begin);
+        while (try nextJsonObjectKey(&scanner, arena)) |key| {
+            try seen.put(key, {});
+            try scanner.skipValue();
+            first = false;
+        }
+        try writeNewJsonMembers(w, &seen, attrs, &first);
+        return;
+    }
+
+    if (destination.member_count > 0) try w.writeByte(',');
+    try w.writeAll("\"attributes\":{");
+    try writeNewJsonMembers(w, &seen, attrs, &first);
+    try w.writeByte('}');
+}
+
 fn writeCurrentFeatureLineWithAttributes(
     reader: *CityJSONSeqReader,
     writer: *CityJSONSeqWriter,
@@ -1672,44 +2154,36 @@ fn writeCurrentFeatureLineWithAttributes(
     source_attributes: ?SourceAttributes,
     source_attribute_target: u8,
 ) !void {
-    if (reader.current_line.len == 0) return error.InvalidCityJSONSeqFeature;
+    const line = reader.current_line;
+    if (line.len == 0) return error.InvalidCityJSONSeqFeature;
     if (source_attribute_target == 0) {
-        try writer.writeLine(reader.current_line);
+        try writer.writeLine(line);
         return;
     }
 
-    const parsed = try std.json.parseFromSlice(std.json.Value, reader.allocator, reader.current_line, .{});
-    defer parsed.deinit();
-    const arena_alloc = parsed.arena.allocator();
-
-    if (parsed.value != .object) return error.InvalidCityJSONSeqFeature;
-    var root_obj = &parsed.value.object;
+    _ = reader.parse_arena.reset(.retain_capacity);
+    const arena_alloc = reader.parse_arena.allocator();
+    const layout = try scanFeatureLayout(arena_alloc, line, false);
+    const target_object = try layout.target(arena_alloc, feature_id);
 
-    const city_objects_value = root_obj.getPtr("CityObjects") orelse return error.InvalidCityJSONSeqFeature;
-    if (city_objects_value.* != .object) return error.InvalidCityJSONSeqFeature;
-    var city_objects_obj = &city_objects_value.object;
-
-    var target_obj_id = try std.fmt.allocPrint(arena_alloc, "{s}-0", .{feature_id});
-    var target_object = city_objects_obj.getPtr(target_obj_id);
-    if (target_object == null) {
-        target_obj_id = try arena_alloc.dupe(u8, feature_id);
-        target_object = city_objects_obj.getPtr(target_obj_id);
+    const attrs = source_attributes orelse {
+        try writer.writeLine(line);
+        return;
+    };
+    if (attrs.count == 0) {
+        try writer.writeLine(line);
+        return;
     }
-    const target_object_value = target_object orelse return error.TargetObjectNotFound;
-    if (target_object_value.* != .object) return error.TargetObjectNotFound;
-
-    try mergeSourceAttributes(
-        arena_alloc,
-        city_objects_obj,
-        target_object_value,
-        feature_id,
-        source_attributes,
-        source_attribute_target,
-    );
+    const destination = try layout.attributeDestination(target_object, feature_id, source_attribute_target);
 
-    var out: std.Io.Writer.Allocating = .init(reader.allocator);
+    // Splice the new attribute members into the original bytes; everything
+    // else in the line is copied verbatim.
+    var out: std.Io.Writer.Allocating = .init(arena_alloc);
     defer out.deinit();
-    try std.json.Stringify.value(parsed.value, .{ .whitespace = .minified }, &out.writer);
+    const splice_at = attributeSpliceOffset(destination);
+    try out.writer.writeAll(line[0..splice_at]);
+    try writeAttributeSplice(&out.writer, arena_alloc, line, destination, attrs);
+    try out.writer.writeAll(line[splice_at..]);
     try writer.writeLine(out.written());
 }
 
@@ -1900,20 +2374,118 @@ fn quantizedRingArea3d(
     );
 }
 
-fn writeReplacedCurrentFeatureLinePolygonal(
-    reader: *CityJSONSeqReader,
-    writer: *CityJSONSeqWriter,
-    feature_id: []const u8,
+const CJSeqLineEdit = struct {
+    const Kind = enum { attributes, geometry, vertices };
+
+    span: ByteSpan,
+    kind: Kind,
+
+    fn lessThan(_: void, a: CJSeqLineEdit, b: CJSeqLineEdit) bool {
+        return a.span.start < b.span.start;
+    }
+};
+
+/// Copies the members of an existing geometry object other than the ones
+/// the replacement writes, so unrelated keys survive byte for byte.
+fn writeRetainedGeometryMembers(
+    w: *std.Io.Writer,
+    arena: std.mem.Allocator,
+    geometry_bytes: []const u8,
+) !void {
+    var scanner = std.json.Scanner.initCompleteInput(arena, geometry_bytes);
+    defer scanner.deinit();
+    try expectJsonToken(&scanner, .object_begin);
+    while (try nextJsonObjectKey(&scanner, arena)) |key| {
+        const value = try scanValueSpan(&scanner);
+        if (std.mem.eql(u8, key, "type") or std.mem.eql(u8, key, "lod") or
+            std.mem.eql(u8, key, "boundaries") or std.mem.eql(u8, key, "semantics"))
+        {
+            continue;
+        }
+        try w.writeByte(',');
+        try std.json.Stringify.value(key, .{}, w);
+        try w.writeByte(':');
+        try w.writeAll(value.bytes(geometry_bytes));
+    }
+}
+
+/// Quantized vertex list that replacement geometry is appended to. Existing
+/// vertices keep their indices, and a replacement vertex reuses the index of
+/// an equal quantized coordinate, so boundaries elsewhere stay valid.
+const SpliceVertices = struct {
+    allocator: std.mem.Allocator,
+    items: std.ArrayList([3]i64),
+    old_count: usize,
+    coord_to_index: std.AutoHashMap([3]i64, usize),
+
+    fn init(allocator: std.mem.Allocator, existing: []const [3]i64) !SpliceVertices {
+        var vertices: SpliceVertices = .{
+            .allocator = allocator,
+            .items = .empty,
+            .old_count = existing.len,
+            .coord_to_index = std.AutoHashMap([3]i64, usize).init(allocator),
+        };
+        try vertices.items.appendSlice(allocator, existing);
+        for (existing, 0..) |coord, i| {
+            const entry = try vertices.coord_to_index.getOrPut(coord);
+            if (!entry.found_existing) entry.value_ptr.* = i;
+        }
+        return vertices;
+    }
+
+    fn indexOf(self: *SpliceVertices, world: []const f64, transform: CJTransform) !usize {
+        const quantized = [3]i64{
+            try quantizeWorldCoordinate(world[0], transform.scale[0], transform.translate[0]),
+            try quantizeWorldCoordinate(world[1], transform.scale[1], transform.translate[1]),
+            try quantizeWorldCoordinate(world[2], transform.scale[2], transform.translate[2]),
+        };
+        const entry = try self.coord_to_index.getOrPut(quantized);
+        if (!entry.found_existing) {
+            entry.value_ptr.* = self.items.items.len;
+            try self.items.append(self.allocator, quantized);
+        }
+        return entry.value_ptr.*;
+    }
+
+    /// Drops the vertices appended after the first `count`.
+    fn truncate(self: *SpliceVertices, count: usize) void {
+        for (self.items.items[count..]) |coord| {
+            _ = self.coord_to_index.remove(coord);
+        }
+        self.items.shrinkRetainingCapacity(count);
+    }
+
+    fn appended(self: SpliceVertices) bool {
+        return self.items.items.len > self.old_count;
+    }
+
+    /// Writes the appended vertices, to be inserted before the closing
+    /// bracket of the original "vertices" array.
+    fn writeAppended(self: SpliceVertices, w: *std.Io.Writer) !void {
+        for (self.items.items[self.old_count..], self.old_count..) |coord, i| {
+            if (i > 0) try w.writeByte(',');
+            try w.print("[{d},{d},{d}]", .{ coord[0], coord[1], coord[2] });
+        }
+    }
+};
+
+/// Renders the geometry object that replaces a LoD 2.2 solid: polygonal
+/// surfaces with optional holes, their semantics, and the members of the
+/// original geometry (`retained_geometry_bytes`) other than the replaced
+/// ones. Vertices are quantized with `transform` into `vertices`.
+fn renderReplacedSolidGeometry(
+    arena: std.mem.Allocator,
+    vertices: *SpliceVertices,
+    transform: CJTransform,
     vertices_xyz_world: []const f64,
     surface_ring_counts: []const u32,
     ring_vertex_counts: []const u32,
     boundary_indices: []const u32,
     surface_semantic_types: []const u8,
-    source_attributes: ?SourceAttributes,
-    source_attribute_target: u8,
     surface_attribute_group_indices: ?[]const u32,
     surface_attribute_groups: ?SourceAttributeGroups,
-) !void {
+    retained_geometry_bytes: []const u8,
+) ![]const u8 {
     if (vertices_xyz_world.len % 3 != 0) return error.InvalidVertexArray;
     if (surface_ring_counts.len == 0 or ring_vertex_counts.len == 0 or boundary_indices.len == 0) {
         return error.InvalidReplacementGeometry;
@@ -1936,149 +2508,24 @@ fn writeReplacedCurrentFeatureLinePolygonal(
     if (expected_boundary_count != boundary_indices.len) return error.InvalidReplacementGeometry;
     if (vertices_xyz_world.len == 0) return error.InvalidReplacementGeometry;
 
-    const parsed = try std.json.parseFromSlice(std.json.Value, reader.allocator, reader.current_line, .{});
-    defer parsed.deinit();
-    const arena_alloc = parsed.arena.allocator();
-
-    if (parsed.value != .object) return error.InvalidCityJSONSeqFeature;
-    var root_obj = &parsed.value.object;
-
-    const city_objects_value = root_obj.getPtr("CityObjects") orelse return error.InvalidCityJSONSeqFeature;
-    if (city_objects_value.* != .object) return error.InvalidCityJSONSeqFeature;
-    var city_objects_obj = &city_objects_value.object;
-
-    const vertices_value = root_obj.getPtr("vertices") orelse return error.InvalidCityJSONSeqFeature;
-    if (vertices_value.* != .array) return error.InvalidCityJSONSeqFeature;
-
-    var target_obj_id = try std.fmt.allocPrint(arena_alloc, "{s}-0", .{feature_id});
-    var target_object = city_objects_obj.getPtr(target_obj_id);
-    if (target_object == null) {
-        target_obj_id = try arena_alloc.dupe(u8, feature_id);
-        target_object = city_objects_obj.getPtr(target_obj_id);
-    }
-    var target_object_value = target_object orelse return error.TargetObjectNotFound;
-    if (target_object_value.* != .object) return error.TargetObjectNotFound;
-
-    if (source_attribute_target != 0) {
-        try mergeSourceAttributes(
-            arena_alloc,
-            city_objects_obj,
-            target_object_value,
-            feature_id,
-            source_attributes,
-            source_attribute_target,
-        );
-    }
-
-    const target_geometries_value = target_object_value.object.getPtr("geometry") orelse return error.TargetGeometryNotFound;
-    if (target_geometries_value.* != .array) return error.TargetGeometryNotFound;
-
-    var target_geometry: ?*std.json.Value = null;
-    for (target_geometries_value.array.items) |*geom| {
-        if (geom.* != .object) continue;
-        const geom_type_value = geom.object.get("type") orelse continue;
-        if (geom_type_value != .string) continue;
-        if (!isSolidLikeGeometryType(geom_type_value.string)) continue;
-        const lod_value = geom.object.get("lod") orelse continue;
-        if (lod_value != .string) continue;
-        if (std.mem.eql(u8, lod_value.string, "2.2")) {
-            target_geometry = geom;
-            break;
-        }
-    }
-    const target_geometry_value = target_geometry orelse return error.TargetGeometryNotFound;
-
-    var old_vertices = std.ArrayList([3]i64).empty;
-    defer old_vertices.deinit(arena_alloc);
-    for (vertices_value.array.items) |vertex| {
-        if (vertex != .array or vertex.array.items.len != 3) return error.InvalidCityJSONSeqFeature;
-        const vx = try parseJsonI64(vertex.array.items[0]);
-        const vy = try parseJsonI64(vertex.array.items[1]);
-        const vz = try parseJsonI64(vertex.array.items[2]);
-        try old_vertices.append(arena_alloc, .{ vx, vy, vz });
-    }
-
-    var used_old_indices = std.AutoHashMap(usize, void).init(arena_alloc);
-    defer used_old_indices.deinit();
-
-    var object_it = city_objects_obj.iterator();
-    while (object_it.next()) |entry| {
-        if (entry.value_ptr.* != .object) continue;
-        const geoms = entry.value_ptr.object.getPtr("geometry") orelse continue;
-        if (geoms.* != .array) continue;
-        for (geoms.array.items) |*geom| {
-            if (geom == target_geometry_value) continue;
-            if (geom.* != .object) continue;
-            const boundaries = geom.object.getPtr("boundaries") orelse continue;
-            try collectBoundaryIndices(boundaries, &used_old_indices);
-        }
-    }
-
-    var old_to_new = std.AutoHashMap(usize, usize).init(arena_alloc);
-    defer old_to_new.deinit();
-    var coord_to_new = std.AutoHashMap([3]i64, usize).init(arena_alloc);
-    defer coord_to_new.deinit();
-    var new_vertices = std.ArrayList([3]i64).empty;
-    defer new_vertices.deinit(arena_alloc);
-
-    for (old_vertices.items, 0..) |coord, old_idx| {
-        if (used_old_indices.contains(old_idx)) {
-            const new_idx = new_vertices.items.len;
-            try old_to_new.put(old_idx, new_idx);
-            try new_vertices.append(arena_alloc, coord);
-            try coord_to_new.put(coord, new_idx);
-        }
-    }
-
     const input_vertex_count = vertices_xyz_world.len / 3;
     var remapped_boundary_indices = std.ArrayList(usize).empty;
-    defer remapped_boundary_indices.deinit(arena_alloc);
-    try remapped_boundary_indices.ensureTotalCapacity(arena_alloc, boundary_indices.len);
+    try remapped_boundary_indices.ensureTotalCapacity(arena, boundary_indices.len);
     for (boundary_indices) |src_idx_u32| {
         const src_idx: usize = @intCast(src_idx_u32);
         if (src_idx >= input_vertex_count) return error.InvalidReplacementGeometry;
-
-        const quantized = [3]i64{
-            try quantizeWorldCoordinate(vertices_xyz_world[src_idx * 3 + 0], reader.seq_transform.scale[0], reader.seq_transform.translate[0]),
-            try quantizeWorldCoordinate(vertices_xyz_world[src_idx * 3 + 1], reader.seq_transform.scale[1], reader.seq_transform.translate[1]),
-            try quantizeWorldCoordinate(vertices_xyz_world[src_idx * 3 + 2], reader.seq_transform.scale[2], reader.seq_transform.translate[2]),
-        };
-
-        const final_idx = if (coord_to_new.get(quantized)) |existing_idx| blk: {
-            break :blk existing_idx;
-        } else blk: {
-            const appended_idx = new_vertices.items.len;
-            try new_vertices.append(arena_alloc, quantized);
-            try coord_to_new.put(quantized, appended_idx);
-            break :blk appended_idx;
-        };
-
-        remapped_boundary_indices.appendAssumeCapacity(final_idx);
-    }
-
-    object_it = city_objects_obj.iterator();
-    while (object_it.next()) |entry| {
-        if (entry.value_ptr.* != .object) continue;
-        const geoms = entry.value_ptr.object.getPtr("geometry") orelse continue;
-        if (geoms.* != .array) continue;
-        for (geoms.array.items) |*geom| {
-            if (geom == target_geometry_value) continue;
-            if (geom.* != .object) continue;
-            const boundaries = geom.object.getPtr("boundaries") orelse continue;
-            try remapBoundaryIndices(boundaries, &old_to_new);
-        }
+        const index = try vertices.indexOf(vertices_xyz_world[src_idx * 3 .. src_idx * 3 + 3], transform);
+        remapped_boundary_indices.appendAssumeCapacity(index);
     }
 
     const no_attribute_group = std.math.maxInt(u32);
     const surface_attribute_group_count = if (surface_attribute_groups) |groups| groups.count() else 0;
-    const surface_attribute_group_areas = try arena_alloc.alloc(f64, surface_attribute_group_count);
+    const surface_attribute_group_areas = try arena.alloc(f64, surface_attribute_group_count);
     @memset(surface_attribute_group_areas, 0.0);
 
-    var shell_polygons = std.json.Array.init(arena_alloc);
     var ring_cursor: usize = 0;
     var boundary_cursor: usize = 0;
     for (surface_ring_counts, 0..) |surface_ring_count, geometry_surface_index| {
-        var polygon = std.json.Array.init(arena_alloc);
         var surface_area: f64 = 0.0;
         for (0..surface_ring_count) |surface_ring_index| {
             if (ring_cursor >= ring_vertex_counts.len) return error.InvalidReplacementGeometry;
@@ -2086,24 +2533,18 @@ fn writeReplacedCurrentFeatureLinePolygonal(
             ring_cursor += 1;
 
             const ring_boundary_start = boundary_cursor;
-            var ring = std.json.Array.init(arena_alloc);
-            try ring.ensureTotalCapacity(ring_size);
-            for (0..ring_size) |_| {
-                if (boundary_cursor >= remapped_boundary_indices.items.len) return error.InvalidReplacementGeometry;
-                ring.appendAssumeCapacity(.{ .integer = @intCast(remapped_boundary_indices.items[boundary_cursor]) });
-                boundary_cursor += 1;
-            }
+            boundary_cursor += ring_size;
+            if (boundary_cursor > remapped_boundary_indices.items.len) return error.InvalidReplacementGeometry;
             const ring_area = try quantizedRingArea3d(
-                new_vertices.items,
+                vertices.items.items,
                 remapped_boundary_indices.items[ring_boundary_start..boundary_cursor],
-                reader.seq_transform.scale,
+                transform.scale,
             );
             if (surface_ring_index == 0) {
                 surface_area += ring_area;
             } else {
                 surface_area -= ring_area;
             }
-            try polygon.append(.{ .array = ring });
         }
         const attribute_group = if (surface_semantic_types[geometry_surface_index] == SemanticOuterCeilingSurface and surface_attribute_group_indices != null)
             surface_attribute_group_indices.?[geometry_surface_index]
@@ -2115,23 +2556,19 @@ fn writeReplacedCurrentFeatureLinePolygonal(
             }
             surface_attribute_group_areas[attribute_group] += @max(surface_area, 0.0);
         }
-        try shell_polygons.append(.{ .array = polygon });
     }
     if (ring_cursor != ring_vertex_counts.len or boundary_cursor != remapped_boundary_indices.items.len) {
         return error.InvalidReplacementGeometry;
     }
-    var solid_boundaries = std.json.Array.init(arena_alloc);
-    try solid_boundaries.append(.{ .array = shell_polygons });
 
-    var surfaces = std.json.Array.init(arena_alloc);
     const SemanticSurfaceKey = struct {
         semantic_type: u8,
         attribute_group: u32,
     };
-    var semantic_to_surface = std.AutoHashMap(SemanticSurfaceKey, usize).init(arena_alloc);
-    defer semantic_to_surface.deinit();
+    var semantic_to_surface = std.AutoHashMap(SemanticSurfaceKey, usize).init(arena);
+    var semantic_surfaces = std.ArrayList(SemanticSurfaceKey).empty;
     var semantic_values = std.ArrayList(usize).empty;
-    defer semantic_values.deinit(arena_alloc);
+    try semantic_values.ensureTotalCapacity(arena, surface_semantic_types.len);
 
     for (surface_semantic_types, 0..) |semantic_type, geometry_surface_index| {
         const attribute_group = if (semantic_type == SemanticOuterCeilingSurface and surface_attribute_group_indices != null)
@@ -2146,117 +2583,151 @@ fn writeReplacedCurrentFeatureLinePolygonal(
             .semantic_type = semantic_type,
             .attribute_group = attribute_group,
         };
-        const surface_idx = if (semantic_to_surface.get(key)) |idx| blk: {
-            break :blk idx;
-        } else blk: {
-            var surface_obj: std.json.ObjectMap = .empty;
-            try surface_obj.put(arena_alloc, "type", .{ .string = semanticSurfaceTypeName(semantic_type) });
-            if (attribute_group != no_attribute_group) {
-                const groups = surface_attribute_groups orelse return error.InvalidSourceAttributeGroup;
-                if (try groups.group(attribute_group)) |attributes| {
-                    try mergeAttributesIntoObject(arena_alloc, &surface_obj, attributes);
-                }
-                try surface_obj.put(
-                    arena_alloc,
-                    "underpass_area",
-                    .{ .float = surface_attribute_group_areas[attribute_group] },
-                );
+        const entry = try semantic_to_surface.getOrPut(key);
+        if (!entry.found_existing) {
+            entry.value_ptr.* = semantic_surfaces.items.len;
+            try semantic_surfaces.append(arena, key);
+        }
+        semantic_values.appendAssumeCapacity(entry.value_ptr.*);
+    }
+
+    var out: std.Io.Writer.Allocating = .init(arena);
+    const w = &out.writer;
+    try w.writeAll("{\"type\":\"Solid\",\"lod\":\"2.2\",\"boundaries\":[[");
+    ring_cursor = 0;
+    boundary_cursor = 0;
+    for (surface_ring_counts, 0..) |surface_ring_count, surface_i| {
+        if (surface_i > 0) try w.writeByte(',');
+        try w.writeByte('[');
+        for (0..surface_ring_count) |ring_i| {
+            if (ring_i > 0) try w.writeByte(',');
+            const ring_size = ring_vertex_counts[ring_cursor];
+            ring_cursor += 1;
+            try w.writeByte('[');
+            for (remapped_boundary_indices.items[boundary_cursor .. boundary_cursor + ring_size], 0..) |vertex_index, vertex_i| {
+                if (vertex_i > 0) try w.writeByte(',');
+                try w.print("{d}", .{vertex_index});
             }
-            const idx = surfaces.items.len;
-            try surfaces.append(.{ .object = surface_obj });
-            try semantic_to_surface.put(key, idx);
-            break :blk idx;
-        };
-        try semantic_values.append(arena_alloc, surface_idx);
-    }
-
-    var shell_values = std.json.Array.init(arena_alloc);
-    for (semantic_values.items) |semantic_idx| {
-        try shell_values.append(.{ .integer = @intCast(semantic_idx) });
+            boundary_cursor += ring_size;
+            try w.writeByte(']');
+        }
+        try w.writeByte(']');
+    }
+    try w.writeAll("]],\"semantics\":{\"surfaces\":[");
+    for (semantic_surfaces.items, 0..) |surface, surface_i| {
+        if (surface_i > 0) try w.writeByte(',');
+        try w.writeAll("{\"type\":");
+        try std.json.Stringify.value(semanticSurfaceTypeName(surface.semantic_type), .{}, w);
+        if (surface.attribute_group != no_attribute_group) {
+            var seen = std.StringHashMap(void).init(arena);
+            try seen.put("type", {});
+            try seen.put("underpass_area", {});
+            var first = false;
+            if (try surface_attribute_groups.?.group(surface.attribute_group)) |attributes| {
+                try writeNewJsonMembers(w, &seen, attributes, &first);
+            }
+            try w.writeAll(",\"underpass_area\":");
+            try std.json.Stringify.value(surface_attribute_group_areas[surface.attribute_group], .{}, w);
+        }
+        try w.writeByte('}');
     }
-    var values_outer = std.json.Array.init(arena_alloc);
-    try values_outer.append(.{ .array = shell_values });
-
-    var semantics_obj: std.json.ObjectMap = .empty;
-    try semantics_obj.put(arena_alloc, "surfaces", .{ .array = surfaces });
-    try semantics_obj.put(arena_alloc, "values", .{ .array = values_outer });
-
-    if (target_geometry_value.* != .object) return error.TargetGeometryNotFound;
-    try target_geometry_value.object.put(arena_alloc, "type", .{ .string = "Solid" });
-    try target_geometry_value.object.put(arena_alloc, "lod", .{ .string = "2.2" });
-    try target_geometry_value.object.put(arena_alloc, "boundaries", .{ .array = solid_boundaries });
-    try target_geometry_value.object.put(arena_alloc, "semantics", .{ .object = semantics_obj });
-
-    var vertices_array = std.json.Array.init(arena_alloc);
-    try vertices_array.ensureTotalCapacity(new_vertices.items.len);
-    for (new_vertices.items) |coord| {
-        var vertex_triplet = std.json.Array.init(arena_alloc);
-        try vertex_triplet.append(.{ .integer = coord[0] });
-        try vertex_triplet.append(.{ .integer = coord[1] });
-        try vertex_triplet.append(.{ .integer = coord[2] });
-        vertices_array.appendAssumeCapacity(.{ .array = vertex_triplet });
+    try w.writeAll("],\"values\":[[");
+    for (semantic_values.items, 0..) |semantic_index, value_i| {
+        if (value_i > 0) try w.writeByte(',');
+        try w.print("{d}", .{semantic_index});
     }
-    vertices_value.* = .{ .array = vertices_array };
-
-    // Serialize the replaced feature to an in-memory line, then append through
-    // writeLine() so we preserve output stream ordering.
-    var out: std.Io.Writer.Allocating = .init(reader.allocator);
-    defer out.deinit();
-    try std.json.Stringify.value(parsed.value, .{ .whitespace = .minified }, &out.writer);
-    try writer.writeLine(out.written());
+    try w.writeAll("]]}");
+    try writeRetainedGeometryMembers(w, arena, retained_geometry_bytes);
+    try w.writeByte('}');
+    return out.written();
 }
 
-fn mergeSourceAttributes(
-    arena_alloc: std.mem.Allocator,
-    city_objects_obj: *std.json.ObjectMap,
-    target_object_value: *std.json.Value,
+/// Replaces the target object's LoD 2.2 solid by splicing into the current
+/// line. Only three regions change: the replaced geometry object, the tail
+/// of "vertices" (new vertices are appended, existing ones keep their
+/// indices) and the destination "attributes". All other CityObjects and
+/// geometries are copied verbatim, so no boundary renumbering is needed.
+/// Vertices that only the replaced geometry used stay in the vertex list.
+fn writeReplacedCurrentFeatureLinePolygonal(
+    reader: *CityJSONSeqReader,
+    writer: *CityJSONSeqWriter,
     feature_id: []const u8,
+    vertices_xyz_world: []const f64,
+    surface_ring_counts: []const u32,
+    ring_vertex_counts: []const u32,
+    boundary_indices: []const u32,
+    surface_semantic_types: []const u8,
     source_attributes: ?SourceAttributes,
     source_attribute_target: u8,
+    surface_attribute_group_indices: ?[]const u32,
+    surface_attribute_groups: ?SourceAttributeGroups,
 ) !void {
-    const attrs = source_attributes orelse return;
-    if (attrs.count == 0) return;
-
-    var destination_object = target_object_value;
-    if (source_attribute_target == 2) {
-        if (city_objects_obj.getPtr(feature_id)) |parent_object| {
-            destination_object = parent_object;
-        } else if (target_object_value.object.get("parents")) |parents_value| {
-            if (parents_value == .array and parents_value.array.items.len > 0) {
-                const first_parent = parents_value.array.items[0];
-                if (first_parent == .string) {
-                    destination_object = city_objects_obj.getPtr(first_parent.string) orelse target_object_value;
-                }
+    const line = reader.current_line;
+    if (line.len == 0) return error.InvalidCityJSONSeqFeature;
+    _ = reader.parse_arena.reset(.retain_capacity);
+    const arena_alloc = reader.parse_arena.allocator();
+
+    const layout = try scanFeatureLayout(arena_alloc, line, true);
+    const target_object = try layout.target(arena_alloc, feature_id);
+    const target_geometry = target_object.lod22_solid orelse return error.TargetGeometryNotFound;
+
+    var attribute_destination: ?*const CJSeqObjectLayout = null;
+    var attributes_to_add: ?SourceAttributes = null;
+    if (source_attribute_target != 0) {
+        if (source_attributes) |attrs| {
+            if (attrs.count > 0) {
+                attribute_destination = try layout.attributeDestination(target_object, feature_id, source_attribute_target);
+                attributes_to_add = attrs;
             }
         }
-    } else if (source_attribute_target != 1) {
-        return error.InvalidSourceAttributeTarget;
     }
 
-    if (destination_object.* != .object) return error.TargetObjectNotFound;
+    var vertices = try SpliceVertices.init(arena_alloc, layout.vertex_values);
+    const geometry_bytes = try renderReplacedSolidGeometry(
+        arena_alloc,
+        &vertices,
+        reader.seq_transform,
+        vertices_xyz_world,
+        surface_ring_counts,
+        ring_vertex_counts,
+        boundary_indices,
+        surface_semantic_types,
+        surface_attribute_group_indices,
+        surface_attribute_groups,
+        target_geometry.bytes(line),
+    );
 
-    var attributes_value = destination_object.object.getPtr("attributes");
-    if (attributes_value == null) {
-        const new_attributes: std.json.ObjectMap = .empty;
-        try destination_object.object.put(arena_alloc, "attributes", .{ .object = new_attributes });
-        attributes_value = destination_object.object.getPtr("attributes");
+    var edits: [3]CJSeqLineEdit = undefined;
+    var edit_count: usize = 0;
+    edits[edit_count] = .{ .span = target_geometry, .kind = .geometry };
+    edit_count += 1;
+    if (vertices.appended()) {
+        const at = layout.vertices.closing();
+        edits[edit_count] = .{ .span = .{ .start = at, .end = at }, .kind = .vertices };
+        edit_count += 1;
     }
-    var attributes = attributes_value orelse return error.InvalidCityJSONSeqFeature;
-    if (attributes.* != .object) return error.InvalidCityJSONSeqFeature;
-
-    try mergeAttributesIntoObject(arena_alloc, &attributes.object, attrs);
-}
+    if (attribute_destination) |destination| {
+        const at = attributeSpliceOffset(destination);
+        edits[edit_count] = .{ .span = .{ .start = at, .end = at }, .kind = .attributes };
+        edit_count += 1;
+    }
+    std.mem.sort(CJSeqLineEdit, edits[0..edit_count], {}, CJSeqLineEdit.lessThan);
 
-fn mergeAttributesIntoObject(
-    arena_alloc: std.mem.Allocator,
-    object: *std.json.ObjectMap,
-    attrs: SourceAttributes,
-) !void {
-    for (0..attrs.count) |i| {
-        const name = attrs.name(i) orelse continue;
-        if (name.len == 0 or object.contains(name)) continue;
-        try object.put(arena_alloc, name, try attrs.jsonValue(i));
+    var out: std.Io.Writer.Allocating = .init(arena_alloc);
+    defer out.deinit();
+    const w = &out.writer;
+    var copied: usize = 0;
+    for (edits[0..edit_count]) |edit| {
+        try w.writeAll(line[copied..edit.span.start]);
+        switch (edit.kind) {
+            .attributes => try writeAttributeSplice(w, arena_alloc, line, attribute_destination.?, attributes_to_add.?),
+            .vertices => try vertices.writeAppended(w),
+            .geometry => try w.writeAll(geometry_bytes),
+        }
+        copied = edit.span.end;
     }
+    try w.writeAll(line[copied..]);
+    try writer.writeLine(out.written());
 }
 
 fn writeReplacedCurrentFeatureLine(
@@ -2623,6 +3094,629 @@ export fn cityjsonseq_writer_write_current_replaced_lod22_polygonal_with_semanti
     return 0;
 }
 
+// =============================================================================
+// CityJSON tile API
+// =============================================================================
+
+/// A whole CityJSON file held in memory as its original bytes. Replaced
+/// LoD 2.2 solids and merged attributes are recorded as splices into those
+/// bytes, the way the CityJSONSeq writers rewrite a feature line, and save()
+/// applies all of them in one pass: everything else, including metadata,
+/// attributes and other LoDs, is written back byte for byte, and new
+/// vertices are appended to the shared "vertices" array.
+const CityJSONTile = struct {
+    const Splice = struct {
+        span: ByteSpan,
+        bytes: []const u8,
+
+        fn lessThan(_: void, a: Splice, b: Splice) bool {
+            return a.span.start < b.span.start;
+        }
+    };
+
+    allocator: std.mem.Allocator,
+    bytes: []u8,
+    // Layout, splices and the vertex index; freed on deinit.
+    arena: std.heap.ArenaAllocator,
+    // Reset after every recorded splice.
+    scratch: std.heap.ArenaAllocator,
+    layout: CJSeqFeatureLayout,
+    transform: CJTransform,
+    extent: ?[6]f64,
+    // Every CityObject, with geometry decoded for LoD 2.2 Solids only.
+    // Recording splices never modifies it.
+    cj: CityJSON,
+    // Built by the first replacement.
+    vertices: ?SpliceVertices,
+    splices: std.ArrayList(Splice),
+    // Features with a recorded splice; each is rewritten at most once.
+    edited: std.StringHashMapUnmanaged(void),
+
+    fn init(allocator: std.mem.Allocator, path: []const u8) !*CityJSONTile {
+        const tile = try allocator.create(CityJSONTile);
+        errdefer allocator.destroy(tile);
+        const bytes = try readFileBytes(allocator, path);
+        errdefer allocator.free(bytes);
+        tile.* = .{
+            .allocator = allocator,
+            .bytes = bytes,
+            .arena = std.heap.ArenaAllocator.init(allocator),
+            .scratch = std.heap.ArenaAllocator.init(allocator),
+            .layout = undefined,
+            .transform = undefined,
+            .extent = null,
+            .cj = try CityJSON.init(allocator),
+            .vertices = null,
+            .splices = .empty,
+            .edited = .empty,
+        };
+        errdefer {
+            tile.cj.deinit();
+            tile.arena.deinit();
+            tile.scratch.deinit();
+        }
+
+        tile.layout = try scanFeatureLayout(tile.arena.allocator(), tile.json(), true);
+        try tile.decode(tile.json());
+        return tile;
+    }
+
+    fn deinit(self: *CityJSONTile) void {
+        const allocator = self.allocator;
+        self.cj.deinit();
+        self.arena.deinit();
+        self.scratch.deinit();
+        allocator.free(self.bytes);
+        allocator.destroy(self);
+    }
+
+    fn readFileBytes(allocator: std.mem.Allocator, path: []const u8) ![]u8 {
+        const file = try openFileRead(path);
+        defer closeFile(file);
+
+        var contents: std.ArrayList(u8) = .empty;
+        errdefer contents.deinit(allocator);
+        var read_chunk: [64 * 1024]u8 = undefined;
+        while (true) {
+            const bytes_read = try std.posix.read(file.handle, &read_chunk);
+            if (bytes_read == 0) break;
+            try contents.appendSlice(allocator, read_chunk[0..bytes_read]);
+        }
+        return contents.toOwnedSlice(allocator);
+    }
+
+    /// The document without a leading UTF-8 BOM, which is dropped from the
+    /// output as well.
+    fn json(self: *const CityJSONTile) []const u8 {
+        return if (std.mem.startsWith(u8, self.bytes, "\xEF\xBB\xBF")) self.bytes[3..] else self.bytes;
+    }
+
+    /// Reads the transform and extent and decodes the LoD 2.2 Solids of
+    /// every CityObject into `cj`, using the vertices scanFeatureLayout
+    /// already decoded.
+    fn decode(self: *CityJSONTile, json_bytes: []const u8) !void {
+        var decode_arena = std.heap.ArenaAllocator.init(self.allocator);
+        defer decode_arena.deinit();
+        const arena = decode_arena.allocator();
+        const options: std.json.ParseOptions = .{
+            .max_value_len = json_bytes.len,
+            .allocate = .alloc_if_needed,
+            .ignore_unknown_fields = true,
+        };
+
+        var scanner = std.json.Scanner.initCompleteInput(arena, json_bytes);
+        defer scanner.deinit();
+
+        var selected: std.ArrayList(SelectedGeometry) = .empty;
+        var is_cityjson = false;
+        var transform: ?CJTransform = null;
+        try expectJsonToken(&scanner, .object_begin);
+        while (try nextJsonObjectKey(&scanner, arena)) |key| {
+            if (std.mem.eql(u8, key, "type")) {
+                is_cityjson = std.mem.eql(u8, try nextJsonString(&scanner, arena), "CityJSON");
+            } else if (std.mem.eql(u8, key, "transform")) {
+                transform = try std.json.innerParse(CJTransform, arena, &scanner, options);
+            } else if (std.mem.eql(u8, key, "metadata")) {
+                const metadata = try std.json.innerParse(CJSeqHeaderMetadata, arena, &scanner, options);
+                self.extent = metadata.geographicalExtent;
+            } else if (std.mem.eql(u8, key, "CityObjects")) {
+                try decodeCityObjects(&self.cj, &scanner, arena, options, null, &selected);
+            } else {
+                try scanner.skipValue();
+            }
+        }
+        try expectJsonToken(&scanner, .end_of_document);
+        if (!is_cityjson) return error.InvalidCityJSONTile;
+        self.transform = transform orelse return error.InvalidCityJSONTile;
+
+        for (selected.items) |entry| {
+            const geometry_index = try self.cj.addGeometry(entry.object_index, .Solid, entry.geometry.lod);
+            const geom = try self.cj.getGeometry(entry.object_index, geometry_index);
+            try self.cj.ingestGeometry(geom, entry.geometry, self.layout.vertex_values, self.transform);
+        }
+    }
+
+    /// The attribute splice for a feature, or null when there is nothing
+    /// to merge.
+    fn attributeSplice(
+        self: *CityJSONTile,
+        scratch: std.mem.Allocator,
+        target_object: *const CJSeqObjectLayout,
+        feature_id: []const u8,
+        source_attributes: ?SourceAttributes,
+        source_attribute_target: u8,
+    ) !?Splice {
+        if (source_attribute_target == 0) return null;
+        const attrs = source_attributes orelse return null;
+        if (attrs.count == 0) return null;
+        const destination = try self.layout.attributeDestination(target_object, feature_id, source_attribute_target);
+        var out: std.Io.Writer.Allocating = .init(scratch);
+        try writeAttributeSplice(&out.writer, scratch, self.json(), destination, attrs);
+        const at = attributeSpliceOffset(destination);
+        return .{
+            .span = .{ .start = at, .end = at },
+            .bytes = try self.arena.allocator().dupe(u8, out.written()),
+        };
+    }
+
+    /// Records the replacement of the feature's LoD 2.2 solid, on its
+    /// "<id>-0" part when present, and the attributes to merge.
+    fn replaceLod22Polygonal(
+        self: *CityJSONTile,
+        feature_id: []const u8,
+        vertices_xyz_world: []const f64,
+        surface_ring_counts: []const u32,
+        ring_vertex_counts: []const u32,
+        boundary_indices: []const u32,
+        surface_semantic_types: []const u8,
+        source_attributes: ?SourceAttributes,
+        source_attribute_target: u8,
+    ) !void {
+        defer _ = self.scratch.reset(.retain_capacity);
+        const scratch = self.scratch.allocator();
+        const arena = self.arena.allocator();
+        if (self.edited.contains(feature_id)) return error.FeatureAlreadyEdited;
+
+        const json_bytes = self.json();
+        const target_object = try self.layout.target(scratch, feature_id);
+        const target_geometry = target_object.lod22_solid orelse return error.TargetGeometryNotFound;
+        if (self.vertices == null) {
+            self.vertices = try SpliceVertices.init(arena, self.layout.vertex_values);
+        }
+        const vertices = &self.vertices.?;
+        // A rejected replacement leaves no vertices behind.
+        const vertex_count = vertices.items.items.len;
+        errdefer vertices.truncate(vertex_count);
+
+        const geometry_bytes = try renderReplacedSolidGeometry(
+            scratch,
+            vertices,
+            self.transform,
+            vertices_xyz_world,
+            surface_ring_counts,
+            ring_vertex_counts,
+            boundary_indices,
+            surface_semantic_types,
+            null,
+            null,
+            target_geometry.bytes(json_bytes),
+        );
+        const attribute_splice = try self.attributeSplice(
+            scratch,
+            target_object,
+            feature_id,
+            source_attributes,
+            source_attribute_target,
+        );
+
+        const geometry_splice: Splice = .{ .span = target_geometry, .bytes = try arena.dupe(u8, geometry_bytes) };
+        try self.splices.ensureUnusedCapacity(arena, 2);
+        try self.edited.put(arena, try arena.dupe(u8, feature_id), {});
+        self.splices.appendAssumeCapacity(geometry_splice);
+        if (attribute_splice) |splice| self.splices.appendAssumeCapacity(splice);
+    }
+
+    /// Records attributes to merge into a feature whose geometry stays.
+    fn mergeAttributes(
+        self: *CityJSONTile,
+        feature_id: []const u8,
+        source_attributes: ?SourceAttributes,
+        source_attribute_target: u8,
+    ) !void {
+        defer _ = self.scratch.reset(.retain_capacity);
+        const scratch = self.scratch.allocator();
+        const arena = self.arena.allocator();
+        if (self.edited.contains(feature_id)) return error.FeatureAlreadyEdited;
+
+        const target_object = try self.layout.target(scratch, feature_id);
+        const splice = try self.attributeSplice(
+            scratch,
+            target_object,
+            feature_id,
+            source_attributes,
+            source_attribute_target,
+        ) orelse return;
+        try self.splices.ensureUnusedCapacity(arena, 1);
+        try self.edited.put(arena, try arena.dupe(u8, feature_id), {});
+        self.splices.appendAssumeCapacity(splice);
+    }
+
+    /// Writes the tile with every recorded splice applied.
+    fn save(self: *CityJSONTile, path: []const u8) !void {
+        defer _ = self.scratch.reset(.retain_capacity);
+        const scratch = self.scratch.allocator();
+        const json_bytes = self.json();
+
+        var splices: std.ArrayList(Splice) = .empty;
+        try splices.appendSlice(scratch, self.splices.items);
+        if (self.vertices) |vertices| {
+            if (vertices.appended()) {
+                var out: std.Io.Writer.Allocating = .init(scratch);
+                try vertices.writeAppended(&out.writer);
+                const at = self.layout.vertices.closing();
+                try splices.append(scratch, .{ .span = .{ .start = at, .end = at }, .bytes = out.written() });
+            }
+        }
+        std.mem.sort(Splice, splices.items, {}, Splice.lessThan);
+
+        const file = try createFileTruncate(path);
+        defer closeFile(file);
+        var write_buf: [64 * 1024]u8 = undefined;
+        var f_writer = file.writer(default_io, &write_buf);
+        const w = &f_writer.interface;
+        var copied: usize = 0;
+        for (splices.items) |splice| {
+            try w.writeAll(json_bytes[copied..splice.span.start]);
+            try w.writeAll(splice.bytes);
+            copied = splice.span.end;
+        }
+        try w.writeAll(json_bytes[copied..]);
+        try w.flush();
+    }
+};
+
+pub const CityJSONTileHandle = *CityJSONTile;
+
+export fn cityjson_tile_open(path: [*c]const u8) callconv(.c) ?CityJSONTileHandle {
+    if (path == null) return null;
+    const path_slice = std.mem.span(path);
+    return CityJSONTile.init(c_allocator, path_slice) catch |err| {
+        std.debug.print("Error opening CityJSON tile: {}\n", .{err});
+        return null;
+    };
+}
+
+export fn cityjson_tile_destroy(handle: ?CityJSONTileHandle) callconv(.c) void {
+    if (handle) |tile| {
+        tile.deinit();
+    }
+}
+
+export fn cityjson_tile_cityjson(handle: ?CityJSONTileHandle) callconv(.c) ?CityJSONHandle {
+    const tile = handle orelse return null;
+    return &tile.cj;
+}
+
+export fn cityjson_tile_geographical_extent(
+    handle: ?CityJSONTileHandle,
+    out_min_xyz: [*c]f64,
+    out_max_xyz: [*c]f64,
+) callconv(.c) c_int {
+    const tile = handle orelse return -1;
+    if (out_min_xyz == null or out_max_xyz == null) return -1;
+    const extent = tile.extent orelse return 0;
+    out_min_xyz[0] = extent[0];
+    out_min_xyz[1] = extent[1];
+    out_min_xyz[2] = extent[2];
+    out_max_xyz[0] = extent[3];
+    out_max_xyz[1] = extent[4];
+    out_max_xyz[2] = extent[5];
+    return 1;
+}
+
+export fn cityjson_tile_transform(
+    handle: ?CityJSONTileHandle,
+    out_scale_xyz: [*c]f64,
+    out_translate_xyz: [*c]f64,
+) callconv(.c) c_int {
+    const tile = handle orelse return -1;
+    if (out_scale_xyz == null or out_translate_xyz == null) return -1;
+    for (0..3) |axis| {
+        out_scale_xyz[axis] = tile.transform.scale[axis];
+        out_translate_xyz[axis] = tile.transform.translate[axis];
+    }
+    return 1;
+}
+
+export fn cityjson_tile_merge_attributes(
+    handle: ?CityJSONTileHandle,
+    feature_id_ptr: [*c]const u8,
+    feature_id_len: usize,
+    source_attribute_names: [*c]const [*c]const u8,
+    source_attribute_name_lens: [*c]const usize,
+    source_attribute_types: [*c]const u8,
+    source_attribute_integer_values: [*c]const i64,
+    source_attribute_real_values: [*c]const f64,
+    source_attribute_string_values: [*c]const [*c]const u8,
+    source_attribute_string_value_lens: [*c]const usize,
+    source_attribute_count: usize,
+    source_attribute_target: u8,
+) callconv(.c) c_int {
+    const tile = handle orelse return -1;
+    if (feature_id_ptr == null or feature_id_len == 0) return -1;
+
+    const source_attributes = sourceAttributesFromC(
+        source_attribute_names,
+        source_attribute_name_lens,
+        source_attribute_types,
+        source_attribute_integer_values,
+        source_attribute_real_values,
+        source_attribute_string_values,
+        source_attribute_string_value_lens,
+        source_attribute_count,
+    );
+    if (source_attribute_target != 0 and source_attribute_count != 0 and source_attributes == null) return -1;
+
+    tile.mergeAttributes(
+        feature_id_ptr[0..feature_id_len],
+        source_attributes,
+        source_attribute_target,
+    ) catch return -1;
+    return 0;
+}
+
+export fn cityjson_tile_replace_lod22_polygonal(
+    handle: ?CityJSONTileHandle,
+    feature_id_ptr: [*c]const u8,
+    feature_id_len: usize,
+    vertices_xyz_world_ptr: [*c]const f64,
+    vertex_count: usize,
+    surface_ring_counts_ptr: [*c]const u32,
+    surface_count: usize,
+    ring_vertex_counts_ptr: [*c]const u32,
+    ring_count: usize,
+    boundary_indices_ptr: [*c]const u32,
+    boundary_index_count: usize,
+    surface_semantic_types_ptr: [*c]const u8,
+    surface_semantic_types_count: usize,
+    source_attribute_names: [*c]const [*c]const u8,
+    source_attribute_name_lens: [*c]const usize,
+    source_attribute_types: [*c]const u8,
+    source_attribute_integer_values: [*c]const i64,
+    source_attribute_real_values: [*c]const f64,
+    source_attribute_string_values: [*c]const [*c]const u8,
+    source_attribute_string_value_lens: [*c]const usize,
+    source_attribute_count: usize,
+    source_attribute_target: u8,
+) callconv(.c) c_int {
+    const tile = handle orelse return -1;
+    if (feature_id_ptr == null or feature_id_len == 0) return -1;
+    if (vertices_xyz_world_ptr == null or vertex_count == 0) return -1;
+    if (surface_ring_counts_ptr == null or surface_count == 0) return -1;
+    if (ring_vertex_counts_ptr == null or ring_count == 0) return -1;
+    if (boundary_indices_ptr == null or boundary_index_count == 0) return -1;
+    if (surface_semantic_types_ptr == null or surface_semantic_types_count != surface_count) return -1;
+
+    const source_attributes = sourceAttributesFromC(
+        source_attribute_names,
+        source_attribute_name_lens,
+        source_attribute_types,
+        source_attribute_integer_values,
+        source_attribute_real_values,
+        source_attribute_string_values,
+        source_attribute_string_value_lens,
+        source_attribute_count,
+    );
+    if (source_attribute_target != 0 and source_attribute_count != 0 and source_attributes == null) return -1;
+
+    tile.replaceLod22Polygonal(
+        feature_id_ptr[0..feature_id_len],
+        vertices_xyz_world_ptr[0 .. vertex_count * 3],
+        surface_ring_counts_ptr[0..surface_count],
+        ring_vertex_counts_ptr[0..ring_count],
+        boundary_indices_ptr[0..boundary_index_count],
+        surface_semantic_types_ptr[0..surface_semantic_types_count],
+        source_attributes,
+        source_attribute_target,
+    ) catch return -1;
+    return 0;
+}
+
+export fn cityjson_tile_save(handle: ?CityJSONTileHandle, path: [*c]const u8) callconv(.c) c_int {
+    const tile = handle orelse return -1;
+    if (path == null) return -1;
+    tile.save(std.mem.span(path)) catch |err| {
+        std.debug.print("Error saving CityJSON tile: {}\n", .{err});
+        return -1;
+    };
+    return 0;
+}
+
+test {
+    _ = compression;
+}
+
+test "CityJSONSeq reader passes lines through and decodes only LoD 2.2 solids" {
+    const allocator = std.testing.allocator;
+    const input_path = "/tmp/zityjson_selective_reader_input.city.jsonl";
+    const output_path = "/tmp/zityjson_selective_reader_output.city.jsonl";
+    const header = "{\"type\":\"CityJSON\",\"version\":\"2.0\",\"transform\":{\"scale\":[1,1,1],\"translate\":[0,0,0]},\"CityObjects\":{},\"vertices\":[]}";
+    const passthrough = "{\"CityObjects\":{\"A\":{\"type\":\"Building\",\"geometry\":[]}},\"vertices\":[],\"id\":\"A\",\"type\":\"CityJSONFeature\"}";
+    const decoded =
+        \\{"type":"CityJSONFeature","id":"B","CityObjects":{"B":{"type":"Building","children":["B-0"],"geometry":[{"type":"MultiSurface","lod":"0","boundaries":[[[0,1,2]]]}]},"B-0":{"type":"BuildingPart","parents":["B"],"geometry":[{"boundaries":[[[[0,1,2]]]],"type":"Solid","lod":"1.2"},{"type":"Solid","lod":"2.2","boundaries":[[[[0,1,2]],[[0,2,3]]]],"semantics":{"surfaces":[{"type":"RoofSurface"}],"values":[[0,null]]}}]}},"vertices":[[0,0,0],[1,0,0],[0,1,0],[1,1,0]]}
+    ;
+    const input_file = try createFileTruncate(input_path);
+    try writeAll(input_file, header ++ "\n\n" ++ passthrough ++ "\r\n" ++ decoded ++ "\n");
+    closeFile(input_file);
+
+    const reader = try CityJSONSeqReader.init(allocator, input_path);
+    defer reader.deinit();
+    const writer = try CityJSONSeqWriter.init(allocator, reader, output_path);
+
+    var id_ptr: [*c]const u8 = null;
+    var id_len: usize = 0;
+    try std.testing.expectEqual(@as(c_int, 1), cityjsonseq_peek_next_id(reader, &id_ptr, &id_len));
+    try std.testing.expectEqualStrings("A", id_ptr[0..id_len]);
+    try std.testing.expectEqual(@as(c_int, 1), cityjsonseq_writer_write_pending_raw(reader, writer));
+
+    try std.testing.expectEqual(@as(c_int, 1), cityjsonseq_next(reader));
+    try std.testing.expectEqual(@as(c_int, 0), cityjsonseq_next(reader));
+    try writer.deinit();
+
+    const reread = try CityJSONSeqReader.init(allocator, output_path);
+    defer reread.deinit();
+    try std.testing.expectEqual(@as(c_int, 1), cityjsonseq_peek_next_id(reread, &id_ptr, &id_len));
+    try std.testing.expectEqualStrings(passthrough, reread.pending_line);
+
+    const second = try CityJSONSeqReader.init(allocator, input_path);
+    defer second.deinit();
+    try std.testing.expectEqual(@as(c_int, 1), cityjsonseq_next(second));
+    try std.testing.expectEqual(@as(c_int, 1), cityjsonseq_next(second));
+    const cj = cityjsonseq_current_cityjson(second) orelse return error.MissingFeature;
+    try std.testing.expectEqual(@as(usize, 2), cj.objects.count());
+    const building = cj.objects.get("B").?;
+    try std.testing.expectEqual(@as(usize, 0), building.geometries.len);
+    const part = cj.objects.get("B-0").?;
+    try std.testing.expectEqual(@as(usize, 1), part.geometries.len);
+    try std.testing.expectEqualStrings("2.2", part.geometries[0].lod);
+    try std.testing.expectEqualSlices(usize, &.{ 1, 1 }, part.geometries[0].surfaces.items);
+    try std.testing.expectEqualSlices(u8, &.{ SemanticRoofSurface, SemanticWallSurface }, part.geometries[0].surface_semantic_types.items);
+}
+
+test "CityJSONSeq replaced writer splices into the original line" {
+    const allocator = std.testing.allocator;
+    const input_path = "/tmp/zityjson_splice_input.city.jsonl";
+    const output_path = "/tmp/zityjson_splice_output.city.jsonl";
+    const header = "{\"type\":\"CityJSON\",\"version\":\"2.0\",\"transform\":{\"scale\":[1,1,1],\"translate\":[0,0,0]},\"CityObjects\":{},\"vertices\":[]}";
+    const building = "{ \"type\": \"Building\", \"children\": [\"B-0\"], \"attributes\": {\"b3_h_max\": 10.50}, \"geometry\": [{\"type\":\"MultiSurface\",\"lod\":\"0\",\"boundaries\":[[[0, 1, 2]]]}] }";
+    const feature = "{\"type\":\"CityJSONFeature\",\"id\":\"B\",\"CityObjects\":{\"B\":" ++ building ++
+        ",\"B-0\":{\"type\":\"BuildingPart\",\"parents\":[\"B\"],\"geometry\":[{\"type\":\"Solid\",\"lod\":\"1.2\",\"boundaries\":[[[[0,1,2]]]]},{\"type\":\"Solid\",\"lod\":\"2.2\",\"boundaries\":[[[[0,1,3]]]],\"material\":{\"m\":{\"value\":0}}}]}},\"vertices\":[[0,0,0],[1,0,0],[0,1,0],[1,1,0]]}";
+    const input_file = try createFileTruncate(input_path);
+    try writeAll(input_file, header ++ "\n" ++ feature ++ "\n");
+    closeFile(input_file);
+
+    const reader = try CityJSONSeqReader.init(allocator, input_path);
+    defer reader.deinit();
+    try std.testing.expectEqual(@as(c_int, 1), cityjsonseq_next(reader));
+    const writer = try CityJSONSeqWriter.init(allocator, reader, output_path);
+
+    const vertices = [_]f64{ 0, 0, 0, 1, 0, 0, 0, 0, 5 };
+    const surface_ring_counts = [_]u32{1};
+    const ring_vertex_counts = [_]u32{3};
+    const boundary_indices = [_]u32{ 0, 1, 2 };
+    const semantic_types = [_]u8{SemanticRoofSurface};
+    const attribute_names = [_][*c]const u8{ "b3_h_max", "underpass" };
+    const attribute_name_lens = [_]usize{ 8, 9 };
+    const attribute_types = [_]u8{ SOURCE_ATTRIBUTE_REAL, SOURCE_ATTRIBUTE_INTEGER };
+    const attribute_integer_values = [_]i64{ 0, 1 };
+    const attribute_real_values = [_]f64{ 99.0, 0 };
+    const attribute_string_values = [_][*c]const u8{ "", "" };
+    const attribute_string_value_lens = [_]usize{ 0, 0 };
+    const attributes = SourceAttributes{
+        .names = &attribute_names,
+        .name_lens = &attribute_name_lens,
+        .types = &attribute_types,
+        .integer_values = &attribute_integer_values,
+        .real_values = &attribute_real_values,
+        .string_values = &attribute_string_values,
+        .string_value_lens = &attribute_string_value_lens,
+        .count = 2,
+    };
+
+    try writeReplacedCurrentFeatureLinePolygonal(
+        reader,
+        writer,
+        "B",
+        &vertices,
+        &surface_ring_counts,
+        &ring_vertex_counts,
+        &boundary_indices,
+        &semantic_types,
+        attributes,
+        2,
+        null,
+        null,
+    );
+    try writer.deinit();
+
+    const output_reader = try CityJSONSeqReader.init(allocator, output_path);
+    defer output_reader.deinit();
+    var feature_id: [*c]const u8 = null;
+    var feature_id_len: usize = 0;
+    try std.testing.expectEqual(@as(c_int, 1), cityjsonseq_peek_next_id(output_reader, &feature_id, &feature_id_len));
+    const expected_building = "{ \"type\": \"Building\", \"children\": [\"B-0\"], \"attributes\": {\"b3_h_max\": 10.50,\"underpass\":1}, \"geometry\": [{\"type\":\"MultiSurface\",\"lod\":\"0\",\"boundaries\":[[[0, 1, 2]]]}] }";
+    const expected = "{\"type\":\"CityJSONFeature\",\"id\":\"B\",\"CityObjects\":{\"B\":" ++ expected_building ++
+        ",\"B-0\":{\"type\":\"BuildingPart\",\"parents\":[\"B\"],\"geometry\":[{\"type\":\"Solid\",\"lod\":\"1.2\",\"boundaries\":[[[[0,1,2]]]]}," ++
+        "{\"type\":\"Solid\",\"lod\":\"2.2\",\"boundaries\":[[[[0,1,4]]]],\"semantics\":{\"surfaces\":[{\"type\":\"RoofSurface\"}],\"values\":[[0]]},\"material\":{\"m\":{\"value\":0}}}]}}," ++
+        "\"vertices\":[[0,0,0],[1,0,0],[0,1,0],[1,1,0],[0,0,5]]}";
+    try std.testing.expectEqualStrings(expected, output_reader.pending_line);
+}
+
+test "CityJSON tile splices replacements and saves once" {
+    const allocator = std.testing.allocator;
+    const input_path = "/tmp/zityjson_tile_input.city.json";
+    const output_path = "/tmp/zityjson_tile_output.city.json";
+    const head = "{\"type\":\"CityJSON\",\"version\":\"2.0\",\"transform\":{\"scale\":[1,1,1],\"translate\":[0,0,0]},\"metadata\":{\"geographicalExtent\":[0,0,0,1,1,0],\"title\":\"t\"},\"CityObjects\":{";
+    const building_a = "\"A\":{\"type\":\"Building\",\"geometry\":[{\"type\":\"Solid\",\"lod\":\"2.2\",\"boundaries\":[[[[0,1,2]]]]}]}";
+    const building_b = "\"B\":{\"type\":\"Building\",\"attributes\":{\"h\":1},\"geometry\":[{\"type\":\"Solid\",\"lod\":\"2.2\",\"boundaries\":[[[[0,1,3]]]]}]}";
+    const input = head ++ building_a ++ "," ++ building_b ++ "},\"vertices\":[[0,0,0],[1,0,0],[0,1,0],[1,1,0]]}";
+    const input_file = try createFileTruncate(input_path);
+    try writeAll(input_file, input);
+    closeFile(input_file);
+
+    const tile = try CityJSONTile.init(allocator, input_path);
+    defer tile.deinit();
+    try std.testing.expectEqual(@as(usize, 2), tile.cj.objects.count());
+    try std.testing.expectEqual(@as(usize, 1), (try tile.cj.getGeometry(1, 0)).surfaces.items.len);
+    try std.testing.expectEqual(@as(f64, 1), tile.extent.?[3]);
+
+    const vertices = [_]f64{ 0, 0, 0, 1, 0, 0, 0, 0, 5 };
+    const surface_ring_counts = [_]u32{1};
+    const ring_vertex_counts = [_]u32{3};
+    const boundary_indices = [_]u32{ 0, 1, 2 };
+    const semantic_types = [_]u8{SemanticRoofSurface};
+    const attribute_names = [_][*c]const u8{"underpass"};
+    const attribute_name_lens = [_]usize{9};
+    const attribute_types = [_]u8{SOURCE_ATTRIBUTE_INTEGER};
+    const attribute_integer_values = [_]i64{1};
+    const attribute_real_values = [_]f64{0};
+    const attribute_string_values = [_][*c]const u8{""};
+    const attribute_string_value_lens = [_]usize{0};
+    const attributes = SourceAttributes{
+        .names = &attribute_names,
+        .name_lens = &attribute_name_lens,
+        .types = &attribute_types,
+        .integer_values = &attribute_integer_values,
+        .real_values = &attribute_real_values,
+        .string_values = &attribute_string_values,
+        .string_value_lens = &attribute_string_value_lens,
+        .count = 1,
+    };
+
+    // B is replaced before A, so splices are recorded out of byte order.
+    try tile.replaceLod22Polygonal(
+        "B",
+        &vertices,
+        &surface_ring_counts,
+        &ring_vertex_counts,
+        &boundary_indices,
+        &semantic_types,
+        attributes,
+        1,
+    );
+    try tile.mergeAttributes("A", attributes, 1);
+    try std.testing.expectError(error.FeatureAlreadyEdited, tile.mergeAttributes("B", attributes, 1));
+    try tile.save(output_path);
+
+    const output = try CityJSONTile.readFileBytes(allocator, output_path);
+    defer allocator.free(output);
+    const expected = head ++
+        "\"A\":{\"type\":\"Building\",\"geometry\":[{\"type\":\"Solid\",\"lod\":\"2.2\",\"boundaries\":[[[[0,1,2]]]]}],\"attributes\":{\"underpass\":1}}," ++
+        "\"B\":{\"type\":\"Building\",\"attributes\":{\"h\":1,\"underpass\":1},\"geometry\":[{\"type\":\"Solid\",\"lod\":\"2.2\",\"boundaries\":[[[[0,1,4]]]],\"semantics\":{\"surfaces\":[{\"type\":\"RoofSurface\"}],\"values\":[[0]]}}]}}," ++
+        "\"vertices\":[[0,0,0],[1,0,0],[0,1,0],[1,1,0],[0,0,5]]}";
+    try std.testing.expectEqualStrings(expected, output);
+}
+
 test "CityJSONSeq polygonal writer attaches distinct attributes to outer ceilings" {
     const allocator = std.testing.allocator;
     const input_path = "/tmp/zityjson_semantic_surface_attributes_input.city.jsonl";
@@ -2691,12 +3785,14 @@ test "CityJSONSeq polygonal writer attaches distinct attributes to outer ceiling
         &group_indices,
         .{ .attributes = grouped_attributes, .offsets = &group_offsets },
     );
-    writer.deinit();
+    try writer.deinit();
 
     const output_reader = try CityJSONSeqReader.init(allocator, output_path);
     defer output_reader.deinit();
-    const feature_line = try output_reader.readNextMeaningfulLineAlloc() orelse return error.MissingFeatureLine;
-    defer allocator.free(feature_line);
+    var feature_id: [*c]const u8 = null;
+    var feature_id_len: usize = 0;
+    try std.testing.expectEqual(@as(c_int, 1), cityjsonseq_peek_next_id(output_reader, &feature_id, &feature_id_len));
+    const feature_line = output_reader.pending_line;
     const parsed = try std.json.parseFromSlice(std.json.Value, allocator, feature_line, .{});
     defer parsed.deinit();
 